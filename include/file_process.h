@@ -16,6 +16,65 @@
   */
  int read_file(const char *file_path, char **buffer, size_t *size);
  
+ /**
+  * @brief File nhỏ hơn ngưỡng này được đọc vào buffer thay vì map (mmap và page fault tốn hơn một lần read)
+  */
+ #define FILE_VIEW_MMAP_MIN (64 * 1024)
+ 
+ /**
+  * @brief Tùy chọn của file_view_open_ex: luôn đọc vào buffer, không map
+  *
+  * Dùng cho file có thể bị sửa trong lúc đọc (ví dụ suite trong chế độ --watch).
+  */
+ #define FILE_VIEW_COPY 0x1
+ 
+ /**
+  * @brief Vùng nhớ chỉ đọc chứa toàn bộ nội dung một file
+  *
+  * File thường đủ lớn được map thẳng (không sao chép); pipe, procfs và file
+  * nhỏ được đọc vào buffer. Nội dung map không kết thúc bằng '\0', nên luôn
+  * dùng kèm size.
+  */
+ typedef struct {
+     const char *data;       /**< Nội dung file (không bao giờ NULL sau khi mở thành công) */
+     size_t size;            /**< Số byte */
+     int mapped;             /**< 1 nếu data là vùng mmap, 0 nếu là buffer cấp phát */
+ } file_view_t;
+ 
+ /**
+  * @brief Mở view chỉ đọc của file: open, fstat, mmap và madvise(MADV_SEQUENTIAL)
+  *
+  * Khi file không map được (không phải file thường, kích thước fstat bằng 0
+  * như procfs, hoặc mmap lỗi) nội dung được đọc tuần tự vào buffer.
+  *
+  * Lưu ý: nếu file bị cắt ngắn (truncate, "echo > file", trình soạn thảo ghi
+  * đè tại chỗ) trong lúc view đang map, đọc phần đã mất gây SIGBUS và kết thúc
+  * chương trình. File có thể bị sửa trong lúc đọc phải mở bằng
+  * file_view_open_ex(..., FILE_VIEW_COPY).
+  *
+  * @param file_path Đường dẫn đến file
+  * @param view View nhận kết quả, giải phóng bằng file_view_release
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int file_view_open(const char *file_path, file_view_t *view);
+ 
+ /**
+  * @brief Mở view chỉ đọc của file với tùy chọn
+  *
+  * @param file_path Đường dẫn đến file
+  * @param view View nhận kết quả, giải phóng bằng file_view_release
+  * @param flags 0 (như file_view_open) hoặc FILE_VIEW_COPY
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int file_view_open_ex(const char *file_path, file_view_t *view, int flags);
+ 
+ /**
+  * @brief Giải phóng view (munmap hoặc free), gọi được nhiều lần
+  *
+  * @param view View đã mở bằng file_view_open
+  */
+ void file_view_release(file_view_t *view);
+ 
  /**
   * @brief Ghi dữ liệu vào file
   * 
@@ -60,15 +119,40 @@
   */
  int delete_file(const char *file_path);
  
+ /**
+  * @brief Tùy chọn của copy_file_ex
+  */
+ #define COPY_FILE_PRESERVE_MODE  0x1   /* Giữ quyền truy cập của file nguồn */
+ #define COPY_FILE_PRESERVE_TIMES 0x2   /* Giữ atime/mtime của file nguồn */
+ 
+ /**
+  * @brief Buffer của cách sao chép dự phòng (read/write) khi kernel không sao chép trực tiếp được
+  */
+ #define COPY_FILE_BUFFER_SIZE (1024 * 1024)
+ #define COPY_FILE_ALIGN 4096
+ 
  /**
   * @brief Sao chép file
   * 
+  * Dữ liệu được sao chép trong kernel (copy_file_range, rồi sendfile), chỉ
+  * đọc/ghi qua buffer khi cả hai không dùng được.
+  * 
   * @param src_path Đường dẫn đến file nguồn
   * @param dest_path Đường dẫn đến file đích
   * @return int 0 nếu thành công, -1 nếu thất bại
   */
  int copy_file(const char *src_path, const char *dest_path);
  
+ /**
+  * @brief Sao chép file, có thể giữ mode và thời gian của file nguồn
+  * 
+  * @param src_path Đường dẫn đến file nguồn
+  * @param dest_path Đường dẫn đến file đích (không được là chính file nguồn)
+  * @param flags Tổ hợp COPY_FILE_PRESERVE_MODE, COPY_FILE_PRESERVE_TIMES (0: như copy_file)
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int copy_file_ex(const char *src_path, const char *dest_path, int flags);
+ 
  /**
   * @brief Lấy kích thước của file
   * 
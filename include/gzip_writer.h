@@ -0,0 +1,75 @@
+ #ifndef GZIP_WRITER_H
+ #define GZIP_WRITER_H
+
+ #include <stdbool.h>
+ #include <stddef.h>
+ #include <stdint.h>
+ #include <zlib.h>
+
+ /**
+  * @brief Kích thước buffer đầu ra của bộ nén (và buffer đọc khi nén file)
+  */
+ #define GZIP_WRITER_CHUNK 65536
+
+ /**
+  * @brief Mức nén mặc định (như gzip -6)
+  */
+ #define GZIP_DEFAULT_LEVEL 6
+
+ /**
+  * @brief Bộ ghi file gzip dạng luồng
+  *
+  * Dữ liệu được deflate dần theo từng lần ghi vào buffer đầu ra cố định rồi
+  * ghi ra file, nên bộ nhớ dùng không phụ thuộc kích thước dữ liệu. File tạo
+  * ra là gzip chuẩn, đọc được bằng gzip/zcat.
+  */
+ typedef struct {
+     z_stream stream;                        /**< Trạng thái deflate */
+     int fd;                                 /**< File đích (-1 nếu chưa mở) */
+     bool error;                             /**< Đã xảy ra lỗi */
+     uint64_t bytes_in;                      /**< Số byte chưa nén đã nhận */
+     uint64_t bytes_out;                     /**< Số byte nén đã ghi ra file */
+     unsigned char out[GZIP_WRITER_CHUNK];   /**< Buffer đầu ra */
+ } gzip_writer_t;
+
+ /**
+  * @brief Tạo (ghi đè) file gzip để ghi
+  *
+  * @param gz Con trỏ đến bộ ghi
+  * @param path Đường dẫn file đích
+  * @param level Mức nén 1-9 (giá trị ngoài khoảng được giới hạn lại)
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int gzip_writer_open(gzip_writer_t *gz, const char *path, int level);
+
+ /**
+  * @brief Nén và ghi thêm dữ liệu
+  *
+  * @param gz Con trỏ đến bộ ghi
+  * @param data Dữ liệu cần ghi
+  * @param len Số byte
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int gzip_writer_write(gzip_writer_t *gz, const void *data, size_t len);
+
+ /**
+  * @brief Kết thúc luồng nén, ghi trailer gzip và đóng file
+  *
+  * Luôn giải phóng tài nguyên kể cả khi trước đó đã có lỗi.
+  *
+  * @param gz Con trỏ đến bộ ghi
+  * @return int 0 nếu toàn bộ dữ liệu đã được ghi, -1 nếu có lỗi
+  */
+ int gzip_writer_close(gzip_writer_t *gz);
+
+ /**
+  * @brief Nén một file sang file gzip theo từng khối
+  *
+  * @param src_path File nguồn
+  * @param dst_path File gzip đích (ghi đè; bị xóa nếu nén thất bại)
+  * @param level Mức nén 1-9
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int gzip_compress_file(const char *src_path, const char *dst_path, int level);
+
+ #endif /* GZIP_WRITER_H */
@@ -0,0 +1,173 @@
+ #ifndef JSON_WRITER_H
+ #define JSON_WRITER_H
+
+ #include <stdbool.h>
+ #include <stddef.h>
+ #include <stdio.h>
+
+ /**
+  * @brief Độ sâu lồng nhau tối đa của object/array
+  */
+ #define JSON_WRITER_MAX_DEPTH 32
+
+ /**
+  * @brief Kích thước buffer trung gian khi ghi ra FILE* hoặc fd
+  */
+ #define JSON_WRITER_STAGING_SIZE 65536
+
+ /**
+  * @brief Hàm nhận dữ liệu đầu ra của writer (ví dụ bộ nén gzip)
+  *
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ typedef int (*json_writer_sink_t)(void *context, const void *data, size_t len);
+
+ /**
+  * @brief Bộ ghi JSON dạng luồng
+  *
+  * Ghi trực tiếp từng token vào một trong các đích: buffer tự mở rộng, buffer
+  * cố định của người gọi, hoặc FILE* / fd / hàm sink (qua buffer trung gian).
+  * Không dựng cây trung gian nên bộ nhớ dùng không phụ thuộc kích thước dữ
+  * liệu khi ghi ra file. Lỗi (hết bộ nhớ, tràn buffer cố định, lỗi ghi) được ghi nhớ và
+  * báo ở json_writer_finish().
+  */
+ typedef struct {
+     char *data;                             /**< Buffer dữ liệu */
+     size_t size;                            /**< Số byte đang có trong buffer */
+     size_t capacity;                        /**< Dung lượng buffer */
+     bool growable;                          /**< Buffer được phép mở rộng */
+     bool owns_data;                         /**< Writer cấp phát data */
+     FILE *file;                             /**< Đích FILE* (NULL nếu không dùng) */
+     int fd;                                 /**< Đích file descriptor (-1 nếu không dùng) */
+     json_writer_sink_t sink;                /**< Đích hàm sink (NULL nếu không dùng) */
+     void *sink_context;                     /**< Tham số truyền cho sink */
+     size_t flushed;                         /**< Số byte đã ghi ra file/fd/sink */
+     bool error;                             /**< Đã xảy ra lỗi */
+     int depth;                              /**< Độ sâu hiện tại */
+     bool has_items[JSON_WRITER_MAX_DEPTH];  /**< Cấp hiện tại đã có phần tử (cần dấu phẩy) */
+     bool after_key;                         /**< Vừa ghi key, giá trị kế tiếp không cần dấu phẩy */
+ } json_writer_t;
+
+ /**
+  * @brief Khởi tạo writer ghi vào buffer tự mở rộng
+  *
+  * @param writer Con trỏ đến writer
+  * @param initial_capacity Dung lượng ban đầu, 0 để dùng mặc định
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int json_writer_init_buffer(json_writer_t *writer, size_t initial_capacity);
+
+ /**
+  * @brief Khởi tạo writer ghi vào buffer cố định của người gọi
+  *
+  * Kết quả luôn kết thúc bằng '\0'; nếu không đủ chỗ writer báo lỗi.
+  *
+  * @param writer Con trỏ đến writer
+  * @param buffer Buffer của người gọi
+  * @param buffer_size Kích thước buffer
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int json_writer_init_fixed(json_writer_t *writer, char *buffer, size_t buffer_size);
+
+ /**
+  * @brief Khởi tạo writer ghi ra FILE*
+  *
+  * @param writer Con trỏ đến writer
+  * @param file File đã mở để ghi
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int json_writer_init_file(json_writer_t *writer, FILE *file);
+
+ /**
+  * @brief Khởi tạo writer ghi ra file descriptor
+  *
+  * @param writer Con trỏ đến writer
+  * @param fd File descriptor đã mở để ghi
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int json_writer_init_fd(json_writer_t *writer, int fd);
+
+ /**
+  * @brief Khởi tạo writer đẩy đầu ra qua hàm sink theo từng khối
+  *
+  * @param writer Con trỏ đến writer
+  * @param sink Hàm nhận dữ liệu
+  * @param context Tham số truyền cho sink
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int json_writer_init_sink(json_writer_t *writer, json_writer_sink_t sink, void *context);
+
+ /** @brief Mở object '{' */
+ void json_writer_begin_object(json_writer_t *writer);
+ /** @brief Đóng object '}' */
+ void json_writer_end_object(json_writer_t *writer);
+ /** @brief Mở array '[' */
+ void json_writer_begin_array(json_writer_t *writer);
+ /** @brief Đóng array ']' */
+ void json_writer_end_array(json_writer_t *writer);
+
+ /**
+  * @brief Ghi key của một trường trong object
+  */
+ void json_writer_key(json_writer_t *writer, const char *key);
+
+ /** @brief Ghi chuỗi (NULL được ghi thành null) */
+ void json_writer_string(json_writer_t *writer, const char *value);
+ /** @brief Ghi chuỗi có độ dài cho trước */
+ void json_writer_string_n(json_writer_t *writer, const char *value, size_t len);
+ /** @brief Ghi số nguyên */
+ void json_writer_int(json_writer_t *writer, long long value);
+ /** @brief Ghi số thực (NaN/Inf được ghi thành null) */
+ void json_writer_double(json_writer_t *writer, double value);
+ /** @brief Ghi số thực float bằng số chữ số ngắn nhất vẫn đọc lại đúng giá trị float */
+ void json_writer_float(json_writer_t *writer, float value);
+ /** @brief Ghi giá trị boolean */
+ void json_writer_bool(json_writer_t *writer, bool value);
+ /** @brief Ghi null */
+ void json_writer_null(json_writer_t *writer);
+ /** @brief Ghi nguyên văn một giá trị JSON đã được mã hóa sẵn */
+ void json_writer_raw(json_writer_t *writer, const char *json, size_t len);
+
+ /** @brief Ghi trường chuỗi "key": "value" */
+ void json_writer_field_string(json_writer_t *writer, const char *key, const char *value);
+ /** @brief Ghi trường số nguyên */
+ void json_writer_field_int(json_writer_t *writer, const char *key, long long value);
+ /** @brief Ghi trường số thực */
+ void json_writer_field_double(json_writer_t *writer, const char *key, double value);
+ /** @brief Ghi trường số thực float */
+ void json_writer_field_float(json_writer_t *writer, const char *key, float value);
+ /** @brief Ghi trường boolean */
+ void json_writer_field_bool(json_writer_t *writer, const char *key, bool value);
+
+ /**
+  * @brief Hoàn tất: đẩy dữ liệu còn lại ra file hoặc fd và kết thúc chuỗi bằng '\0'
+  *
+  * @param writer Con trỏ đến writer
+  * @return int 0 nếu toàn bộ quá trình ghi thành công, -1 nếu có lỗi
+  */
+ int json_writer_finish(json_writer_t *writer);
+
+ /**
+  * @brief Xóa nội dung đã ghi để dùng lại buffer cho tài liệu JSON kế tiếp
+  *
+  * @param writer Con trỏ đến writer (buffer tự mở rộng hoặc buffer cố định)
+  */
+ void json_writer_reset(json_writer_t *writer);
+
+ /**
+  * @brief Lấy buffer kết quả ra khỏi writer (chỉ dùng với json_writer_init_buffer)
+  *
+  * @param writer Con trỏ đến writer
+  * @param length Con trỏ lưu độ dài chuỗi JSON (có thể NULL)
+  * @return char* Chuỗi JSON, người gọi giải phóng bằng free()
+  */
+ char *json_writer_release(json_writer_t *writer, size_t *length);
+
+ /**
+  * @brief Giải phóng tài nguyên của writer (không đóng file/fd)
+  *
+  * @param writer Con trỏ đến writer
+  */
+ void json_writer_free(json_writer_t *writer);
+
+ #endif /* JSON_WRITER_H */
@@ -2,9 +2,18 @@
 #define LOG_H
 
 #include <stdarg.h>
+#include <stddef.h>
+#include <time.h>
 
 #define BUFFER_SIZE 1024
 
+// Độ dài tối đa của một dòng log (kể cả header)
+#define MAX_LOG_LINE_SIZE 2048
+
+// Kích thước log mặc định để xoay vòng và số bản lưu trữ giữ lại
+#define LOG_ROTATE_SIZE (1024 * 1024)
+#define LOG_ROTATE_GENERATIONS 5
+
 enum {
     LOG_LVL_NONE = 0,
     LOG_LVL_ERROR,
@@ -12,17 +21,147 @@ enum {
     LOG_LVL_DEBUG
 };
 
+// Chính sách khi ring buffer của logger bất đồng bộ bị đầy
+enum {
+    LOG_OVERFLOW_DROP = 0,      // Bỏ dòng mới, đếm số dòng bị bỏ
+    LOG_OVERFLOW_BLOCK,         // Chờ đến khi luồng ghi giải phóng chỗ
+    LOG_OVERFLOW_DROP_DEBUG     // Chỉ bỏ dòng DEBUG, chờ với ERROR/WARN
+};
+
+// Định dạng timestamp ở đầu mỗi dòng log
+enum {
+    LOG_TS_SECONDS = 0,         // [YYYY-mm-dd HH:MM:SS]
+    LOG_TS_MILLIS,              // [YYYY-mm-dd HH:MM:SS.mmm]
+    LOG_TS_MONO_MICROS          // [YYYY-mm-dd HH:MM:SS] [giây.micro giây theo CLOCK_MONOTONIC]
+};
+
+// Định dạng file log
+enum {
+    LOG_FORMAT_TEXT = 0,        // Dòng text đã định dạng
+    LOG_FORMAT_BINARY           // Id định dạng, timestamp và tham số thô; đọc bằng "device_test log-decode"
+};
+
+// Giới hạn mặc định của mỗi điểm gọi (log_set_rate_limit) và chu kỳ báo số dòng lặp lại
+#define LOG_RATE_BURST 20
+#define LOG_RATE_PER_SEC 5
+#define LOG_REPEAT_FLUSH_SEC 30
+
+// Số dòng mặc định của ring buffer bất đồng bộ (mỗi dòng tối đa MAX_LOG_LINE_SIZE byte)
+#define LOG_ASYNC_SLOTS 512
+
+// Module của điểm gọi log, để đổi mức log riêng khi chạy (set_log_module_level)
+enum {
+    LOG_MOD_CORE = 0,           // main, log, so sánh kết quả và phần còn lại
+    LOG_MOD_PARSER,             // Đọc cấu hình, bộ nhớ đệm suite, dải địa chỉ
+    LOG_MOD_TC,                 // Chạy test, phân giải tên, xử lý gói tin
+    LOG_MOD_FILE,               // File, báo cáo, journal, kho kết quả
+    LOG_MOD_REMOTE,             // Kết nối ra ngoài: endpoint số liệu, gửi log về máy khác
+    LOG_MOD_COUNT
+};
+
+// Mỗi file .c định nghĩa LOG_MODULE trước mọi #include để chọn module của các LOG_*
+#ifndef LOG_MODULE
+#define LOG_MODULE LOG_MOD_CORE
+#endif
+
 typedef struct {
     char log_file_path[256];
-    unsigned char log_level;
+    unsigned char log_level;                        // Mức chung (module không có mức riêng dùng mức này)
+    unsigned char module_levels[LOG_MOD_COUNT];     // Mức ghi file của từng module
+    unsigned char capture_levels[LOG_MOD_COUNT];    // Mức cao nhất cần dựng dòng log: module_levels, hoặc DEBUG khi flight recorder bật
 } LoggerConfig;
 
 extern LoggerConfig logger_config;
 
+// Mức log cao nhất được biên dịch vào chương trình (số, vì dùng trong #if): 3 = DEBUG, 2 = WARN, 1 = ERROR.
+// Bản release (NDEBUG) bỏ hẳn các lời gọi DEBUG
+#ifndef LOG_COMPILE_LEVEL
+#ifdef NDEBUG
+#define LOG_COMPILE_LEVEL 2
+#else
+#define LOG_COMPILE_LEVEL 3
+#endif
+#endif
+
+// Kiểm tra mức log trước khi tính tham số: hằng số khi level bị loại lúc biên dịch, một phép đọc atomic
+// relaxed và một phép so sánh khi chạy (mức có thể đổi từ luồng khác hoặc signal handler)
+#define LOG_ENABLED(level) \
+    ((level) <= LOG_COMPILE_LEVEL && \
+     (level) <= __atomic_load_n(&logger_config.capture_levels[LOG_MODULE], __ATOMIC_RELAXED))
+
+// Số phần tử kiểu tham số tối đa của một điểm gọi ở chế độ nhị phân (nhiều hơn thì ghi dạng text)
+#define LOG_SITE_MAX_ARGS 16
+
+// Điểm gọi log: mỗi LOG_* có một biến static riêng, chế độ nhị phân đăng ký chuỗi định dạng một lần
+typedef struct {
+    int id;                                     // 0 = chưa đăng ký, -1 = luôn ghi dạng text
+    unsigned char module;                       // LOG_MOD_* của file chứa điểm gọi
+    unsigned char arg_count;
+    unsigned char arg_types[LOG_SITE_MAX_ARGS];
+    unsigned char rate_lock;                    // Khóa của token bucket (__atomic_test_and_set)
+    unsigned int rate_tokens;                   // Số dòng còn được ghi ngay
+    unsigned int rate_suppressed;               // Số dòng bị bỏ từ lần ghi trước, báo khi điểm gọi ghi lại
+    long long rate_refill_ns;                   // Lần nạp token gần nhất (CLOCK_MONOTONIC), 0 = chưa dùng
+} log_site_t;
+
+// Chỉ điểm gọi có chuỗi định dạng hằng mới có id (chuỗi không phải hằng có thể đổi giữa các lần gọi)
+#define LOG_FORMAT_ARG_(format, ...) format
+#define LOG_SITE_ID_(...) (__builtin_constant_p(LOG_FORMAT_ARG_(__VA_ARGS__, 0)) ? 0 : -1)
+
+#define LOG_AT(level, ...) \
+    do { \
+        if (LOG_ENABLED(level)) { \
+            static log_site_t log_site_ = { .id = LOG_SITE_ID_(__VA_ARGS__), .module = LOG_MODULE }; \
+            log_site_message(&log_site_, (level), __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_ERROR(...) LOG_AT(LOG_LVL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LVL_WARN, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LVL_DEBUG, __VA_ARGS__)
+
 void init_logger(void);
 void cleanup_logger(void);
 void set_log_level(int level);
+// Đặt mức log riêng của một module (level < 0: dùng lại mức chung); dùng được trong signal handler
+int set_log_module_level(int module, int level);
+// Mức log hiện tại của module, kèm cho biết đó là mức riêng hay mức chung
+int get_log_module_level(int module, int *is_override);
+// Tên module ("core", "parser", "tc", "file", "remote") và ngược lại (-1 nếu không biết)
+const char *log_module_name(int module);
+int log_module_from_name(const char *name);
 void set_log_file(const char *file_path);
-void log_message(int level, const char *format, ...);
+void log_message(int level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+void log_site_message(log_site_t *site, int level, const char *format, ...) __attribute__((format(printf, 3, 4)));
+void set_log_timestamp(int mode);
+// Chọn ghi dạng text hay nhị phân; file mới (hoặc mỗi lần mở lại) bắt đầu bằng bảng định dạng đã đăng ký
+int set_log_format(int format);
+// Dựng "[timestamp] LEVEL: " cho thời điểm cho trước (monotonic chỉ dùng với LOG_TS_MONO_MICROS), trả về độ dài
+size_t log_format_header(char *out, int level, const struct timespec *realtime,
+                         const struct timespec *monotonic, int mode);
+
+// Ghi log qua luồng nền: giữ fd mở, dòng log đi qua ring buffer MPSC và được ghi gộp bằng writev
+int log_async_start(size_t slots, int overflow_policy);
+// Ghi hết các dòng đang chờ rồi dừng luồng nền, quay lại ghi trực tiếp (tự gọi khi exit)
+void log_async_stop(void);
+// Chờ đến khi mọi dòng đã log trước lời gọi được ghi xuống file
+void log_flush(void);
+// Số dòng bị bỏ do ring buffer đầy kể từ khi bật chế độ bất đồng bộ
+unsigned long log_async_dropped(void);
+
+// Giới hạn mỗi điểm gọi ở burst dòng liên tiếp rồi per_sec dòng/giây (burst = 0: tắt); khi điểm gọi
+// ghi lại, một dòng "Suppressed N messages like ..." báo số dòng đã bị bỏ
+int log_set_rate_limit(unsigned int burst, unsigned int per_sec);
+// Gộp các dòng giống hệt nhau liên tiếp thành "Last message repeated N times" (ghi ít nhất mỗi
+// LOG_REPEAT_FLUSH_SEC giây khi dòng còn lặp, và khi log_flush)
+void log_set_dedup(int enabled);
+
+// Đổi tên log hiện tại thành <log>.<YYYYmmdd_HHMMSS> (nén thành .gz nếu gzip_level > 0)
+int rotate_log_file(int gzip_level);
+// Tự xoay vòng khi log đạt max_bytes hoặc cũ hơn max_age_sec (0 = bỏ qua tiêu chí), giữ generations bản
+// lưu trữ mới nhất (0 = giữ tất cả); bản lưu trữ được nén và dọn ở luồng nền
+int log_set_rotation(size_t max_bytes, long max_age_sec, int generations, int gzip_level);
+// Chờ luồng nền nén xong các bản lưu trữ đang chờ
+void log_rotation_wait(void);
 
 #endif
\ No newline at end of file
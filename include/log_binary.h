@@ -0,0 +1,140 @@
+ #ifndef LOG_BINARY_H
+ #define LOG_BINARY_H
+
+ #include <stdarg.h>
+ #include <stddef.h>
+ #include <stdint.h>
+ #include <stdio.h>
+ #include "log.h"
+
+ /**
+  * @brief Magic đầu phiên và phiên bản định dạng log nhị phân
+  */
+ #define LOG_BIN_MAGIC "DTBLOG"
+ #define LOG_BIN_VERSION 1
+
+ /**
+  * @brief Loại bản ghi trong file log nhị phân
+  *
+  * Mỗi lần mở file, logger ghi một bản ghi SESSION rồi FORMAT của mọi điểm
+  * gọi đã đăng ký, nên mỗi file (kể cả bản lưu trữ sau khi xoay vòng) tự giải
+  * mã được mà không cần chương trình đã ghi ra nó.
+  */
+ typedef enum {
+     LOG_BIN_SESSION = 1,    /**< Đầu phiên ghi: magic, thông tin nền tảng, thời điểm mở */
+     LOG_BIN_FORMAT,         /**< Chuỗi định dạng của một id */
+     LOG_BIN_RECORD,         /**< Một dòng log: id, timestamp, tham số thô */
+     LOG_BIN_TEXT            /**< Một dòng log đã định dạng sẵn (lời gọi không có id) */
+ } log_bin_type_t;
+
+ /**
+  * @brief Kiểu tham số lưu trong bản ghi, suy ra từ chuỗi định dạng printf
+  *
+  * Số nguyên và số thực được lưu nguyên kích thước gốc, chuỗi lưu dạng
+  * độ dài (uint16) + nội dung.
+  */
+ typedef enum {
+     LOG_ARG_INT = 1,        /**< int (cả char/short đã được nâng kiểu, và '*') */
+     LOG_ARG_LONG,           /**< long */
+     LOG_ARG_LLONG,          /**< long long */
+     LOG_ARG_SIZE,           /**< size_t */
+     LOG_ARG_PTRDIFF,        /**< ptrdiff_t */
+     LOG_ARG_INTMAX,         /**< intmax_t */
+     LOG_ARG_DOUBLE,         /**< double */
+     LOG_ARG_LDOUBLE,        /**< long double */
+     LOG_ARG_POINTER,        /**< void * (%p) */
+     LOG_ARG_STRING,         /**< const char * */
+     LOG_ARG_STRING_PREC,    /**< const char * với độ chính xác cố định (byte kế tiếp) */
+     LOG_ARG_STRING_STAR     /**< const char * với độ chính xác '*' (tham số int ngay trước) */
+ } log_arg_type_t;
+
+ /**
+  * @brief Header chung của mọi bản ghi
+  *
+  * Bản ghi RECORD và TEXT có tiếp int64 CLOCK_REALTIME (ns), thêm int64
+  * CLOCK_MONOTONIC (ns) khi ts_mode là LOG_TS_MONO_MICROS, rồi đến dữ liệu.
+  */
+ typedef struct {
+     uint16_t length;        /**< Tổng độ dài bản ghi, kể cả header */
+     uint8_t type;           /**< log_bin_type_t */
+     uint8_t level;          /**< Mức log (RECORD, TEXT) */
+     uint16_t id;            /**< Id định dạng (FORMAT, RECORD) */
+     uint8_t ts_mode;        /**< Định dạng timestamp khi ghi (RECORD, TEXT) */
+     uint8_t reserved;
+ } log_bin_header_t;
+
+ /**
+  * @brief Nội dung bản ghi SESSION
+  */
+ typedef struct {
+     char magic[6];          /**< "DTBLOG" */
+     uint8_t version;        /**< LOG_BIN_VERSION */
+     uint8_t pointer_size;   /**< sizeof(void *) của chương trình ghi */
+     uint32_t byte_order;    /**< 0x01020304 theo thứ tự byte của chương trình ghi */
+     int64_t started_ns;     /**< Thời điểm mở file (CLOCK_REALTIME, ns) */
+ } log_bin_session_t;
+
+ /**
+  * @brief Suy ra kiểu tham số từ chuỗi định dạng printf
+  *
+  * @param format Chuỗi định dạng
+  * @param types Mảng lưu kiểu tham số (LOG_ARG_STRING_PREC chiếm thêm một byte độ chính xác)
+  * @param max_types Kích thước mảng types
+  * @return int Số phần tử đã ghi vào types, -1 nếu định dạng không ghi được dạng nhị phân
+  *         (%n, %m, %ls, %lc, tham số theo vị trí, quá nhiều tham số)
+  */
+ int log_binary_parse_format(const char *format, unsigned char *types, int max_types);
+
+ /**
+  * @brief Dựng bản ghi SESSION
+  *
+  * @return size_t Độ dài bản ghi, 0 nếu buffer không đủ
+  */
+ size_t log_binary_encode_session(char *out, size_t size);
+
+ /**
+  * @brief Dựng bản ghi FORMAT gán chuỗi định dạng cho id
+  *
+  * @return size_t Độ dài bản ghi, 0 nếu buffer không đủ
+  */
+ size_t log_binary_encode_format(char *out, size_t size, int id, const char *format);
+
+ /**
+  * @brief Dựng bản ghi RECORD: id, timestamp hiện tại và tham số thô
+  *
+  * Chuỗi dài bị cắt để bản ghi vừa buffer.
+  *
+  * @param out Buffer đích
+  * @param size Kích thước buffer (tối đa 65535 byte được dùng)
+  * @param id Id định dạng
+  * @param level Mức log
+  * @param ts_mode Định dạng timestamp (LOG_TS_*)
+  * @param types Kiểu tham số từ log_binary_parse_format
+  * @param type_count Số phần tử của types
+  * @param args Tham số của lời gọi log
+  * @return size_t Độ dài bản ghi, 0 nếu buffer không đủ
+  */
+ size_t log_binary_encode_record(char *out, size_t size, int id, int level, int ts_mode,
+                                 const unsigned char *types, int type_count, va_list args);
+
+ /**
+  * @brief Dựng bản ghi TEXT với nội dung định dạng bằng vsnprintf
+  *
+  * @return size_t Độ dài bản ghi, 0 nếu buffer không đủ
+  */
+ size_t log_binary_encode_text(char *out, size_t size, int level, int ts_mode, const char *format, va_list args);
+
+ /**
+  * @brief Giải mã file log nhị phân (có thể đã nén gzip) thành định dạng log text
+  *
+  * Mỗi dòng được dựng giống hệt dòng log_message ghi ở chế độ text với cùng
+  * định dạng timestamp.
+  *
+  * @param path Đường dẫn file log nhị phân hoặc bản lưu trữ .gz
+  * @param out Luồng ghi kết quả
+  * @return long Số dòng đã giải mã, -1 nếu không phải log nhị phân hoặc file bị hỏng
+  *         (các dòng trước chỗ hỏng vẫn được ghi ra)
+  */
+ long log_binary_decode_file(const char *path, FILE *out);
+
+ #endif /* LOG_BINARY_H */
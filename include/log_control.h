@@ -0,0 +1,45 @@
+ #ifndef LOG_CONTROL_H
+ #define LOG_CONTROL_H
+
+ #include <stddef.h>
+
+ /**
+  * @brief Đường dẫn mặc định của socket điều khiển logger
+  */
+ #define LOG_CONTROL_DEFAULT_PATH "logs/testing_device.ctl"
+
+ /**
+  * @brief Bật điều khiển logger khi đang chạy
+  *
+  * SIGUSR2 bật/tắt mức DEBUG chung (lần sau trả về mức trước đó). Nếu có
+  * socket_path, một luồng nền nhận lệnh qua Unix socket, mỗi dòng một lệnh
+  * (xem log_control_execute), ví dụ:
+  *   echo "level tc debug" | socat - UNIX-CONNECT:logs/testing_device.ctl
+  *
+  * @param socket_path Đường dẫn Unix socket (NULL: chỉ dùng SIGUSR2)
+  * @return int 0 nếu thành công, -1 nếu không mở được socket (SIGUSR2 vẫn được bật)
+  */
+ int log_control_start(const char *socket_path);
+
+ /**
+  * @brief Dừng luồng điều khiển, xóa socket và khôi phục xử lý SIGUSR2 cũ
+  */
+ void log_control_stop(void);
+
+ /**
+  * @brief Thực thi một lệnh điều khiển
+  *
+  * Lệnh:
+  *   level                         Xem mức chung và mức của từng module
+  *   level <mức>                   Đặt mức chung (0-3 hoặc none/error/warn/debug)
+  *   level <module> <mức|default>  Đặt mức riêng của module (core, parser, tc, file, remote)
+  *   file <đường dẫn>              Ghi log sang file khác
+  *
+  * @param command Lệnh (không cần '\n')
+  * @param reply Buffer nhận phản hồi "OK ..." hoặc "ERR ..." (kết thúc bằng '\n')
+  * @param reply_size Kích thước buffer reply
+  * @return int 0 nếu lệnh thành công, -1 nếu lệnh sai
+  */
+ int log_control_execute(const char *command, char *reply, size_t reply_size);
+
+ #endif /* LOG_CONTROL_H */
@@ -0,0 +1,56 @@
+ #ifndef LOG_FLIGHT_H
+ #define LOG_FLIGHT_H
+
+ #include <stdbool.h>
+ #include <stddef.h>
+
+ /**
+  * @brief Kích thước gợi ý của flight recorder (byte)
+  */
+ #define LOG_FLIGHT_SIZE (256 * 1024)
+
+ /**
+  * @brief Bật flight recorder: giữ N byte dòng log gần nhất trong bộ nhớ
+  *
+  * Mọi dòng log ở mọi mức (đến LOG_COMPILE_LEVEL) được dựng và chép vào ring,
+  * kể cả khi file log chỉ ghi ERROR, nên khi bật mỗi lời gọi LOG_DEBUG đều
+  * tốn chi phí định dạng; ring chỉ được ghi ra đĩa khi dump. Dump
+  * tự động khi nhận SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT (rồi kết thúc
+  * như mặc định) và SIGUSR1 (chạy tiếp).
+  *
+  * @param size Kích thước ring (byte)
+  * @param dump_path File nhận các lần dump (ghi nối tiếp)
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int log_flight_start(size_t size, const char *dump_path);
+
+ /**
+  * @brief Tắt flight recorder, khôi phục signal handler cũ và giải phóng ring
+  */
+ void log_flight_stop(void);
+
+ /**
+  * @brief Flight recorder có đang bật không
+  */
+ bool log_flight_enabled(void);
+
+ /**
+  * @brief Chép một dòng log đã định dạng vào ring (dòng cũ nhất bị ghi đè)
+  *
+  * @param line Dòng log (kết thúc bằng '\n')
+  * @param length Độ dài dòng
+  */
+ void log_flight_record(const char *line, size_t length);
+
+ /**
+  * @brief Ghi các dòng trong ring chưa được dump ra file dump
+  *
+  * Mỗi lần dump bắt đầu bằng dòng "===== flight recorder: <reason> =====",
+  * nên nhiều lần dump (ví dụ mỗi test lỗi) không lặp lại cùng một đoạn log.
+  *
+  * @param reason Lý do dump
+  * @return int 0 nếu thành công, -1 nếu flight recorder không bật hoặc không mở được file
+  */
+ int log_flight_dump(const char *reason);
+
+ #endif /* LOG_FLIGHT_H */
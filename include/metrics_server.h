@@ -0,0 +1,63 @@
+ #ifndef METRICS_SERVER_H
+ #define METRICS_SERVER_H
+
+ #include <stdbool.h>
+ #include <stddef.h>
+ #include "tc.h"
+
+ /**
+  * @brief Số giá trị RTT gần nhất của mỗi test ID dùng để tính phân vị
+  */
+ #define METRICS_RTT_WINDOW 128
+
+ /**
+  * @brief Khoảng thời gian tính tốc độ chạy test (giây)
+  */
+ #define METRICS_RATE_WINDOW_SEC 60
+
+ /**
+  * @brief Bắt đầu ghi nhận số liệu và phục vụ GET /metrics trên 127.0.0.1
+  *
+  * Luồng HTTP riêng chỉ sao chép trạng thái trong bộ nhớ dưới mutex rồi
+  * định dạng ngoài mutex, nên luồng chạy test chỉ bị giữ trong thời gian sao
+  * chép.
+  *
+  * @param port Cổng TCP lắng nghe (0 để hệ thống tự chọn)
+  * @return int Cổng đang lắng nghe, -1 nếu thất bại
+  */
+ int metrics_server_start(int port);
+
+ /**
+  * @brief Dừng luồng HTTP và giải phóng trạng thái
+  */
+ void metrics_server_stop(void);
+
+ /**
+  * @brief Bật ghi nhận số liệu mà không mở cổng HTTP (dùng khi kiểm thử)
+  */
+ void metrics_enable(void);
+
+ /**
+  * @brief Ghi nhận một test bắt đầu chạy
+  *
+  * @param queue_depth Số test còn chờ sau test này
+  */
+ void metrics_test_started(long queue_depth);
+
+ /**
+  * @brief Ghi nhận kết quả của một test đã chạy xong
+  *
+  * @param result Kết quả test
+  */
+ void metrics_record_result(const test_result_info_t *result);
+
+ /**
+  * @brief Định dạng trạng thái hiện tại theo OpenMetrics text (kết thúc bằng "# EOF")
+  *
+  * @param output Con trỏ lưu chuỗi kết quả (người gọi free)
+  * @param length Con trỏ lưu độ dài chuỗi
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int metrics_render(char **output, size_t *length);
+
+ #endif /* METRICS_SERVER_H */
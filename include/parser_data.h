@@ -5,6 +5,9 @@
  
  #include <stdbool.h>
  #include <stddef.h>
+ #include <stdint.h>
+ #include "string_pool.h"
+ #include "json_writer.h"
  
  /**
   * @brief Loại mạng cho test case
@@ -50,23 +53,32 @@
   * @brief Cấu trúc chung cho các tham số security test
   */
  typedef struct {
-     char method[32];    /**< Phương thức kiểm tra bảo mật */
+     str_ref_t method;   /**< Phương thức kiểm tra bảo mật (trong bảng chuỗi) */
      int port;           /**< Cổng */
      bool tls;           /**< Sử dụng TLS */
  } security_params_t;
  
  /**
   * @brief Cấu trúc lưu thông tin của một test case
+  *
+  * Các chuỗi không nằm trong struct mà nằm trong bảng chuỗi (strtab) dùng
+  * chung cho cả suite, struct chỉ giữ offset. Mọi test case trong một mảng
+  * do parser tạo ra dùng chung một strtab, được giải phóng bởi free_test_cases().
+  * Dùng các hàm test_case_id(), test_case_target()... để đọc chuỗi.
+  *
+  * Các trường scheduler/executor cần (loại, đích, tham số, timeout) nằm trong
+  * 64 byte đầu và mảng được cấp phát căn lề 64 byte, nên mỗi test case chiếm
+  * đúng một cache line.
   */
  typedef struct {
-     char id[32];                /**< ID của test case */
-     test_type_t type;           /**< Loại test case */
-     network_type_t network_type;/**< Loại mạng */
-     char name[64];              /**< Tên test case */
-     char description[256];      /**< Mô tả test case */
-     char target[128];           /**< Đích thực thi test case */
-     int timeout;                /**< Thời gian timeout (ms) */
+     uint8_t type;               /**< Loại test case (test_type_t) */
+     uint8_t network_type;       /**< Loại mạng (network_type_t) */
      bool enabled;               /**< Test case có được bật hay không */
+     uint8_t flags;              /**< Cờ nội bộ */
+     int timeout;                /**< Thời gian timeout (ms) */
+     const char *strtab;         /**< Bảng chuỗi của suite */
+     str_ref_t id;               /**< ID của test case */
+     str_ref_t target;           /**< Đích thực thi test case */
      
      /* Tham số tùy theo loại test */
      union {
@@ -75,11 +87,242 @@
          security_params_t security;  /**< Tham số cho security test */
      } params;
      
-     /* Dữ liệu bổ sung nếu cần */
-     void *extra_data;           /**< Con trỏ đến dữ liệu bổ sung */
-     size_t extra_data_size;     /**< Kích thước dữ liệu bổ sung */
+     str_ref_t name;             /**< Tên test case */
+     str_ref_t description;      /**< Mô tả test case */
+     str_ref_t extra_data;       /**< Dữ liệu bổ sung dạng chuỗi JSON (0 nếu không có) */
  } test_case_t;
  
+ /**
+  * @brief Căn lề khi cấp phát mảng test cases
+  */
+ #define TEST_CASE_ALIGN 64
+ 
+ _Static_assert(sizeof(test_case_t) <= TEST_CASE_ALIGN, "test_case_t must fit in one cache line");
+ 
+ /** @brief ID của test case */
+ static inline const char *test_case_id(const test_case_t *tc) { return strtab_get(tc->strtab, tc->id); }
+ /** @brief Tên test case */
+ static inline const char *test_case_name(const test_case_t *tc) { return strtab_get(tc->strtab, tc->name); }
+ /** @brief Mô tả test case */
+ static inline const char *test_case_description(const test_case_t *tc) { return strtab_get(tc->strtab, tc->description); }
+ /** @brief Đích thực thi test case */
+ static inline const char *test_case_target(const test_case_t *tc) { return strtab_get(tc->strtab, tc->target); }
+ /** @brief Phương thức của security test */
+ static inline const char *test_case_security_method(const test_case_t *tc) { return strtab_get(tc->strtab, tc->params.security.method); }
+ /** @brief Dữ liệu bổ sung (chuỗi JSON), NULL nếu không có */
+ static inline const char *test_case_extra_data(const test_case_t *tc) { return tc->extra_data ? strtab_get(tc->strtab, tc->extra_data) : NULL; }
+ /** @brief Kích thước dữ liệu bổ sung */
+ static inline size_t test_case_extra_data_size(const test_case_t *tc) { return strtab_len(tc->strtab, tc->extra_data); }
+ 
+ /**
+  * @brief Cấp phát mảng test cases căn lề cache line, đã xóa về 0
+  *
+  * @param count Số lượng test cases
+  * @return test_case_t* Mảng test cases (giải phóng bằng free()), NULL nếu thất bại
+  */
+ test_case_t *alloc_test_cases(int count);
+ 
+ /**
+  * @brief Gắn bảng chuỗi cho một mảng test cases
+  *
+  * Bảng chuỗi được lấy ra khỏi pool và mảng test cases trở thành chủ sở hữu.
+  *
+  * @param test_cases Mảng test cases
+  * @param count Số lượng test cases
+  * @param pool String pool chứa các chuỗi đã intern
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int attach_string_table(test_case_t *test_cases, int count, string_pool_t *pool);
+ 
+ /**
+  * @brief Bảng băm ID -> vị trí test case trong mảng
+  *
+  * Open addressing, mỗi slot lưu vị trí + 1 (0 = trống). Bảng chỉ tham chiếu
+  * đến mảng test cases nên phải được xây lại nếu mảng thay đổi.
+  */
+ typedef struct {
+     const test_case_t *test_cases;  /**< Mảng test cases được đánh chỉ mục */
+     int count;                      /**< Số lượng test cases */
+     int32_t *slots;                 /**< Các slot của bảng băm */
+     size_t slot_count;              /**< Số slot (lũy thừa của 2) */
+ } test_case_index_t;
+ 
+ /**
+  * @brief Xây bảng chỉ mục ID cho mảng test cases
+  *
+  * ID trùng lặp được ghi log; chỉ test case xuất hiện đầu tiên được đánh chỉ mục.
+  *
+  * @param index Con trỏ đến bảng chỉ mục
+  * @param test_cases Mảng test cases
+  * @param count Số lượng test cases
+  * @return int Số ID trùng lặp (0 nếu không có), -1 nếu thất bại
+  */
+ int test_case_index_build(test_case_index_t *index, const test_case_t *test_cases, int count);
+ 
+ /**
+  * @brief Tìm vị trí test case theo ID
+  *
+  * @param index Bảng chỉ mục
+  * @param id ID cần tìm
+  * @return int Vị trí trong mảng, -1 nếu không tìm thấy
+  */
+ int test_case_index_find(const test_case_index_t *index, const char *id);
+ 
+ /**
+  * @brief Tìm test case theo ID
+  *
+  * @param index Bảng chỉ mục
+  * @param id ID cần tìm
+  * @return const test_case_t* Test case, NULL nếu không tìm thấy
+  */
+ const test_case_t *find_test_case_by_id(const test_case_index_t *index, const char *id);
+ 
+ /**
+  * @brief Hash nội dung của test case (không phụ thuộc vị trí chuỗi trong bảng chuỗi)
+  *
+  * Hai test case có cùng hash khi mọi trường cấu hình đều giống nhau; dùng để
+  * phát hiện test case bị sửa khi nạp lại suite.
+  *
+  * @param tc Test case
+  * @return uint64_t Giá trị hash FNV-1a 64 bit
+  */
+ uint64_t test_case_hash(const test_case_t *tc);
+ 
+ /**
+  * @brief Giải phóng bảng chỉ mục (không giải phóng mảng test cases)
+  *
+  * @param index Con trỏ đến bảng chỉ mục
+  */
+ void test_case_index_free(test_case_index_t *index);
+ 
+ /**
+  * @brief Các trục của một test matrix
+  */
+ typedef enum {
+     TEST_AXIS_TARGET,      /**< Danh sách đích */
+     TEST_AXIS_SIZE,        /**< Kích thước gói tin (ping) hoặc buffer (throughput) */
+     TEST_AXIS_NETWORK,     /**< Loại mạng */
+     TEST_AXIS_COUNT
+ } test_axis_t;
+ 
+ /**
+  * @brief Test matrix: một test case mẫu cùng các trục tham số
+  *
+  * Tích Descartes của các trục không bao giờ được sinh ra thành mảng
+  * test_case_t; từng test case được tạo khi cần bằng test_matrix_expand().
+  */
+ typedef struct {
+     test_case_t base;                        /**< Test case mẫu */
+     uint32_t axis_offset[TEST_AXIS_COUNT];   /**< Vị trí giá trị đầu tiên của trục trong axis_values */
+     uint32_t axis_count[TEST_AXIS_COUNT];    /**< Số giá trị của trục (0 = giữ giá trị mẫu) */
+ } test_matrix_t;
+ 
+ /**
+  * @brief Tập các test matrix của một suite
+  *
+  * Giá trị trục được lưu phẳng trong axis_values: offset chuỗi cho trục target,
+  * số nguyên cho trục size, network_type_t cho trục network. Mọi chuỗi nằm
+  * trong strtab riêng của tập matrix.
+  */
+ typedef struct {
+     test_matrix_t *matrices;     /**< Mảng matrix */
+     int count;                   /**< Số lượng matrix */
+     uint32_t *axis_values;       /**< Giá trị của tất cả các trục */
+     size_t axis_value_count;     /**< Số phần tử trong axis_values */
+     char *strtab;                /**< Bảng chuỗi của tập matrix */
+     size_t strtab_size;          /**< Kích thước bảng chuỗi */
+ } test_matrix_set_t;
+ 
+ /**
+  * @brief Test case sinh ra từ matrix, kèm bảng chuỗi tạm của nó
+  */
+ typedef struct {
+     test_case_t test_case;       /**< Test case, hợp lệ đến lần expand kế tiếp */
+     string_pool_t strings;       /**< Bảng chuỗi tạm (tái sử dụng giữa các lần expand) */
+ } test_matrix_item_t;
+ 
+ /**
+  * @brief Số test case mà một matrix sinh ra
+  *
+  * @param matrix Con trỏ đến matrix
+  * @return long Tích số giá trị của các trục
+  */
+ long test_matrix_size(const test_matrix_t *matrix);
+ 
+ /**
+  * @brief Tổng số test case mà cả tập matrix sinh ra
+  *
+  * @param set Con trỏ đến tập matrix
+  * @return long Tổng số test case
+  */
+ long test_matrix_set_size(const test_matrix_set_t *set);
+ 
+ /**
+  * @brief Khởi tạo item dùng cho test_matrix_expand()
+  *
+  * @param item Con trỏ đến item
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int test_matrix_item_init(test_matrix_item_t *item);
+ 
+ /**
+  * @brief Giải phóng item
+  *
+  * @param item Con trỏ đến item
+  */
+ void test_matrix_item_free(test_matrix_item_t *item);
+ 
+ /**
+  * @brief Sinh test case thứ index của một matrix
+  *
+  * ID của test case sinh ra có dạng "<id matrix>_<index + 1>".
+  *
+  * @param set Tập matrix
+  * @param matrix_index Vị trí matrix trong tập
+  * @param index Vị trí test case trong matrix (0 .. test_matrix_size() - 1)
+  * @param item Item nhận test case sinh ra
+  * @return true nếu thành công, false nếu thất bại
+  */
+ bool test_matrix_expand(const test_matrix_set_t *set, int matrix_index, long index, test_matrix_item_t *item);
+ 
+ /**
+  * @brief Giải phóng tập matrix
+  *
+  * @param set Con trỏ đến tập matrix
+  */
+ void free_test_matrices(test_matrix_set_t *set);
+ 
+ /**
+  * @brief Phân tích nội dung JSON thành test cases và test matrix
+  *
+  * Khác với parse_json_content(), mảng "test_cases" được phép rỗng nếu có
+  * ít nhất một matrix trong mảng "matrices".
+  * ID test case phải duy nhất: suite có ID trùng bị từ chối, mỗi cặp trùng
+  * được ghi log kèm hai vị trí.
+  *
+  * @param json_content Chuỗi JSON
+  * @param test_cases Con trỏ đến mảng test cases (NULL nếu không có test case nào)
+  * @param count Con trỏ đến biến lưu số lượng test cases
+  * @param matrices Tập matrix nhận kết quả (NULL để bỏ qua "matrices")
+  * @return true nếu thành công, false nếu thất bại hoặc có ID trùng
+  */
+ bool parse_json_suite(const char *json_content, test_case_t **test_cases, int *count,
+                       test_matrix_set_t *matrices);
+ 
+ /**
+  * @brief Như parse_json_suite() nhưng nội dung JSON có độ dài cho trước, không cần
+  *        kết thúc bằng '\0' (ví dụ file_view_t được map từ file)
+  *
+  * @param json_content Nội dung JSON
+  * @param length Số byte của json_content
+  * @param test_cases Con trỏ đến mảng test cases (NULL nếu không có test case nào)
+  * @param count Con trỏ đến biến lưu số lượng test cases
+  * @param matrices Tập matrix nhận kết quả (NULL để bỏ qua "matrices")
+  * @return true nếu thành công, false nếu thất bại hoặc có ID trùng
+  */
+ bool parse_json_suite_length(const char *json_content, size_t length, test_case_t **test_cases, int *count,
+                              test_matrix_set_t *matrices);
+ 
  /**
   * @brief Đọc test cases từ file JSON
   * 
@@ -123,6 +366,25 @@
   */
  void free_test_cases(test_case_t *test_cases, int count);
  
+ /**
+  * @brief Ghi một test case thành object JSON qua writer
+  * 
+  * @param writer Writer đích (buffer, FILE* hoặc fd)
+  * @param test_case Test case cần ghi
+  * @return true nếu writer chưa gặp lỗi, false nếu ngược lại
+  */
+ bool test_case_write_json(json_writer_t *writer, const test_case_t *test_case);
+ 
+ /**
+  * @brief Ghi mảng test cases thành {"test_cases": [...]} qua writer
+  * 
+  * @param writer Writer đích (buffer, FILE* hoặc fd)
+  * @param test_cases Mảng test cases
+  * @param count Số lượng test cases
+  * @return true nếu writer chưa gặp lỗi, false nếu ngược lại
+  */
+ bool test_cases_write_json(json_writer_t *writer, const test_case_t *test_cases, int count);
+ 
  /**
   * @brief Chuyển đổi một test case thành chuỗi JSON
   * 
@@ -0,0 +1,231 @@
+ #ifndef RESULT_COMPARE_H
+ #define RESULT_COMPARE_H
+
+ #include <stdbool.h>
+ #include <stddef.h>
+ #include "tc.h"
+ #include "json_writer.h"
+ #include "result_store.h"
+
+ /**
+  * @brief Ngưỡng mặc định khi so sánh với baseline
+  */
+ #define RESULT_COMPARE_DEFAULT_THRESHOLD 10.0   /* % thay đổi trung vị RTT/băng thông */
+ #define RESULT_COMPARE_DEFAULT_LOSS_POINTS 1.0  /* điểm phần trăm mất gói */
+ #define RESULT_COMPARE_DEFAULT_ALPHA 0.05       /* mức ý nghĩa một phía */
+
+ /**
+  * @brief Số mẫu tối thiểu của baseline để kiểm định
+  */
+ #define RESULT_COMPARE_MIN_SAMPLES 3
+
+ /**
+  * @brief Bên của phép so sánh
+  */
+ typedef enum {
+     COMPARE_BASELINE = 0,
+     COMPARE_CURRENT,
+     COMPARE_SIDES
+ } compare_side_t;
+
+ /**
+  * @brief Số đo được so sánh
+  */
+ typedef enum {
+     COMPARE_RTT = 0,        /**< RTT trung bình mỗi lần ping (ms), cao hơn là xấu */
+     COMPARE_LOSS,           /**< Tỷ lệ mất gói ping (%), cao hơn là xấu */
+     COMPARE_BANDWIDTH,      /**< Băng thông throughput (Mbps), thấp hơn là xấu */
+     COMPARE_METRICS
+ } compare_metric_t;
+
+ /**
+  * @brief Kết luận cho một số đo hoặc một test ID
+  */
+ typedef enum {
+     COMPARE_UNCHANGED = 0,  /**< Không có thay đổi đáng kể */
+     COMPARE_IMPROVEMENT,    /**< Tốt hơn có ý nghĩa thống kê */
+     COMPARE_REGRESSION,     /**< Xấu hơn có ý nghĩa thống kê */
+     COMPARE_INSUFFICIENT,   /**< Không đủ mẫu để kiểm định */
+     COMPARE_MISSING,        /**< Có trong baseline, không có trong lần chạy hiện tại */
+     COMPARE_NEW             /**< Chỉ có trong lần chạy hiện tại */
+ } compare_verdict_t;
+
+ /**
+  * @brief Tập mẫu của một số đo
+  */
+ typedef struct {
+     float *values;          /**< Giá trị */
+     int count;              /**< Số mẫu */
+     int capacity;           /**< Dung lượng */
+ } compare_samples_t;
+
+ /**
+  * @brief Mẫu của một test ID ở cả hai bên
+  */
+ typedef struct {
+     char test_id[32];                                       /**< Test ID */
+     long runs[COMPARE_SIDES];                               /**< Số lần chạy */
+     long success[COMPARE_SIDES];                            /**< Số lần thành công */
+     compare_samples_t samples[COMPARE_SIDES][COMPARE_METRICS]; /**< Mẫu theo bên và số đo */
+ } compare_entry_t;
+
+ /**
+  * @brief Thống kê một bên của một số đo
+  */
+ typedef struct {
+     int n;                  /**< Số mẫu */
+     double mean;            /**< Trung bình */
+     double stddev;          /**< Độ lệch chuẩn mẫu */
+     double p50;             /**< Trung vị */
+     double p95;             /**< Phân vị 95 */
+ } compare_stats_t;
+
+ /**
+  * @brief Kết quả so sánh một số đo của một test ID
+  */
+ typedef struct {
+     compare_stats_t side[COMPARE_SIDES];    /**< Thống kê baseline và hiện tại */
+     double delta;                           /**< Trung vị hiện tại - trung vị baseline */
+     double change_pct;                      /**< delta theo % trung vị baseline (NaN nếu baseline = 0) */
+     double p_value;                         /**< p một phía theo hướng thay đổi (NaN nếu không kiểm định) */
+     compare_verdict_t verdict;              /**< Kết luận */
+ } compare_metric_result_t;
+
+ /**
+  * @brief Bộ so sánh kết quả với baseline, ghép theo test ID bằng bảng băm
+  */
+ typedef struct {
+     compare_entry_t *entries;   /**< Các test ID theo thứ tự gặp đầu tiên */
+     int count;                  /**< Số test ID */
+     int capacity;               /**< Dung lượng entries */
+     int *slots;                 /**< Bảng băm địa chỉ mở trên chỉ số entries */
+     int slot_count;             /**< Số ô bảng băm (lũy thừa của 2) */
+     double threshold_pct;       /**< Thay đổi tối thiểu (%) của RTT/băng thông */
+     double loss_points;         /**< Thay đổi tối thiểu (điểm %) của tỷ lệ mất gói */
+     double alpha;               /**< Mức ý nghĩa */
+ } result_compare_t;
+
+ /**
+  * @brief Tổng hợp kết luận của toàn bộ test ID
+  */
+ typedef struct {
+     int counts[COMPARE_NEW + 1];    /**< Số test ID theo kết luận */
+ } compare_summary_t;
+
+ /**
+  * @brief Khởi tạo bộ so sánh với ngưỡng mặc định
+  *
+  * @param cmp Con trỏ đến bộ so sánh
+  */
+ void result_compare_init(result_compare_t *cmp);
+
+ /**
+  * @brief Thêm một kết quả vào một bên
+  *
+  * Kết quả ERROR (không đo được) chỉ được đếm số lần chạy, không góp mẫu.
+  *
+  * @param cmp Con trỏ đến bộ so sánh
+  * @param side Bên baseline hoặc hiện tại
+  * @param result Kết quả test
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int result_compare_add_result(result_compare_t *cmp, compare_side_t side, const test_result_info_t *result);
+
+ /**
+  * @brief Thêm một dòng của kho kết quả lịch sử vào một bên
+  *
+  * @param cmp Con trỏ đến bộ so sánh
+  * @param side Bên baseline hoặc hiện tại
+  * @param row Dòng của kho
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int result_compare_add_row(result_compare_t *cmp, compare_side_t side, const result_store_row_t *row);
+
+ /**
+  * @brief Nạp một bên từ file: kho lịch sử (.rstore) hoặc báo cáo tổng hợp (.json/.json.gz)
+  *
+  * @param cmp Con trỏ đến bộ so sánh
+  * @param side Bên baseline hoặc hiện tại
+  * @param path Đường dẫn file, loại file được nhận biết theo magic
+  * @param filter Điều kiện lọc khi đọc kho lịch sử (NULL = tất cả)
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int result_compare_load(result_compare_t *cmp, compare_side_t side, const char *path,
+                         const result_store_filter_t *filter);
+
+ /**
+  * @brief So sánh một số đo của một test ID
+  *
+  * Khi cả hai bên có từ RESULT_COMPARE_MIN_SAMPLES mẫu dùng kiểm định
+  * Mann-Whitney; khi chỉ baseline đủ mẫu (thường là một lần chạy so với lịch
+  * sử) dùng z-score của trung bình hiện tại so với phân bố baseline. Chỉ kết
+  * luận hồi quy khi vừa có ý nghĩa thống kê vừa vượt ngưỡng thay đổi.
+  *
+  * @param cmp Con trỏ đến bộ so sánh
+  * @param entry Test ID cần so sánh
+  * @param metric Số đo
+  * @param out Con trỏ lưu kết quả
+  * @return bool false nếu không bên nào có mẫu của số đo này
+  */
+ bool result_compare_metric(const result_compare_t *cmp, const compare_entry_t *entry,
+                            compare_metric_t metric, compare_metric_result_t *out);
+
+ /**
+  * @brief Kết luận chung của một test ID (hồi quy nếu có số đo hồi quy)
+  *
+  * @param cmp Con trỏ đến bộ so sánh
+  * @param entry Test ID
+  * @return compare_verdict_t Kết luận
+  */
+ compare_verdict_t result_compare_entry_verdict(const result_compare_t *cmp, const compare_entry_t *entry);
+
+ /**
+  * @brief Tìm test ID trong bộ so sánh
+  *
+  * @param cmp Con trỏ đến bộ so sánh
+  * @param test_id Test ID
+  * @return const compare_entry_t* NULL nếu không có
+  */
+ const compare_entry_t *result_compare_find(const result_compare_t *cmp, const char *test_id);
+
+ /**
+  * @brief Chuyển kết luận thành chuỗi dùng trong diff JSON
+  *
+  * @param verdict Kết luận
+  * @return const char* Chuỗi ("regression", "improvement", ...)
+  */
+ const char *compare_verdict_to_string(compare_verdict_t verdict);
+
+ /**
+  * @brief Ghi diff dạng JSON: ngưỡng, tổng hợp và số liệu từng test ID
+  *
+  * @param cmp Con trỏ đến bộ so sánh
+  * @param writer Writer đích
+  * @param baseline_label Nguồn baseline (đường dẫn)
+  * @param current_label Nguồn hiện tại
+  * @param summary Con trỏ lưu tổng hợp kết luận (có thể NULL)
+  */
+ void result_compare_write_json(const result_compare_t *cmp, json_writer_t *writer, const char *baseline_label,
+                                const char *current_label, compare_summary_t *summary);
+
+ /**
+  * @brief Ghi diff ra file
+  *
+  * @param cmp Con trỏ đến bộ so sánh
+  * @param path Đường dẫn file diff
+  * @param baseline_label Nguồn baseline
+  * @param current_label Nguồn hiện tại
+  * @param summary Con trỏ lưu tổng hợp kết luận (có thể NULL)
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int result_compare_write_file(const result_compare_t *cmp, const char *path, const char *baseline_label,
+                               const char *current_label, compare_summary_t *summary);
+
+ /**
+  * @brief Giải phóng bộ so sánh
+  *
+  * @param cmp Con trỏ đến bộ so sánh
+  */
+ void result_compare_free(result_compare_t *cmp);
+
+ #endif /* RESULT_COMPARE_H */
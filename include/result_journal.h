@@ -0,0 +1,125 @@
+ #ifndef RESULT_JOURNAL_H
+ #define RESULT_JOURNAL_H
+
+ #include <stdbool.h>
+ #include <time.h>
+ #include "tc.h"
+ #include "json_writer.h"
+
+ /**
+  * @brief Đường dẫn mặc định của journal kết quả
+  */
+ #define RESULT_JOURNAL_DEFAULT_PATH "results/journal.ndjson"
+
+ /**
+  * @brief Số bản ghi tối đa giữa hai lần fdatasync
+  */
+ #define RESULT_JOURNAL_SYNC_RECORDS 16
+
+ /**
+  * @brief Khoảng thời gian tối đa giữa hai lần fdatasync (ms)
+  */
+ #define RESULT_JOURNAL_SYNC_INTERVAL_MS 5000
+
+ /**
+  * @brief Journal kết quả dạng NDJSON (mỗi dòng một test_result_info_t)
+  *
+  * Mỗi bản ghi được dựng trong buffer dùng lại rồi ghi bằng một lệnh write()
+  * với O_APPEND ngay khi test hoàn thành, nên phía PC đọc được ngay và một
+  * lần crash chỉ có thể làm hỏng dòng cuối. fdatasync được gọi định kỳ theo
+  * số bản ghi và thời gian thay vì sau mỗi dòng.
+  */
+ typedef struct {
+     int fd;                         /**< File descriptor của journal (-1 nếu chưa mở) */
+     json_writer_t line;             /**< Buffer dựng một dòng JSON */
+     int unsynced;                   /**< Số bản ghi chưa fdatasync */
+     struct timespec last_sync;      /**< Thời điểm fdatasync gần nhất */
+ } result_journal_t;
+
+ /**
+  * @brief Các bản ghi đọc lại từ journal
+  */
+ typedef struct {
+     test_result_info_t *results;    /**< Kết quả theo thứ tự ghi */
+     int count;                      /**< Số kết quả */
+     int *order;                     /**< Vị trí kết quả sắp xếp theo test_id (để tìm kiếm nhị phân) */
+ } result_journal_records_t;
+
+ /**
+  * @brief Mở journal để ghi
+  *
+  * Khi nối tiếp, dòng cuối bị cắt dở (do lần chạy trước bị dừng giữa chừng)
+  * được loại bỏ trước khi ghi tiếp.
+  *
+  * @param journal Con trỏ đến journal
+  * @param path Đường dẫn file journal
+  * @param append true để ghi tiếp vào journal cũ, false để tạo journal mới
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int result_journal_open(result_journal_t *journal, const char *path, bool append);
+
+ /**
+  * @brief Ghi một kết quả vào journal
+  *
+  * @param journal Con trỏ đến journal
+  * @param result Kết quả vừa hoàn thành
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int result_journal_append(result_journal_t *journal, const test_result_info_t *result);
+
+ /**
+  * @brief Đẩy journal xuống đĩa (fdatasync)
+  *
+  * @param journal Con trỏ đến journal
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int result_journal_sync(result_journal_t *journal);
+
+ /**
+  * @brief Đồng bộ và đóng journal
+  *
+  * @param journal Con trỏ đến journal
+  */
+ void result_journal_close(result_journal_t *journal);
+
+ /**
+  * @brief Đọc lại toàn bộ journal
+  *
+  * Dòng không hợp lệ (ví dụ dòng cuối bị cắt dở) được bỏ qua. File không tồn
+  * tại được coi là journal rỗng.
+  *
+  * @param path Đường dẫn file journal
+  * @param records Con trỏ lưu các bản ghi
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int result_journal_load(const char *path, result_journal_records_t *records);
+
+ /**
+  * @brief Đọc kết quả từ một báo cáo tổng hợp (JSON thường hoặc nén gzip)
+  *
+  * Mỗi phần tử test_results có cùng định dạng với một dòng journal nên báo
+  * cáo cũ được đọc lại thành các bản ghi như journal (ví dụ làm baseline).
+  *
+  * @param path Đường dẫn báo cáo (summary_*.json hoặc summary_*.json.gz)
+  * @param records Con trỏ lưu các bản ghi (giải phóng bằng result_journal_records_free)
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int result_journal_load_report(const char *path, result_journal_records_t *records);
+
+ /**
+  * @brief Tìm kết quả của một test ID trong các bản ghi đã đọc
+  *
+  * @param records Các bản ghi
+  * @param test_id ID cần tìm
+  * @return const test_result_info_t* Kết quả ghi sau cùng của test ID, NULL nếu không có
+  */
+ const test_result_info_t *result_journal_find(const result_journal_records_t *records, const char *test_id);
+
+ /**
+  * @brief Giải phóng các bản ghi đã đọc
+  *
+  * @param records Các bản ghi
+  */
+ void result_journal_records_free(result_journal_records_t *records);
+
+ #endif /* RESULT_JOURNAL_H */
@@ -0,0 +1,170 @@
+ #ifndef RESULT_STORE_H
+ #define RESULT_STORE_H
+
+ #include <stdbool.h>
+ #include <stddef.h>
+ #include <stdint.h>
+ #include "tc.h"
+
+ /**
+  * @brief Đường dẫn mặc định của kho kết quả lịch sử
+  */
+ #define RESULT_STORE_DEFAULT_PATH "results/history.rstore"
+
+ /**
+  * @brief Magic và phiên bản định dạng kho kết quả
+  */
+ #define RESULT_STORE_MAGIC 0x53524454u    /* "TDRS" */
+ #define RESULT_STORE_SEGMENT_MAGIC 0x31474553u  /* "SEG1" */
+ #define RESULT_STORE_VERSION 1
+
+ /**
+  * @brief Header đầu file kho kết quả
+  */
+ typedef struct {
+     uint32_t magic;             /**< RESULT_STORE_MAGIC */
+     uint32_t version;           /**< RESULT_STORE_VERSION */
+     uint64_t reserved;          /**< Dành cho mở rộng, luôn 0 */
+ } result_store_header_t;
+
+ /**
+  * @brief Header của một segment (một lần ghi, thường là một lần chạy)
+  *
+  * Sau header là bảng offset của từ điển test ID (đã sắp xếp), bảng chuỗi,
+  * rồi các cột có độ rộng cố định theo thứ tự: timestamp (int64), test_index
+  * (uint32), execution_time, min_rtt, avg_rtt, max_rtt, packet_loss,
+  * bandwidth (float), status, kind (uint8). Mỗi phần được đệm về bội số của 8
+  * byte nên đọc trực tiếp được từ vùng mmap. Số đo không áp dụng cho loại
+  * test được lưu là NaN.
+  */
+ typedef struct {
+     uint32_t magic;             /**< RESULT_STORE_SEGMENT_MAGIC */
+     uint32_t row_count;         /**< Số dòng */
+     uint32_t dict_count;        /**< Số test ID trong từ điển */
+     uint32_t dict_bytes;        /**< Kích thước bảng chuỗi của từ điển */
+     int64_t min_timestamp;      /**< Timestamp nhỏ nhất (ms kể từ epoch) */
+     int64_t max_timestamp;      /**< Timestamp lớn nhất (ms kể từ epoch) */
+     uint64_t segment_size;      /**< Tổng kích thước segment kể cả header */
+ } result_store_segment_t;
+
+ /**
+  * @brief Kho kết quả đã mở để đọc (mmap chỉ đọc)
+  */
+ typedef struct {
+     const uint8_t *data;        /**< Vùng mmap */
+     size_t size;                /**< Kích thước vùng mmap */
+ } result_store_t;
+
+ /**
+  * @brief Điều kiện lọc khi truy vấn
+  */
+ typedef struct {
+     const char *test_id;        /**< Chỉ lấy test ID này (NULL = tất cả) */
+     int64_t from_ms;            /**< Từ thời điểm (ms kể từ epoch, 0 = không giới hạn) */
+     int64_t to_ms;              /**< Đến thời điểm, tính cả mốc này (0 = không giới hạn) */
+ } result_store_filter_t;
+
+ /**
+  * @brief Số liệu tổng hợp của một test ID
+  */
+ typedef struct {
+     char test_id[32];           /**< Test ID */
+     long runs;                  /**< Số lần chạy */
+     long success;               /**< Số lần thành công */
+     int64_t first_ms;           /**< Lần chạy đầu tiên */
+     int64_t last_ms;            /**< Lần chạy cuối cùng */
+     double time_sum;            /**< Tổng thời gian thực thi (ms) */
+     long rtt_count;             /**< Số lần có số đo RTT (ping nhận được ít nhất một gói) */
+     double rtt_sum;             /**< Tổng RTT trung bình (ms) */
+     float rtt_min;              /**< RTT nhỏ nhất (ms) */
+     float rtt_max;              /**< RTT lớn nhất (ms) */
+     long loss_count;            /**< Số lần có số đo mất gói */
+     double loss_sum;            /**< Tổng tỷ lệ mất gói (%) */
+     long bandwidth_count;       /**< Số lần có số đo băng thông */
+     double bandwidth_sum;       /**< Tổng băng thông (Mbps) */
+ } result_store_group_t;
+
+ /**
+  * @brief Một dòng của kho khi duyệt bằng result_store_scan
+  */
+ typedef struct {
+     const char *test_id;            /**< Test ID (trỏ vào vùng mmap, hợp lệ tới khi đóng kho) */
+     int64_t timestamp;              /**< Thời điểm chạy (ms kể từ epoch) */
+     test_result_status_t status;    /**< Trạng thái */
+     test_type_t test_type;          /**< Loại test */
+     bool is_sweep;                  /**< Kết quả quét dải địa chỉ */
+     float execution_time;           /**< Thời gian thực thi (ms) */
+     float min_rtt;                  /**< RTT nhỏ nhất (ms), NaN nếu không có */
+     float avg_rtt;                  /**< RTT trung bình (ms), NaN nếu không có */
+     float max_rtt;                  /**< RTT lớn nhất (ms), NaN nếu không có */
+     float packet_loss;              /**< Tỷ lệ mất gói (%), NaN nếu không có */
+     float bandwidth;                /**< Băng thông (Mbps), NaN nếu không có */
+ } result_store_row_t;
+
+ /**
+  * @brief Hàm nhận từng dòng khi duyệt kho
+  *
+  * @return int 0 để tiếp tục, khác 0 để dừng duyệt và báo lỗi
+  */
+ typedef int (*result_store_row_cb)(const result_store_row_t *row, void *context);
+
+ /**
+  * @brief Ghi thêm một segment chứa các kết quả vào cuối kho
+  *
+  * Segment được dựng trong bộ nhớ rồi ghi bằng một lần write() với O_APPEND;
+  * segment cuối bị cắt dở (crash giữa chừng) được bỏ qua khi đọc.
+  *
+  * @param path Đường dẫn kho kết quả (tạo mới nếu chưa có)
+  * @param results Mảng kết quả
+  * @param count Số kết quả
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int result_store_append(const char *path, const test_result_info_t *results, int count);
+
+ /**
+  * @brief Mở kho kết quả để đọc bằng mmap
+  *
+  * @param store Con trỏ đến kho
+  * @param path Đường dẫn kho kết quả
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int result_store_open(result_store_t *store, const char *path);
+
+ /**
+  * @brief Đóng kho kết quả
+  *
+  * @param store Con trỏ đến kho
+  */
+ void result_store_close(result_store_t *store);
+
+ /**
+  * @brief Lọc và tổng hợp số liệu theo test ID mà không cần parse JSON
+  *
+  * Segment nằm ngoài khoảng thời gian hoặc không chứa test ID cần tìm được
+  * bỏ qua chỉ nhờ header và từ điển; các cột chỉ được đọc khi cần.
+  *
+  * @param store Kho đã mở
+  * @param filter Điều kiện lọc (NULL = tất cả)
+  * @param groups Con trỏ lưu mảng kết quả tổng hợp (người gọi free), theo thứ tự gặp đầu tiên
+  * @param group_count Con trỏ lưu số nhóm
+  * @return long Số dòng khớp điều kiện, -1 nếu lỗi
+  */
+ long result_store_query(const result_store_t *store, const result_store_filter_t *filter,
+                         result_store_group_t **groups, int *group_count);
+
+ /**
+  * @brief Duyệt từng dòng khớp điều kiện lọc theo thứ tự ghi
+  *
+  * Dùng cùng cách bỏ qua segment như result_store_query nhưng trả về số
+  * liệu từng lần chạy (ví dụ để tính phân vị khi so sánh với baseline).
+  *
+  * @param store Kho đã mở
+  * @param filter Điều kiện lọc (NULL = tất cả)
+  * @param callback Hàm nhận từng dòng
+  * @param context Tham số truyền cho callback
+  * @return long Số dòng đã duyệt, -1 nếu lỗi hoặc callback dừng duyệt
+  */
+ long result_store_scan(const result_store_t *store, const result_store_filter_t *filter,
+                        result_store_row_cb callback, void *context);
+
+ #endif /* RESULT_STORE_H */
@@ -0,0 +1,95 @@
+ #ifndef STRING_POOL_H
+ #define STRING_POOL_H
+
+ #include <stddef.h>
+ #include <stdint.h>
+
+ /**
+  * @brief Tham chiếu đến một chuỗi trong string pool (offset tính từ đầu bảng chuỗi)
+  *
+  * Giá trị 0 nghĩa là "không có chuỗi". Mỗi chuỗi trong bảng được lưu dạng
+  * [uint32_t độ dài][các byte][\0], căn lề 4 byte, và offset trỏ vào byte đầu
+  * tiên của chuỗi nên strtab + offset luôn là một C string hợp lệ.
+  */
+ typedef uint32_t str_ref_t;
+
+ /**
+  * @brief String pool có intern: các chuỗi giống nhau chỉ được lưu một lần
+  */
+ typedef struct {
+     char *data;            /**< Bảng chuỗi */
+     size_t size;           /**< Số byte đã dùng */
+     size_t capacity;       /**< Dung lượng của data */
+     uint32_t *slots;       /**< Bảng băm intern (open addressing, lưu offset) */
+     size_t slot_count;     /**< Số slot (lũy thừa của 2) */
+     size_t used;           /**< Số chuỗi đã intern */
+ } string_pool_t;
+
+ /**
+  * @brief Khởi tạo string pool
+  *
+  * @param pool Con trỏ đến pool
+  * @param initial_capacity Dung lượng ban đầu (byte), 0 để dùng mặc định
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int string_pool_init(string_pool_t *pool, size_t initial_capacity);
+
+ /**
+  * @brief Intern một chuỗi có độ dài cho trước
+  *
+  * @param pool Con trỏ đến pool
+  * @param str Chuỗi cần intern (không cần kết thúc bằng '\0')
+  * @param len Độ dài chuỗi
+  * @return str_ref_t Offset của chuỗi, 0 nếu thất bại
+  */
+ str_ref_t string_pool_intern_n(string_pool_t *pool, const char *str, size_t len);
+
+ /**
+  * @brief Intern một C string (NULL được coi là chuỗi rỗng)
+  *
+  * @param pool Con trỏ đến pool
+  * @param str Chuỗi cần intern
+  * @return str_ref_t Offset của chuỗi, 0 nếu thất bại
+  */
+ str_ref_t string_pool_intern(string_pool_t *pool, const char *str);
+
+ /**
+  * @brief Xóa toàn bộ chuỗi nhưng giữ lại bộ nhớ để dùng tiếp
+  *
+  * @param pool Con trỏ đến pool
+  */
+ void string_pool_reset(string_pool_t *pool);
+ 
+ /**
+  * @brief Lấy bảng chuỗi ra khỏi pool, người gọi chịu trách nhiệm free()
+  *
+  * Sau lời gọi này pool trở về trạng thái rỗng (bảng intern bị giải phóng).
+  *
+  * @param pool Con trỏ đến pool
+  * @param size Con trỏ lưu kích thước bảng chuỗi (có thể NULL)
+  * @return char* Bảng chuỗi
+  */
+ char *string_pool_release(string_pool_t *pool, size_t *size);
+
+ /**
+  * @brief Giải phóng toàn bộ pool
+  *
+  * @param pool Con trỏ đến pool
+  */
+ void string_pool_free(string_pool_t *pool);
+
+ /**
+  * @brief Lấy chuỗi từ bảng chuỗi
+  */
+ static inline const char *strtab_get(const char *strtab, str_ref_t ref) {
+     return (strtab && ref) ? strtab + ref : "";
+ }
+
+ /**
+  * @brief Lấy độ dài chuỗi từ bảng chuỗi (không cần strlen)
+  */
+ static inline uint32_t strtab_len(const char *strtab, str_ref_t ref) {
+     return (strtab && ref) ? *(const uint32_t *)(strtab + ref - sizeof(uint32_t)) : 0;
+ }
+
+ #endif /* STRING_POOL_H */
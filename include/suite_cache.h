@@ -0,0 +1,124 @@
+ #ifndef SUITE_CACHE_H
+ #define SUITE_CACHE_H
+
+ #include <stdbool.h>
+ #include <stddef.h>
+ #include <stdint.h>
+ #include "parser_data.h"
+
+ /**
+  * @brief Phần mở rộng của file cache, đặt cạnh file config (config.json -> config.json.cache)
+  */
+ #define SUITE_CACHE_SUFFIX ".cache"
+
+ /**
+  * @brief Phiên bản định dạng cache, tăng khi bố cục test_case_t hoặc header thay đổi,
+  *        hoặc khi parser từ chối thêm trường hợp (cache cũ bỏ qua bước kiểm tra đó)
+  */
+ #define SUITE_CACHE_VERSION 4
+
+ /**
+  * @brief Header của file cache nhị phân
+  *
+  * Bố cục file: [header][count bản ghi test_case_t][bảng chuỗi]
+  * [matrix_count bản ghi test_matrix_t][giá trị trục][bảng chuỗi matrix].
+  * Bản ghi chỉ chứa offset vào bảng chuỗi nên được sao chép nguyên khối, chỉ
+  * cần gắn lại con trỏ strtab.
+  * Cache chỉ hợp lệ khi kích thước và mtime (hoặc hash nội dung) của file
+  * config khớp với giá trị lưu trong header.
+  */
+ typedef struct {
+     char magic[4];               /**< "TDSC" */
+     uint32_t version;            /**< SUITE_CACHE_VERSION */
+     uint32_t record_size;        /**< sizeof(test_case_t) lúc ghi */
+     uint32_t count;              /**< Số lượng test cases */
+     uint64_t source_size;        /**< Kích thước file config */
+     int64_t source_mtime_sec;    /**< mtime của file config (giây) */
+     int64_t source_mtime_nsec;   /**< mtime của file config (nano giây) */
+     uint64_t source_hash;        /**< FNV-1a 64 bit của nội dung file config */
+     uint64_t strtab_size;        /**< Kích thước bảng chuỗi */
+     uint32_t matrix_count;       /**< Số lượng test matrix */
+     uint32_t matrix_record_size; /**< sizeof(test_matrix_t) lúc ghi */
+     uint64_t axis_value_count;   /**< Số giá trị trục của các matrix */
+     uint64_t matrix_strtab_size; /**< Kích thước bảng chuỗi của các matrix */
+ } suite_cache_header_t;
+
+ /**
+  * @brief Tạo đường dẫn file cache tương ứng với file config
+  *
+  * @param config_file Đường dẫn file config JSON
+  * @param cache_path Buffer lưu đường dẫn cache
+  * @param path_size Kích thước buffer
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int suite_cache_path(const char *config_file, char *cache_path, size_t path_size);
+
+ /**
+  * @brief Tính hash FNV-1a 64 bit của một vùng nhớ
+  *
+  * @param data Dữ liệu cần hash
+  * @param size Kích thước dữ liệu
+  * @return uint64_t Giá trị hash
+  */
+ uint64_t suite_cache_hash(const void *data, size_t size);
+
+ /**
+  * @brief Nạp test cases từ file cache nếu cache còn hợp lệ
+  *
+  * @param config_file Đường dẫn file config JSON
+  * @param test_cases Con trỏ đến mảng test cases (giải phóng bằng free_test_cases)
+  * @param count Con trỏ đến biến lưu số lượng test cases
+  * @param matrices Tập matrix nhận kết quả (NULL nếu không dùng matrix)
+  * @return true nếu cache hợp lệ và nạp thành công, false nếu không có cache/cache cũ
+  */
+ bool suite_cache_load(const char *config_file, test_case_t **test_cases, int *count,
+                       test_matrix_set_t *matrices);
+
+ /**
+  * @brief Ghi mảng test cases ra file cache cho file config
+  *
+  * File được ghi ra file tạm rồi rename nên tiến trình khác không bao giờ
+  * thấy cache ghi dở.
+  *
+  * @param config_file Đường dẫn file config JSON
+  * @param json_content Nội dung file config đã dùng để parse
+  * @param content_size Kích thước nội dung
+  * @param test_cases Mảng test cases đã parse
+  * @param count Số lượng test cases
+  * @param matrices Tập matrix đã parse (có thể NULL)
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int suite_cache_store(const char *config_file, const char *json_content, size_t content_size,
+                       const test_case_t *test_cases, int count, const test_matrix_set_t *matrices);
+
+ /**
+  * @brief Xóa file cache của file config (nếu có)
+  *
+  * @param config_file Đường dẫn file config JSON
+  * @return int 0 nếu thành công hoặc không có cache, -1 nếu thất bại
+  */
+ int suite_cache_invalidate(const char *config_file);
+
+ /**
+  * @brief Đọc test cases, ưu tiên cache nhị phân và chỉ parse JSON khi cache không hợp lệ
+  *
+  * @param config_file Đường dẫn file config JSON
+  * @param test_cases Con trỏ đến mảng test cases
+  * @param count Con trỏ đến biến lưu số lượng test cases
+  * @param matrices Tập matrix nhận kết quả (NULL để bỏ qua "matrices")
+  * @return true nếu thành công, false nếu thất bại
+  */
+ bool read_test_cases_cached(const char *config_file, test_case_t **test_cases, int *count,
+                             test_matrix_set_t *matrices);
+ 
+ /**
+  * @brief Đọc test cases như read_test_cases_cached, chọn cách đọc file config
+  *
+  * @param view_flags Tùy chọn file_view_open_ex cho file config (FILE_VIEW_COPY khi
+  *                   file có thể bị sửa trong lúc đọc, ví dụ khi nạp lại ở chế độ --watch)
+  * @return true nếu thành công, false nếu thất bại
+  */
+ bool read_test_cases_cached_ex(const char *config_file, test_case_t **test_cases, int *count,
+                                test_matrix_set_t *matrices, int view_flags);
+
+ #endif /* SUITE_CACHE_H */
@@ -0,0 +1,80 @@
+ #ifndef SUITE_WATCH_H
+ #define SUITE_WATCH_H
+
+ #include <stdbool.h>
+ #include "parser_data.h"
+
+ /**
+  * @brief Theo dõi thay đổi của file config bằng inotify
+  *
+  * Theo dõi thư mục chứa file chứ không theo dõi chính file, vì trình soạn
+  * thảo thường ghi ra file tạm rồi rename đè lên file config.
+  */
+ typedef struct {
+     int fd;                     /**< File descriptor của inotify */
+     int wd;                     /**< Watch descriptor của thư mục */
+     char name[256];             /**< Tên file config trong thư mục */
+ } suite_watch_t;
+
+ /**
+  * @brief Kết quả so sánh hai phiên bản test suite theo ID và hash nội dung
+  */
+ typedef struct {
+     int *added;                 /**< Vị trí trong suite mới của test case được thêm */
+     int added_count;            /**< Số test case được thêm */
+     int *changed;               /**< Vị trí trong suite mới của test case bị sửa */
+     int changed_count;          /**< Số test case bị sửa */
+     int *removed;               /**< Vị trí trong suite cũ của test case bị xóa */
+     int removed_count;          /**< Số test case bị xóa */
+     int *old_to_new;            /**< Vị trí mới của từng test case cũ (-1 nếu bị xóa) */
+     int unchanged_count;        /**< Số test case không đổi */
+ } suite_diff_t;
+
+ /**
+  * @brief Bắt đầu theo dõi file config
+  *
+  * @param watch Con trỏ đến watcher
+  * @param config_file Đường dẫn file config
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int suite_watch_init(suite_watch_t *watch, const char *config_file);
+
+ /**
+  * @brief Chờ file config thay đổi
+  *
+  * Các sự kiện liên tiếp (ghi nhiều lần, rename) được gộp thành một lần báo.
+  *
+  * @param watch Con trỏ đến watcher
+  * @param timeout_ms Thời gian chờ tối đa (0 để chỉ kiểm tra, -1 để chờ mãi)
+  * @return int 1 nếu file đã thay đổi, 0 nếu hết thời gian chờ, -1 nếu lỗi
+  */
+ int suite_watch_wait(suite_watch_t *watch, int timeout_ms);
+
+ /**
+  * @brief Dừng theo dõi
+  *
+  * @param watch Con trỏ đến watcher
+  */
+ void suite_watch_close(suite_watch_t *watch);
+
+ /**
+  * @brief So sánh suite đang chạy với suite vừa nạp lại
+  *
+  * @param old_cases Mảng test cases đang chạy
+  * @param old_count Số lượng test cases đang chạy
+  * @param new_cases Mảng test cases mới
+  * @param new_count Số lượng test cases mới
+  * @param diff Con trỏ lưu kết quả (giải phóng bằng suite_diff_free)
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int suite_diff_compute(const test_case_t *old_cases, int old_count,
+                        const test_case_t *new_cases, int new_count, suite_diff_t *diff);
+
+ /**
+  * @brief Giải phóng kết quả so sánh
+  *
+  * @param diff Con trỏ đến kết quả so sánh
+  */
+ void suite_diff_free(suite_diff_t *diff);
+
+ #endif /* SUITE_WATCH_H */
@@ -0,0 +1,75 @@
+ #ifndef TARGET_RANGE_H
+ #define TARGET_RANGE_H
+
+ #include <stdbool.h>
+ #include <stddef.h>
+ #include <stdint.h>
+
+ /**
+  * @brief Số host tối đa của một dải đích (tương đương /16)
+  */
+ #define TARGET_RANGE_MAX_HOSTS 65536
+
+ /**
+  * @brief Dải địa chỉ IPv4 liên tục (thứ tự byte của host)
+  */
+ typedef struct {
+     uint32_t first;        /**< Địa chỉ đầu tiên */
+     uint32_t last;         /**< Địa chỉ cuối cùng (bao gồm) */
+ } target_range_t;
+
+ /**
+  * @brief Bộ duyệt địa chỉ của một dải, địa chỉ được sinh ra khi cần
+  */
+ typedef struct {
+     target_range_t range;  /**< Dải đang duyệt */
+     uint64_t position;     /**< Số địa chỉ đã trả về */
+ } target_range_iter_t;
+
+ /**
+  * @brief Phân tích target dạng CIDR hoặc dải địa chỉ
+  *
+  * Chấp nhận "10.0.0.0/22" (bỏ địa chỉ network và broadcast nếu prefix < 31),
+  * "10.0.0.1-10.0.0.50" và dạng rút gọn "10.0.0.1-50".
+  *
+  * @param target Chuỗi target
+  * @param range Con trỏ lưu dải địa chỉ
+  * @return int 1 nếu là dải hợp lệ, 0 nếu là một host đơn, -1 nếu dải không hợp lệ
+  */
+ int target_range_parse(const char *target, target_range_t *range);
+
+ /**
+  * @brief Số địa chỉ trong dải
+  */
+ static inline uint64_t target_range_size(const target_range_t *range) {
+     return (uint64_t)range->last - range->first + 1;
+ }
+
+ /**
+  * @brief Khởi tạo bộ duyệt cho dải địa chỉ
+  *
+  * @param iter Con trỏ đến bộ duyệt
+  * @param range Dải địa chỉ
+  */
+ void target_range_iter_init(target_range_iter_t *iter, const target_range_t *range);
+
+ /**
+  * @brief Lấy địa chỉ kế tiếp
+  *
+  * @param iter Con trỏ đến bộ duyệt
+  * @param address Con trỏ lưu địa chỉ (thứ tự byte của host)
+  * @return true nếu còn địa chỉ, false nếu đã duyệt hết
+  */
+ bool target_range_iter_next(target_range_iter_t *iter, uint32_t *address);
+
+ /**
+  * @brief Chuyển địa chỉ sang dạng chuỗi a.b.c.d
+  *
+  * @param address Địa chỉ (thứ tự byte của host)
+  * @param buffer Buffer lưu chuỗi (tối thiểu 16 byte)
+  * @param buffer_size Kích thước buffer
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int target_range_format(uint32_t address, char *buffer, size_t buffer_size);
+
+ #endif /* TARGET_RANGE_H */
@@ -0,0 +1,69 @@
+ #ifndef TARGET_RESOLVE_H
+ #define TARGET_RESOLVE_H
+
+ #include <stdbool.h>
+ #include <time.h>
+ #include <netinet/in.h>
+ #include <sys/socket.h>
+ #include "parser_data.h"
+
+ /**
+  * @brief Thời gian sống mặc định của một địa chỉ đã phân giải (giây)
+  */
+ #define RESOLVE_DEFAULT_TTL 300
+
+ /**
+  * @brief Số luồng phân giải tối đa khi nạp suite
+  */
+ #define RESOLVE_MAX_WORKERS 8
+
+ /**
+  * @brief Địa chỉ đã phân giải của một target
+  *
+  * sockaddr không nằm trong test_case_t (giữ struct trong một cache line) mà
+  * nằm trong bảng cache của module, khóa theo tên target và họ địa chỉ.
+  */
+ typedef struct {
+     struct sockaddr_storage addr;       /**< Địa chỉ đã phân giải */
+     socklen_t addr_len;                 /**< Độ dài địa chỉ */
+     char address[INET6_ADDRSTRLEN];     /**< Địa chỉ dạng chuỗi, truyền cho lệnh ping */
+     float dns_time;                     /**< Thời gian phân giải (ms), 0 nếu target là địa chỉ IP hoặc lấy từ cache */
+     time_t resolved_at;                 /**< Thời điểm phân giải */
+     bool cached;                        /**< Lấy từ cache, không phân giải lại ở lần gọi này */
+ } resolved_target_t;
+
+ /**
+  * @brief Phân giải trước toàn bộ target của suite bằng một nhóm luồng giới hạn
+  *
+  * Mỗi target chỉ được phân giải một lần dù nhiều test case dùng chung; target
+  * dạng CIDR/range và địa chỉ IP được bỏ qua.
+  *
+  * @param test_cases Mảng test cases
+  * @param count Số lượng test cases
+  * @return int Số target không phân giải được, -1 nếu lỗi
+  */
+ int target_resolve_prefetch(const test_case_t *test_cases, int count);
+
+ /**
+  * @brief Lấy địa chỉ của target, phân giải lại nếu chưa có hoặc đã quá TTL
+  *
+  * @param target Tên host hoặc địa chỉ IP
+  * @param ipv6 Phân giải địa chỉ IPv6 thay vì IPv4
+  * @param resolved Con trỏ lưu kết quả
+  * @return int 0 nếu thành công, -1 nếu không phân giải được
+  */
+ int target_resolve(const char *target, bool ipv6, resolved_target_t *resolved);
+
+ /**
+  * @brief Đặt TTL cho các địa chỉ đã phân giải
+  *
+  * @param seconds TTL tính bằng giây (0 để luôn phân giải lại)
+  */
+ void target_resolve_set_ttl(int seconds);
+
+ /**
+  * @brief Xóa toàn bộ cache phân giải
+  */
+ void target_resolve_clear(void);
+
+ #endif /* TARGET_RESOLVE_H */
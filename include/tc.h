@@ -3,6 +3,7 @@
  #define TC_H
  
  #include "parser_data.h"  // Để sử dụng cấu trúc test_case_t
+ #include "string_pool.h"  // Để sử dụng str_ref_t
  
  /**
   * @brief Trạng thái kết quả test
@@ -14,6 +15,30 @@
      TEST_RESULT_ERROR     /**< Lỗi khi thực thi test */
  } test_result_status_t;
  
+ /**
+  * @brief Loại chi tiết của kết quả test
+  * 
+  * Kết quả chỉ lưu mã này cùng các số liệu dạng số; chuỗi mô tả được dựng
+  * khi cần bởi test_result_format_details.
+  */
+ typedef enum {
+     RESULT_REASON_NONE,           /**< Không có chi tiết */
+     RESULT_REASON_TEXT,           /**< Chi tiết dạng text lưu nguyên trong message (ví dụ đọc lại từ journal) */
+     RESULT_REASON_EMPTY_TARGET,   /**< Target rỗng */
+     RESULT_REASON_INVALID_RANGE,  /**< Dải địa chỉ không hợp lệ */
+     RESULT_REASON_RESOLVE_FAILED, /**< Không phân giải được target */
+     RESULT_REASON_EXEC_FAILED,    /**< Không chạy được lệnh ping (message là mô tả lỗi hệ thống) */
+     RESULT_REASON_PING_TIMEOUT,   /**< Ping bị timeout */
+     RESULT_REASON_PING_DONE,      /**< Ping hoàn tất, dùng data.ping */
+     RESULT_REASON_PING_ALL_LOST,  /**< Mất toàn bộ gói */
+     RESULT_REASON_NO_OUTPUT,      /**< Lệnh ping không có output */
+     RESULT_REASON_ABNORMAL_EXIT,  /**< Lệnh ping không kết thúc đúng cách */
+     RESULT_REASON_SWEEP,          /**< Quét dải địa chỉ, dùng data.sweep (message là danh sách host lỗi) */
+     RESULT_REASON_DISABLED,       /**< Test case bị tắt */
+     RESULT_REASON_UNSUPPORTED,    /**< Loại test chưa được hỗ trợ */
+     RESULT_REASON_WRONG_NETWORK   /**< Test case không dành cho loại mạng này */
+ } test_result_reason_t;
+ 
  /**
   * @brief Kết quả chi tiết cho ping test
   */
@@ -26,6 +51,14 @@
      float packet_loss;     /**< Tỷ lệ mất gói (%) */
  } ping_result_t;
  
+ /**
+  * @brief Kết quả tổng hợp cho ping test trên một dải địa chỉ (CIDR hoặc range)
+  */
+ typedef struct {
+     int hosts_total;       /**< Số host đã thăm dò */
+     int hosts_reachable;   /**< Số host trả lời */
+ } ping_sweep_result_t;
+ 
  /**
   * @brief Kết quả chi tiết cho throughput test
   */
@@ -42,7 +75,7 @@
  typedef struct {
      bool passed;           /**< Test bảo mật qua */
      int vulnerabilities;   /**< Số lỗ hổng tìm thấy */
-     char vuln_details[256];/**< Chi tiết về lỗ hổng */
+     str_ref_t vuln_details;/**< Chi tiết về lỗ hổng trong bảng chuỗi kết quả, 0 nếu không có */
  } security_result_t;
  
  /**
@@ -52,19 +85,33 @@
      char test_id[32];               /**< ID của test case */
      test_type_t test_type;          /**< Loại test */
      test_result_status_t status;    /**< Trạng thái kết quả */
-     float execution_time;           /**< Thời gian thực thi (ms) */
-     char result_details[1024];      /**< Chi tiết kết quả dạng text */
+     bool is_sweep;                  /**< Kết quả tổng hợp của một dải địa chỉ (dùng data.sweep) */
+     float execution_time;           /**< Thời gian thực thi (ms), không gồm thời gian phân giải DNS */
+     float dns_time;                 /**< Thời gian phân giải target (ms), 0 nếu target là địa chỉ IP */
+     int64_t started_at;             /**< Thời điểm bắt đầu (ms kể từ epoch) */
+     int64_t finished_at;            /**< Thời điểm kết thúc (ms kể từ epoch) */
+     test_result_reason_t reason;    /**< Loại chi tiết kết quả (text được dựng khi cần) */
+     str_ref_t target;               /**< Target trong bảng chuỗi kết quả, 0 nếu không có */
+     str_ref_t message;              /**< Text bổ sung trong bảng chuỗi kết quả, 0 nếu không có */
      
      /**
       * @brief Union chứa kết quả chi tiết tùy theo loại test
       */
      union {
          ping_result_t ping;             /**< Kết quả ping test */
+         ping_sweep_result_t sweep;      /**< Kết quả ping test trên dải địa chỉ (is_sweep) */
          throughput_result_t throughput; /**< Kết quả throughput test */
          security_result_t security;     /**< Kết quả security test */
      } data;
  } test_result_info_t;
  
+ /**
+  * @brief Kích thước tối đa của test_result_info_t: mọi text nằm trong bảng chuỗi kết quả
+  */
+ #define TEST_RESULT_INFO_MAX_SIZE 112
+ _Static_assert(sizeof(test_result_info_t) <= TEST_RESULT_INFO_MAX_SIZE,
+                "test_result_info_t must keep text in the result string table");
+ 
  /* Các hằng số và macro */
  /**
   * @brief Ngưỡng thời gian timeout mặc định (ms)
@@ -81,6 +128,16 @@
   */
  #define PING_MAX_ACCEPTABLE_RTT 200.0f  /* 200ms */
  
+ /**
+  * @brief Số tiến trình ping chạy song song khi quét một dải địa chỉ
+  */
+ #define PING_SWEEP_BATCH 32
+ 
+ /**
+  * @brief Kích thước tối đa của chuỗi chi tiết kết quả khi được dựng
+  */
+ #define TEST_RESULT_DETAILS_SIZE 1024
+ 
  /* Khai báo các hàm */
  
  /**
@@ -113,6 +170,10 @@
  /**
   * @brief Tạo báo cáo tổng hợp từ các kết quả test
   * 
+  * Báo cáo là JSON gồm thời điểm tạo, thống kê theo trạng thái và toàn bộ
+  * kết quả với các số liệu ping/throughput/security dạng số (xem
+  * test_result_write_json), để phía PC không phải tách số ra từ chuỗi details.
+  * 
   * @param results Mảng kết quả test
   * @param count Số lượng kết quả
   * @param filename Đường dẫn đến file báo cáo
@@ -120,6 +181,20 @@
   */
  int generate_summary_report(test_result_info_t *results, int count, const char *filename);
  
+ /**
+  * @brief Tạo báo cáo tổng hợp như generate_summary_report nhưng nén gzip
+  * 
+  * JSON được nén dần qua bộ ghi gzip dạng luồng trong lúc sinh ra, không cần
+  * giữ toàn bộ báo cáo trong bộ nhớ. File không hoàn chỉnh bị xóa khi lỗi.
+  * 
+  * @param results Mảng kết quả test
+  * @param count Số lượng kết quả
+  * @param filename Đường dẫn đến file báo cáo (.json.gz)
+  * @param level Mức nén 1-9
+  * @return int 0 nếu thành công, -1 nếu thất bại
+  */
+ int generate_summary_report_gz(test_result_info_t *results, int count, const char *filename, int level);
+ 
  /**
   * @brief Thực thi test case dựa trên loại mạng
   * 
@@ -130,6 +205,66 @@
   */
  int execute_test_case_by_network(test_case_t *test_case, network_type_t network_type, test_result_info_t *result);
  
+ /**
+  * @brief Ghi kết quả test thành object JSON qua writer
+  * 
+  * @param writer Writer đích (buffer, FILE* hoặc fd)
+  * @param result Con trỏ đến kết quả test
+  * @return true nếu writer chưa gặp lỗi, false nếu ngược lại
+  */
+ bool test_result_write_json(json_writer_t *writer, const test_result_info_t *result);
+ 
+ /**
+  * @brief Dựng chuỗi chi tiết dạng text của kết quả test
+  * 
+  * Chuỗi được tạo từ reason, các số liệu dạng số và target/message trong bảng
+  * chuỗi kết quả, nên kết quả test không phải mang sẵn một buffer text.
+  * 
+  * @param result Con trỏ đến kết quả test
+  * @param buffer Buffer lưu chuỗi (nên có kích thước TEST_RESULT_DETAILS_SIZE)
+  * @param size Kích thước buffer
+  * @return int Độ dài chuỗi đầy đủ như snprintf, -1 nếu tham số không hợp lệ
+  */
+ int test_result_format_details(const test_result_info_t *result, char *buffer, size_t size);
+ 
+ /**
+  * @brief Kết quả có số đo ping (gói gửi/nhận, mất gói) lấy từ output của lệnh ping
+  * 
+  * Kết quả timeout, lỗi, sweep hoặc không parse được output chỉ có data.ping
+  * bằng 0 sau memset, không phải 0% mất gói. Dựa vào packets_sent (không dựa
+  * vào reason) để đúng cả với kết quả đọc lại từ journal.
+  * 
+  * @param result Con trỏ đến kết quả test
+  * @return true nếu data.ping là số đo thật
+  */
+ bool test_result_has_ping_stats(const test_result_info_t *result);
+ 
+ /**
+  * @brief Intern một chuỗi vào bảng chuỗi kết quả dùng chung
+  * 
+  * Các chuỗi giống nhau (ví dụ target của cùng một test qua nhiều lần chạy)
+  * chỉ được lưu một lần. An toàn khi gọi từ nhiều luồng.
+  * 
+  * @param text Chuỗi cần intern
+  * @return str_ref_t Tham chiếu đến chuỗi, 0 nếu chuỗi rỗng hoặc thất bại
+  */
+ str_ref_t test_result_intern(const char *text);
+ 
+ /**
+  * @brief Gán chi tiết dạng text cho kết quả test (reason RESULT_REASON_TEXT)
+  * 
+  * @param result Con trỏ đến kết quả test
+  * @param text Chi tiết dạng text
+  */
+ void test_result_set_details(test_result_info_t *result, const char *text);
+ 
+ /**
+  * @brief Giải phóng bảng chuỗi kết quả
+  * 
+  * Chỉ gọi khi không còn kết quả test nào được dùng đến.
+  */
+ void test_result_strings_free(void);
+ 
  /**
   * @brief Chuyển đổi kết quả test sang định dạng JSON
   * 
@@ -148,4 +283,12 @@
   */
  const char* test_result_status_to_string(test_result_status_t status);
  
+ /**
+  * @brief Chuyển đổi loại test sang chuỗi
+  * 
+  * @param type Loại test
+  * @return const char* Tên loại test (giống trường "type" trong file cấu hình)
+  */
+ const char* test_type_to_string(test_type_t type);
+ 
  #endif /* TC_H */
\ No newline at end of file
@@ -1,4 +1,6 @@
 
+#define _GNU_SOURCE   /* copy_file_range */
+#define LOG_MODULE LOG_MOD_FILE
 
  #include "file_process.h"
  #include "log.h"
@@ -9,106 +11,203 @@
  #include <errno.h>
  #include <unistd.h>
  #include <fcntl.h>
+ #include <stdbool.h>
+ #include <sys/mman.h>
+ #include <sys/sendfile.h>
+ 
+ /**
+  * @brief Đọc tuần tự từ fd đến EOF vào buffer cấp phát (kết thúc bằng '\0')
+  *
+  * @param size_hint Kích thước dự kiến (từ fstat, 0 nếu không biết như pipe, procfs)
+  */
+ static int read_fd_all(int fd, const char *file_path, size_t size_hint, char **buffer, size_t *size) {
+     size_t capacity = size_hint > 0 ? size_hint : 4096;
+     size_t used = 0;
+     char *data = (char *)malloc(capacity + 1);
+     if (!data) {
+         LOG_ERROR("Memory allocation failed for file %s", file_path);
+         return -1;
+     }
+     
+     for (;;) {
+         if (used == capacity) {
+             // Đọc thử một byte sau kích thước dự kiến trước khi nới buffer (file thường đúng kích thước)
+             char probe;
+             ssize_t n = read(fd, &probe, 1);
+             if (n == 0) {
+                 break;
+             }
+             if (n < 0 && errno == EINTR) {
+                 continue;
+             }
+             char *grown = n > 0 ? (char *)realloc(data, capacity * 2 + 1) : NULL;
+             if (!grown) {
+                 LOG_ERROR("Failed to read entire file %s: %s", file_path, n < 0 ? strerror(errno) : "out of memory");
+                 free(data);
+                 return -1;
+             }
+             data = grown;
+             capacity *= 2;
+             data[used++] = probe;
+             continue;
+         }
+         ssize_t n = read(fd, data + used, capacity - used);
+         if (n == 0) {
+             break;
+         }
+         if (n < 0) {
+             if (errno == EINTR) {
+                 continue;
+             }
+             LOG_ERROR("Failed to read entire file %s: %s", file_path, strerror(errno));
+             free(data);
+             return -1;
+         }
+         used += (size_t)n;
+     }
+     
+     // Thêm null terminator cho chuỗi
+     data[used] = '\0';
+     *buffer = data;
+     *size = used;
+     return 0;
+ }
  
  int read_file(const char *file_path, char **buffer, size_t *size) {
      if (!file_path || !buffer || !size) {
-         log_message(LOG_LVL_ERROR, "read_file: Invalid parameters");
+         LOG_ERROR("read_file: Invalid parameters");
          return -1;
      }
      
      *buffer = NULL;
      *size = 0;
      
-     FILE *file = fopen(file_path, "rb");
-     if (!file) {
-         log_message(LOG_LVL_ERROR, "Failed to open file %s: %s", file_path, strerror(errno));
+     int fd = open(file_path, O_RDONLY | O_CLOEXEC);
+     if (fd < 0) {
+         LOG_ERROR("Failed to open file %s: %s", file_path, strerror(errno));
          return -1;
      }
      
-     // Lấy kích thước file
-     fseek(file, 0, SEEK_END);
-     long file_size = ftell(file);
-     if (file_size < 0) {
-         log_message(LOG_LVL_ERROR, "Failed to determine size of file %s: %s", file_path, strerror(errno));
-         fclose(file);
-         return -1;
+     // Kích thước từ fstat chỉ là gợi ý: pipe và procfs báo 0 nhưng vẫn có nội dung
+     struct stat st;
+     size_t size_hint = fstat(fd, &st) == 0 && S_ISREG(st.st_mode) ? (size_t)st.st_size : 0;
+     int ret = read_fd_all(fd, file_path, size_hint, buffer, size);
+     close(fd);
+     if (ret == 0) {
+         LOG_DEBUG("Successfully read %lu bytes from file %s", (unsigned long)*size, file_path);
      }
-     fseek(file, 0, SEEK_SET);
-     
-     // Cấp phát bộ nhớ
-     *buffer = (char *)malloc(file_size + 1);
-     if (!*buffer) {
-         log_message(LOG_LVL_ERROR, "Memory allocation failed for file %s", file_path);
-         fclose(file);
+     return ret;
+ }
+ 
+ int file_view_open(const char *file_path, file_view_t *view) {
+     return file_view_open_ex(file_path, view, 0);
+ }
+ 
+ int file_view_open_ex(const char *file_path, file_view_t *view, int flags) {
+     if (!file_path || !view) {
+         LOG_ERROR("file_view_open: Invalid parameters");
          return -1;
      }
      
-     // Đọc nội dung file
-     size_t bytes_read = fread(*buffer, 1, file_size, file);
-     if (bytes_read != file_size) {
-         log_message(LOG_LVL_ERROR, "Failed to read entire file %s: %s", file_path, strerror(errno));
-         free(*buffer);
-         *buffer = NULL;
-         fclose(file);
+     memset(view, 0, sizeof(*view));
+     int fd = open(file_path, O_RDONLY | O_CLOEXEC);
+     if (fd < 0) {
+         LOG_ERROR("Failed to open file %s: %s", file_path, strerror(errno));
          return -1;
      }
      
-     // Thêm null terminator cho chuỗi
-     (*buffer)[file_size] = '\0';
-     *size = file_size;
+     struct stat st;
+     bool regular = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+     // Bản sao không bị ảnh hưởng khi file bị cắt ngắn sau đó (vùng map sẽ gây SIGBUS)
+     if (regular && st.st_size >= FILE_VIEW_MMAP_MIN && !(flags & FILE_VIEW_COPY)) {
+         void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (data != MAP_FAILED) {
+             // Người đọc đi một lượt từ đầu đến cuối: đọc trước mạnh, bỏ trang đã qua sớm
+             madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+             close(fd);
+             view->data = (const char *)data;
+             view->size = (size_t)st.st_size;
+             view->mapped = 1;
+             LOG_DEBUG("Mapped %lu bytes of file %s", (unsigned long)view->size, file_path);
+             return 0;
+         }
+         LOG_DEBUG("Failed to map %s (%s), reading it instead", file_path, strerror(errno));
+     }
      
-     fclose(file);
-     log_message(LOG_LVL_DEBUG, "Successfully read %lu bytes from file %s", (unsigned long)file_size, file_path);
+     char *buffer = NULL;
+     size_t size = 0;
+     int ret = read_fd_all(fd, file_path, regular ? (size_t)st.st_size : 0, &buffer, &size);
+     close(fd);
+     if (ret != 0) {
+         return -1;
+     }
+     view->data = buffer;
+     view->size = size;
+     view->mapped = 0;
      return 0;
  }
  
+ void file_view_release(file_view_t *view) {
+     if (!view || !view->data) {
+         return;
+     }
+     if (view->mapped) {
+         munmap((void *)view->data, view->size);
+     } else {
+         free((void *)view->data);
+     }
+     view->data = NULL;
+     view->size = 0;
+     view->mapped = 0;
+ }
+ 
  int write_file(const char *file_path, const char *buffer, size_t size) {
      if (!file_path || (!buffer && size > 0)) {
-         log_message(LOG_LVL_ERROR, "write_file: Invalid parameters");
+         LOG_ERROR("write_file: Invalid parameters");
          return -1;
      }
      
      FILE *file = fopen(file_path, "wb");
      if (!file) {
-         log_message(LOG_LVL_ERROR, "Failed to open file for writing %s: %s", file_path, strerror(errno));
+         LOG_ERROR("Failed to open file for writing %s: %s", file_path, strerror(errno));
          return -1;
      }
      
      // Ghi nội dung vào file
      size_t bytes_written = fwrite(buffer, 1, size, file);
      if (bytes_written != size) {
-         log_message(LOG_LVL_ERROR, "Failed to write entire content to file %s: %s", file_path, strerror(errno));
+         LOG_ERROR("Failed to write entire content to file %s: %s", file_path, strerror(errno));
          fclose(file);
          return -1;
      }
      
      fclose(file);
-     log_message(LOG_LVL_DEBUG, "Successfully wrote %lu bytes to file %s", (unsigned long)size, file_path);
+     LOG_DEBUG("Successfully wrote %lu bytes to file %s", (unsigned long)size, file_path);
      return 0;
  }
  
  int append_to_file(const char *file_path, const char *buffer, size_t size) {
      if (!file_path || (!buffer && size > 0)) {
-         log_message(LOG_LVL_ERROR, "append_to_file: Invalid parameters");
+         LOG_ERROR("append_to_file: Invalid parameters");
          return -1;
      }
      
      FILE *file = fopen(file_path, "ab");
      if (!file) {
-         log_message(LOG_LVL_ERROR, "Failed to open file for appending %s: %s", file_path, strerror(errno));
+         LOG_ERROR("Failed to open file for appending %s: %s", file_path, strerror(errno));
          return -1;
      }
      
      // Ghi thêm nội dung vào file
      size_t bytes_written = fwrite(buffer, 1, size, file);
      if (bytes_written != size) {
-         log_message(LOG_LVL_ERROR, "Failed to append entire content to file %s: %s", file_path, strerror(errno));
+         LOG_ERROR("Failed to append entire content to file %s: %s", file_path, strerror(errno));
          fclose(file);
          return -1;
      }
      
      fclose(file);
-     log_message(LOG_LVL_DEBUG, "Successfully appended %lu bytes to file %s", (unsigned long)size, file_path);
+     LOG_DEBUG("Successfully appended %lu bytes to file %s", (unsigned long)size, file_path);
      return 0;
  }
  
@@ -121,18 +220,18 @@
  
  int create_directory(const char *dir_path) {
      if (!dir_path) {
-         log_message(LOG_LVL_ERROR, "create_directory: Invalid parameter");
+         LOG_ERROR("create_directory: Invalid parameter");
          return -1;
      }
      
      // Tạo thư mục với quyền 0755 (rwxr-xr-x)
      if (mkdir(dir_path, 0755) != 0 && errno != EEXIST) {
-         log_message(LOG_LVL_ERROR, "Failed to create directory %s: %s", dir_path, strerror(errno));
+         LOG_ERROR("Failed to create directory %s: %s", dir_path, strerror(errno));
          return -1;
      } else if (errno == EEXIST) {
-         log_message(LOG_LVL_DEBUG, "Directory %s already exists", dir_path);
+         LOG_DEBUG("Directory %s already exists", dir_path);
      } else {
-         log_message(LOG_LVL_DEBUG, "Successfully created directory %s", dir_path);
+         LOG_DEBUG("Successfully created directory %s", dir_path);
      }
      
      return 0;
@@ -140,63 +239,206 @@
  
  int delete_file(const char *file_path) {
      if (!file_path) {
-         log_message(LOG_LVL_ERROR, "delete_file: Invalid parameter");
+         LOG_ERROR("delete_file: Invalid parameter");
          return -1;
      }
      
      if (unlink(file_path) != 0) {
-         log_message(LOG_LVL_ERROR, "Failed to delete file %s: %s", file_path, strerror(errno));
+         LOG_ERROR("Failed to delete file %s: %s", file_path, strerror(errno));
          return -1;
      }
      
-     log_message(LOG_LVL_DEBUG, "Successfully deleted file %s", file_path);
+     LOG_DEBUG("Successfully deleted file %s", file_path);
      return 0;
  }
  
- int copy_file(const char *src_path, const char *dest_path) {
-     char buffer[4096];
-     size_t bytes_read;
+ /**
+  * @brief Lỗi cho biết cách sao chép này không dùng được với cặp file (thử cách tiếp theo)
+  */
+ static bool copy_unsupported(int err) {
+     return err == ENOSYS || err == EXDEV || err == EINVAL || err == EOPNOTSUPP || err == ENOTSUP ||
+            err == EBADF || err == EPERM || err == ETXTBSY;
+ }
+ 
+ /**
+  * @brief Sao chép phần còn lại của in sang out bằng buffer lớn căn lề trang
+  */
+ static int copy_fd_buffered(int in_fd, int out_fd, const char *src_path, const char *dest_path) {
+     void *buffer = NULL;
+     if (posix_memalign(&buffer, COPY_FILE_ALIGN, COPY_FILE_BUFFER_SIZE) != 0) {
+         LOG_ERROR("Memory allocation failed for copying %s", src_path);
+         return -1;
+     }
+     posix_fadvise(in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+     
+     int ret = 0;
+     for (;;) {
+         ssize_t n = read(in_fd, buffer, COPY_FILE_BUFFER_SIZE);
+         if (n == 0) {
+             break;
+         }
+         if (n < 0) {
+             if (errno == EINTR) {
+                 continue;
+             }
+             LOG_ERROR("Error reading from source file %s: %s", src_path, strerror(errno));
+             ret = -1;
+             break;
+         }
+         
+         const char *data = (const char *)buffer;
+         while (n > 0) {
+             ssize_t written = write(out_fd, data, (size_t)n);
+             if (written < 0 && errno == EINTR) {
+                 continue;
+             }
+             if (written <= 0) {
+                 LOG_ERROR("Error writing to destination file %s: %s", dest_path, strerror(errno));
+                 ret = -1;
+                 break;
+             }
+             data += written;
+             n -= written;
+         }
+         if (ret != 0) {
+             break;
+         }
+     }
+     
+     free(buffer);
+     return ret;
+ }
+ 
+ /**
+  * @brief Sao chép nội dung từ in sang out, ưu tiên sao chép trong kernel
+  *
+  * copy_file_range không đưa dữ liệu qua user space (và dùng reflink/sao chép
+  * phía server nếu filesystem hỗ trợ); nếu kernel hoặc cặp filesystem không hỗ
+  * trợ thì dùng sendfile, cuối cùng là read/write qua buffer. Cả ba đều đọc/ghi
+  * theo offset hiện tại của fd nên cách sau tiếp tục đúng chỗ cách trước dừng.
+  */
+ static int copy_fd(int in_fd, int out_fd, const char *src_path, const char *dest_path) {
+     const size_t chunk = 1UL << 30;
+     const char *method = "copy_file_range";
+     bool copied = false;
+     
+     for (;;) {
+         ssize_t n = copy_file_range(in_fd, NULL, out_fd, NULL, chunk, 0);
+         if (n == 0) {
+             // Một số kernel trả về 0 ngay với file procfs/sysfs (kích thước 0); để cách sau đọc lại đến EOF
+             if (!copied) {
+                 method = NULL;
+             }
+             break;
+         }
+         if (n < 0) {
+             if (errno == EINTR) {
+                 continue;
+             }
+             if (!copy_unsupported(errno)) {
+                 LOG_ERROR("Failed to copy %s to %s: %s", src_path, dest_path, strerror(errno));
+                 return -1;
+             }
+             method = NULL;
+             break;
+         }
+         copied = true;
+     }
      
+     if (!method) {
+         method = "sendfile";
+         for (;;) {
+             ssize_t n = sendfile(out_fd, in_fd, NULL, chunk);
+             if (n == 0) {
+                 break;
+             }
+             if (n < 0) {
+                 if (errno == EINTR) {
+                     continue;
+                 }
+                 if (!copy_unsupported(errno)) {
+                     LOG_ERROR("Failed to copy %s to %s: %s", src_path, dest_path, strerror(errno));
+                     return -1;
+                 }
+                 method = NULL;
+                 break;
+             }
+         }
+     }
+     
+     if (!method) {
+         method = "read/write";
+         if (copy_fd_buffered(in_fd, out_fd, src_path, dest_path) != 0) {
+             return -1;
+         }
+     }
+     
+     LOG_DEBUG("Copied %s to %s using %s", src_path, dest_path, method);
+     return 0;
+ }
+ 
+ int copy_file(const char *src_path, const char *dest_path) {
+     return copy_file_ex(src_path, dest_path, 0);
+ }
+ 
+ int copy_file_ex(const char *src_path, const char *dest_path, int flags) {
      if (!src_path || !dest_path) {
-         log_message(LOG_LVL_ERROR, "copy_file: Invalid parameters");
+         LOG_ERROR("copy_file: Invalid parameters");
          return -1;
      }
      
-     FILE *src_file = fopen(src_path, "rb");
-     if (!src_file) {
-         log_message(LOG_LVL_ERROR, "Failed to open source file %s: %s", src_path, strerror(errno));
+     int in_fd = open(src_path, O_RDONLY | O_CLOEXEC);
+     if (in_fd < 0) {
+         LOG_ERROR("Failed to open source file %s: %s", src_path, strerror(errno));
          return -1;
      }
      
-     FILE *dest_file = fopen(dest_path, "wb");
-     if (!dest_file) {
-         log_message(LOG_LVL_ERROR, "Failed to open destination file %s: %s", dest_path, strerror(errno));
-         fclose(src_file);
+     struct stat src_st;
+     if (fstat(in_fd, &src_st) != 0) {
+         LOG_ERROR("Failed to stat source file %s: %s", src_path, strerror(errno));
+         close(in_fd);
          return -1;
      }
      
-     // Copy nội dung
-     while ((bytes_read = fread(buffer, 1, sizeof(buffer), src_file)) > 0) {
-         if (fwrite(buffer, 1, bytes_read, dest_file) != bytes_read) {
-             log_message(LOG_LVL_ERROR, "Error writing to destination file %s: %s", dest_path, strerror(errno));
-             fclose(src_file);
-             fclose(dest_file);
-             return -1;
-         }
+     // O_TRUNC trên chính file nguồn sẽ xóa sạch dữ liệu
+     struct stat dest_st;
+     if (stat(dest_path, &dest_st) == 0 && dest_st.st_dev == src_st.st_dev && dest_st.st_ino == src_st.st_ino) {
+         LOG_ERROR("copy_file: %s and %s are the same file", src_path, dest_path);
+         close(in_fd);
+         return -1;
      }
      
-     if (ferror(src_file)) {
-         log_message(LOG_LVL_ERROR, "Error reading from source file %s: %s", src_path, strerror(errno));
-         fclose(src_file);
-         fclose(dest_file);
+     mode_t mode = (flags & COPY_FILE_PRESERVE_MODE) ? (src_st.st_mode & 07777) : 0666;
+     int out_fd = open(dest_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode);
+     if (out_fd < 0) {
+         LOG_ERROR("Failed to open destination file %s: %s", dest_path, strerror(errno));
+         close(in_fd);
          return -1;
      }
      
-     fclose(src_file);
-     fclose(dest_file);
+     int ret = copy_fd(in_fd, out_fd, src_path, dest_path);
      
-     log_message(LOG_LVL_DEBUG, "Successfully copied file %s to %s", src_path, dest_path);
-     return 0;
+     // Mode lúc tạo bị umask che và không áp dụng khi file đích đã tồn tại
+     if (ret == 0 && (flags & COPY_FILE_PRESERVE_MODE) && fchmod(out_fd, src_st.st_mode & 07777) != 0) {
+         LOG_WARN("Failed to preserve mode of %s: %s", dest_path, strerror(errno));
+     }
+     if (ret == 0 && (flags & COPY_FILE_PRESERVE_TIMES)) {
+         struct timespec times[2] = { src_st.st_atim, src_st.st_mtim };
+         if (futimens(out_fd, times) != 0) {
+             LOG_WARN("Failed to preserve times of %s: %s", dest_path, strerror(errno));
+         }
+     }
+     
+     close(in_fd);
+     if (close(out_fd) != 0 && ret == 0) {
+         LOG_ERROR("Error writing to destination file %s: %s", dest_path, strerror(errno));
+         ret = -1;
+     }
+     
+     if (ret == 0) {
+         LOG_DEBUG("Successfully copied file %s to %s", src_path, dest_path);
+     }
+     return ret;
  }
  
  long get_file_size(const char *file_path) {
@@ -206,7 +448,7 @@
      
      struct stat st;
      if (stat(file_path, &st) != 0) {
-         log_message(LOG_LVL_ERROR, "Failed to get file size for %s: %s", file_path, strerror(errno));
+         LOG_ERROR("Failed to get file size for %s: %s", file_path, strerror(errno));
          return -1;
      }
      
@@ -220,7 +462,7 @@
      
      struct stat st;
      if (stat(file_path, &st) != 0) {
-         log_message(LOG_LVL_ERROR, "Failed to get modification time for %s: %s", file_path, strerror(errno));
+         LOG_ERROR("Failed to get modification time for %s: %s", file_path, strerror(errno));
          return -1;
      }
      
@@ -229,7 +471,7 @@
  
  char* create_temp_file(const char *prefix, char *temp_path, size_t path_size) {
      if (!prefix || !temp_path || path_size < 16) {
-         log_message(LOG_LVL_ERROR, "create_temp_file: Invalid parameters");
+         LOG_ERROR("create_temp_file: Invalid parameters");
          return NULL;
      }
      
@@ -237,18 +479,18 @@
      
      int fd = mkstemp(temp_path);
      if (fd == -1) {
-         log_message(LOG_LVL_ERROR, "Failed to create temp file with prefix %s: %s", prefix, strerror(errno));
+         LOG_ERROR("Failed to create temp file with prefix %s: %s", prefix, strerror(errno));
          return NULL;
      }
      
      close(fd);
-     log_message(LOG_LVL_DEBUG, "Successfully created temp file %s", temp_path);
+     LOG_DEBUG("Successfully created temp file %s", temp_path);
      return temp_path;
  }
  
  int read_file_chunk(const char *file_path, char *buffer, size_t buffer_size, off_t offset, size_t *bytes_read) {
      if (!file_path || !buffer || !bytes_read) {
-         log_message(LOG_LVL_ERROR, "read_file_chunk: Invalid parameters");
+         LOG_ERROR("read_file_chunk: Invalid parameters");
          return -1;
      }
      
@@ -256,13 +498,13 @@
      
      int fd = open(file_path, O_RDONLY);
      if (fd == -1) {
-         log_message(LOG_LVL_ERROR, "Failed to open file %s: %s", file_path, strerror(errno));
+         LOG_ERROR("Failed to open file %s: %s", file_path, strerror(errno));
          return -1;
      }
      
      // Di chuyển con trỏ đến vị trí offset
      if (lseek(fd, offset, SEEK_SET) == -1) {
-         log_message(LOG_LVL_ERROR, "Failed to seek to offset %ld in file %s: %s", (long)offset, file_path, strerror(errno));
+         LOG_ERROR("Failed to seek to offset %ld in file %s: %s", (long)offset, file_path, strerror(errno));
          close(fd);
          return -1;
      }
@@ -270,7 +512,7 @@
      // Đọc dữ liệu
      ssize_t read_size = read(fd, buffer, buffer_size);
      if (read_size == -1) {
-         log_message(LOG_LVL_ERROR, "Failed to read from file %s: %s", file_path, strerror(errno));
+         LOG_ERROR("Failed to read from file %s: %s", file_path, strerror(errno));
          close(fd);
          return -1;
      }
@@ -278,6 +520,6 @@
      *bytes_read = (size_t)read_size;
      close(fd);
      
-     log_message(LOG_LVL_DEBUG, "Successfully read %lu bytes from file %s at offset %ld", (unsigned long)read_size, file_path, (long)offset);
+     LOG_DEBUG("Successfully read %lu bytes from file %s at offset %ld", (unsigned long)read_size, file_path, (long)offset);
      return 0;
  }
\ No newline at end of file
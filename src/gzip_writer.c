@@ -0,0 +1,195 @@
+
+#define _POSIX_C_SOURCE 200809L
+#define LOG_MODULE LOG_MOD_FILE
+
+#include "gzip_writer.h"
+#include "log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// windowBits 15 cộng 16: zlib tự ghi header và trailer gzip
+#define GZIP_WINDOW_BITS (15 + 16)
+#define GZIP_MEM_LEVEL 8
+
+/**
+ * @brief Ghi toàn bộ buffer ra fd, thử lại khi bị ngắt
+ */
+static int write_all(int fd, const unsigned char *data, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = write(fd, data + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Chạy deflate cho tới khi hết đầu vào, đẩy từng khối đầu ra ra file
+ */
+static int deflate_pending(gzip_writer_t *gz, int flush) {
+    int ret;
+    do {
+        gz->stream.next_out = gz->out;
+        gz->stream.avail_out = sizeof(gz->out);
+        ret = deflate(&gz->stream, flush);
+        if (ret == Z_STREAM_ERROR) {
+            LOG_ERROR("deflate failed: %s", gz->stream.msg ? gz->stream.msg : "stream error");
+            gz->error = true;
+            return -1;
+        }
+
+        size_t produced = sizeof(gz->out) - gz->stream.avail_out;
+        if (produced > 0) {
+            if (write_all(gz->fd, gz->out, produced) != 0) {
+                LOG_ERROR("Failed to write compressed output: %s", strerror(errno));
+                gz->error = true;
+                return -1;
+            }
+            gz->bytes_out += produced;
+        }
+    } while (gz->stream.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+
+    return 0;
+}
+
+int gzip_writer_open(gzip_writer_t *gz, const char *path, int level) {
+    if (!gz || !path) {
+        return -1;
+    }
+
+    memset(&gz->stream, 0, sizeof(gz->stream));
+    gz->error = false;
+    gz->bytes_in = 0;
+    gz->bytes_out = 0;
+
+    if (level < Z_BEST_SPEED) {
+        level = Z_BEST_SPEED;
+    } else if (level > Z_BEST_COMPRESSION) {
+        level = Z_BEST_COMPRESSION;
+    }
+
+    gz->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (gz->fd < 0) {
+        LOG_ERROR("Failed to create %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    if (deflateInit2(&gz->stream, level, Z_DEFLATED, GZIP_WINDOW_BITS, GZIP_MEM_LEVEL,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        LOG_ERROR("Failed to initialise deflate for %s", path);
+        close(gz->fd);
+        gz->fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+int gzip_writer_write(gzip_writer_t *gz, const void *data, size_t len) {
+    if (!gz || gz->fd < 0 || (!data && len > 0)) {
+        return -1;
+    }
+    if (gz->error) {
+        return -1;
+    }
+
+    // avail_in là uInt: chia nhỏ khối quá lớn
+    const unsigned char *p = (const unsigned char *)data;
+    while (len > 0) {
+        uInt part = len > (size_t)UINT32_MAX ? UINT32_MAX : (uInt)len;
+        gz->stream.next_in = (Bytef *)p;
+        gz->stream.avail_in = part;
+        if (deflate_pending(gz, Z_NO_FLUSH) != 0) {
+            return -1;
+        }
+        gz->bytes_in += part;
+        p += part;
+        len -= part;
+    }
+
+    return 0;
+}
+
+int gzip_writer_close(gzip_writer_t *gz) {
+    if (!gz || gz->fd < 0) {
+        return -1;
+    }
+
+    if (!gz->error) {
+        gz->stream.next_in = NULL;
+        gz->stream.avail_in = 0;
+        deflate_pending(gz, Z_FINISH);
+    }
+    deflateEnd(&gz->stream);
+
+    if (close(gz->fd) != 0) {
+        LOG_ERROR("Failed to close compressed output: %s", strerror(errno));
+        gz->error = true;
+    }
+    gz->fd = -1;
+
+    return gz->error ? -1 : 0;
+}
+
+int gzip_compress_file(const char *src_path, const char *dst_path, int level) {
+    if (!src_path || !dst_path) {
+        return -1;
+    }
+
+    int src = open(src_path, O_RDONLY);
+    if (src < 0) {
+        LOG_ERROR("Failed to open %s: %s", src_path, strerror(errno));
+        return -1;
+    }
+
+    gzip_writer_t *gz = (gzip_writer_t *)malloc(sizeof(gzip_writer_t));
+    unsigned char *chunk = (unsigned char *)malloc(GZIP_WRITER_CHUNK);
+    if (!gz || !chunk) {
+        LOG_ERROR("Memory allocation failed for gzip compression");
+        free(gz);
+        free(chunk);
+        close(src);
+        return -1;
+    }
+
+    int ret = gzip_writer_open(gz, dst_path, level);
+    if (ret == 0) {
+        for (;;) {
+            ssize_t n = read(src, chunk, GZIP_WRITER_CHUNK);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0) {
+                LOG_ERROR("Failed to read %s: %s", src_path, strerror(errno));
+                ret = -1;
+                break;
+            }
+            if (n == 0 || gzip_writer_write(gz, chunk, (size_t)n) != 0) {
+                break;
+            }
+        }
+        if (gzip_writer_close(gz) != 0) {
+            ret = -1;
+        }
+        if (ret != 0) {
+            unlink(dst_path);
+        } else {
+            LOG_DEBUG("Compressed %s to %s (%llu -> %llu bytes)", src_path, dst_path,
+                      (unsigned long long)gz->bytes_in, (unsigned long long)gz->bytes_out);
+        }
+    }
+
+    free(chunk);
+    free(gz);
+    close(src);
+    return ret;
+}
@@ -0,0 +1,439 @@
+
+#define _POSIX_C_SOURCE 200809L
+#define LOG_MODULE LOG_MOD_FILE
+
+#include "json_writer.h"
+#include "log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+
+#define JSON_WRITER_DEFAULT_CAPACITY 4096
+
+static void writer_reset(json_writer_t *writer) {
+    memset(writer, 0, sizeof(*writer));
+    writer->fd = -1;
+}
+
+int json_writer_init_buffer(json_writer_t *writer, size_t initial_capacity) {
+    if (!writer) {
+        return -1;
+    }
+
+    writer_reset(writer);
+    writer->capacity = initial_capacity > 0 ? initial_capacity : JSON_WRITER_DEFAULT_CAPACITY;
+    writer->data = (char *)malloc(writer->capacity);
+    if (!writer->data) {
+        LOG_ERROR("Memory allocation failed for JSON writer");
+        return -1;
+    }
+    writer->growable = true;
+    writer->owns_data = true;
+    return 0;
+}
+
+int json_writer_init_fixed(json_writer_t *writer, char *buffer, size_t buffer_size) {
+    if (!writer || !buffer || buffer_size == 0) {
+        return -1;
+    }
+
+    writer_reset(writer);
+    writer->data = buffer;
+    writer->capacity = buffer_size;
+    buffer[0] = '\0';
+    return 0;
+}
+
+/**
+ * @brief Khởi tạo buffer trung gian cho đích file/fd
+ */
+static int init_staging(json_writer_t *writer) {
+    writer->capacity = JSON_WRITER_STAGING_SIZE;
+    writer->data = (char *)malloc(writer->capacity);
+    if (!writer->data) {
+        LOG_ERROR("Memory allocation failed for JSON writer");
+        return -1;
+    }
+    writer->owns_data = true;
+    return 0;
+}
+
+int json_writer_init_file(json_writer_t *writer, FILE *file) {
+    if (!writer || !file) {
+        return -1;
+    }
+
+    writer_reset(writer);
+    writer->file = file;
+    return init_staging(writer);
+}
+
+int json_writer_init_fd(json_writer_t *writer, int fd) {
+    if (!writer || fd < 0) {
+        return -1;
+    }
+
+    writer_reset(writer);
+    writer->fd = fd;
+    return init_staging(writer);
+}
+
+int json_writer_init_sink(json_writer_t *writer, json_writer_sink_t sink, void *context) {
+    if (!writer || !sink) {
+        return -1;
+    }
+
+    writer_reset(writer);
+    writer->sink = sink;
+    writer->sink_context = context;
+    return init_staging(writer);
+}
+
+/**
+ * @brief Writer ghi ra đích ngoài qua buffer trung gian
+ */
+static bool is_streaming(const json_writer_t *writer) {
+    return writer->file || writer->fd >= 0 || writer->sink;
+}
+
+/**
+ * @brief Đẩy buffer trung gian ra file/fd/sink
+ */
+static void flush_staging(json_writer_t *writer) {
+    if (writer->size == 0) {
+        return;
+    }
+
+    if (writer->sink) {
+        if (writer->sink(writer->sink_context, writer->data, writer->size) != 0) {
+            LOG_ERROR("Failed to write JSON output to sink");
+            writer->error = true;
+        }
+    } else if (writer->file) {
+        if (fwrite(writer->data, 1, writer->size, writer->file) != writer->size) {
+            LOG_ERROR("Failed to write JSON output: %s", strerror(errno));
+            writer->error = true;
+        }
+    } else {
+        size_t done = 0;
+        while (done < writer->size) {
+            ssize_t n = write(writer->fd, writer->data + done, writer->size - done);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                LOG_ERROR("Failed to write JSON output: %s", strerror(errno));
+                writer->error = true;
+                break;
+            }
+            done += (size_t)n;
+        }
+    }
+
+    writer->flushed += writer->size;
+    writer->size = 0;
+}
+
+/**
+ * @brief Đảm bảo còn chỗ cho extra byte (cộng 1 byte cho '\0')
+ */
+static bool reserve(json_writer_t *writer, size_t extra) {
+    if (writer->error) {
+        return false;
+    }
+    if (writer->size + extra + 1 <= writer->capacity) {
+        return true;
+    }
+
+    if (is_streaming(writer)) {
+        flush_staging(writer);
+        if (extra + 1 <= writer->capacity) {
+            return !writer->error;
+        }
+        // Một token lớn hơn buffer trung gian: mở rộng tạm thời
+    } else if (!writer->growable) {
+        LOG_ERROR("JSON output exceeds buffer size %zu", writer->capacity);
+        writer->error = true;
+        return false;
+    }
+
+    size_t new_capacity = writer->capacity * 2;
+    while (new_capacity < writer->size + extra + 1) {
+        new_capacity *= 2;
+    }
+    char *new_data = (char *)realloc(writer->data, new_capacity);
+    if (!new_data) {
+        LOG_ERROR("Memory allocation failed while growing JSON output");
+        writer->error = true;
+        return false;
+    }
+    writer->data = new_data;
+    writer->capacity = new_capacity;
+    return true;
+}
+
+static void put(json_writer_t *writer, const char *bytes, size_t len) {
+    if (reserve(writer, len)) {
+        memcpy(writer->data + writer->size, bytes, len);
+        writer->size += len;
+    }
+}
+
+static void put_char(json_writer_t *writer, char c) {
+    if (reserve(writer, 1)) {
+        writer->data[writer->size++] = c;
+    }
+}
+
+/**
+ * @brief Ghi dấu phẩy trước phần tử nếu cần
+ */
+static void before_value(json_writer_t *writer) {
+    if (writer->after_key) {
+        writer->after_key = false;
+        return;
+    }
+    if (writer->depth > 0) {
+        if (writer->has_items[writer->depth - 1]) {
+            put_char(writer, ',');
+        }
+        writer->has_items[writer->depth - 1] = true;
+    }
+}
+
+static void open_container(json_writer_t *writer, char c) {
+    before_value(writer);
+    if (writer->depth >= JSON_WRITER_MAX_DEPTH) {
+        LOG_ERROR("JSON nesting deeper than %d", JSON_WRITER_MAX_DEPTH);
+        writer->error = true;
+        return;
+    }
+    put_char(writer, c);
+    writer->has_items[writer->depth++] = false;
+}
+
+static void close_container(json_writer_t *writer, char c) {
+    if (writer->depth <= 0) {
+        writer->error = true;
+        return;
+    }
+    writer->depth--;
+    put_char(writer, c);
+}
+
+void json_writer_begin_object(json_writer_t *writer) { open_container(writer, '{'); }
+void json_writer_end_object(json_writer_t *writer) { close_container(writer, '}'); }
+void json_writer_begin_array(json_writer_t *writer) { open_container(writer, '['); }
+void json_writer_end_array(json_writer_t *writer) { close_container(writer, ']'); }
+
+/**
+ * @brief Ghi chuỗi có escape theo RFC 8259 (byte UTF-8 được giữ nguyên)
+ */
+static void put_escaped(json_writer_t *writer, const char *str, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+
+    put_char(writer, '"');
+    size_t start = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)str[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        // Ghi một lần cả đoạn không cần escape
+        put(writer, str + start, i - start);
+        start = i + 1;
+
+        char esc[6] = { '\\', 0, 0, 0, 0, 0 };
+        size_t esc_len = 2;
+        switch (c) {
+            case '"': esc[1] = '"'; break;
+            case '\\': esc[1] = '\\'; break;
+            case '\b': esc[1] = 'b'; break;
+            case '\f': esc[1] = 'f'; break;
+            case '\n': esc[1] = 'n'; break;
+            case '\r': esc[1] = 'r'; break;
+            case '\t': esc[1] = 't'; break;
+            default:
+                esc[1] = 'u';
+                esc[2] = '0';
+                esc[3] = '0';
+                esc[4] = hex[c >> 4];
+                esc[5] = hex[c & 0xF];
+                esc_len = 6;
+                break;
+        }
+        put(writer, esc, esc_len);
+    }
+    put(writer, str + start, len - start);
+    put_char(writer, '"');
+}
+
+void json_writer_key(json_writer_t *writer, const char *key) {
+    before_value(writer);
+    put_escaped(writer, key ? key : "", key ? strlen(key) : 0);
+    put_char(writer, ':');
+    writer->after_key = true;
+}
+
+void json_writer_string(json_writer_t *writer, const char *value) {
+    if (!value) {
+        json_writer_null(writer);
+        return;
+    }
+    json_writer_string_n(writer, value, strlen(value));
+}
+
+void json_writer_string_n(json_writer_t *writer, const char *value, size_t len) {
+    before_value(writer);
+    put_escaped(writer, value, len);
+}
+
+void json_writer_int(json_writer_t *writer, long long value) {
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%lld", value);
+    before_value(writer);
+    put(writer, buf, (size_t)len);
+}
+
+void json_writer_double(json_writer_t *writer, double value) {
+    if (!isfinite(value)) {
+        json_writer_null(writer);
+        return;
+    }
+
+    char buf[32];
+    int len;
+    // Số nguyên được ghi không kèm phần thập phân, giống cJSON
+    if (value > -1e15 && value < 1e15 && value == (double)(long long)value) {
+        len = snprintf(buf, sizeof(buf), "%lld", (long long)value);
+    } else {
+        len = snprintf(buf, sizeof(buf), "%.15g", value);
+    }
+    before_value(writer);
+    put(writer, buf, (size_t)len);
+}
+
+void json_writer_float(json_writer_t *writer, float value) {
+    if (!isfinite(value) || (value > -1e7f && value < 1e7f && value == (float)(long)value)) {
+        json_writer_double(writer, value);
+        return;
+    }
+
+    // Tránh đuôi nhiễu khi đổi float sang double (0.015f -> 0.0149999996647239)
+    char buf[32];
+    int len = 0;
+    for (int precision = 6; precision <= 9; precision++) {
+        len = snprintf(buf, sizeof(buf), "%.*g", precision, value);
+        if (strtof(buf, NULL) == value) {
+            break;
+        }
+    }
+    before_value(writer);
+    put(writer, buf, (size_t)len);
+}
+
+void json_writer_bool(json_writer_t *writer, bool value) {
+    before_value(writer);
+    if (value) {
+        put(writer, "true", 4);
+    } else {
+        put(writer, "false", 5);
+    }
+}
+
+void json_writer_null(json_writer_t *writer) {
+    before_value(writer);
+    put(writer, "null", 4);
+}
+
+void json_writer_raw(json_writer_t *writer, const char *json, size_t len) {
+    before_value(writer);
+    put(writer, json, len);
+}
+
+void json_writer_field_string(json_writer_t *writer, const char *key, const char *value) {
+    json_writer_key(writer, key);
+    json_writer_string(writer, value);
+}
+
+void json_writer_field_int(json_writer_t *writer, const char *key, long long value) {
+    json_writer_key(writer, key);
+    json_writer_int(writer, value);
+}
+
+void json_writer_field_double(json_writer_t *writer, const char *key, double value) {
+    json_writer_key(writer, key);
+    json_writer_double(writer, value);
+}
+
+void json_writer_field_float(json_writer_t *writer, const char *key, float value) {
+    json_writer_key(writer, key);
+    json_writer_float(writer, value);
+}
+
+void json_writer_field_bool(json_writer_t *writer, const char *key, bool value) {
+    json_writer_key(writer, key);
+    json_writer_bool(writer, value);
+}
+
+int json_writer_finish(json_writer_t *writer) {
+    if (!writer || !writer->data) {
+        return -1;
+    }
+
+    if (is_streaming(writer)) {
+        flush_staging(writer);
+        if (writer->file && fflush(writer->file) != 0) {
+            writer->error = true;
+        }
+    } else {
+        // reserve() luôn chừa 1 byte cho '\0'
+        writer->data[writer->size] = '\0';
+    }
+
+    if (writer->depth != 0) {
+        LOG_ERROR("JSON output finished with %d unclosed containers", writer->depth);
+        writer->error = true;
+    }
+    return writer->error ? -1 : 0;
+}
+
+void json_writer_reset(json_writer_t *writer) {
+    if (!writer) {
+        return;
+    }
+
+    writer->size = 0;
+    writer->error = false;
+    writer->depth = 0;
+    writer->after_key = false;
+}
+
+char *json_writer_release(json_writer_t *writer, size_t *length) {
+    if (!writer || !writer->owns_data || is_streaming(writer)) {
+        return NULL;
+    }
+
+    writer->data[writer->size] = '\0';
+    char *data = writer->data;
+    if (length) {
+        *length = writer->size;
+    }
+    writer->data = NULL;
+    writer->owns_data = false;
+    return data;
+}
+
+void json_writer_free(json_writer_t *writer) {
+    if (!writer) {
+        return;
+    }
+
+    if (writer->owns_data) {
+        free(writer->data);
+    }
+    writer_reset(writer);
+}
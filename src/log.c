@@ -5,24 +5,107 @@
  #include <string.h>
  #include <time.h>
  #include <stdarg.h>
+ #include <stdbool.h>
+ #include <stdint.h>
+ #include <stdatomic.h>
  #include <pthread.h>
- 
- #define MAX_LOG_LINE_SIZE 2048
- 
+ #include <sched.h>
+ #include <errno.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <sys/uio.h>
+ #include <sys/stat.h>
+ #include <dirent.h>
+ #include "gzip_writer.h"
+ #include "log_binary.h"
+ #include "log_flight.h"
+
+ // Số dòng tối đa gộp trong một lần writev
+ #define LOG_WRITEV_BATCH 64
+
+ // Thời gian luồng ghi ngủ khi ring rỗng trước khi tự kiểm tra lại (ms)
+ #define LOG_WRITER_IDLE_MS 100
+
+ // Số bản lưu trữ tối đa chờ luồng nền nén
+ #define LOG_COMPRESS_QUEUE 16
+
+ // Kích thước đường dẫn bản lưu trữ <log>.<YYYYmmdd_HHMMSS>[_N]
+ #define LOG_ARCHIVE_PATH_SIZE (sizeof(logger_config.log_file_path) + 32)
+
  LoggerConfig logger_config = {
      .log_file_path = "application.log",
-     .log_level = LOG_LVL_DEBUG
+     .log_level = LOG_LVL_DEBUG,
+     .module_levels = { [0 ... LOG_MOD_COUNT - 1] = LOG_LVL_DEBUG },
+     .capture_levels = { [0 ... LOG_MOD_COUNT - 1] = LOG_LVL_DEBUG }
  };
- 
+
+ // Mức riêng của từng module (-1 = dùng mức chung), đọc/ghi bằng atomic relaxed
+ static signed char module_overrides[LOG_MOD_COUNT] = { [0 ... LOG_MOD_COUNT - 1] = -1 };
+
+ static const char *log_module_names[LOG_MOD_COUNT] = { "core", "parser", "tc", "file", "remote" };
+
  static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
- 
- static const char *log_level_names[] = {
-     "NONE",
-     "ERROR",
-     "WARN",
-     "DEBUG"
+
+ // " LEVEL: " dựng sẵn cho từng mức log
+ static const char *log_level_tags[] = {
+     " NONE: ",
+     " ERROR: ",
+     " WARN: ",
+     " DEBUG: "
  };
- 
+
+ /**
+  * @brief Một dòng trong ring buffer (hàng đợi bounded MPSC theo số thứ tự)
+  *
+  * sequence == pos: slot trống, producer giữ vị trí pos có thể ghi vào.
+  * sequence == pos + 1: dòng đã ghi xong, luồng ghi có thể lấy ra.
+  */
+ typedef struct {
+     atomic_size_t sequence;
+     size_t length;
+     int level;
+     char line[MAX_LOG_LINE_SIZE];
+ } log_slot_t;
+
+ // Trạng thái logger bất đồng bộ
+ static log_slot_t *ring = NULL;
+ static size_t ring_capacity = 0;
+ static atomic_size_t enqueue_pos;
+ static atomic_size_t dequeue_pos;
+ static atomic_bool async_enabled = false;
+ static atomic_int active_producers = 0;
+ static atomic_ulong dropped_lines = 0;
+ static atomic_ulong dropped_total = 0;
+ static int overflow_policy = LOG_OVERFLOW_DROP_DEBUG;
+ static int log_fd = -1;
+
+ static pthread_t writer_thread;
+ static bool writer_running = false;
+ static atomic_bool writer_stop = false;
+ static atomic_bool writer_waiting = false;
+ static pthread_mutex_t writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+ static pthread_cond_t writer_cond = PTHREAD_COND_INITIALIZER;
+ static pthread_cond_t drained_cond = PTHREAD_COND_INITIALIZER;
+
+ // Giới hạn tốc độ theo điểm gọi (rate_burst = 0: tắt)
+ static atomic_uint rate_burst = 0;
+ static atomic_uint rate_per_sec = 0;
+
+ // Chống lặp: mục log ghi gần nhất và số lần nó lặp lại từ đó, đọc/ghi khi giữ log_mutex
+ // (chế độ bất đồng bộ: luồng ghi so sánh trong lúc giữ log_mutex để ghi lô)
+ static atomic_bool dedup_enabled = false;
+ static char repeat_entry[MAX_LOG_LINE_SIZE];
+ static size_t repeat_len = 0;
+ static int repeat_level = 0;
+ static unsigned int repeat_count = 0;
+ static long long repeat_since_ns = 0;
+
+ // Chế độ nhị phân: chuỗi định dạng đã đăng ký theo id (phần tử 0 không dùng), đọc/ghi khi giữ log_mutex
+ static int log_format = LOG_FORMAT_TEXT;
+ static const char **binary_formats = NULL;
+ static int binary_format_count = 0;
+ static int binary_format_capacity = 0;
+
  void init_logger(void) {
      FILE *log_file = fopen(logger_config.log_file_path, "a");
      if (log_file) {
@@ -31,21 +114,509 @@
          fprintf(stderr, "Cannot open log file %s. Using stderr for logging.\n", logger_config.log_file_path);
      }
  }
- 
+
+ // Cấu hình xoay vòng tự động (0 = tắt tiêu chí tương ứng), đọc/ghi khi giữ log_mutex
+ static size_t rotate_max_bytes = 0;
+ static long rotate_max_age = 0;
+ static int rotate_generations = 0;
+ static int rotate_gzip_level = 0;
+ static size_t current_log_size = 0;
+ static time_t current_log_started = 0;
+
+ /**
+  * @brief Một bản lưu trữ chờ luồng nền nén và dọn các bản cũ
+  */
+ typedef struct {
+     char archive[LOG_ARCHIVE_PATH_SIZE];
+     char base[sizeof(logger_config.log_file_path)];
+     int gzip_level;
+     int generations;
+ } log_archive_job_t;
+
+ // Hàng đợi của luồng nén nền (phần tử đầu được giữ đến khi xử lý xong)
+ static log_archive_job_t compress_queue[LOG_COMPRESS_QUEUE];
+ static int compress_head = 0;
+ static int compress_count = 0;
+ static bool compress_running = false;
+ static bool compress_stop = false;
+ static pthread_t compress_thread;
+ static pthread_mutex_t compress_mutex = PTHREAD_MUTEX_INITIALIZER;
+ static pthread_cond_t compress_cond = PTHREAD_COND_INITIALIZER;
+ static pthread_cond_t compress_idle_cond = PTHREAD_COND_INITIALIZER;
+
+ /**
+  * @brief Dừng luồng nén nền sau khi xử lý hết các bản lưu trữ đang chờ
+  */
+ static void stop_compressor(void) {
+     pthread_mutex_lock(&compress_mutex);
+     bool running = compress_running;
+     compress_stop = true;
+     pthread_cond_signal(&compress_cond);
+     pthread_mutex_unlock(&compress_mutex);
+
+     if (running) {
+         pthread_join(compress_thread, NULL);
+     }
+
+     pthread_mutex_lock(&compress_mutex);
+     compress_running = false;
+     compress_stop = false;
+     pthread_mutex_unlock(&compress_mutex);
+ }
+
+ static void flush_repeats(void);
+
  void cleanup_logger(void) {
+     // Luồng ghi có thể xoay vòng khi ghi nốt ring, nên dừng trước luồng nén
+     log_async_stop();
+     flush_repeats();
+     stop_compressor();
  }
- 
+
+ /**
+  * @brief Đăng ký cleanup_logger chạy khi chương trình kết thúc bình thường
+  */
+ static void register_exit_handler(void) {
+     static bool registered = false;
+     if (!registered) {
+         atexit(cleanup_logger);
+         registered = true;
+     }
+ }
+
+ /**
+  * @brief Tính lại mức ghi file và mức dựng dòng log của mọi module
+  *
+  * Chỉ đọc/ghi atomic nên gọi được trong signal handler.
+  */
+ static void update_module_levels(void) {
+     int global = __atomic_load_n(&logger_config.log_level, __ATOMIC_RELAXED);
+     bool capture_all = log_flight_enabled();
+     for (int module = 0; module < LOG_MOD_COUNT; module++) {
+         int level = __atomic_load_n(&module_overrides[module], __ATOMIC_RELAXED);
+         if (level < 0) {
+             level = global;
+         }
+         __atomic_store_n(&logger_config.module_levels[module], (unsigned char)level, __ATOMIC_RELAXED);
+         __atomic_store_n(&logger_config.capture_levels[module],
+                          (unsigned char)(capture_all ? LOG_LVL_DEBUG : level), __ATOMIC_RELAXED);
+     }
+ }
+
  void set_log_level(int level) {
      if (level >= LOG_LVL_NONE && level <= LOG_LVL_DEBUG) {
-         logger_config.log_level = level;
+         __atomic_store_n(&logger_config.log_level, (unsigned char)level, __ATOMIC_RELAXED);
+     }
+     update_module_levels();
+ }
+
+ int set_log_module_level(int module, int level) {
+     if (module < 0 || module >= LOG_MOD_COUNT || level > LOG_LVL_DEBUG) {
+         return -1;
+     }
+     __atomic_store_n(&module_overrides[module], (signed char)(level < 0 ? -1 : level), __ATOMIC_RELAXED);
+     update_module_levels();
+     return 0;
+ }
+
+ int get_log_module_level(int module, int *is_override) {
+     if (module < 0 || module >= LOG_MOD_COUNT) {
+         return -1;
+     }
+     if (is_override) {
+         *is_override = __atomic_load_n(&module_overrides[module], __ATOMIC_RELAXED) >= 0;
+     }
+     return __atomic_load_n(&logger_config.module_levels[module], __ATOMIC_RELAXED);
+ }
+
+ const char *log_module_name(int module) {
+     return module >= 0 && module < LOG_MOD_COUNT ? log_module_names[module] : "unknown";
+ }
+
+ int log_module_from_name(const char *name) {
+     for (int module = 0; module < LOG_MOD_COUNT; module++) {
+         if (name && strcmp(name, log_module_names[module]) == 0) {
+             return module;
+         }
+     }
+     return -1;
+ }
+
+ /**
+  * @brief Ghi toàn bộ các dòng bằng writev, xử lý ghi thiếu và EINTR
+  */
+ static void write_lines(int fd, struct iovec *iov, int count) {
+     while (count > 0) {
+         ssize_t written = writev(fd, iov, count);
+         if (written < 0) {
+             if (errno == EINTR) {
+                 continue;
+             }
+             return;
+         }
+         while (count > 0 && (size_t)written >= iov->iov_len) {
+             written -= iov->iov_len;
+             iov++;
+             count--;
+         }
+         if (count > 0) {
+             iov->iov_base = (char *)iov->iov_base + written;
+             iov->iov_len -= written;
+         }
+     }
+ }
+
+ /**
+  * @brief Ghi một bản ghi nhị phân xuống log_fd; gọi khi giữ log_mutex
+  */
+ static void write_binary_record(char *record, size_t length) {
+     struct iovec iov = { .iov_base = record, .iov_len = length };
+     write_lines(log_fd, &iov, 1);
+     current_log_size += length;
+ }
+
+ /**
+  * @brief Ghi đầu phiên và mọi định dạng đã đăng ký để file tự giải mã được; gọi khi giữ log_mutex
+  */
+ static void write_binary_preamble(void) {
+     char record[MAX_LOG_LINE_SIZE];
+     size_t length = log_binary_encode_session(record, sizeof(record));
+     write_binary_record(record, length);
+     for (int id = 1; id <= binary_format_count; id++) {
+         length = log_binary_encode_format(record, sizeof(record), id, binary_formats[id]);
+         write_binary_record(record, length);
+     }
+ }
+
+ /**
+  * @brief Mở fd ghi log (O_APPEND), trả về stderr nếu không mở được; gọi khi giữ log_mutex
+  */
+ static void reopen_log_fd(void) {
+     if (log_fd > STDERR_FILENO) {
+         close(log_fd);
+     }
+     log_fd = open(logger_config.log_file_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+     if (log_fd < 0 && log_format == LOG_FORMAT_BINARY) {
+         // Không ghi bản ghi nhị phân ra stderr: thử mở lại ở lần ghi sau (thư mục log có thể chưa được tạo)
+         return;
+     }
+     if (log_fd < 0) {
+         fprintf(stderr, "Cannot open log file %s. Using stderr for logging.\n", logger_config.log_file_path);
+         log_fd = STDERR_FILENO;
+     }
+     if (log_format == LOG_FORMAT_BINARY) {
+         write_binary_preamble();
+     }
+ }
+
+ /**
+  * @brief Mở fd nếu chế độ nhị phân chưa mở được file log; gọi khi giữ log_mutex
+  *
+  * @return bool true nếu có fd để ghi
+  */
+ static bool ensure_log_fd(void) {
+     if (log_fd < 0 && log_format == LOG_FORMAT_BINARY) {
+         reopen_log_fd();
+     }
+     return log_fd >= 0;
+ }
+
+ /**
+  * @brief Đặt lại kích thước và thời điểm bắt đầu của file log hiện tại; gọi khi giữ log_mutex
+  *
+  * Tuổi của file log có sẵn được tính từ timestamp của dòng đầu tiên (hoặc của
+  * bản ghi đầu phiên với log nhị phân), để thiết bị chạy tester nhiều lần ngắn
+  * vẫn xoay vòng theo tuổi.
+  */
+ static void reset_rotation_state(void) {
+     struct stat st;
+     current_log_size = stat(logger_config.log_file_path, &st) == 0 ? (size_t)st.st_size : 0;
+     current_log_started = time(NULL);
+
+     FILE *log_file = current_log_size > 0 ? fopen(logger_config.log_file_path, "r") : NULL;
+     if (log_file) {
+         char head[sizeof(log_bin_header_t) + sizeof(log_bin_session_t) + 1];
+         size_t got = fread(head, 1, sizeof(head) - 1, log_file);
+         head[got] = '\0';
+         fclose(log_file);
+
+         time_t first = (time_t)-1;
+         struct tm tm_first;
+         memset(&tm_first, 0, sizeof(tm_first));
+         if (sscanf(head, "[%d-%d-%d %d:%d:%d", &tm_first.tm_year, &tm_first.tm_mon, &tm_first.tm_mday,
+                    &tm_first.tm_hour, &tm_first.tm_min, &tm_first.tm_sec) == 6) {
+             tm_first.tm_year -= 1900;
+             tm_first.tm_mon -= 1;
+             tm_first.tm_isdst = -1;
+             first = mktime(&tm_first);
+         } else if (got == sizeof(head) - 1) {
+             log_bin_header_t header;
+             log_bin_session_t session;
+             memcpy(&header, head, sizeof(header));
+             memcpy(&session, head + sizeof(header), sizeof(session));
+             if (header.type == LOG_BIN_SESSION && memcmp(session.magic, LOG_BIN_MAGIC, sizeof(session.magic)) == 0) {
+                 first = (time_t)(session.started_ns / 1000000000);
+             }
+         }
+         if (first != (time_t)-1 && first < current_log_started) {
+             current_log_started = first;
+         }
+     }
+ }
+
+ /**
+  * @brief Đặt tên bản lưu trữ <log>.<YYYYmmdd_HHMMSS>[_NNN]; gọi khi giữ log_mutex
+  *
+  * Các lần xoay vòng trong cùng một giây được đánh số tăng dần để thứ tự tên luôn
+  * là thứ tự thời gian, kể cả khi bản cũ hơn đã bị dọn.
+  */
+ static void archive_name(char *archive, size_t size) {
+     static time_t last_second = 0;
+     static int last_sequence = 0;
+
+     time_t now = time(NULL);
+     struct tm tm_now;
+     localtime_r(&now, &tm_now);
+     int sequence = now == last_second ? last_sequence + 1 : 0;
+
+     int len = snprintf(archive, size, "%s.", logger_config.log_file_path);
+     len += strftime(archive + len, size - len, "%Y%m%d_%H%M%S", &tm_now);
+     char gz_path[LOG_ARCHIVE_PATH_SIZE + 8];
+     for (; sequence < 1000; sequence++) {
+         if (sequence > 0) {
+             snprintf(archive + len, size - len, "_%03d", sequence);
+         }
+         snprintf(gz_path, sizeof(gz_path), "%s.gz", archive);
+         if (access(archive, F_OK) != 0 && access(gz_path, F_OK) != 0) {
+             break;
+         }
+     }
+     last_second = now;
+     last_sequence = sequence;
+ }
+
+ /**
+  * @brief Nén bản lưu trữ thành <archive>.gz rồi xóa bản gốc
+  */
+ static int compress_archive(const char *archive, int gzip_level) {
+     char gz_path[LOG_ARCHIVE_PATH_SIZE + 8];
+     snprintf(gz_path, sizeof(gz_path), "%s.gz", archive);
+     if (gzip_compress_file(archive, gz_path, gzip_level) != 0) {
+         LOG_WARN("Keeping uncompressed log archive %s", archive);
+         return -1;
+     }
+     unlink(archive);
+     return 0;
+ }
+
+ static int compare_names(const void *a, const void *b) {
+     return strcmp(*(char *const *)a, *(char *const *)b);
+ }
+
+ /**
+  * @brief Chỉ giữ lại generations bản lưu trữ mới nhất của log base
+  *
+  * Bản lưu trữ là <base>.<YYYYmmdd_HHMMSS>[_NNN][.gz]; tên tăng dần theo thời gian.
+  */
+ static void prune_archives(const char *base, int generations) {
+     if (generations <= 0) {
+         return;
+     }
+
+     char dir[sizeof(logger_config.log_file_path)];
+     const char *slash = strrchr(base, '/');
+     const char *prefix = slash ? slash + 1 : base;
+     if (slash) {
+         snprintf(dir, sizeof(dir), "%.*s", (int)(slash - base), base);
+     } else {
+         strcpy(dir, ".");
+     }
+     size_t prefix_len = strlen(prefix);
+
+     DIR *d = opendir(dir[0] ? dir : "/");
+     if (!d) {
+         return;
+     }
+     char **names = NULL;
+     size_t count = 0, capacity = 0;
+     struct dirent *entry;
+     while ((entry = readdir(d)) != NULL) {
+         const char *name = entry->d_name;
+         if (strncmp(name, prefix, prefix_len) != 0 || name[prefix_len] != '.' ||
+             name[prefix_len + 1] < '0' || name[prefix_len + 1] > '9') {
+             continue;
+         }
+         if (count == capacity) {
+             capacity = capacity ? capacity * 2 : 16;
+             char **grown = (char **)realloc(names, capacity * sizeof(char *));
+             if (!grown) {
+                 break;
+             }
+             names = grown;
+         }
+         names[count] = strdup(name);
+         if (names[count]) {
+             count++;
+         }
+     }
+     closedir(d);
+
+     // Duyệt từ mới đến cũ; <x> và <x>.gz là cùng một bản
+     qsort(names, count, sizeof(char *), compare_names);
+     int kept = 0;
+     const char *previous = NULL;
+     size_t previous_len = 0;
+     for (size_t i = count; i-- > 0;) {
+         size_t key_len = strlen(names[i]);
+         if (key_len > 3 && strcmp(names[i] + key_len - 3, ".gz") == 0) {
+             key_len -= 3;
+         }
+         if (!previous || key_len != previous_len || strncmp(names[i], previous, key_len) != 0) {
+             kept++;
+         }
+         previous = names[i];
+         previous_len = key_len;
+         if (kept > generations) {
+             char path[sizeof(dir) + 300];
+             snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+             unlink(path);
+         }
+     }
+     for (size_t i = 0; i < count; i++) {
+         free(names[i]);
+     }
+     free(names);
+ }
+
+ /**
+  * @brief Luồng nén nền: nén từng bản lưu trữ và dọn các bản cũ, ngoài mọi mutex của logger
+  */
+ static void *log_compress_main(void *arg) {
+     (void)arg;
+     for (;;) {
+         pthread_mutex_lock(&compress_mutex);
+         while (compress_count == 0 && !compress_stop) {
+             pthread_cond_wait(&compress_cond, &compress_mutex);
+         }
+         if (compress_count == 0) {
+             pthread_mutex_unlock(&compress_mutex);
+             break;
+         }
+         log_archive_job_t job = compress_queue[compress_head];
+         pthread_mutex_unlock(&compress_mutex);
+
+         if (job.gzip_level > 0) {
+             compress_archive(job.archive, job.gzip_level);
+         }
+         prune_archives(job.base, job.generations);
+
+         pthread_mutex_lock(&compress_mutex);
+         compress_head = (compress_head + 1) % LOG_COMPRESS_QUEUE;
+         compress_count--;
+         pthread_cond_broadcast(&compress_idle_cond);
+         pthread_mutex_unlock(&compress_mutex);
+     }
+     return NULL;
+ }
+
+ /**
+  * @brief Giao bản lưu trữ cho luồng nén nền; gọi khi giữ log_mutex nên không được ghi log
+  */
+ static void queue_archive(const char *archive) {
+     pthread_mutex_lock(&compress_mutex);
+     if (!compress_running) {
+         if (pthread_create(&compress_thread, NULL, log_compress_main, NULL) != 0) {
+             pthread_mutex_unlock(&compress_mutex);
+             fprintf(stderr, "Cannot start log compression thread, keeping %s uncompressed\n", archive);
+             return;
+         }
+         compress_running = true;
+         register_exit_handler();
+     }
+     if (compress_count == LOG_COMPRESS_QUEUE) {
+         pthread_mutex_unlock(&compress_mutex);
+         fprintf(stderr, "Log compression queue full, keeping %s uncompressed\n", archive);
+         return;
+     }
+     log_archive_job_t *job = &compress_queue[(compress_head + compress_count) % LOG_COMPRESS_QUEUE];
+     snprintf(job->archive, sizeof(job->archive), "%s", archive);
+     snprintf(job->base, sizeof(job->base), "%s", logger_config.log_file_path);
+     job->gzip_level = rotate_gzip_level;
+     job->generations = rotate_generations;
+     compress_count++;
+     pthread_cond_signal(&compress_cond);
+     pthread_mutex_unlock(&compress_mutex);
+ }
+
+ /**
+  * @brief Xoay vòng trước khi ghi nếu file log đã đạt kích thước hoặc tuổi cấu hình; gọi khi giữ log_mutex
+  *
+  * Trên đường ghi log chỉ có một lần rename (và mở lại fd); việc nén và xóa
+  * bản cũ do luồng nền đảm nhận.
+  */
+ static void maybe_rotate(void) {
+     time_t now = time(NULL);
+     if (!(rotate_max_bytes > 0 && current_log_size >= rotate_max_bytes) &&
+         !(rotate_max_age > 0 && now - current_log_started >= rotate_max_age)) {
+         return;
+     }
+
+     char archive[LOG_ARCHIVE_PATH_SIZE];
+     archive_name(archive, sizeof(archive));
+     current_log_size = 0;
+     current_log_started = now;
+     if (rename(logger_config.log_file_path, archive) != 0) {
+         fprintf(stderr, "Cannot rotate log file %s\n", logger_config.log_file_path);
+         return;
+     }
+     if (log_fd >= 0) {
+         reopen_log_fd();
+     }
+     queue_archive(archive);
+ }
+
+ static bool rotation_enabled(void) {
+     return rotate_max_bytes > 0 || rotate_max_age > 0;
+ }
+
+ int log_set_rotation(size_t max_bytes, long max_age_sec, int generations, int gzip_level) {
+     if (max_age_sec < 0 || generations < 0 || gzip_level < 0 || gzip_level > 9) {
+         return -1;
+     }
+     pthread_mutex_lock(&log_mutex);
+     rotate_max_bytes = max_bytes;
+     rotate_max_age = max_age_sec;
+     rotate_generations = generations;
+     rotate_gzip_level = gzip_level;
+     reset_rotation_state();
+     pthread_mutex_unlock(&log_mutex);
+     return 0;
+ }
+
+ void log_rotation_wait(void) {
+     pthread_mutex_lock(&compress_mutex);
+     while (compress_count > 0 && compress_running) {
+         pthread_cond_wait(&compress_idle_cond, &compress_mutex);
      }
+     pthread_mutex_unlock(&compress_mutex);
  }
- 
+
  void set_log_file(const char *file_path) {
      if (file_path) {
+         // Các dòng log trước khi đổi file vẫn thuộc về file cũ
+         log_flush();
+
+         pthread_mutex_lock(&log_mutex);
          strncpy(logger_config.log_file_path, file_path, sizeof(logger_config.log_file_path) - 1);
          logger_config.log_file_path[sizeof(logger_config.log_file_path) - 1] = '\0';
-         
+         if (log_fd >= 0) {
+             reopen_log_fd();
+         }
+         if (rotation_enabled()) {
+             reset_rotation_state();
+         }
+         pthread_mutex_unlock(&log_mutex);
+
          FILE *log_file = fopen(logger_config.log_file_path, "a");
          if (log_file) {
              fclose(log_file);
@@ -54,65 +625,859 @@
          }
      }
  }
- 
- void log_message(int level, const char *format, ...) {
-     if (level <= LOG_LVL_NONE || level > LOG_LVL_DEBUG || level > logger_config.log_level) {
-         return;
+
+ /**
+  * @brief Phần "[YYYY-mm-dd HH:MM:SS" đã định dạng của giây hiện tại, riêng cho từng thread
+  *
+  * localtime_r có thể khóa và đọc trạng thái múi giờ, nên chỉ gọi khi sang giây mới.
+  */
+ typedef struct {
+     time_t second;
+     size_t length;
+     char text[24];
+ } log_time_cache_t;
+
+ static __thread log_time_cache_t time_cache = { .second = (time_t)-1 };
+
+ // Buffer định dạng của từng thread khi ghi trực tiếp
+ static __thread char thread_log_buffer[MAX_LOG_LINE_SIZE];
+
+ static int timestamp_mode = LOG_TS_SECONDS;
+
+ void set_log_timestamp(int mode) {
+     if (mode >= LOG_TS_SECONDS && mode <= LOG_TS_MONO_MICROS) {
+         timestamp_mode = mode;
      }
-     
-  // Lấy thời gian hiện tại
-  time_t now = time(NULL);
-  struct tm tm_now;
-  localtime_r(&now, &tm_now);
-  
-  char time_str[20];
-  strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &tm_now);
-  
-  // Tạo chuỗi log
-  char log_buffer[MAX_LOG_LINE_SIZE];
-  
+ }
+
+ /**
+  * @brief Ghi số nguyên không âm với đúng width chữ số (thêm 0 ở đầu)
+  */
+ static size_t put_digits(char *out, unsigned long value, int width) {
+     for (int i = width - 1; i >= 0; i--) {
+         out[i] = (char)('0' + value % 10);
+         value /= 10;
+     }
+     return (size_t)width;
+ }
+
+ size_t log_format_header(char *out, int level, const struct timespec *realtime,
+                          const struct timespec *monotonic, int mode) {
+     if (realtime->tv_sec != time_cache.second) {
+         struct tm tm_now;
+         localtime_r(&realtime->tv_sec, &tm_now);
+         time_cache.text[0] = '[';
+         time_cache.length = 1 + strftime(time_cache.text + 1, sizeof(time_cache.text) - 1,
+                                          "%Y-%m-%d %H:%M:%S", &tm_now);
+         time_cache.second = realtime->tv_sec;
+     }
+
+     size_t pos = time_cache.length;
+     memcpy(out, time_cache.text, pos);
+     if (mode == LOG_TS_MILLIS) {
+         out[pos++] = '.';
+         pos += put_digits(out + pos, (unsigned long)(realtime->tv_nsec / 1000000), 3);
+     }
+     out[pos++] = ']';
+     if (mode == LOG_TS_MONO_MICROS) {
+         pos += sprintf(out + pos, " [%lu.", (unsigned long)monotonic->tv_sec);
+         pos += put_digits(out + pos, (unsigned long)(monotonic->tv_nsec / 1000), 6);
+         out[pos++] = ']';
+     }
+
+     size_t tag_len = strlen(log_level_tags[level]);
+     memcpy(out + pos, log_level_tags[level], tag_len + 1);
+     return pos + tag_len;
+ }
+
+ /**
+  * @brief Dựng header "[timestamp] LEVEL: " cho thời điểm hiện tại, dùng phần thời gian đã cache
+  *
+  * @return size_t Độ dài header (buffer phải có ít nhất 64 byte)
+  */
+ static size_t format_log_header(char *out, int level) {
+     struct timespec now, mono = { 0, 0 };
+     clock_gettime(CLOCK_REALTIME, &now);
+     if (timestamp_mode == LOG_TS_MONO_MICROS) {
+         clock_gettime(CLOCK_MONOTONIC, &mono);
+     }
+     return log_format_header(out, level, &now, &mono, timestamp_mode);
+ }
+
+ /**
+  * @brief Định dạng một dòng log hoàn chỉnh (timestamp, level, nội dung, '\n')
+  *
+  * @return size_t Độ dài dòng, 0 nếu lỗi
+  */
+ static size_t format_log_line(char *log_buffer, size_t size, int level, const char *format, va_list args) {
   // Header với timestamp và log level
-  int header_len = snprintf(log_buffer, sizeof(log_buffer), "[%s] %s: ", 
-                           time_str, log_level_names[level]);
-  
-  if (header_len < 0 || header_len >= sizeof(log_buffer)) {
-      return; // Lỗi khi tạo header
-  }
-  
+  size_t header_len = format_log_header(log_buffer, level);
+
   // Nội dung log
-  va_list args;
-  va_start(args, format);
-  int content_len = vsnprintf(log_buffer + header_len, sizeof(log_buffer) - header_len, 
+  int content_len = vsnprintf(log_buffer + header_len, size - header_len,
                             format, args);
-  va_end(args);
-  
+
   if (content_len < 0) {
-      return; // Lỗi khi tạo nội dung
+      return 0; // Lỗi khi tạo nội dung
   }
-  
+
   // Đảm bảo có ký tự xuống dòng ở cuối
   size_t total_len = header_len + content_len;
-  if (total_len < sizeof(log_buffer) - 2) {
+  if (total_len < size - 2) {
       if (log_buffer[total_len - 1] != '\n') {
           log_buffer[total_len] = '\n';
           log_buffer[total_len + 1] = '\0';
+          total_len++;
       }
   } else {
       // Đặt ký tự xuống dòng cho chuỗi quá dài
-      log_buffer[sizeof(log_buffer) - 2] = '\n';
-      log_buffer[sizeof(log_buffer) - 1] = '\0';
+      log_buffer[size - 2] = '\n';
+      log_buffer[size - 1] = '\0';
+      total_len = size - 1;
   }
-  
-  pthread_mutex_lock(&log_mutex);
-  
+  return total_len;
+}
+
+/**
+ * @brief Dựng một mục log theo định dạng hiện tại
+ *
+ * Chế độ text: dòng text đầy đủ. Chế độ nhị phân: bản ghi RECORD nếu điểm gọi
+ * đã có id (id > 0), ngược lại bản ghi TEXT.
+ *
+ * @return size_t Độ dài mục log, 0 nếu lỗi
+ */
+static size_t format_entry(char *out, size_t size, const log_site_t *site, int id, int level,
+                           const char *format, va_list args) {
+    if (log_format != LOG_FORMAT_BINARY) {
+        return format_log_line(out, size, level, format, args);
+    }
+    if (id > 0) {
+        return log_binary_encode_record(out, size, id, level, timestamp_mode, site->arg_types, site->arg_count, args);
+    }
+    return log_binary_encode_text(out, size, level, timestamp_mode, format, args);
+}
+
+static size_t format_entryf(char *out, size_t size, int level, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    size_t len = format_entry(out, size, NULL, 0, level, format, args);
+    va_end(args);
+    return len;
+}
+
+/**
+ * @brief Đăng ký chuỗi định dạng của điểm gọi và ghi bản ghi FORMAT; gọi khi giữ log_mutex
+ *
+ * @return int Id mới, -1 nếu định dạng không ghi được dạng nhị phân
+ */
+static int register_format(log_site_t *site, const char *format) {
+    unsigned char types[LOG_SITE_MAX_ARGS];
+    int count = log_binary_parse_format(format, types, LOG_SITE_MAX_ARGS);
+    char record[MAX_LOG_LINE_SIZE];
+    size_t length = 0;
+    int id = -1;
+
+    if (count >= 0 && binary_format_count < UINT16_MAX &&
+        (length = log_binary_encode_format(record, sizeof(record), binary_format_count + 1, format)) > 0) {
+        if (binary_format_count + 1 >= binary_format_capacity) {
+            int capacity = binary_format_capacity ? binary_format_capacity * 2 : 256;
+            const char **grown = (const char **)realloc(binary_formats, capacity * sizeof(char *));
+            if (grown) {
+                binary_formats = grown;
+                binary_format_capacity = capacity;
+            }
+        }
+        if (binary_format_count + 1 < binary_format_capacity) {
+            // Chuỗi định dạng là hằng (xem LOG_AT) nên giữ con trỏ
+            id = ++binary_format_count;
+            binary_formats[id] = format;
+            memcpy(site->arg_types, types, (size_t)count);
+            site->arg_count = (unsigned char)count;
+            if (log_fd >= 0) {
+                write_binary_record(record, length);
+            }
+        }
+    }
+    __atomic_store_n(&site->id, id, __ATOMIC_RELEASE);
+    return id;
+}
+
+/**
+ * @brief Id định dạng của điểm gọi, đăng ký ở lần gọi đầu tiên trong chế độ nhị phân
+ *
+ * @return int Id (> 0), -1 nếu lời gọi phải ghi dạng bản ghi TEXT
+ */
+static int binary_site_id(log_site_t *site, const char *format) {
+    if (!site) {
+        return -1;
+    }
+    int id = __atomic_load_n(&site->id, __ATOMIC_ACQUIRE);
+    if (id == 0) {
+        pthread_mutex_lock(&log_mutex);
+        id = site->id;
+        if (id == 0) {
+            id = register_format(site, format);
+        }
+        pthread_mutex_unlock(&log_mutex);
+    }
+    return id;
+}
+
+/**
+ * @brief Độ dài phần đầu thay đổi theo thời điểm ghi (timestamp), bỏ qua khi so sánh hai mục log
+ */
+static size_t entry_time_length(const char *entry, size_t len, int level) {
+    if (log_format == LOG_FORMAT_BINARY) {
+        log_bin_header_t header;
+        if (len < sizeof(header)) {
+            return 0;
+        }
+        memcpy(&header, entry, sizeof(header));
+        size_t skip = sizeof(int64_t) * (header.ts_mode == LOG_TS_MONO_MICROS ? 2 : 1);
+        return sizeof(header) + skip <= len ? skip : 0;
+    }
+    const char *tag = strstr(entry, log_level_tags[level]);
+    return tag ? (size_t)(tag - entry) : 0;
+}
+
+/**
+ * @brief Hai mục log có cùng mức và nội dung (không tính timestamp)
+ */
+static bool same_entry(const char *entry, size_t len, int level) {
+    if (level != repeat_level || len != repeat_len) {
+        return false;
+    }
+    size_t skip = entry_time_length(entry, len, level);
+    if (skip != entry_time_length(repeat_entry, repeat_len, level)) {
+        return false;
+    }
+    // Bản ghi nhị phân: header (id, mức) đứng trước timestamp
+    size_t prefix = log_format == LOG_FORMAT_BINARY && skip > 0 ? sizeof(log_bin_header_t) : 0;
+    return memcmp(entry, repeat_entry, prefix) == 0 &&
+           memcmp(entry + prefix + skip, repeat_entry + prefix + skip, len - prefix - skip) == 0;
+}
+
+/**
+ * @brief Dựng dòng "Last message repeated N times" cho các dòng lặp đang đếm; gọi khi giữ log_mutex
+ *
+ * @return size_t Độ dài dòng tổng kết, 0 nếu không có dòng lặp
+ */
+static size_t take_repeat_summary(char *out, size_t size) {
+    if (repeat_count == 0) {
+        return 0;
+    }
+    size_t len = format_entryf(out, size, repeat_level, "Last message repeated %u times", repeat_count);
+    repeat_count = 0;
+    return len;
+}
+
+static long long monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * @brief Chống lặp cho mục log sắp ghi; gọi khi giữ log_mutex
+ *
+ * Mục log và dòng tổng kết được ghi trong cùng lần giữ log_mutex nên dòng tổng
+ * kết luôn đứng ngay sau dòng bị lặp.
+ *
+ * @param summary Nhận dòng tổng kết phải ghi trước mục log
+ * @param summary_len Nhận độ dài dòng tổng kết (0: không có)
+ * @return bool true nếu ghi mục log, false nếu nó lặp lại dòng vừa ghi và chỉ được đếm
+ */
+static bool collapse_repeat(const char *entry, size_t len, int level,
+                            char *summary, size_t summary_size, size_t *summary_len) {
+    *summary_len = 0;
+    if (!atomic_load_explicit(&dedup_enabled, memory_order_relaxed)) {
+        return true;
+    }
+
+    if (repeat_len > 0 && same_entry(entry, len, level)) {
+        repeat_count++;
+        // Dòng còn lặp lâu: báo định kỳ để log không im lặng
+        long long now = monotonic_ns();
+        if (now - repeat_since_ns >= LOG_REPEAT_FLUSH_SEC * 1000000000LL) {
+            *summary_len = take_repeat_summary(summary, summary_size);
+            repeat_since_ns = now;
+        }
+        return false;
+    }
+
+    *summary_len = take_repeat_summary(summary, summary_size);
+    if (len <= sizeof(repeat_entry)) {
+        memcpy(repeat_entry, entry, len);
+        repeat_len = len;
+        repeat_level = level;
+        repeat_since_ns = monotonic_ns();
+    } else {
+        repeat_len = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief Đánh thức luồng ghi
+ */
+static void wake_writer(void) {
+    pthread_mutex_lock(&writer_mutex);
+    pthread_cond_signal(&writer_cond);
+    pthread_mutex_unlock(&writer_mutex);
+}
+
+/**
+ * @brief Ghi thông báo số dòng đã bị bỏ (nếu có) trước các dòng tiếp theo
+ */
+static void write_dropped_notice(void) {
+    unsigned long dropped = atomic_exchange(&dropped_lines, 0);
+    if (dropped == 0) {
+        return;
+    }
+    char notice[256];
+    size_t len = format_entryf(notice, sizeof(notice), LOG_LVL_WARN,
+                               "%lu log lines dropped (async log buffer full)", dropped);
+    struct iovec iov = { .iov_base = notice, .iov_len = len };
+    pthread_mutex_lock(&log_mutex);
+    write_lines(log_fd, &iov, 1);
+    current_log_size += len;
+    pthread_mutex_unlock(&log_mutex);
+}
+
+/**
+ * @brief Luồng ghi: lấy các dòng liên tiếp đã sẵn sàng và ghi gộp bằng một lần writev
+ */
+static void *log_writer_main(void *arg) {
+    (void)arg;
+    struct iovec iov[LOG_WRITEV_BATCH];
+    // Mỗi dòng có thể kèm một dòng "Last message repeated" đứng trước
+    struct iovec out[LOG_WRITEV_BATCH * 2];
+    static char summaries[LOG_WRITEV_BATCH][128];
+
+    for (;;) {
+        // Đọc cờ dừng trước khi gom: producer đã rời hết khi cờ được đặt
+        bool stopping = atomic_load(&writer_stop);
+        size_t pos = atomic_load_explicit(&dequeue_pos, memory_order_relaxed);
+        int count = 0;
+        while (count < LOG_WRITEV_BATCH) {
+            log_slot_t *slot = &ring[(pos + count) & (ring_capacity - 1)];
+            if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != pos + count + 1) {
+                break;
+            }
+            iov[count].iov_base = slot->line;
+            iov[count].iov_len = slot->length;
+            count++;
+        }
+
+        write_dropped_notice();
+
+        if (count > 0) {
+            pthread_mutex_lock(&log_mutex);
+            // Chống lặp ở luồng ghi duy nhất: producer không lấy thêm khóa nào
+            int out_count = 0;
+            for (int i = 0; i < count; i++) {
+                const log_slot_t *slot = &ring[(pos + i) & (ring_capacity - 1)];
+                size_t summary_len;
+                bool keep = collapse_repeat(slot->line, slot->length, slot->level,
+                                            summaries[i], sizeof(summaries[i]), &summary_len);
+                if (summary_len > 0) {
+                    out[out_count].iov_base = summaries[i];
+                    out[out_count++].iov_len = summary_len;
+                }
+                if (keep) {
+                    out[out_count++] = iov[i];
+                }
+            }
+            for (int first = 0; first < out_count;) {
+                if (rotation_enabled()) {
+                    maybe_rotate();
+                }
+                ensure_log_fd();
+
+                // Chỉ ghi đến dòng làm file đạt giới hạn kích thước, các dòng sau sang file mới
+                int last = first;
+                size_t part_bytes = 0;
+                do {
+                    part_bytes += out[last++].iov_len;
+                } while (last < out_count &&
+                         (rotate_max_bytes == 0 || current_log_size + part_bytes < rotate_max_bytes));
+                write_lines(log_fd, out + first, last - first);
+                current_log_size += part_bytes;
+                first = last;
+            }
+            pthread_mutex_unlock(&log_mutex);
+
+            // Trả slot cho vòng tiếp theo của ring
+            for (int i = 0; i < count; i++) {
+                atomic_store_explicit(&ring[(pos + i) & (ring_capacity - 1)].sequence,
+                                      pos + i + ring_capacity, memory_order_release);
+            }
+            atomic_store_explicit(&dequeue_pos, pos + count, memory_order_release);
+
+            pthread_mutex_lock(&writer_mutex);
+            pthread_cond_broadcast(&drained_cond);
+            pthread_mutex_unlock(&writer_mutex);
+            continue;
+        }
+
+        if (stopping) {
+            break;
+        }
+
+        // Ring rỗng: ngủ đến khi producer đánh thức (hoặc hết thời gian chờ)
+        pthread_mutex_lock(&writer_mutex);
+        atomic_store(&writer_waiting, true);
+        log_slot_t *next = &ring[pos & (ring_capacity - 1)];
+        if (atomic_load_explicit(&next->sequence, memory_order_acquire) != pos + 1 &&
+            !atomic_load(&writer_stop) && atomic_load(&dropped_lines) == 0) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += LOG_WRITER_IDLE_MS * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&writer_cond, &writer_mutex, &deadline);
+        }
+        atomic_store(&writer_waiting, false);
+        pthread_mutex_unlock(&writer_mutex);
+    }
+
+    pthread_mutex_lock(&writer_mutex);
+    pthread_cond_broadcast(&drained_cond);
+    pthread_mutex_unlock(&writer_mutex);
+    return NULL;
+}
+
+/**
+ * @brief Chép mục log đã dựng vào một slot của ring
+ *
+ * @return true nếu mục log đã được xử lý (ghi vào ring hoặc bị bỏ theo chính sách),
+ *         false nếu chế độ bất đồng bộ không bật
+ */
+static bool async_log(const char *entry, size_t len, int level) {
+    atomic_fetch_add(&active_producers, 1);
+    if (!atomic_load(&async_enabled)) {
+        atomic_fetch_sub(&active_producers, 1);
+        return false;
+    }
+
+    size_t pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+    log_slot_t *slot;
+    for (;;) {
+        slot = &ring[pos & (ring_capacity - 1)];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Ring đầy
+            if (overflow_policy == LOG_OVERFLOW_DROP ||
+                (overflow_policy == LOG_OVERFLOW_DROP_DEBUG && level == LOG_LVL_DEBUG)) {
+                atomic_fetch_add(&dropped_lines, 1);
+                atomic_fetch_add(&dropped_total, 1);
+                atomic_fetch_sub(&active_producers, 1);
+                if (atomic_load(&writer_waiting)) {
+                    wake_writer();
+                }
+                return true;
+            }
+            if (atomic_load(&writer_waiting)) {
+                wake_writer();
+            }
+            sched_yield();
+            pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+        } else {
+            pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    memcpy(slot->line, entry, len);
+    slot->length = len;
+    slot->level = level;
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+    atomic_fetch_sub(&active_producers, 1);
+
+    if (atomic_load(&writer_waiting)) {
+        wake_writer();
+    }
+    return true;
+}
+
+/**
+ * @brief Ghi trực tiếp một mục log vào file (xoay vòng nếu cần); gọi khi giữ log_mutex
+ */
+static void write_locked(const char *entry, size_t len) {
+  bool rotating = rotation_enabled();
+  if (rotating) {
+      maybe_rotate();
+  }
+
+  if (ensure_log_fd()) {
+      // Chế độ nhị phân giữ fd mở: bản ghi có byte 0 nên không ghi bằng fputs
+      struct iovec iov = { .iov_base = (void *)entry, .iov_len = len };
+      write_lines(log_fd, &iov, 1);
+      current_log_size += len;
+      return;
+  }
+  if (log_format == LOG_FORMAT_BINARY) {
+      return;
+  }
+
   // Ghi log vào file
   FILE *log_file = fopen(logger_config.log_file_path, "a");
   if (log_file) {
-      fputs(log_buffer, log_file);
+      fwrite(entry, 1, len, log_file);
+      if (rotating) {
+          long file_size = ftell(log_file);
+          current_log_size = file_size > 0 ? (size_t)file_size : current_log_size + len;
+      }
       fclose(log_file);
   } else {
-      fputs(log_buffer, stderr);
+      fwrite(entry, 1, len, stderr);
+  }
+}
+
+/**
+ * @brief Ghi một mục log đã dựng (qua ring nếu bật chế độ bất đồng bộ)
+ *
+ * Chế độ đồng bộ chống lặp ngay dưới log_mutex; chế độ bất đồng bộ để luồng ghi làm.
+ */
+static void write_entry(const char *entry, size_t len, int level) {
+  if (async_log(entry, len, level)) {
+      return;
+  }
+
+  pthread_mutex_lock(&log_mutex);
+  char summary[128];
+  size_t summary_len;
+  bool keep = collapse_repeat(entry, len, level, summary, sizeof(summary), &summary_len);
+  if (summary_len > 0) {
+      write_locked(summary, summary_len);
   }
-  
+  if (keep) {
+      write_locked(entry, len);
+  }
+  pthread_mutex_unlock(&log_mutex);
+}
+
+/**
+ * @brief Ghi ra số dòng lặp đang đếm và quên dòng cuối (gọi sau khi ring đã ghi hết)
+ */
+static void flush_repeats(void) {
+  pthread_mutex_lock(&log_mutex);
+  char summary[128];
+  size_t len = take_repeat_summary(summary, sizeof(summary));
+  if (len > 0) {
+      write_locked(summary, len);
+  }
+  repeat_len = 0;
   pthread_mutex_unlock(&log_mutex);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Token bucket của điểm gọi: cho ghi tối đa rate_burst dòng liên tiếp, nạp lại rate_per_sec dòng/giây
+ *
+ * @param site Điểm gọi (NULL: không giới hạn)
+ * @param suppressed Nhận số dòng đã bị bỏ trước dòng này (chỉ khi dòng được ghi)
+ * @return true nếu dòng được ghi
+ */
+static bool rate_allow(log_site_t *site, unsigned int *suppressed) {
+    unsigned int burst = atomic_load_explicit(&rate_burst, memory_order_relaxed);
+    *suppressed = 0;
+    if (!site || burst == 0) {
+        return true;
+    }
+
+    unsigned int per_sec = atomic_load_explicit(&rate_per_sec, memory_order_relaxed);
+    long long now = monotonic_ns();
+    while (__atomic_test_and_set(&site->rate_lock, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+
+    if (site->rate_refill_ns == 0) {
+        site->rate_tokens = burst;
+        site->rate_refill_ns = now;
+    } else if (per_sec > 0) {
+        long long period = 1000000000LL / per_sec;
+        long long refill = (now - site->rate_refill_ns) / period;
+        if (refill > 0) {
+            unsigned long long tokens = site->rate_tokens + (unsigned long long)refill;
+            site->rate_tokens = tokens < burst ? (unsigned int)tokens : burst;
+            // Giữ phần lẻ của chu kỳ nạp khi bucket chưa đầy
+            site->rate_refill_ns = tokens < burst ? site->rate_refill_ns + refill * period : now;
+        }
+    }
+
+    bool allowed = site->rate_tokens > 0;
+    if (allowed) {
+        site->rate_tokens--;
+        *suppressed = site->rate_suppressed;
+        site->rate_suppressed = 0;
+    } else {
+        site->rate_suppressed++;
+    }
+    __atomic_clear(&site->rate_lock, __ATOMIC_RELEASE);
+    return allowed;
+}
+
+static void log_vmessage(log_site_t *site, int level, const char *format, va_list args);
+
+static void log_notice(int level, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    log_vmessage(NULL, level, format, args);
+    va_end(args);
+}
+
+/**
+ * @brief Ghi một mục log (qua ring nếu bật chế độ bất đồng bộ)
+ *
+ * @param site Điểm gọi (NULL khi gọi log_message trực tiếp)
+ */
+static void log_vmessage(log_site_t *site, int level, const char *format, va_list args) {
+  // Điểm gọi vượt giới hạn bị bỏ trước khi định dạng hay lấy khóa nào
+  unsigned int suppressed;
+  if (!rate_allow(site, &suppressed)) {
+      return;
+  }
+  if (suppressed > 0) {
+      log_notice(level, "Suppressed %u messages like \"%s\"", suppressed, format);
+  }
+
+  // Flight recorder giữ dòng ở mọi mức, dạng text để dump được ngay cả khi file log là nhị phân
+  size_t flight_len = 0;
+  if (log_flight_enabled()) {
+      va_list copy;
+      va_copy(copy, args);
+      flight_len = format_log_line(thread_log_buffer, sizeof(thread_log_buffer), level, format, copy);
+      va_end(copy);
+      log_flight_record(thread_log_buffer, flight_len);
+  }
+  int module = site ? site->module : LOG_MOD_CORE;
+  if (level > __atomic_load_n(&logger_config.module_levels[module], __ATOMIC_RELAXED)) {
+      return;
+  }
+
+  // Tạo mục log trong buffer riêng của thread (dòng text của flight recorder dùng lại được)
+  int id = log_format == LOG_FORMAT_BINARY ? binary_site_id(site, format) : 0;
+  size_t len = flight_len > 0 && log_format != LOG_FORMAT_BINARY ? flight_len :
+               format_entry(thread_log_buffer, sizeof(thread_log_buffer), site, id, level, format, args);
+  if (len > 0) {
+      write_entry(thread_log_buffer, len, level);
+  }
+}
+
+ void log_message(int level, const char *format, ...) {
+     if (level <= LOG_LVL_NONE || level > LOG_LVL_DEBUG ||
+         level > __atomic_load_n(&logger_config.capture_levels[LOG_MOD_CORE], __ATOMIC_RELAXED)) {
+         return;
+     }
+
+     va_list args;
+     va_start(args, format);
+     log_vmessage(NULL, level, format, args);
+     va_end(args);
+ }
+
+ void log_site_message(log_site_t *site, int level, const char *format, ...) {
+     int module = site && site->module < LOG_MOD_COUNT ? site->module : LOG_MOD_CORE;
+     if (level <= LOG_LVL_NONE || level > LOG_LVL_DEBUG ||
+         level > __atomic_load_n(&logger_config.capture_levels[module], __ATOMIC_RELAXED)) {
+         return;
+     }
+
+     va_list args;
+     va_start(args, format);
+     log_vmessage(site, level, format, args);
+     va_end(args);
+ }
+
+ int set_log_format(int format) {
+     if (format != LOG_FORMAT_TEXT && format != LOG_FORMAT_BINARY) {
+         return -1;
+     }
+
+     // Các dòng đang chờ được ghi theo định dạng cũ
+     log_flush();
+
+     pthread_mutex_lock(&log_mutex);
+     if (format != log_format) {
+         log_format = format;
+         if (format == LOG_FORMAT_BINARY) {
+             // Giữ fd mở để ghi bản ghi nhị phân, bắt đầu bằng đầu phiên và bảng định dạng
+             reopen_log_fd();
+         } else if (!writer_running && log_fd > STDERR_FILENO) {
+             close(log_fd);
+             log_fd = -1;
+         }
+     }
+     pthread_mutex_unlock(&log_mutex);
+     return 0;
+ }
+
+int log_async_start(size_t slots, int policy) {
+    if (writer_running) {
+        return 0;
+    }
+    if (policy < LOG_OVERFLOW_DROP || policy > LOG_OVERFLOW_DROP_DEBUG) {
+        return -1;
+    }
+
+    // Làm tròn lên lũy thừa của 2 để lấy chỉ số bằng phép AND
+    size_t capacity = 2;
+    while (capacity < slots) {
+        capacity <<= 1;
+    }
+    ring = (log_slot_t *)malloc(capacity * sizeof(log_slot_t));
+    if (!ring) {
+        fprintf(stderr, "Cannot allocate async log buffer (%zu lines)\n", capacity);
+        return -1;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&ring[i].sequence, i);
+        ring[i].length = 0;
+    }
+    ring_capacity = capacity;
+    overflow_policy = policy;
+    atomic_store(&enqueue_pos, 0);
+    atomic_store(&dequeue_pos, 0);
+    atomic_store(&dropped_lines, 0);
+    atomic_store(&dropped_total, 0);
+    atomic_store(&writer_stop, false);
+
+    // Chế độ nhị phân đã có fd mở
+    pthread_mutex_lock(&log_mutex);
+    if (log_fd < 0) {
+        reopen_log_fd();
+    }
+    pthread_mutex_unlock(&log_mutex);
+
+    if (pthread_create(&writer_thread, NULL, log_writer_main, NULL) != 0) {
+        fprintf(stderr, "Cannot start async log writer thread\n");
+        pthread_mutex_lock(&log_mutex);
+        if (log_format != LOG_FORMAT_BINARY) {
+            if (log_fd > STDERR_FILENO) {
+                close(log_fd);
+            }
+            log_fd = -1;
+        }
+        pthread_mutex_unlock(&log_mutex);
+        free(ring);
+        ring = NULL;
+        return -1;
+    }
+    writer_running = true;
+    atomic_store(&async_enabled, true);
+
+    // Các dòng còn trong ring được ghi xuống khi chương trình kết thúc bình thường
+    register_exit_handler();
+    return 0;
+}
+
+void log_async_stop(void) {
+    if (!writer_running) {
+        return;
+    }
+
+    // Chặn producer mới rồi chờ các producer đang ghi vào slot hoàn tất
+    atomic_store(&async_enabled, false);
+    while (atomic_load(&active_producers) > 0) {
+        sched_yield();
+    }
+
+    atomic_store(&writer_stop, true);
+    wake_writer();
+    pthread_join(writer_thread, NULL);
+    writer_running = false;
+
+    // Chế độ nhị phân luôn ghi qua fd nên giữ fd mở
+    pthread_mutex_lock(&log_mutex);
+    if (log_format != LOG_FORMAT_BINARY) {
+        if (log_fd > STDERR_FILENO) {
+            close(log_fd);
+        }
+        log_fd = -1;
+    }
+    pthread_mutex_unlock(&log_mutex);
+
+    free(ring);
+    ring = NULL;
+    ring_capacity = 0;
+}
+
+void log_flush(void) {
+    if (!atomic_load(&async_enabled)) {
+        flush_repeats();
+        return;
+    }
+
+    size_t target = atomic_load(&enqueue_pos);
+    pthread_mutex_lock(&writer_mutex);
+    while (atomic_load(&dequeue_pos) < target && !atomic_load(&writer_stop)) {
+        pthread_cond_signal(&writer_cond);
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec++;
+        pthread_cond_timedwait(&drained_cond, &writer_mutex, &deadline);
+    }
+    pthread_mutex_unlock(&writer_mutex);
+
+    // Luồng ghi đã so sánh hết các dòng trong ring
+    flush_repeats();
+}
+
+unsigned long log_async_dropped(void) {
+    return atomic_load(&dropped_total);
+}
+
+int log_set_rate_limit(unsigned int burst, unsigned int per_sec) {
+    if (burst > 0 && per_sec > 1000000000U) {
+        return -1;
+    }
+    atomic_store(&rate_per_sec, per_sec);
+    atomic_store(&rate_burst, burst);
+    return 0;
+}
+
+void log_set_dedup(int enabled) {
+    if (!enabled) {
+        log_flush();
+    }
+    atomic_store(&dedup_enabled, enabled != 0);
+}
+
+int rotate_log_file(int gzip_level) {
+    char archive_path[LOG_ARCHIVE_PATH_SIZE];
+    char base[sizeof(logger_config.log_file_path)];
+
+    log_flush();
+
+    // Đổi tên dưới mutex: dòng log kế tiếp sẽ tạo file mới
+    pthread_mutex_lock(&log_mutex);
+    archive_name(archive_path, sizeof(archive_path));
+    int ret = rename(logger_config.log_file_path, archive_path);
+    if (ret == 0) {
+        current_log_size = 0;
+        current_log_started = time(NULL);
+        if (log_fd >= 0) {
+            reopen_log_fd();
+        }
+    }
+    snprintf(base, sizeof(base), "%s", logger_config.log_file_path);
+    int generations = rotate_generations;
+    pthread_mutex_unlock(&log_mutex);
+
+    if (ret != 0) {
+        fprintf(stderr, "Cannot rotate log file %s\n", logger_config.log_file_path);
+        return -1;
+    }
+
+    // Nén ngoài mutex để không chặn các luồng đang ghi log
+    int status = gzip_level > 0 ? compress_archive(archive_path, gzip_level) : 0;
+    prune_archives(base, generations);
+    return status;
+}
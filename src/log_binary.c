@@ -0,0 +1,718 @@
+
+ #include "log_binary.h"
+ #include <stdlib.h>
+ #include <string.h>
+ #include <stdbool.h>
+ #include <time.h>
+ #include <zlib.h>
+
+ #define LOG_BIN_BYTE_ORDER 0x01020304u
+
+ // Độ dài tối đa của một đặc tả chuyển đổi (dài hơn thì ghi dạng text)
+ #define LOG_SPEC_MAX 32
+
+ // Độ dài của chuỗi NULL trong bản ghi
+ #define LOG_STRING_NULL 0xFFFF
+
+ // Modifier độ dài của đặc tả chuyển đổi
+ enum {
+     LOG_LEN_NONE = 0,
+     LOG_LEN_HH,
+     LOG_LEN_H,
+     LOG_LEN_L,
+     LOG_LEN_LL,
+     LOG_LEN_J,
+     LOG_LEN_Z,
+     LOG_LEN_T,
+     LOG_LEN_BIG_L
+ };
+
+ /**
+  * @brief Một đặc tả chuyển đổi printf "%[flags][width][.precision][length]conversion"
+  */
+ typedef struct {
+     const char *start;      // Ký tự '%'
+     const char *end;        // Ngay sau ký tự chuyển đổi
+     bool width_star;
+     bool precision_star;
+     int precision;          // -1 nếu không có hoặc là '*'
+     int length;
+     char conversion;
+ } log_spec_t;
+
+ /**
+  * @brief Đọc một đặc tả chuyển đổi bắt đầu tại p ('%', không phải "%%")
+  *
+  * @return bool false nếu đặc tả không hợp lệ hoặc quá dài
+  */
+ static bool scan_spec(const char *p, log_spec_t *spec) {
+     memset(spec, 0, sizeof(*spec));
+     spec->start = p++;
+     spec->precision = -1;
+
+     while (*p && strchr("-+ #0'", *p)) {
+         p++;
+     }
+     if (*p == '*') {
+         spec->width_star = true;
+         p++;
+     } else {
+         while (*p >= '0' && *p <= '9') {
+             p++;
+         }
+     }
+     if (*p == '.') {
+         p++;
+         if (*p == '*') {
+             spec->precision_star = true;
+             p++;
+         } else {
+             spec->precision = 0;
+             while (*p >= '0' && *p <= '9') {
+                 if (spec->precision < 100000) {
+                     spec->precision = spec->precision * 10 + (*p - '0');
+                 }
+                 p++;
+             }
+         }
+     }
+
+     switch (*p) {
+     case 'h':
+         spec->length = p[1] == 'h' ? LOG_LEN_HH : LOG_LEN_H;
+         p += p[1] == 'h' ? 2 : 1;
+         break;
+     case 'l':
+         spec->length = p[1] == 'l' ? LOG_LEN_LL : LOG_LEN_L;
+         p += p[1] == 'l' ? 2 : 1;
+         break;
+     case 'q':
+         spec->length = LOG_LEN_LL;
+         p++;
+         break;
+     case 'j':
+         spec->length = LOG_LEN_J;
+         p++;
+         break;
+     case 'z':
+         spec->length = LOG_LEN_Z;
+         p++;
+         break;
+     case 't':
+         spec->length = LOG_LEN_T;
+         p++;
+         break;
+     case 'L':
+         spec->length = LOG_LEN_BIG_L;
+         p++;
+         break;
+     default:
+         break;
+     }
+
+     spec->conversion = *p;
+     if (*p == '\0') {
+         return false;
+     }
+     spec->end = p + 1;
+     return spec->end - spec->start <= LOG_SPEC_MAX;
+ }
+
+ /**
+  * @brief Kiểu tham số của đặc tả, -1 nếu không ghi được dạng nhị phân
+  */
+ static int spec_type(const log_spec_t *spec) {
+     switch (spec->conversion) {
+     case 'c':
+         return spec->length == LOG_LEN_NONE ? LOG_ARG_INT : -1;
+     case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+         switch (spec->length) {
+         case LOG_LEN_NONE: case LOG_LEN_HH: case LOG_LEN_H: return LOG_ARG_INT;
+         case LOG_LEN_L: return LOG_ARG_LONG;
+         case LOG_LEN_LL: return LOG_ARG_LLONG;
+         case LOG_LEN_J: return LOG_ARG_INTMAX;
+         case LOG_LEN_Z: return LOG_ARG_SIZE;
+         case LOG_LEN_T: return LOG_ARG_PTRDIFF;
+         default: return -1;
+         }
+     case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+         if (spec->length == LOG_LEN_BIG_L) {
+             return LOG_ARG_LDOUBLE;
+         }
+         return spec->length == LOG_LEN_NONE || spec->length == LOG_LEN_L ? LOG_ARG_DOUBLE : -1;
+     case 's':
+         if (spec->length != LOG_LEN_NONE) {
+             return -1;
+         }
+         if (spec->precision_star) {
+             return LOG_ARG_STRING_STAR;
+         }
+         return spec->precision >= 0 ? LOG_ARG_STRING_PREC : LOG_ARG_STRING;
+     case 'p':
+         return spec->length == LOG_LEN_NONE ? LOG_ARG_POINTER : -1;
+     default:
+         // %n, %m (phụ thuộc errno lúc ghi), tham số theo vị trí '$'...
+         return -1;
+     }
+ }
+
+ int log_binary_parse_format(const char *format, unsigned char *types, int max_types) {
+     int count = 0;
+     for (const char *p = format; *p; p++) {
+         if (*p != '%') {
+             continue;
+         }
+         if (p[1] == '%') {
+             p++;
+             continue;
+         }
+
+         log_spec_t spec;
+         if (!scan_spec(p, &spec)) {
+             return -1;
+         }
+         int type = spec_type(&spec);
+         if (type < 0 || (type == LOG_ARG_STRING_PREC && spec.precision > 255)) {
+             return -1;
+         }
+         int needed = spec.width_star + spec.precision_star + 1 + (type == LOG_ARG_STRING_PREC);
+         if (count + needed > max_types) {
+             return -1;
+         }
+         if (spec.width_star) {
+             types[count++] = LOG_ARG_INT;
+         }
+         if (spec.precision_star) {
+             types[count++] = LOG_ARG_INT;
+         }
+         types[count++] = (unsigned char)type;
+         if (type == LOG_ARG_STRING_PREC) {
+             types[count++] = (unsigned char)spec.precision;
+         }
+         p = spec.end - 1;
+     }
+     return count;
+ }
+
+ /**
+  * @brief Số byte tối đa một tham số chiếm trong bản ghi
+  */
+ static size_t arg_size(int type) {
+     switch (type) {
+     case LOG_ARG_INT: return sizeof(int);
+     case LOG_ARG_LONG: return sizeof(long);
+     case LOG_ARG_LLONG: return sizeof(long long);
+     case LOG_ARG_SIZE: return sizeof(size_t);
+     case LOG_ARG_PTRDIFF: return sizeof(ptrdiff_t);
+     case LOG_ARG_INTMAX: return sizeof(intmax_t);
+     case LOG_ARG_DOUBLE: return sizeof(double);
+     case LOG_ARG_LDOUBLE: return sizeof(long double);
+     case LOG_ARG_POINTER: return sizeof(void *);
+     default: return sizeof(uint16_t);
+     }
+ }
+
+ /**
+  * @brief Chép n byte vào bản ghi nếu còn chỗ
+  */
+ static bool put(char *out, size_t size, size_t *pos, const void *value, size_t n) {
+     if (*pos + n > size) {
+         return false;
+     }
+     memcpy(out + *pos, value, n);
+     *pos += n;
+     return true;
+ }
+
+ /**
+  * @brief Ghi header (độ dài được điền sau) và timestamp nếu là RECORD/TEXT
+  *
+  * @return size_t Vị trí dữ liệu kế tiếp, 0 nếu buffer không đủ
+  */
+ static size_t begin_record(char *out, size_t size, int type, int level, int id, int ts_mode) {
+     log_bin_header_t header;
+     memset(&header, 0, sizeof(header));
+     header.type = (uint8_t)type;
+     header.level = (uint8_t)level;
+     header.id = (uint16_t)id;
+     header.ts_mode = (uint8_t)ts_mode;
+
+     size_t pos = 0;
+     if (!put(out, size, &pos, &header, sizeof(header))) {
+         return 0;
+     }
+     if (type == LOG_BIN_RECORD || type == LOG_BIN_TEXT) {
+         struct timespec now;
+         clock_gettime(CLOCK_REALTIME, &now);
+         int64_t ns = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+         if (!put(out, size, &pos, &ns, sizeof(ns))) {
+             return 0;
+         }
+         if (ts_mode == LOG_TS_MONO_MICROS) {
+             clock_gettime(CLOCK_MONOTONIC, &now);
+             ns = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+             if (!put(out, size, &pos, &ns, sizeof(ns))) {
+                 return 0;
+             }
+         }
+     }
+     return pos;
+ }
+
+ /**
+  * @brief Điền độ dài vào header
+  */
+ static size_t end_record(char *out, size_t pos) {
+     uint16_t length = (uint16_t)pos;
+     memcpy(out, &length, sizeof(length));
+     return pos;
+ }
+
+ size_t log_binary_encode_session(char *out, size_t size) {
+     size_t pos = begin_record(out, size, LOG_BIN_SESSION, 0, 0, 0);
+     if (pos == 0) {
+         return 0;
+     }
+
+     log_bin_session_t session;
+     memset(&session, 0, sizeof(session));
+     memcpy(session.magic, LOG_BIN_MAGIC, sizeof(session.magic));
+     session.version = LOG_BIN_VERSION;
+     session.pointer_size = (uint8_t)sizeof(void *);
+     session.byte_order = LOG_BIN_BYTE_ORDER;
+     struct timespec now;
+     clock_gettime(CLOCK_REALTIME, &now);
+     session.started_ns = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+     if (!put(out, size, &pos, &session, sizeof(session))) {
+         return 0;
+     }
+     return end_record(out, pos);
+ }
+
+ size_t log_binary_encode_format(char *out, size_t size, int id, const char *format) {
+     if (size > UINT16_MAX) {
+         size = UINT16_MAX;
+     }
+     size_t pos = begin_record(out, size, LOG_BIN_FORMAT, 0, id, 0);
+     if (pos == 0 || !put(out, size, &pos, format, strlen(format) + 1)) {
+         return 0;
+     }
+     return end_record(out, pos);
+ }
+
+ size_t log_binary_encode_record(char *out, size_t size, int id, int level, int ts_mode,
+                                 const unsigned char *types, int type_count, va_list args) {
+     if (size > UINT16_MAX) {
+         size = UINT16_MAX;
+     }
+     size_t pos = begin_record(out, size, LOG_BIN_RECORD, level, id, ts_mode);
+     if (pos == 0) {
+         return 0;
+     }
+
+     int last_int = -1;
+     for (int i = 0; i < type_count; i++) {
+         bool ok;
+         switch (types[i]) {
+         case LOG_ARG_INT: {
+             int value = va_arg(args, int);
+             last_int = value;
+             ok = put(out, size, &pos, &value, sizeof(value));
+             break;
+         }
+         case LOG_ARG_LONG: {
+             long value = va_arg(args, long);
+             ok = put(out, size, &pos, &value, sizeof(value));
+             break;
+         }
+         case LOG_ARG_LLONG: {
+             long long value = va_arg(args, long long);
+             ok = put(out, size, &pos, &value, sizeof(value));
+             break;
+         }
+         case LOG_ARG_SIZE: {
+             size_t value = va_arg(args, size_t);
+             ok = put(out, size, &pos, &value, sizeof(value));
+             break;
+         }
+         case LOG_ARG_PTRDIFF: {
+             ptrdiff_t value = va_arg(args, ptrdiff_t);
+             ok = put(out, size, &pos, &value, sizeof(value));
+             break;
+         }
+         case LOG_ARG_INTMAX: {
+             intmax_t value = va_arg(args, intmax_t);
+             ok = put(out, size, &pos, &value, sizeof(value));
+             break;
+         }
+         case LOG_ARG_DOUBLE: {
+             double value = va_arg(args, double);
+             ok = put(out, size, &pos, &value, sizeof(value));
+             break;
+         }
+         case LOG_ARG_LDOUBLE: {
+             long double value = va_arg(args, long double);
+             ok = put(out, size, &pos, &value, sizeof(value));
+             break;
+         }
+         case LOG_ARG_POINTER: {
+             void *value = va_arg(args, void *);
+             ok = put(out, size, &pos, &value, sizeof(value));
+             break;
+         }
+         default: {
+             const char *value = va_arg(args, const char *);
+             size_t bound = (size_t)-1;
+             if (types[i] == LOG_ARG_STRING_PREC) {
+                 bound = types[++i];
+             } else if (types[i] == LOG_ARG_STRING_STAR && last_int >= 0) {
+                 bound = (size_t)last_int;
+             }
+
+             // Chừa chỗ cho các tham số phía sau, cắt chuỗi nếu không đủ
+             size_t reserve = sizeof(uint16_t);
+             for (int j = i + 1; j < type_count; j++) {
+                 reserve += arg_size(types[j]);
+                 if (types[j] == LOG_ARG_STRING_PREC) {
+                     j++;
+                 }
+             }
+             size_t room = pos + reserve < size ? size - pos - reserve : 0;
+             if (bound > room) {
+                 bound = room;
+             }
+
+             uint16_t length = value ? (uint16_t)strnlen(value, bound) : LOG_STRING_NULL;
+             ok = put(out, size, &pos, &length, sizeof(length)) &&
+                  (!value || put(out, size, &pos, value, length));
+             break;
+         }
+         }
+         if (!ok) {
+             return 0;
+         }
+     }
+     return end_record(out, pos);
+ }
+
+ size_t log_binary_encode_text(char *out, size_t size, int level, int ts_mode, const char *format, va_list args) {
+     if (size > UINT16_MAX) {
+         size = UINT16_MAX;
+     }
+     size_t pos = begin_record(out, size, LOG_BIN_TEXT, level, 0, ts_mode);
+     if (pos == 0 || pos >= size) {
+         return 0;
+     }
+     int len = vsnprintf(out + pos, size - pos, format, args);
+     if (len < 0) {
+         return 0;
+     }
+     // Bỏ ký tự '\0' cuối (khi bị cắt, vsnprintf đã đặt '\0' ở byte cuối của buffer)
+     pos += (size_t)len < size - pos ? (size_t)len : size - pos - 1;
+     return end_record(out, pos);
+ }
+
+ /**
+  * @brief Lấy n byte tiếp theo của dữ liệu bản ghi
+  */
+ static bool take(const char **data, size_t *left, void *value, size_t n) {
+     if (*left < n) {
+         return false;
+     }
+     memcpy(value, *data, n);
+     *data += n;
+     *left -= n;
+     return true;
+ }
+
+ /**
+  * @brief Định dạng lại nội dung dòng log từ chuỗi định dạng và tham số thô
+  *
+  * Mỗi đặc tả được gọi snprintf riêng với đúng kiểu C gốc; '*' được thay bằng
+  * giá trị đã lưu.
+  *
+  * @param data Tham số thô (buffer phải có thêm 1 byte sau dữ liệu)
+  * @return size_t Độ dài nội dung (giống vsnprintf: có thể lớn hơn size)
+  */
+ static size_t render_message(char *out, size_t size, const char *format, char *data, size_t left) {
+     size_t pos = 0;
+     const char *cursor = data;
+
+     for (const char *p = format; *p; p++) {
+         if (*p != '%' || p[1] == '%') {
+             if (pos + 1 < size) {
+                 out[pos] = *p;
+             }
+             pos++;
+             p += *p == '%';
+             continue;
+         }
+
+         log_spec_t spec;
+         if (!scan_spec(p, &spec)) {
+             break;
+         }
+         int type = spec_type(&spec);
+         int width = 0, precision = 0;
+         if ((spec.width_star && !take(&cursor, &left, &width, sizeof(width))) ||
+             (spec.precision_star && !take(&cursor, &left, &precision, sizeof(precision)))) {
+             break;
+         }
+
+         // Đặc tả với '*' được thay bằng số; độ chính xác âm coi như không có
+         char spec_text[LOG_SPEC_MAX + 32];
+         size_t s = 0;
+         for (const char *c = spec.start; c < spec.end; c++) {
+             if (*c != '*') {
+                 spec_text[s++] = *c;
+             } else if (c[-1] != '.') {
+                 s += sprintf(spec_text + s, "%d", width);
+             } else if (precision >= 0) {
+                 s += sprintf(spec_text + s, "%d", precision);
+             } else {
+                 s--;
+             }
+         }
+         spec_text[s] = '\0';
+
+         char *dst = out + (pos < size ? pos : size);
+         size_t room = pos < size ? size - pos : 0;
+         int n = -1;
+         switch (type) {
+         case LOG_ARG_INT: {
+             int value;
+             if (take(&cursor, &left, &value, sizeof(value))) {
+                 n = snprintf(dst, room, spec_text, value);
+             }
+             break;
+         }
+         case LOG_ARG_LONG: {
+             long value;
+             if (take(&cursor, &left, &value, sizeof(value))) {
+                 n = snprintf(dst, room, spec_text, value);
+             }
+             break;
+         }
+         case LOG_ARG_LLONG: {
+             long long value;
+             if (take(&cursor, &left, &value, sizeof(value))) {
+                 n = snprintf(dst, room, spec_text, value);
+             }
+             break;
+         }
+         case LOG_ARG_SIZE: {
+             size_t value;
+             if (take(&cursor, &left, &value, sizeof(value))) {
+                 n = snprintf(dst, room, spec_text, value);
+             }
+             break;
+         }
+         case LOG_ARG_PTRDIFF: {
+             ptrdiff_t value;
+             if (take(&cursor, &left, &value, sizeof(value))) {
+                 n = snprintf(dst, room, spec_text, value);
+             }
+             break;
+         }
+         case LOG_ARG_INTMAX: {
+             intmax_t value;
+             if (take(&cursor, &left, &value, sizeof(value))) {
+                 n = snprintf(dst, room, spec_text, value);
+             }
+             break;
+         }
+         case LOG_ARG_DOUBLE: {
+             double value;
+             if (take(&cursor, &left, &value, sizeof(value))) {
+                 n = snprintf(dst, room, spec_text, value);
+             }
+             break;
+         }
+         case LOG_ARG_LDOUBLE: {
+             long double value;
+             if (take(&cursor, &left, &value, sizeof(value))) {
+                 n = snprintf(dst, room, spec_text, value);
+             }
+             break;
+         }
+         case LOG_ARG_POINTER: {
+             void *value;
+             if (take(&cursor, &left, &value, sizeof(value))) {
+                 n = snprintf(dst, room, spec_text, value);
+             }
+             break;
+         }
+         case LOG_ARG_STRING:
+         case LOG_ARG_STRING_PREC:
+         case LOG_ARG_STRING_STAR: {
+             uint16_t length;
+             if (!take(&cursor, &left, &length, sizeof(length))) {
+                 break;
+             }
+             if (length == LOG_STRING_NULL) {
+                 n = snprintf(dst, room, spec_text, (const char *)NULL);
+             } else if (length <= left) {
+                 // Kết thúc chuỗi tại chỗ rồi trả lại byte cũ
+                 char *value = (char *)cursor;
+                 char saved = value[length];
+                 value[length] = '\0';
+                 n = snprintf(dst, room, spec_text, value);
+                 value[length] = saved;
+                 cursor += length;
+                 left -= length;
+             }
+             break;
+         }
+         default:
+             break;
+         }
+         if (n < 0) {
+             break;
+         }
+         pos += (size_t)n;
+         p = spec.end - 1;
+     }
+
+     if (size > 0) {
+         out[pos < size ? pos : size - 1] = '\0';
+     }
+     return pos;
+ }
+
+ /**
+  * @brief Dựng dòng log text hoàn chỉnh từ bản ghi RECORD hoặc TEXT
+  *
+  * @return size_t Độ dài dòng, 0 nếu bản ghi hỏng
+  */
+ static size_t render_line(char *line, size_t size, const log_bin_header_t *header, char *data, size_t left,
+                           char **formats) {
+     struct timespec realtime, monotonic = { 0, 0 };
+     int64_t ns;
+     if (header->level > LOG_LVL_DEBUG || header->ts_mode > LOG_TS_MONO_MICROS ||
+         !take((const char **)&data, &left, &ns, sizeof(ns))) {
+         return 0;
+     }
+     realtime.tv_sec = (time_t)(ns / 1000000000);
+     realtime.tv_nsec = (long)(ns % 1000000000);
+     if (header->ts_mode == LOG_TS_MONO_MICROS) {
+         if (!take((const char **)&data, &left, &ns, sizeof(ns))) {
+             return 0;
+         }
+         monotonic.tv_sec = (time_t)(ns / 1000000000);
+         monotonic.tv_nsec = (long)(ns % 1000000000);
+     }
+
+     size_t header_len = log_format_header(line, header->level, &realtime, &monotonic, header->ts_mode);
+     size_t content_len;
+     if (header->type == LOG_BIN_TEXT) {
+         content_len = left;
+         memcpy(line + header_len, data, left < size - header_len ? left : size - header_len - 1);
+     } else if (formats[header->id]) {
+         content_len = render_message(line + header_len, size - header_len, formats[header->id], data, left);
+     } else {
+         content_len = (size_t)snprintf(line + header_len, size - header_len, "<unknown log format %u>",
+                                        (unsigned)header->id);
+     }
+
+     // Giống format_log_line: thêm '\n' nếu thiếu, dòng quá dài bị cắt
+     size_t total_len = header_len + content_len;
+     if (total_len < size - 2) {
+         if (line[total_len - 1] != '\n') {
+             line[total_len++] = '\n';
+         }
+         line[total_len] = '\0';
+     } else {
+         line[size - 2] = '\n';
+         line[size - 1] = '\0';
+         total_len = size - 1;
+     }
+     return total_len;
+ }
+
+ long log_binary_decode_file(const char *path, FILE *out) {
+     gzFile in = gzopen(path, "rb");
+     if (!in) {
+         return -1;
+     }
+
+     // Một byte dư để kết thúc chuỗi tại chỗ khi định dạng lại
+     char *data = (char *)malloc((size_t)UINT16_MAX + 1);
+     char **formats = (char **)calloc((size_t)UINT16_MAX + 1, sizeof(char *));
+     char line[MAX_LOG_LINE_SIZE];
+     long lines = 0;
+     bool session = false;
+     bool corrupt = !data || !formats;
+
+     while (!corrupt) {
+         log_bin_header_t header;
+         int n = gzread(in, &header, sizeof(header));
+         if (n == 0) {
+             break;
+         }
+         if (n != (int)sizeof(header) || header.length < sizeof(header)) {
+             corrupt = true;
+             break;
+         }
+         size_t left = header.length - sizeof(header);
+         if (left > 0 && gzread(in, data, (unsigned)left) != (int)left) {
+             corrupt = true;
+             break;
+         }
+         data[left] = '\0';
+
+         switch (header.type) {
+         case LOG_BIN_SESSION: {
+             // Id chỉ có nghĩa trong một phiên: bỏ bảng định dạng của phiên trước
+             log_bin_session_t info;
+             if (left < sizeof(info)) {
+                 corrupt = true;
+                 break;
+             }
+             memcpy(&info, data, sizeof(info));
+             if (memcmp(info.magic, LOG_BIN_MAGIC, sizeof(info.magic)) != 0 || info.version != LOG_BIN_VERSION ||
+                 info.pointer_size != sizeof(void *) || info.byte_order != LOG_BIN_BYTE_ORDER) {
+                 corrupt = true;
+                 break;
+             }
+             for (size_t i = 0; i <= UINT16_MAX; i++) {
+                 free(formats[i]);
+                 formats[i] = NULL;
+             }
+             session = true;
+             break;
+         }
+         case LOG_BIN_FORMAT:
+             if (!session || left == 0) {
+                 corrupt = true;
+                 break;
+             }
+             free(formats[header.id]);
+             formats[header.id] = strndup(data, left);
+             break;
+         case LOG_BIN_RECORD:
+         case LOG_BIN_TEXT: {
+             size_t len = session ? render_line(line, sizeof(line), &header, data, left, formats) : 0;
+             if (len == 0) {
+                 corrupt = true;
+                 break;
+             }
+             fwrite(line, 1, len, out);
+             lines++;
+             break;
+         }
+         default:
+             corrupt = true;
+             break;
+         }
+     }
+
+     if (formats) {
+         for (size_t i = 0; i <= UINT16_MAX; i++) {
+             free(formats[i]);
+         }
+     }
+     free(formats);
+     free(data);
+     gzclose(in);
+     return corrupt ? -1 : lines;
+ }
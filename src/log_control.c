@@ -0,0 +1,322 @@
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "log_control.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#define LOG_CONTROL_COMMAND_SIZE 512
+#define LOG_CONTROL_REPLY_SIZE 256
+#define LOG_CONTROL_POLL_MS 500
+
+static const char *level_names[] = { "none", "error", "warn", "debug" };
+
+/* SIGUSR2: mức chung trước khi bật DEBUG (-1 = chưa bật) */
+static volatile sig_atomic_t saved_level = -1;
+static struct sigaction saved_usr2;
+static bool signal_installed = false;
+
+/* Luồng socket */
+static pthread_t control_thread;
+static bool control_running = false;
+static volatile int control_stop = 0;
+static int listen_fd = -1;
+static char socket_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+/**
+ * @brief SIGUSR2: chuyển mức chung sang DEBUG, lần sau trả về mức trước đó
+ *
+ * set_log_level chỉ ghi atomic nên gọi được ở đây.
+ */
+static void handle_debug_toggle(int sig) {
+    (void)sig;
+    int current = __atomic_load_n(&logger_config.log_level, __ATOMIC_RELAXED);
+    if (current != LOG_LVL_DEBUG) {
+        saved_level = current;
+        set_log_level(LOG_LVL_DEBUG);
+    } else if (saved_level >= 0) {
+        set_log_level(saved_level);
+        saved_level = -1;
+    }
+}
+
+/**
+ * @brief Đọc mức log dạng số (0-3) hoặc tên
+ *
+ * @return int Mức log, -1 nếu không hợp lệ
+ */
+static int parse_level(const char *text) {
+    if (text[0] >= '0' && text[0] <= '3' && text[1] == '\0') {
+        return text[0] - '0';
+    }
+    for (int level = LOG_LVL_NONE; level <= LOG_LVL_DEBUG; level++) {
+        if (strcasecmp(text, level_names[level]) == 0) {
+            return level;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Dựng "OK global=<mức> <module>=<mức>..."; module có mức riêng được đánh dấu '*'
+ */
+static int format_levels(char *reply, size_t reply_size) {
+    int len = snprintf(reply, reply_size, "OK global=%s", level_names[logger_config.log_level]);
+    for (int module = 0; module < LOG_MOD_COUNT && len > 0 && (size_t)len < reply_size; module++) {
+        int is_override = 0;
+        int level = get_log_module_level(module, &is_override);
+        len += snprintf(reply + len, reply_size - len, " %s=%s%s", log_module_name(module),
+                        level_names[level], is_override ? "*" : "");
+    }
+    if (len > 0 && (size_t)len < reply_size - 1) {
+        reply[len++] = '\n';
+        reply[len] = '\0';
+    }
+    return 0;
+}
+
+static int reply_error(char *reply, size_t reply_size, const char *message) {
+    snprintf(reply, reply_size, "ERR %s\n", message);
+    return -1;
+}
+
+int log_control_execute(const char *command, char *reply, size_t reply_size) {
+    char line[LOG_CONTROL_COMMAND_SIZE];
+    snprintf(line, sizeof(line), "%s", command);
+    line[strcspn(line, "\r\n")] = '\0';
+
+    char *save = NULL;
+    char *verb = strtok_r(line, " \t", &save);
+    if (!verb) {
+        return reply_error(reply, reply_size, "empty command");
+    }
+
+    if (strcmp(verb, "level") == 0) {
+        char *first = strtok_r(NULL, " \t", &save);
+        char *second = strtok_r(NULL, " \t", &save);
+        if (!first) {
+            return format_levels(reply, reply_size);
+        }
+        if (!second) {
+            int level = parse_level(first);
+            if (level < 0) {
+                return reply_error(reply, reply_size, "level must be 0-3 or none/error/warn/debug");
+            }
+            set_log_level(level);
+            saved_level = -1;
+            LOG_WARN("Log level set to %s via control", level_names[level]);
+            return format_levels(reply, reply_size);
+        }
+
+        int module = log_module_from_name(first);
+        if (module < 0) {
+            return reply_error(reply, reply_size, "module must be core/parser/tc/file/remote");
+        }
+        int level = strcmp(second, "default") == 0 ? -1 : parse_level(second);
+        if (level < 0 && strcmp(second, "default") != 0) {
+            return reply_error(reply, reply_size, "level must be 0-3, none/error/warn/debug or default");
+        }
+        set_log_module_level(module, level);
+        LOG_WARN("Log level of module %s set to %s via control", first, second);
+        return format_levels(reply, reply_size);
+    }
+
+    if (strcmp(verb, "file") == 0) {
+        char *path = save ? save + strspn(save, " \t") : NULL;
+        if (!path || *path == '\0' || strlen(path) >= sizeof(logger_config.log_file_path)) {
+            return reply_error(reply, reply_size, "usage: file <path>");
+        }
+        LOG_WARN("Switching log file to %s via control", path);
+        set_log_file(path);
+        snprintf(reply, reply_size, "OK file=%s\n", logger_config.log_file_path);
+        return 0;
+    }
+
+    return reply_error(reply, reply_size, "unknown command (level, file)");
+}
+
+static int send_all(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t n = send(fd, data, length, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Thực thi từng dòng lệnh của một kết nối cho đến khi client đóng hoặc hết thời gian chờ
+ */
+static void handle_client(int fd) {
+    struct timeval timeout = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char buffer[LOG_CONTROL_COMMAND_SIZE];
+    size_t used = 0;
+    while (!control_stop) {
+        ssize_t n = recv(fd, buffer + used, sizeof(buffer) - 1 - used, 0);
+        if (n <= 0) {
+            break;
+        }
+        used += (size_t)n;
+        buffer[used] = '\0';
+
+        char *start = buffer;
+        char *newline;
+        while ((newline = strchr(start, '\n')) != NULL) {
+            *newline = '\0';
+            char reply[LOG_CONTROL_REPLY_SIZE];
+            log_control_execute(start, reply, sizeof(reply));
+            if (send_all(fd, reply, strlen(reply)) != 0) {
+                return;
+            }
+            start = newline + 1;
+        }
+        used -= (size_t)(start - buffer);
+        memmove(buffer, start, used);
+        if (used == sizeof(buffer) - 1) {
+            // Dòng quá dài
+            const char *reply = "ERR command too long\n";
+            send_all(fd, reply, strlen(reply));
+            return;
+        }
+    }
+}
+
+static void *control_main(void *arg) {
+    (void)arg;
+    struct pollfd pfd = { listen_fd, POLLIN, 0 };
+    while (!control_stop) {
+        int ready = poll(&pfd, 1, LOG_CONTROL_POLL_MS);
+        if (ready <= 0) {
+            continue;
+        }
+        int client = accept(listen_fd, NULL, NULL);
+        if (client < 0) {
+            continue;
+        }
+        handle_client(client);
+        close(client);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Kiểm tra socket tại đường dẫn còn tiến trình lắng nghe không
+ *
+ * Socket cũ còn lại sau khi chương trình trước bị kill (kết nối bị từ chối)
+ * được xóa để bind lại; socket đang có người lắng nghe thì giữ nguyên.
+ */
+static bool socket_in_use(const struct sockaddr_un *addr) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    int rc = connect(fd, (const struct sockaddr *)addr, sizeof(*addr));
+    int err = errno;
+    close(fd);
+    if (rc == 0) {
+        return true;
+    }
+    if (err == ECONNREFUSED) {
+        unlink(addr->sun_path);
+    }
+    return false;
+}
+
+int log_control_start(const char *path) {
+    if (!signal_installed) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sigemptyset(&sa.sa_mask);
+        sa.sa_handler = handle_debug_toggle;
+        sa.sa_flags = SA_RESTART;
+        sigaction(SIGUSR2, &sa, &saved_usr2);
+        signal_installed = true;
+    }
+    if (!path || control_running) {
+        return control_running ? -1 : 0;
+    }
+    if (strlen(path) >= sizeof(socket_path)) {
+        LOG_ERROR("Control socket path too long: %s", path);
+        return -1;
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        LOG_ERROR("Failed to create control socket: %s", strerror(errno));
+        return -1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    if (socket_in_use(&addr)) {
+        LOG_ERROR("Control socket %s is in use by another instance", path);
+        close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+
+    // Chỉ người dùng đang chạy chương trình được đổi cấu hình log: quyền 0600 ngay lúc tạo
+    mode_t old_mask = umask(S_IXUSR | S_IRWXG | S_IRWXO);
+    int rc = bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(old_mask);
+    if (rc != 0 || listen(listen_fd, 4) != 0) {
+        LOG_ERROR("Failed to listen on control socket %s: %s", path, strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+    strcpy(socket_path, path);
+
+    control_stop = 0;
+    if (pthread_create(&control_thread, NULL, control_main, NULL) != 0) {
+        LOG_ERROR("Failed to start control socket thread");
+        close(listen_fd);
+        listen_fd = -1;
+        unlink(path);
+        return -1;
+    }
+    control_running = true;
+    LOG_DEBUG("Accepting log control commands on %s", path);
+    return 0;
+}
+
+void log_control_stop(void) {
+    if (control_running) {
+        control_stop = 1;
+        pthread_join(control_thread, NULL);
+        control_running = false;
+    }
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+        unlink(socket_path);
+    }
+    if (signal_installed) {
+        sigaction(SIGUSR2, &saved_usr2, NULL);
+        signal_installed = false;
+    }
+}
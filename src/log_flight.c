@@ -0,0 +1,251 @@
+
+ #include "log_flight.h"
+ #include "log.h"
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <stdint.h>
+ #include <stdatomic.h>
+ #include <errno.h>
+ #include <fcntl.h>
+ #include <sched.h>
+ #include <signal.h>
+ #include <unistd.h>
+
+ // Số lần thử lấy khóa dump trong signal handler trước khi dump không khóa
+ // (luồng bị ngắt có thể đang dump)
+ #define FLIGHT_SIGNAL_SPINS 1000
+
+ // Kích thước stack riêng cho signal handler (dump được cả khi tràn stack)
+ #define FLIGHT_ALT_STACK_SIZE 65536
+
+ // Các tín hiệu làm chương trình kết thúc, dump trước khi chạy hành động mặc định
+ static const int fatal_signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+ #define FATAL_SIGNAL_COUNT (sizeof(fatal_signals) / sizeof(fatal_signals[0]))
+
+ // Ring theo byte; flight_head là tổng số byte đã giữ chỗ, vị trí trong ring là flight_head % flight_capacity.
+ // Luồng ghi giữ chỗ bằng atomic_fetch_add rồi chép không khóa; chỉ các lần dump giữ flight_dump_lock.
+ static char *flight_ring = NULL;
+ static size_t flight_capacity = 0;
+ static atomic_uint_fast64_t flight_head = 0;
+ static uint64_t flight_dumped = 0;
+ static atomic_flag flight_dump_lock = ATOMIC_FLAG_INIT;
+ static atomic_bool flight_on = false;
+ // Số luồng đang chép vào ring (log_flight_stop chờ về 0 trước khi giải phóng ring)
+ static atomic_int flight_writers = 0;
+ static char flight_path[sizeof(logger_config.log_file_path) + 16];
+
+ static struct sigaction saved_fatal[FATAL_SIGNAL_COUNT];
+ static struct sigaction saved_usr1;
+ static char flight_alt_stack[FLIGHT_ALT_STACK_SIZE];
+
+ /**
+  * @brief Lấy khóa dump (ngăn hai lần dump hoặc dump và giải phóng ring chạy cùng lúc)
+  *
+  * @param max_spins Số lần thử tối đa (0 = chờ đến khi lấy được)
+  * @return bool true nếu đã lấy được khóa
+  */
+ static bool flight_acquire(int max_spins) {
+     for (int i = 0; atomic_flag_test_and_set_explicit(&flight_dump_lock, memory_order_acquire); i++) {
+         if (max_spins > 0 && i >= max_spins) {
+             return false;
+         }
+         sched_yield();
+     }
+     return true;
+ }
+
+ static void flight_release(void) {
+     atomic_flag_clear_explicit(&flight_dump_lock, memory_order_release);
+ }
+
+ void log_flight_record(const char *line, size_t length) {
+     atomic_fetch_add(&flight_writers, 1);
+     if (atomic_load(&flight_on) && length > 0) {
+         if (length > flight_capacity) {
+             line += length - flight_capacity;
+             length = flight_capacity;
+         }
+         // Giữ chỗ rồi chép không khóa: dòng đang chép dở khi dump chỉ làm hỏng dòng đó trong file dump
+         uint64_t start = atomic_fetch_add_explicit(&flight_head, length, memory_order_relaxed);
+         size_t offset = (size_t)(start % flight_capacity);
+         size_t first = length < flight_capacity - offset ? length : flight_capacity - offset;
+         memcpy(flight_ring + offset, line, first);
+         memcpy(flight_ring, line + first, length - first);
+     }
+     atomic_fetch_sub(&flight_writers, 1);
+ }
+
+ /**
+  * @brief Chép chuỗi vào buffer (dùng được trong signal handler)
+  */
+ static size_t append_text(char *out, size_t pos, size_t size, const char *text) {
+     while (*text && pos + 1 < size) {
+         out[pos++] = *text++;
+     }
+     return pos;
+ }
+
+ /**
+  * @brief Ghi toàn bộ buffer, thử lại khi bị ngắt (dùng được trong signal handler)
+  */
+ static void write_all(int fd, const char *data, size_t length) {
+     while (length > 0) {
+         ssize_t n = write(fd, data, length);
+         if (n < 0 && errno == EINTR) {
+             continue;
+         }
+         if (n <= 0) {
+             return;
+         }
+         data += n;
+         length -= (size_t)n;
+     }
+ }
+
+ /**
+  * @brief Ghi phần ring chưa dump ra file; chỉ dùng hàm an toàn trong signal handler
+  *
+  * @param in_signal true khi gọi từ signal handler: không chờ khóa vô hạn
+  */
+ static int flight_write(const char *reason, bool in_signal) {
+     bool locked = flight_acquire(in_signal ? FLIGHT_SIGNAL_SPINS : 0);
+     int status = -1;
+
+     int fd = flight_ring ? open(flight_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644) : -1;
+     if (fd >= 0) {
+         char header[256];
+         size_t n = append_text(header, 0, sizeof(header), "===== flight recorder: ");
+         n = append_text(header, n, sizeof(header), reason);
+         n = append_text(header, n, sizeof(header), " =====\n");
+         write_all(fd, header, n);
+
+         // Phần đầu đã bị ghi đè từ lần dump trước: bỏ dòng bị cắt dở ở đầu
+         uint64_t head = atomic_load_explicit(&flight_head, memory_order_acquire);
+         uint64_t start = head > flight_capacity ? head - flight_capacity : 0;
+         if (start > flight_dumped) {
+             while (start < head && flight_ring[start % flight_capacity] != '\n') {
+                 start++;
+             }
+             start += start < head;
+         } else {
+             start = flight_dumped;
+         }
+
+         if (start < head) {
+             size_t offset = (size_t)(start % flight_capacity);
+             size_t length = (size_t)(head - start);
+             size_t first = length < flight_capacity - offset ? length : flight_capacity - offset;
+             write_all(fd, flight_ring + offset, first);
+             write_all(fd, flight_ring, length - first);
+         }
+         close(fd);
+         flight_dumped = head;
+         status = 0;
+     }
+
+     if (locked) {
+         flight_release();
+     }
+     return status;
+ }
+
+ /**
+  * @brief Tín hiệu gây kết thúc: dump rồi để hành động mặc định chạy (SA_RESETHAND)
+  */
+ static void flight_fatal_handler(int sig) {
+     const char *reason = sig == SIGSEGV ? "SIGSEGV" : sig == SIGBUS ? "SIGBUS" : sig == SIGFPE ? "SIGFPE" :
+                          sig == SIGILL ? "SIGILL" : "SIGABRT";
+     flight_write(reason, true);
+     raise(sig);
+ }
+
+ /**
+  * @brief SIGUSR1: dump và chạy tiếp
+  */
+ static void flight_dump_handler(int sig) {
+     (void)sig;
+     int saved_errno = errno;
+     flight_write("SIGUSR1", true);
+     errno = saved_errno;
+ }
+
+ int log_flight_start(size_t size, const char *dump_path) {
+     if (size == 0 || !dump_path || strlen(dump_path) >= sizeof(flight_path)) {
+         return -1;
+     }
+     if (atomic_load(&flight_on)) {
+         log_flight_stop();
+     }
+
+     char *ring = (char *)malloc(size);
+     if (!ring) {
+         LOG_ERROR("Cannot allocate %zu bytes for the flight recorder", size);
+         return -1;
+     }
+
+     flight_acquire(0);
+     flight_ring = ring;
+     flight_capacity = size;
+     atomic_store(&flight_head, 0);
+     flight_dumped = 0;
+     strcpy(flight_path, dump_path);
+     flight_release();
+
+     // Stack riêng để vẫn dump được khi lỗi do tràn stack (cho luồng gọi hàm này)
+     stack_t alt_stack;
+     alt_stack.ss_sp = flight_alt_stack;
+     alt_stack.ss_size = sizeof(flight_alt_stack);
+     alt_stack.ss_flags = 0;
+     sigaltstack(&alt_stack, NULL);
+
+     struct sigaction sa;
+     memset(&sa, 0, sizeof(sa));
+     sigemptyset(&sa.sa_mask);
+     sa.sa_handler = flight_fatal_handler;
+     sa.sa_flags = SA_RESETHAND | SA_ONSTACK;
+     for (size_t i = 0; i < FATAL_SIGNAL_COUNT; i++) {
+         sigaction(fatal_signals[i], &sa, &saved_fatal[i]);
+     }
+     sa.sa_handler = flight_dump_handler;
+     sa.sa_flags = SA_RESTART | SA_ONSTACK;
+     sigaction(SIGUSR1, &sa, &saved_usr1);
+
+     atomic_store(&flight_on, true);
+     // Dựng dòng log ở mọi mức từ bây giờ
+     set_log_level(logger_config.log_level);
+     return 0;
+ }
+
+ void log_flight_stop(void) {
+     if (!atomic_exchange(&flight_on, false)) {
+         return;
+     }
+     set_log_level(logger_config.log_level);
+
+     for (size_t i = 0; i < FATAL_SIGNAL_COUNT; i++) {
+         sigaction(fatal_signals[i], &saved_fatal[i], NULL);
+     }
+     sigaction(SIGUSR1, &saved_usr1, NULL);
+
+     // Chờ các luồng đang chép vào ring (luồng mới thấy flight_on = false)
+     while (atomic_load(&flight_writers) > 0) {
+         sched_yield();
+     }
+     flight_acquire(0);
+     free(flight_ring);
+     flight_ring = NULL;
+     flight_capacity = 0;
+     flight_release();
+ }
+
+ bool log_flight_enabled(void) {
+     return atomic_load_explicit(&flight_on, memory_order_relaxed);
+ }
+
+ int log_flight_dump(const char *reason) {
+     if (!log_flight_enabled()) {
+         return -1;
+     }
+     return flight_write(reason, false);
+ }
@@ -4,6 +4,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/stat.h>
@@ -14,10 +15,48 @@
 #include "log.h"
 #include "file_process.h"
 #include "tc.h"
+#include "suite_cache.h"
+#include "suite_watch.h"
+#include "target_resolve.h"
+#include "result_journal.h"
+#include "result_store.h"
+#include "result_compare.h"
+#include "metrics_server.h"
+#include "gzip_writer.h"
+#include "log_binary.h"
+#include "log_flight.h"
+#include "log_control.h"
 
 // Global flag for signal handling
 static volatile int run_flag = 1;
 
+// gzip level for reports (0 = uncompressed); rotated logs use it too, or GZIP_DEFAULT_LEVEL when 0
+static int gzip_level = 0;
+
+// Log rotation: size and age limits (0 = no limit) and number of archives kept
+static long log_max_size = LOG_ROTATE_SIZE;
+static long log_max_age = 0;
+static int log_keep = LOG_ROTATE_GENERATIONS;
+
+// Write the log in binary form (format id, timestamp, raw arguments); read it back with "log-decode"
+static bool log_binary = false;
+
+// Level written to the log file; the flight recorder keeps every level regardless
+static int log_level = LOG_LVL_DEBUG;
+
+// Size of the in-memory flight recorder dumped to <log>.flight on crash, SIGUSR1 or a failed test.
+// Off by default (--flight-kb N): while on, every line down to DEBUG is formatted on every call.
+static long flight_kb = 0;
+
+// Unix socket accepting runtime log commands ("level tc debug", "file PATH"); NULL = SIGUSR2 only
+static const char *control_socket = LOG_CONTROL_DEFAULT_PATH;
+
+// Port of the OpenMetrics endpoint on 127.0.0.1 (-1 = disabled)
+static int metrics_port = -1;
+
+// Exit code when a comparison against a baseline finds regressions
+#define EXIT_REGRESSION 2
+
 // Signal handler
 static void handle_signal(int sig) {
     run_flag = 0;
@@ -33,11 +72,13 @@ static void handle_signal(int sig) {
 void print_test_results(test_result_info_t *results, int count) {
     printf("\n------ Test Results ------\n");
     for (int i = 0; i < count; i++) {
-        printf("Test #%d: ID=%s, Status=%s, Time=%.2fms\n", 
+        printf("Test #%d: ID=%s, Status=%s, Time=%.2fms, DNS=%.2fms\n", 
                i+1, results[i].test_id, 
                test_result_status_to_string(results[i].status), 
-               results[i].execution_time);
-        printf("  Details: %s\n", results[i].result_details);
+               results[i].execution_time, results[i].dns_time);
+        char details[TEST_RESULT_DETAILS_SIZE];
+        test_result_format_details(&results[i], details, sizeof(details));
+        printf("  Details: %s\n", details);
     }
     printf("-------------------------\n");
 }
@@ -50,8 +91,18 @@ void print_test_results(test_result_info_t *results, int count) {
  */
 int initialize_app(const char *log_file) {
     // Initialize logger
-    set_log_level(LOG_LVL_DEBUG);
+    set_log_level(log_level);
     set_log_file(log_file);
+    if (log_binary) {
+        set_log_format(LOG_FORMAT_BINARY);
+    }
+    
+    // Rotated logs are compressed and pruned in the background; an oversized log
+    // from earlier runs is archived on the first line written
+    if (log_set_rotation((size_t)log_max_size, log_max_age, log_keep,
+                         gzip_level > 0 ? gzip_level : GZIP_DEFAULT_LEVEL) != 0) {
+        printf("Invalid log rotation settings, log rotation disabled\n");
+    }
     
     // Create output directories if they don't exist
     if (!file_exists("logs")) {
@@ -68,6 +119,33 @@ int initialize_app(const char *log_file) {
         }
     }
     
+    // Hand log lines to a background writer so test threads never wait on file I/O;
+    // DEBUG lines are dropped rather than blocking when the buffer is full
+    if (log_async_start(LOG_ASYNC_SLOTS, LOG_OVERFLOW_DROP_DEBUG) != 0) {
+        LOG_WARN("Async logging unavailable, writing log lines synchronously");
+    }
+    
+    // A storm from one call site (e.g. a whole subnet unreachable) is cut down to a few
+    // lines per second, and identical consecutive lines collapse into a repeat count
+    log_set_rate_limit(LOG_RATE_BURST, LOG_RATE_PER_SEC);
+    log_set_dedup(1);
+    
+    // Levels can be raised on a misbehaving device mid-run: SIGUSR2 toggles DEBUG,
+    // the control socket sets global or per-module levels and the log file
+    if (log_control_start(control_socket) != 0) {
+        printf("Warning: log control socket unavailable, only SIGUSR2 toggles DEBUG\n");
+    }
+    
+    // Keep the most recent lines of every level in memory so a crash or failed test
+    // can be diagnosed even when the log file only records errors
+    if (flight_kb > 0) {
+        char flight_path[sizeof(logger_config.log_file_path) + 16];
+        snprintf(flight_path, sizeof(flight_path), "%s.flight", log_file);
+        if (log_flight_start((size_t)flight_kb * 1024, flight_path) != 0) {
+            LOG_WARN("Flight recorder unavailable");
+        }
+    }
+    
     return 0;
 }
 
@@ -75,67 +153,168 @@ int initialize_app(const char *log_file) {
  * @brief Load test cases from config file
  * 
  * @param config_file Path to config file
+ * @param use_cache Use the binary suite cache next to the config file
+ * @param view_flags file_view_open_ex flags for the config file (FILE_VIEW_COPY when it may be
+ *                   rewritten while being read, so a truncation cannot raise SIGBUS)
  * @param tests Pointer to test cases array
  * @param test_count Pointer to test count variable
+ * @param matrices Pointer to test matrix set (expanded lazily while executing)
  * @return int 0 on success, -1 on failure
  */
-int load_test_cases(const char *config_file, test_case_t **tests, int *test_count) {
+int load_test_cases(const char *config_file, bool use_cache, int view_flags, test_case_t **tests, int *test_count,
+                    test_matrix_set_t *matrices) {
     printf("Using config file: %s\n", config_file);
     
-    log_message(LOG_LVL_DEBUG, "Reading test cases from %s", config_file);
-    if (!read_json_test_cases(config_file, tests, test_count)) {
-        log_message(LOG_LVL_ERROR, "Failed to read test cases from %s", config_file);
+    LOG_DEBUG("Reading test cases from %s", config_file);
+    bool loaded = false;
+    if (use_cache) {
+        loaded = read_test_cases_cached_ex(config_file, tests, test_count, matrices, view_flags);
+    } else {
+        file_view_t view;
+        if (file_view_open_ex(config_file, &view, view_flags) == 0) {
+            loaded = parse_json_suite_length(view.data, view.size, tests, test_count, matrices);
+            file_view_release(&view);
+        }
+    }
+    if (!loaded) {
+        LOG_ERROR("Failed to read test cases from %s", config_file);
         printf("Failed to read test cases from %s\n", config_file);
         return -1;
     }
     
-    printf("Loaded %d test cases\n", *test_count);
+    // Resolve hostnames once up front; probes then reuse the cached addresses
+    int unresolved = target_resolve_prefetch(*tests, *test_count);
+    if (unresolved > 0) {
+        printf("Warning: %d target(s) could not be resolved\n", unresolved);
+    }
+    
+    printf("Loaded %d test cases", *test_count);
+    if (matrices->count > 0) {
+        printf(" and %d matrices (%ld generated test cases)", matrices->count, test_matrix_set_size(matrices));
+    }
+    printf("\n");
     return 0;
 }
 
+/**
+ * @brief Execute one test case and print its outcome
+ * 
+ * @param test Test case to execute
+ * @param result Result slot
+ * @param position 1-based position in the run
+ * @param total Total number of test cases in the run
+ * @param success_count Pointer to success counter
+ * @param failed_count Pointer to failure counter
+ * @param journal Result journal the outcome is appended to (may be NULL)
+ */
+static void run_one_test(test_case_t *test, test_result_info_t *result, long position, long total,
+                         int *success_count, int *failed_count, result_journal_t *journal) {
+    printf("Running test case %ld/%ld: %s (%s)\n", 
+           position, total, test_case_id(test), test_case_name(test));
+    
+    // Execute the test case
+    metrics_test_started(total - position);
+    int ret = execute_test_case(test, result);
+    metrics_record_result(result);
+    
+    // Update statistics
+    if (ret == 0) {
+        if (result->status == TEST_RESULT_SUCCESS) {
+            printf("  Result: SUCCESS\n");
+            (*success_count)++;
+        } else {
+            printf("  Result: %s\n", test_result_status_to_string(result->status));
+            (*failed_count)++;
+        }
+    } else {
+        printf("  Result: EXECUTION FAILED\n");
+        (*failed_count)++;
+    }
+    
+    // Keep the lines that led up to the failure next to the log
+    if (ret != 0 || result->status != TEST_RESULT_SUCCESS) {
+        char reason[128];
+        snprintf(reason, sizeof(reason), "test %s failed", test_case_id(test));
+        log_flight_dump(reason);
+    }
+    
+    // Record the outcome right away so a crash or kill later in the run loses nothing
+    if (journal && result_journal_append(journal, result) != 0) {
+        printf("  Warning: failed to record result in journal\n");
+    }
+    
+    // Show progress
+    printf("Progress: %ld/%ld completed (%d success, %d failed)\n",
+           position, total, *success_count, *failed_count);
+}
+
 /**
  * @brief Execute all test cases
  * 
+ * Plain test cases run first, then every matrix is expanded one test case at
+ * a time so the full cartesian product never sits in memory. Test cases whose
+ * id is already in the completed journal records are skipped.
+ * 
  * @param tests Array of test cases
  * @param test_count Number of test cases
+ * @param matrices Test matrix set
  * @param results Array to store results
- * @return int 0 on success, -1 on failure 
+ * @param journal Result journal (may be NULL)
+ * @param completed Results recorded by an earlier run to skip (may be NULL)
+ * @return int Number of results written
  */
-int execute_tests(test_case_t *tests, int test_count, test_result_info_t *results) {
+int execute_tests(test_case_t *tests, int test_count, const test_matrix_set_t *matrices,
+                  test_result_info_t *results, result_journal_t *journal,
+                  const result_journal_records_t *completed) {
     int success_count = 0;
     int failed_count = 0;
+    int skipped_count = 0;
+    long total = test_count + test_matrix_set_size(matrices);
+    long done = 0;
     
     printf("Executing test cases...\n");
     
     // Execute each test case sequentially
     for (int i = 0; i < test_count && run_flag; i++) {
-        printf("Running test case %d/%d: %s (%s)\n", 
-               i+1, test_count, tests[i].id, tests[i].name);
-        
-        // Execute the test case
-        int ret = execute_test_case(&tests[i], &results[i]);
+        if (result_journal_find(completed, test_case_id(&tests[i]))) {
+            skipped_count++;
+            continue;
+        }
+        run_one_test(&tests[i], &results[done], done + skipped_count + 1, total, &success_count, &failed_count, journal);
+        done++;
+    }
+    
+    if (matrices->count > 0) {
+        test_matrix_item_t item;
+        if (test_matrix_item_init(&item) != 0) {
+            printf("Failed to prepare test matrix expansion\n");
+            return (int)done;
+        }
         
-        // Update statistics
-        if (ret == 0) {
-            if (results[i].status == TEST_RESULT_SUCCESS) {
-                printf("  Result: SUCCESS\n");
-                success_count++;
-            } else {
-                printf("  Result: %s\n", test_result_status_to_string(results[i].status));
-                failed_count++;
+        for (int m = 0; m < matrices->count && run_flag; m++) {
+            long size = test_matrix_size(&matrices->matrices[m]);
+            for (long k = 0; k < size && run_flag; k++) {
+                if (!test_matrix_expand(matrices, m, k, &item)) {
+                    continue;
+                }
+                if (result_journal_find(completed, test_case_id(&item.test_case))) {
+                    skipped_count++;
+                    continue;
+                }
+                run_one_test(&item.test_case, &results[done], done + skipped_count + 1, total,
+                             &success_count, &failed_count, journal);
+                done++;
             }
-        } else {
-            printf("  Result: EXECUTION FAILED\n");
-            failed_count++;
         }
         
-        // Show progress
-        printf("Progress: %d/%d completed (%d success, %d failed)\n",
-               i+1, test_count, success_count, failed_count);
+        test_matrix_item_free(&item);
     }
     
+    if (skipped_count > 0) {
+        printf("Skipped %d test cases already recorded in the journal\n", skipped_count);
+    }
     printf("\nTests complete.\n");
-    return 0;
+    return (int)done;
 }
 
 /**
@@ -153,10 +332,13 @@ int generate_report(test_result_info_t *results, int test_count) {
     
     char report_file[128];
     time_t now = time(NULL);
-    strftime(report_file, sizeof(report_file), "results/summary_%Y%m%d_%H%M%S.json", 
+    strftime(report_file, sizeof(report_file),
+             gzip_level > 0 ? "results/summary_%Y%m%d_%H%M%S.json.gz" : "results/summary_%Y%m%d_%H%M%S.json",
              localtime(&now));
     
-    if (generate_summary_report(results, test_count, report_file) == 0) {
+    int ret = gzip_level > 0 ? generate_summary_report_gz(results, test_count, report_file, gzip_level)
+                             : generate_summary_report(results, test_count, report_file);
+    if (ret == 0) {
         printf("Report generated: %s\n", report_file);
         return 0;
     } else {
@@ -171,8 +353,9 @@ int generate_report(test_result_info_t *results, int test_count) {
  * @param tests Test cases array
  * @param results Test results array
  * @param test_count Number of tests
+ * @param matrices Test matrix set
  */
-void cleanup(test_case_t *tests, test_result_info_t *results, int test_count) {
+void cleanup(test_case_t *tests, test_result_info_t *results, int test_count, test_matrix_set_t *matrices) {
     if (results) {
         free(results);
     }
@@ -180,6 +363,158 @@ void cleanup(test_case_t *tests, test_result_info_t *results, int test_count) {
     if (tests) {
         free_test_cases(tests, test_count);
     }
+    
+    free_test_matrices(matrices);
+}
+
+/**
+ * @brief Reload the test suite after a config change and update the run queue
+ * 
+ * Queued cases that were removed are cancelled, added and changed cases are
+ * queued, everything else keeps its place. On failure the running suite is kept.
+ * 
+ * @param config_file Path to config file
+ * @param use_cache Use the binary suite cache
+ * @param tests Pointer to the running test cases array (replaced on success)
+ * @param test_count Pointer to the running test count
+ * @param matrices Pointer to the running matrix set (replaced on success)
+ * @param queue Pointer to the queue of test case positions (replaced on success)
+ * @param queue_len Pointer to the queue length
+ * @return int 0 on success, -1 on failure
+ */
+static int reload_suite(const char *config_file, bool use_cache, test_case_t **tests, int *test_count,
+                        test_matrix_set_t *matrices, int **queue, int *queue_len) {
+    test_case_t *new_tests = NULL;
+    int new_count = 0;
+    test_matrix_set_t new_matrices;
+    // The suite is being edited: copy it instead of mapping it
+    if (load_test_cases(config_file, use_cache, FILE_VIEW_COPY, &new_tests, &new_count, &new_matrices) != 0) {
+        printf("Reload failed, keeping the running test suite\n");
+        return -1;
+    }
+    
+    suite_diff_t diff;
+    int *new_queue = (int *)malloc((new_count + 1) * sizeof(int));
+    bool *queued = (bool *)calloc(new_count + 1, sizeof(bool));
+    if (!new_queue || !queued ||
+        suite_diff_compute(*tests, *test_count, new_tests, new_count, &diff) != 0) {
+        free(new_queue);
+        free(queued);
+        cleanup(new_tests, NULL, new_count, &new_matrices);
+        return -1;
+    }
+    
+    printf("Config reloaded: %d added, %d changed, %d removed, %d unchanged\n",
+           diff.added_count, diff.changed_count, diff.removed_count, diff.unchanged_count);
+    
+    // Keep pending cases that still exist, cancel the removed ones
+    int len = 0;
+    for (int q = 0; q < *queue_len; q++) {
+        int j = diff.old_to_new[(*queue)[q]];
+        if (j < 0) {
+            printf("  Cancelled: %s\n", test_case_id(&(*tests)[(*queue)[q]]));
+            continue;
+        }
+        new_queue[len++] = j;
+        queued[j] = true;
+    }
+    
+    // Schedule added and changed cases
+    for (int k = 0; k < diff.added_count + diff.changed_count; k++) {
+        int j = k < diff.added_count ? diff.added[k] : diff.changed[k - diff.added_count];
+        if (!queued[j]) {
+            new_queue[len++] = j;
+            queued[j] = true;
+        }
+    }
+    
+    suite_diff_free(&diff);
+    free(queued);
+    free(*queue);
+    cleanup(*tests, NULL, *test_count, matrices);
+    
+    *tests = new_tests;
+    *test_count = new_count;
+    *matrices = new_matrices;
+    *queue = new_queue;
+    *queue_len = len;
+    return 0;
+}
+
+/**
+ * @brief Watch the config file and run added or changed test cases
+ * 
+ * The config is checked between test cases, so an edit never interrupts the
+ * case that is currently running. A report is written each time the queue
+ * drains. Matrices are only expanded by the initial run.
+ * 
+ * @param config_file Path to config file
+ * @param use_cache Use the binary suite cache
+ * @param tests Pointer to the running test cases array
+ * @param test_count Pointer to the running test count
+ * @param matrices Pointer to the running matrix set
+ * @param journal Result journal (may be NULL)
+ * @return int 0 on success, -1 on failure
+ */
+int watch_test_cases(const char *config_file, bool use_cache, test_case_t **tests, int *test_count,
+                     test_matrix_set_t *matrices, result_journal_t *journal) {
+    suite_watch_t watch;
+    if (suite_watch_init(&watch, config_file) != 0) {
+        printf("Failed to watch %s\n", config_file);
+        return -1;
+    }
+    printf("\nWatching %s for changes (Ctrl+C to stop)...\n", config_file);
+    
+    int *queue = NULL;
+    int queue_len = 0;
+    test_result_info_t *results = NULL;
+    int result_count = 0;
+    int result_capacity = 0;
+    int success_count = 0;
+    int failed_count = 0;
+    
+    while (run_flag) {
+        int changed = suite_watch_wait(&watch, queue_len > 0 ? 0 : 1000);
+        if (changed < 0) {
+            break;
+        }
+        if (changed > 0) {
+            reload_suite(config_file, use_cache, tests, test_count, matrices, &queue, &queue_len);
+        }
+        
+        if (queue_len == 0) {
+            // Round finished: report what ran since the last reload
+            if (result_count > 0) {
+                print_test_results(results, result_count);
+                generate_report(results, result_count);
+                result_count = success_count = failed_count = 0;
+            }
+            continue;
+        }
+        
+        if (result_count == result_capacity) {
+            int new_capacity = result_capacity ? result_capacity * 2 : 16;
+            test_result_info_t *grown = (test_result_info_t *)realloc(results, new_capacity * sizeof(test_result_info_t));
+            if (!grown) {
+                LOG_ERROR("Failed to allocate memory for results");
+                break;
+            }
+            results = grown;
+            result_capacity = new_capacity;
+        }
+        
+        int i = queue[0];
+        memmove(queue, queue + 1, (queue_len - 1) * sizeof(int));
+        queue_len--;
+        run_one_test(&(*tests)[i], &results[result_count], result_count + 1, result_count + 1 + queue_len,
+                     &success_count, &failed_count, journal);
+        result_count++;
+    }
+    
+    free(queue);
+    free(results);
+    suite_watch_close(&watch);
+    return 0;
 }
 
 /**
@@ -188,58 +523,503 @@ void cleanup(test_case_t *tests, test_result_info_t *results, int test_count) {
  * @param argc Argument count
  * @param argv Argument values
  * @param config_file Pointer to config file path
+ * @param use_cache Pointer to suite cache flag
+ * @param watch Pointer to watch mode flag
+ * @param journal_path Pointer to result journal path
+ * @param resume Pointer to resume flag
+ * @param store_path Pointer to result history store path
+ * @param baseline_path Pointer to baseline path for regression comparison
  */
-void parse_arguments(int argc, char *argv[], const char **config_file) {
+void parse_arguments(int argc, char *argv[], const char **config_file, bool *use_cache, bool *watch,
+                     const char **journal_path, bool *resume, const char **store_path,
+                     const char **baseline_path) {
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
             *config_file = argv[++i];
+        } else if (strcmp(argv[i], "--no-cache") == 0) {
+            *use_cache = false;
+        } else if (strcmp(argv[i], "--watch") == 0) {
+            *watch = true;
+        } else if (strcmp(argv[i], "--dns-ttl") == 0 && i + 1 < argc) {
+            target_resolve_set_ttl(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            *journal_path = argv[++i];
+        } else if (strcmp(argv[i], "--resume") == 0) {
+            *resume = true;
+        } else if (strcmp(argv[i], "--store") == 0 && i + 1 < argc) {
+            *store_path = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            *baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--metrics-port") == 0 && i + 1 < argc) {
+            metrics_port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--gzip-level") == 0 && i + 1 < argc) {
+            gzip_level = atoi(argv[++i]);
+            if (gzip_level < 0 || gzip_level > 9) {
+                printf("Invalid gzip level %s (0-9), reports stay uncompressed\n", argv[i]);
+                gzip_level = 0;
+            }
+        } else if (strcmp(argv[i], "--log-max-size") == 0 && i + 1 < argc) {
+            log_max_size = atol(argv[++i]);
+            if (log_max_size < 0) {
+                log_max_size = 0;
+            }
+        } else if (strcmp(argv[i], "--log-max-age") == 0 && i + 1 < argc) {
+            log_max_age = atol(argv[++i]);
+            if (log_max_age < 0) {
+                log_max_age = 0;
+            }
+        } else if (strcmp(argv[i], "--log-keep") == 0 && i + 1 < argc) {
+            log_keep = atoi(argv[++i]);
+            if (log_keep < 0) {
+                log_keep = 0;
+            }
+        } else if (strcmp(argv[i], "--log-binary") == 0) {
+            log_binary = true;
+        } else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            log_level = atoi(argv[++i]);
+            if (log_level < LOG_LVL_NONE || log_level > LOG_LVL_DEBUG) {
+                printf("Invalid log level %s (0-3), logging everything\n", argv[i]);
+                log_level = LOG_LVL_DEBUG;
+            }
+        } else if (strcmp(argv[i], "--control-socket") == 0 && i + 1 < argc) {
+            control_socket = argv[++i];
+        } else if (strcmp(argv[i], "--no-control-socket") == 0) {
+            control_socket = NULL;
+        } else if (strcmp(argv[i], "--flight-kb") == 0 && i + 1 < argc) {
+            flight_kb = atol(argv[++i]);
+            if (flight_kb < 0) {
+                flight_kb = 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Parse a time given as epoch seconds or local "YYYY-MM-DD[ HH:MM[:SS]]"
+ * 
+ * @param text Time string
+ * @param end_of_day Use the last millisecond of the day when only a date is given
+ * @return int64_t Milliseconds since epoch, -1 if the string is invalid
+ */
+static int64_t parse_query_time(const char *text, bool end_of_day) {
+    char *end = NULL;
+    long long seconds = strtoll(text, &end, 10);
+    if (end != text && *end == '\0') {
+        return (int64_t)seconds * 1000;
+    }
+    
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    char sep = 0;
+    int fields = sscanf(text, "%d-%d-%d%c%d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                        &sep, &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
+    if (fields != 3 && (fields < 6 || (sep != ' ' && sep != 'T'))) {
+        return -1;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    time_t t = mktime(&tm);
+    if (t == (time_t)-1) {
+        return -1;
+    }
+    return (int64_t)t * 1000 + (fields == 3 && end_of_day ? 86400 * 1000 - 1 : 0);
+}
+
+/**
+ * @brief Format epoch milliseconds as local time
+ */
+static void format_query_time(int64_t ms, char *buffer, size_t size) {
+    time_t t = (time_t)(ms / 1000);
+    struct tm tm;
+    if (ms <= 0 || !localtime_r(&t, &tm)) {
+        snprintf(buffer, size, "-");
+        return;
+    }
+    strftime(buffer, size, "%Y-%m-%d %H:%M:%S", &tm);
+}
+
+/**
+ * @brief "query" subcommand: filter and aggregate the result history store
+ * 
+ * Usage: query [--store PATH] [--id TEST_ID] [--from TIME] [--to TIME]
+ * 
+ * @param argc Argument count (argv[0] is "query")
+ * @param argv Argument values
+ * @return int Exit code
+ */
+static int run_query(int argc, char *argv[]) {
+    const char *store_path = RESULT_STORE_DEFAULT_PATH;
+    result_store_filter_t filter = { NULL, 0, 0 };
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--store") == 0 && i + 1 < argc) {
+            store_path = argv[++i];
+        } else if (strcmp(argv[i], "--id") == 0 && i + 1 < argc) {
+            filter.test_id = argv[++i];
+        } else if ((strcmp(argv[i], "--from") == 0 || strcmp(argv[i], "--to") == 0) && i + 1 < argc) {
+            bool to = argv[i][2] == 't';
+            int64_t ms = parse_query_time(argv[++i], to);
+            if (ms < 0) {
+                printf("Invalid time: %s (use epoch seconds or YYYY-MM-DD[ HH:MM[:SS]])\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+            if (to) {
+                filter.to_ms = ms;
+            } else {
+                filter.from_ms = ms;
+            }
+        } else {
+            printf("Usage: device_test query [--store PATH] [--id TEST_ID] [--from TIME] [--to TIME]\n");
+            return EXIT_FAILURE;
         }
     }
+    
+    result_store_t store;
+    if (result_store_open(&store, store_path) != 0) {
+        printf("Failed to open result store %s\n", store_path);
+        return EXIT_FAILURE;
+    }
+    
+    result_store_group_t *groups = NULL;
+    int group_count = 0;
+    long rows = result_store_query(&store, &filter, &groups, &group_count);
+    result_store_close(&store);
+    if (rows < 0) {
+        printf("Query failed\n");
+        return EXIT_FAILURE;
+    }
+    
+    printf("%-20s %6s %7s %10s %10s %10s %8s %10s %-19s %-19s\n", "TEST ID", "RUNS", "OK%",
+           "RTT avg", "RTT min", "RTT max", "LOSS%", "BW Mbps", "FIRST", "LAST");
+    for (int g = 0; g < group_count; g++) {
+        const result_store_group_t *grp = &groups[g];
+        char first[32], last[32], rtt_avg[16] = "-", rtt_min[16] = "-", rtt_max[16] = "-", loss[16] = "-", bw[16] = "-";
+        format_query_time(grp->first_ms, first, sizeof(first));
+        format_query_time(grp->last_ms, last, sizeof(last));
+        if (grp->rtt_count > 0) {
+            snprintf(rtt_avg, sizeof(rtt_avg), "%.2f", grp->rtt_sum / grp->rtt_count);
+            snprintf(rtt_min, sizeof(rtt_min), "%.2f", grp->rtt_min);
+            snprintf(rtt_max, sizeof(rtt_max), "%.2f", grp->rtt_max);
+        }
+        if (grp->loss_count > 0) {
+            snprintf(loss, sizeof(loss), "%.1f", grp->loss_sum / grp->loss_count);
+        }
+        if (grp->bandwidth_count > 0) {
+            snprintf(bw, sizeof(bw), "%.2f", grp->bandwidth_sum / grp->bandwidth_count);
+        }
+        printf("%-20s %6ld %6.1f%% %10s %10s %10s %8s %10s %-19s %-19s\n", grp->test_id, grp->runs,
+               100.0 * grp->success / grp->runs, rtt_avg, rtt_min, rtt_max, loss, bw, first, last);
+    }
+    printf("%ld results, %d test ids\n", rows, group_count);
+    
+    free(groups);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Print the comparison summary and every regressed metric
+ */
+static void print_comparison(const result_compare_t *cmp, const compare_summary_t *summary) {
+    static const char *units[COMPARE_METRICS] = { "ms RTT", "% loss", "Mbps" };
+    
+    for (int e = 0; e < cmp->count; e++) {
+        const compare_entry_t *entry = &cmp->entries[e];
+        for (int m = 0; m < COMPARE_METRICS; m++) {
+            compare_metric_result_t result;
+            if (result_compare_metric(cmp, entry, (compare_metric_t)m, &result) &&
+                result.verdict == COMPARE_REGRESSION) {
+                printf("REGRESSION %s: %.2f -> %.2f %s (p50 over %d -> %d runs, p=%.4f)\n", entry->test_id,
+                       result.side[COMPARE_BASELINE].p50, result.side[COMPARE_CURRENT].p50, units[m],
+                       result.side[COMPARE_BASELINE].n, result.side[COMPARE_CURRENT].n, result.p_value);
+            }
+        }
+    }
+    printf("Compared %d test ids: %d regression, %d improvement, %d unchanged, %d insufficient data, %d missing, %d new\n",
+           cmp->count, summary->counts[COMPARE_REGRESSION], summary->counts[COMPARE_IMPROVEMENT],
+           summary->counts[COMPARE_UNCHANGED], summary->counts[COMPARE_INSUFFICIENT],
+           summary->counts[COMPARE_MISSING], summary->counts[COMPARE_NEW]);
+}
+
+/**
+ * @brief Compare the results of this run with a baseline and write the diff
+ * 
+ * @param baseline_path Baseline summary report or result history store
+ * @param results Results of this run
+ * @param count Number of results
+ * @return int 0 if nothing regressed, EXIT_REGRESSION on regressions, -1 on failure
+ */
+static int compare_with_baseline(const char *baseline_path, const test_result_info_t *results, int count) {
+    result_compare_t cmp;
+    result_compare_init(&cmp);
+    
+    int ret = result_compare_load(&cmp, COMPARE_BASELINE, baseline_path, NULL);
+    for (int i = 0; i < count && ret == 0; i++) {
+        ret = result_compare_add_result(&cmp, COMPARE_CURRENT, &results[i]);
+    }
+    
+    char diff_file[128];
+    time_t now = time(NULL);
+    strftime(diff_file, sizeof(diff_file), "results/regression_%Y%m%d_%H%M%S.json", localtime(&now));
+    
+    compare_summary_t summary;
+    if (ret == 0 && result_compare_write_file(&cmp, diff_file, baseline_path, "current run", &summary) == 0) {
+        print_comparison(&cmp, &summary);
+        printf("Regression diff written: %s\n", diff_file);
+        ret = summary.counts[COMPARE_REGRESSION] > 0 ? EXIT_REGRESSION : 0;
+    } else {
+        printf("Failed to compare with baseline %s\n", baseline_path);
+        ret = -1;
+    }
+    
+    result_compare_free(&cmp);
+    return ret;
+}
+
+/**
+ * @brief "compare" subcommand: diff two result sets and flag regressions
+ * 
+ * Usage: compare --baseline PATH --current PATH [--id TEST_ID] [--from TIME] [--to TIME]
+ *                [--threshold PCT] [--loss-points PTS] [--alpha A] [--out PATH]
+ * 
+ * Either side may be a summary report (.json/.json.gz) or the result history
+ * store; --id/--from/--to select the baseline rows of a store. The JSON diff
+ * goes to stdout unless --out is given.
+ * 
+ * @param argc Argument count (argv[0] is "compare")
+ * @param argv Argument values
+ * @return int Exit code (EXIT_REGRESSION when a regression is found)
+ */
+static int run_compare(int argc, char *argv[]) {
+    const char *baseline_path = NULL;
+    const char *current_path = NULL;
+    const char *out_path = NULL;
+    result_store_filter_t filter = { NULL, 0, 0 };
+    result_compare_t cmp;
+    result_compare_init(&cmp);
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--current") == 0 && i + 1 < argc) {
+            current_path = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "--id") == 0 && i + 1 < argc) {
+            filter.test_id = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            cmp.threshold_pct = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--loss-points") == 0 && i + 1 < argc) {
+            cmp.loss_points = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--alpha") == 0 && i + 1 < argc) {
+            cmp.alpha = atof(argv[++i]);
+        } else if ((strcmp(argv[i], "--from") == 0 || strcmp(argv[i], "--to") == 0) && i + 1 < argc) {
+            bool to = argv[i][2] == 't';
+            int64_t ms = parse_query_time(argv[++i], to);
+            if (ms < 0) {
+                printf("Invalid time: %s (use epoch seconds or YYYY-MM-DD[ HH:MM[:SS]])\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+            if (to) {
+                filter.to_ms = ms;
+            } else {
+                filter.from_ms = ms;
+            }
+        } else {
+            baseline_path = NULL;
+            break;
+        }
+    }
+    if (!baseline_path || !current_path) {
+        printf("Usage: device_test compare --baseline PATH --current PATH [--id TEST_ID] [--from TIME] [--to TIME]\n"
+               "                           [--threshold PCT] [--loss-points PTS] [--alpha A] [--out PATH]\n");
+        return EXIT_FAILURE;
+    }
+    
+    if (result_compare_load(&cmp, COMPARE_BASELINE, baseline_path, &filter) != 0 ||
+        result_compare_load(&cmp, COMPARE_CURRENT, current_path, NULL) != 0) {
+        printf("Failed to load results to compare\n");
+        result_compare_free(&cmp);
+        return EXIT_FAILURE;
+    }
+    
+    compare_summary_t summary;
+    int ret;
+    if (out_path) {
+        ret = result_compare_write_file(&cmp, out_path, baseline_path, current_path, &summary);
+        if (ret == 0) {
+            print_comparison(&cmp, &summary);
+        }
+    } else {
+        json_writer_t writer;
+        ret = json_writer_init_file(&writer, stdout);
+        if (ret == 0) {
+            result_compare_write_json(&cmp, &writer, baseline_path, current_path, &summary);
+            ret = json_writer_finish(&writer);
+            json_writer_free(&writer);
+        }
+    }
+    result_compare_free(&cmp);
+    
+    if (ret != 0) {
+        printf("Failed to write comparison\n");
+        return EXIT_FAILURE;
+    }
+    return summary.counts[COMPARE_REGRESSION] > 0 ? EXIT_REGRESSION : EXIT_SUCCESS;
+}
+
+/**
+ * @brief "log-decode" subcommand: render binary logs in the text log format
+ * 
+ * Usage: log-decode FILE... (current log or rotated archives, .gz included)
+ * 
+ * @param argc Argument count (argv[0] is "log-decode")
+ * @param argv Argument values
+ * @return int Exit code
+ */
+static int run_log_decode(int argc, char *argv[]) {
+    if (argc < 2) {
+        printf("Usage: device_test log-decode FILE...\n");
+        return EXIT_FAILURE;
+    }
+    
+    int exit_code = EXIT_SUCCESS;
+    for (int i = 1; i < argc; i++) {
+        if (log_binary_decode_file(argv[i], stdout) < 0) {
+            fflush(stdout);
+            fprintf(stderr, "%s: not a binary log or truncated record\n", argv[i]);
+            exit_code = EXIT_FAILURE;
+        }
+    }
+    return exit_code;
 }
 
 int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "query") == 0) {
+        return run_query(argc - 1, argv + 1);
+    }
+    if (argc > 1 && strcmp(argv[1], "compare") == 0) {
+        return run_compare(argc - 1, argv + 1);
+    }
+    if (argc > 1 && strcmp(argv[1], "log-decode") == 0) {
+        return run_log_decode(argc - 1, argv + 1);
+    }
+    
     // Set up signal handlers
     signal(SIGINT, handle_signal);
     signal(SIGTERM, handle_signal);
     
     // Default config file path
     const char *config_file = "config/config.json";
+    bool use_cache = true;
+    bool watch = false;
+    const char *journal_path = RESULT_JOURNAL_DEFAULT_PATH;
+    bool resume = false;
+    const char *store_path = RESULT_STORE_DEFAULT_PATH;
+    const char *baseline_path = NULL;
+    int exit_code = EXIT_SUCCESS;
     
     // Parse command line arguments
-    parse_arguments(argc, argv, &config_file);
+    parse_arguments(argc, argv, &config_file, &use_cache, &watch, &journal_path, &resume, &store_path,
+                    &baseline_path);
     
     // Initialize application
-    if (initialize_app("logs/testing_device.log") != 0) {
+    if (initialize_app(log_binary ? "logs/testing_device.blog" : "logs/testing_device.log") != 0) {
         return EXIT_FAILURE;
     }
     
+    // Serve the latest results for scraping, mostly useful together with --watch
+    if (metrics_port >= 0) {
+        int port = metrics_server_start(metrics_port);
+        if (port > 0) {
+            printf("Serving metrics on http://127.0.0.1:%d/metrics\n", port);
+        } else {
+            printf("Warning: failed to start metrics endpoint on port %d\n", metrics_port);
+        }
+    }
+    
     // Load test cases
     test_case_t *tests = NULL;
     int test_count = 0;
-    if (load_test_cases(config_file, &tests, &test_count) != 0) {
+    test_matrix_set_t matrices;
+    if (load_test_cases(config_file, use_cache, watch ? FILE_VIEW_COPY : 0, &tests, &test_count, &matrices) != 0) {
         return EXIT_FAILURE;
     }
     
     // Allocate memory for results
-    test_result_info_t *results = (test_result_info_t*)malloc(test_count * sizeof(test_result_info_t));
+    long total = test_count + test_matrix_set_size(&matrices);
+    test_result_info_t *results = NULL;
+    if (total <= INT_MAX) {
+        results = (test_result_info_t*)malloc(total * sizeof(test_result_info_t));
+    }
     if (!results) {
-        log_message(LOG_LVL_ERROR, "Failed to allocate memory for results");
+        LOG_ERROR("Failed to allocate memory for %ld results", total);
         printf("Failed to allocate memory for results\n");
-        free_test_cases(tests, test_count);
+        cleanup(tests, NULL, test_count, &matrices);
         return EXIT_FAILURE;
     }
     
+    // Results recorded by an interrupted run are kept and their test cases skipped
+    result_journal_records_t completed;
+    memset(&completed, 0, sizeof(completed));
+    if (resume && result_journal_load(journal_path, &completed) == 0) {
+        printf("Resuming: %d results already recorded in %s\n", completed.count, journal_path);
+    }
+    
+    result_journal_t journal;
+    bool journaling = result_journal_open(&journal, journal_path, resume) == 0;
+    if (!journaling) {
+        printf("Warning: result journal %s disabled\n", journal_path);
+    }
+    
     // Execute tests
-    execute_tests(tests, test_count, results);
+    int result_count = execute_tests(tests, test_count, &matrices, results,
+                                     journaling ? &journal : NULL, resume ? &completed : NULL);
+    result_journal_records_free(&completed);
     
     // Print results
-    print_test_results(results, test_count);
+    print_test_results(results, result_count);
+    
+    // Generate report from the journal so it also covers results of a resumed run
+    result_journal_records_t recorded;
+    memset(&recorded, 0, sizeof(recorded));
+    test_result_info_t *final_results = results;
+    int final_count = result_count;
+    if (journaling && result_journal_sync(&journal) == 0 &&
+        result_journal_load(journal_path, &recorded) == 0) {
+        final_results = recorded.results;
+        final_count = recorded.count;
+    }
+    generate_report(final_results, final_count);
     
-    // Generate report
-    generate_report(results, test_count);
+    // Compare before this run is appended, so a store baseline only holds earlier runs
+    if (baseline_path && final_count > 0 &&
+        compare_with_baseline(baseline_path, final_results, final_count) == EXIT_REGRESSION) {
+        exit_code = EXIT_REGRESSION;
+    }
+    
+    // Keep a compact columnar copy for trend queries ("query" subcommand)
+    if (final_count > 0 && result_store_append(store_path, final_results, final_count) != 0) {
+        printf("Warning: failed to update result history %s\n", store_path);
+    }
+    result_journal_records_free(&recorded);
+    
+    // Keep running and pick up config edits
+    if (watch && run_flag) {
+        free(results);
+        results = NULL;
+        watch_test_cases(config_file, use_cache, &tests, &test_count, &matrices, journaling ? &journal : NULL);
+    }
     
     // Clean up
-    cleanup(tests, results, test_count);
+    if (journaling) {
+        result_journal_close(&journal);
+    }
+    cleanup(tests, results, test_count, &matrices);
+    target_resolve_clear();
+    metrics_server_stop();
+    log_control_stop();
+    test_result_strings_free();
     
-    return EXIT_SUCCESS;
+    return exit_code;
 }
\ No newline at end of file
@@ -0,0 +1,563 @@
+
+#define _POSIX_C_SOURCE 200809L
+#define LOG_MODULE LOG_MOD_REMOTE
+
+#include "metrics_server.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define METRICS_REQUEST_SIZE 4096
+#define METRICS_POLL_MS 500
+
+/**
+ * @brief Số liệu gần nhất của một test ID
+ */
+typedef struct {
+    char test_id[32];
+    test_type_t test_type;
+    bool is_sweep;
+    test_result_status_t status;            /* Trạng thái lần chạy gần nhất */
+    long runs[TEST_RESULT_ERROR + 1];       /* Số lần chạy theo trạng thái */
+    float execution_time;                   /* Thời gian thực thi gần nhất (ms) */
+    double last_run;                        /* Thời điểm kết thúc gần nhất (giây kể từ epoch) */
+    float rtt_window[METRICS_RTT_WINDOW];   /* RTT trung bình của các lần chạy gần nhất */
+    int rtt_window_count;
+    int rtt_window_next;
+    long rtt_count;                         /* Tổng số lần có RTT */
+    double rtt_sum;                         /* Tổng RTT (ms) */
+    float packet_loss;                      /* Mất gói gần nhất (%), NaN nếu không áp dụng */
+    float bandwidth;                        /* Băng thông gần nhất (Mbps), NaN nếu không áp dụng */
+} metrics_entry_t;
+
+static pthread_mutex_t metrics_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool metrics_enabled = false;
+
+/* Trạng thái dùng chung, chỉ truy cập dưới metrics_lock */
+static metrics_entry_t *entries = NULL;
+static int entry_count = 0;
+static int entry_capacity = 0;
+static int *slots = NULL;
+static int slot_count = 0;
+static long queue_depth = 0;
+static long in_flight = 0;
+static long completed = 0;
+static long rate_buckets[METRICS_RATE_WINDOW_SEC];     /* Số test xong theo từng giây */
+static time_t rate_seconds[METRICS_RATE_WINDOW_SEC];   /* Giây ứng với mỗi bucket */
+static time_t enabled_at = 0;
+
+/* Luồng HTTP */
+static pthread_t server_thread;
+static bool server_running = false;
+static volatile int server_stop = 0;
+static int listen_fd = -1;
+
+static uint32_t hash_id(const char *id) {
+    uint32_t hash = 2166136261u;
+    for (const char *p = id; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Tìm hoặc tạo entry của test ID (gọi khi đang giữ metrics_lock)
+ */
+static metrics_entry_t *entry_for(const char *test_id) {
+    if ((entry_count + 1) * 2 > slot_count) {
+        int new_slot_count = slot_count ? slot_count * 2 : 64;
+        int *new_slots = (int *)malloc(new_slot_count * sizeof(int));
+        if (!new_slots) {
+            return NULL;
+        }
+        memset(new_slots, -1, new_slot_count * sizeof(int));
+        for (int e = 0; e < entry_count; e++) {
+            uint32_t pos = hash_id(entries[e].test_id) & (new_slot_count - 1);
+            while (new_slots[pos] >= 0) {
+                pos = (pos + 1) & (new_slot_count - 1);
+            }
+            new_slots[pos] = e;
+        }
+        free(slots);
+        slots = new_slots;
+        slot_count = new_slot_count;
+    }
+
+    uint32_t mask = slot_count - 1;
+    uint32_t pos = hash_id(test_id) & mask;
+    while (slots[pos] >= 0) {
+        if (strcmp(entries[slots[pos]].test_id, test_id) == 0) {
+            return &entries[slots[pos]];
+        }
+        pos = (pos + 1) & mask;
+    }
+
+    if (entry_count == entry_capacity) {
+        int new_capacity = entry_capacity ? entry_capacity * 2 : 32;
+        metrics_entry_t *grown = (metrics_entry_t *)realloc(entries, new_capacity * sizeof(metrics_entry_t));
+        if (!grown) {
+            return NULL;
+        }
+        entries = grown;
+        entry_capacity = new_capacity;
+    }
+
+    metrics_entry_t *entry = &entries[entry_count];
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->test_id, sizeof(entry->test_id), "%s", test_id);
+    entry->packet_loss = NAN;
+    entry->bandwidth = NAN;
+    slots[pos] = entry_count++;
+    return entry;
+}
+
+void metrics_enable(void) {
+    pthread_mutex_lock(&metrics_lock);
+    if (!metrics_enabled) {
+        enabled_at = time(NULL);
+        metrics_enabled = true;
+    }
+    pthread_mutex_unlock(&metrics_lock);
+}
+
+void metrics_test_started(long depth) {
+    if (!metrics_enabled) {
+        return;
+    }
+
+    pthread_mutex_lock(&metrics_lock);
+    queue_depth = depth;
+    in_flight++;
+    pthread_mutex_unlock(&metrics_lock);
+}
+
+void metrics_record_result(const test_result_info_t *result) {
+    if (!metrics_enabled || !result) {
+        return;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    // Timeout/lỗi không có số đo: không công bố mất gói 0%
+    bool ping = test_result_has_ping_stats(result);
+
+    pthread_mutex_lock(&metrics_lock);
+    if (in_flight > 0) {
+        in_flight--;
+    }
+    completed++;
+    int bucket = (int)(now.tv_sec % METRICS_RATE_WINDOW_SEC);
+    if (rate_seconds[bucket] != now.tv_sec) {
+        rate_seconds[bucket] = now.tv_sec;
+        rate_buckets[bucket] = 0;
+    }
+    rate_buckets[bucket]++;
+
+    metrics_entry_t *entry = entry_for(result->test_id);
+    if (entry) {
+        entry->test_type = result->test_type;
+        entry->is_sweep = result->is_sweep;
+        entry->status = result->status;
+        if (result->status <= TEST_RESULT_ERROR) {
+            entry->runs[result->status]++;
+        }
+        entry->execution_time = result->execution_time;
+        entry->last_run = now.tv_sec + now.tv_nsec / 1e9;
+        if (ping && result->data.ping.packets_received > 0) {
+            entry->rtt_window[entry->rtt_window_next] = result->data.ping.avg_rtt;
+            entry->rtt_window_next = (entry->rtt_window_next + 1) % METRICS_RTT_WINDOW;
+            if (entry->rtt_window_count < METRICS_RTT_WINDOW) {
+                entry->rtt_window_count++;
+            }
+            entry->rtt_count++;
+            entry->rtt_sum += result->data.ping.avg_rtt;
+        }
+        entry->packet_loss = ping ? result->data.ping.packet_loss : NAN;
+        entry->bandwidth = result->test_type == TEST_THROUGHPUT ? result->data.throughput.bandwidth : NAN;
+    }
+    pthread_mutex_unlock(&metrics_lock);
+}
+
+/**
+ * @brief Buffer văn bản tự mở rộng
+ */
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+    bool error;
+} text_buffer_t;
+
+static void appendf(text_buffer_t *buf, const char *format, ...) {
+    if (buf->error) {
+        return;
+    }
+
+    for (;;) {
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf->data + buf->size, buf->capacity - buf->size, format, args);
+        va_end(args);
+        if (n < 0) {
+            buf->error = true;
+            return;
+        }
+        if ((size_t)n < buf->capacity - buf->size) {
+            buf->size += (size_t)n;
+            return;
+        }
+
+        size_t new_capacity = buf->capacity * 2;
+        while (new_capacity < buf->size + (size_t)n + 1) {
+            new_capacity *= 2;
+        }
+        char *grown = (char *)realloc(buf->data, new_capacity);
+        if (!grown) {
+            buf->error = true;
+            return;
+        }
+        buf->data = grown;
+        buf->capacity = new_capacity;
+    }
+}
+
+/**
+ * @brief Ghi giá trị label với các ký tự \, " và xuống dòng được escape
+ */
+static void append_label(text_buffer_t *buf, const char *value) {
+    for (const char *p = value; *p; p++) {
+        if (*p == '\\' || *p == '"') {
+            appendf(buf, "\\%c", *p);
+        } else if (*p == '\n') {
+            appendf(buf, "\\n");
+        } else {
+            appendf(buf, "%c", *p);
+        }
+    }
+}
+
+/**
+ * @brief Ghi một mẫu: name{test_id="..."[,extra]} value
+ */
+static void append_sample(text_buffer_t *buf, const char *name, const char *test_id, const char *extra,
+                          double value) {
+    appendf(buf, "%s", name);
+    if (test_id) {
+        appendf(buf, "{test_id=\"");
+        append_label(buf, test_id);
+        appendf(buf, "\"%s%s}", extra ? "," : "", extra ? extra : "");
+    }
+    if (isnan(value)) {
+        appendf(buf, " NaN\n");
+    } else {
+        appendf(buf, " %.9g\n", value);
+    }
+}
+
+static void append_family(text_buffer_t *buf, const char *name, const char *type, const char *unit,
+                          const char *help) {
+    appendf(buf, "# TYPE %s %s\n", name, type);
+    if (unit) {
+        appendf(buf, "# UNIT %s %s\n", name, unit);
+    }
+    appendf(buf, "# HELP %s %s\n", name, help);
+}
+
+static int compare_float(const void *a, const void *b) {
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+    return x < y ? -1 : (x > y);
+}
+
+static double quantile(const float *sorted, int n, double q) {
+    double pos = q * (n - 1);
+    int lo = (int)pos;
+    if (lo >= n - 1) {
+        return sorted[n - 1];
+    }
+    return sorted[lo] + (pos - lo) * (sorted[lo + 1] - sorted[lo]);
+}
+
+int metrics_render(char **output, size_t *length) {
+    if (!output || !length) {
+        return -1;
+    }
+
+    // Chụp trạng thái dưới mutex, định dạng sau khi nhả để không giữ luồng chạy test
+    pthread_mutex_lock(&metrics_lock);
+    int count = entry_count;
+    metrics_entry_t *snapshot = (metrics_entry_t *)malloc((count + 1) * sizeof(metrics_entry_t));
+    if (snapshot && count > 0) {
+        memcpy(snapshot, entries, count * sizeof(metrics_entry_t));
+    }
+    long depth = queue_depth;
+    long running = in_flight;
+    long done = completed;
+    time_t now = time(NULL);
+    long recent = 0;
+    for (int b = 0; b < METRICS_RATE_WINDOW_SEC; b++) {
+        if (now - rate_seconds[b] < METRICS_RATE_WINDOW_SEC) {
+            recent += rate_buckets[b];
+        }
+    }
+    time_t since = enabled_at;
+    pthread_mutex_unlock(&metrics_lock);
+
+    text_buffer_t buf = { (char *)malloc(8192), 0, 8192, false };
+    if (!snapshot || !buf.data) {
+        LOG_ERROR("Memory allocation failed for metrics output");
+        free(snapshot);
+        free(buf.data);
+        return -1;
+    }
+
+    // Trạng thái bộ chạy
+    long window = now - since + 1;
+    if (window > METRICS_RATE_WINDOW_SEC) {
+        window = METRICS_RATE_WINDOW_SEC;
+    }
+    append_family(&buf, "device_test_queue_depth", "gauge", NULL, "Test cases waiting to run.");
+    append_sample(&buf, "device_test_queue_depth", NULL, NULL, depth);
+    append_family(&buf, "device_test_in_flight", "gauge", NULL, "Test cases currently running.");
+    append_sample(&buf, "device_test_in_flight", NULL, NULL, running);
+    append_family(&buf, "device_test_completed", "counter", NULL, "Test cases finished since start.");
+    append_sample(&buf, "device_test_completed_total", NULL, NULL, done);
+    append_family(&buf, "device_test_tests_per_second", "gauge", NULL,
+                  "Test cases finished per second over the last minute.");
+    append_sample(&buf, "device_test_tests_per_second", NULL, NULL, (double)recent / window);
+
+    // Số liệu theo test ID
+    static const char *status_names[] = { "SUCCESS", "FAILED", "TIMEOUT", "ERROR" };
+    char extra[64];
+
+    append_family(&buf, "device_test_status", "stateset", NULL, "Status of the latest run.");
+    for (int e = 0; e < count; e++) {
+        for (int s = TEST_RESULT_SUCCESS; s <= TEST_RESULT_ERROR; s++) {
+            snprintf(extra, sizeof(extra), "device_test_status=\"%s\"", status_names[s]);
+            append_sample(&buf, "device_test_status", snapshot[e].test_id, extra, snapshot[e].status == (test_result_status_t)s);
+        }
+    }
+
+    append_family(&buf, "device_test_runs", "counter", NULL, "Runs per test case and status.");
+    for (int e = 0; e < count; e++) {
+        for (int s = TEST_RESULT_SUCCESS; s <= TEST_RESULT_ERROR; s++) {
+            snprintf(extra, sizeof(extra), "status=\"%s\"", status_names[s]);
+            append_sample(&buf, "device_test_runs_total", snapshot[e].test_id, extra, snapshot[e].runs[s]);
+        }
+    }
+
+    append_family(&buf, "device_test_execution_time_milliseconds", "gauge", "milliseconds",
+                  "Execution time of the latest run.");
+    for (int e = 0; e < count; e++) {
+        append_sample(&buf, "device_test_execution_time_milliseconds", snapshot[e].test_id, NULL,
+                      snapshot[e].execution_time);
+    }
+
+    append_family(&buf, "device_test_last_run_timestamp_seconds", "gauge", "seconds",
+                  "Time the latest run finished.");
+    for (int e = 0; e < count; e++) {
+        append_sample(&buf, "device_test_last_run_timestamp_seconds", snapshot[e].test_id, NULL,
+                      snapshot[e].last_run);
+    }
+
+    append_family(&buf, "device_test_rtt_milliseconds", "summary", "milliseconds",
+                  "Average ping RTT per run, quantiles over the recent runs.");
+    for (int e = 0; e < count; e++) {
+        metrics_entry_t *entry = &snapshot[e];
+        if (entry->rtt_count == 0) {
+            continue;
+        }
+        qsort(entry->rtt_window, entry->rtt_window_count, sizeof(float), compare_float);
+        static const char *quantiles[] = { "0.5", "0.9", "0.99" };
+        for (int q = 0; q < 3; q++) {
+            snprintf(extra, sizeof(extra), "quantile=\"%s\"", quantiles[q]);
+            append_sample(&buf, "device_test_rtt_milliseconds", entry->test_id, extra,
+                          quantile(entry->rtt_window, entry->rtt_window_count, atof(quantiles[q])));
+        }
+        append_sample(&buf, "device_test_rtt_milliseconds_count", entry->test_id, NULL, entry->rtt_count);
+        append_sample(&buf, "device_test_rtt_milliseconds_sum", entry->test_id, NULL, entry->rtt_sum);
+    }
+
+    append_family(&buf, "device_test_packet_loss_percent", "gauge", NULL, "Ping packet loss of the latest run.");
+    for (int e = 0; e < count; e++) {
+        if (!isnan(snapshot[e].packet_loss)) {
+            append_sample(&buf, "device_test_packet_loss_percent", snapshot[e].test_id, NULL, snapshot[e].packet_loss);
+        }
+    }
+
+    append_family(&buf, "device_test_bandwidth_mbps", "gauge", NULL, "Throughput of the latest run in Mbit/s.");
+    for (int e = 0; e < count; e++) {
+        if (!isnan(snapshot[e].bandwidth)) {
+            append_sample(&buf, "device_test_bandwidth_mbps", snapshot[e].test_id, NULL, snapshot[e].bandwidth);
+        }
+    }
+
+    appendf(&buf, "# EOF\n");
+    free(snapshot);
+
+    if (buf.error) {
+        LOG_ERROR("Memory allocation failed for metrics output");
+        free(buf.data);
+        return -1;
+    }
+    *output = buf.data;
+    *length = buf.size;
+    return 0;
+}
+
+static int send_all(int fd, const char *data, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = send(fd, data + done, len - done, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Đọc request và trả lời một kết nối (Connection: close)
+ */
+static void handle_client(int fd) {
+    // Client chậm không được giữ luồng HTTP quá lâu
+    struct timeval timeout = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char request[METRICS_REQUEST_SIZE];
+    size_t used = 0;
+    while (used < sizeof(request) - 1) {
+        ssize_t n = recv(fd, request + used, sizeof(request) - 1 - used, 0);
+        if (n <= 0) {
+            break;
+        }
+        used += (size_t)n;
+        request[used] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) {
+            break;
+        }
+    }
+    request[used] = '\0';
+
+    char header[256];
+    char *body = NULL;
+    size_t body_len = 0;
+    bool metrics = strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET /metrics?", 13) == 0;
+    if (metrics && metrics_render(&body, &body_len) == 0) {
+        int len = snprintf(header, sizeof(header),
+                           "HTTP/1.1 200 OK\r\n"
+                           "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                           "Content-Length: %zu\r\nConnection: close\r\n\r\n", body_len);
+        if (send_all(fd, header, (size_t)len) == 0) {
+            send_all(fd, body, body_len);
+        }
+        free(body);
+    } else {
+        const char *reply = metrics ? "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"
+                                    : "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        send_all(fd, reply, strlen(reply));
+    }
+}
+
+static void *server_main(void *arg) {
+    (void)arg;
+    struct pollfd pfd = { listen_fd, POLLIN, 0 };
+    while (!server_stop) {
+        int ready = poll(&pfd, 1, METRICS_POLL_MS);
+        if (ready <= 0) {
+            continue;
+        }
+        int client = accept(listen_fd, NULL, NULL);
+        if (client < 0) {
+            continue;
+        }
+        handle_client(client);
+        close(client);
+    }
+    return NULL;
+}
+
+int metrics_server_start(int port) {
+    if (server_running || port < 0 || port > 65535) {
+        return -1;
+    }
+
+    listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        LOG_ERROR("Failed to create metrics socket: %s", strerror(errno));
+        return -1;
+    }
+    int reuse = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    // Chỉ localhost: scrape qua SSH tunnel hoặc agent trên thiết bị
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+    socklen_t addr_len = sizeof(addr);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listen_fd, 8) != 0 ||
+        getsockname(listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        LOG_ERROR("Failed to listen on 127.0.0.1:%d: %s", port, strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+
+    metrics_enable();
+    server_stop = 0;
+    if (pthread_create(&server_thread, NULL, server_main, NULL) != 0) {
+        LOG_ERROR("Failed to start metrics server thread");
+        close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+    server_running = true;
+
+    int bound = ntohs(addr.sin_port);
+    LOG_DEBUG("Serving metrics on http://127.0.0.1:%d/metrics", bound);
+    return bound;
+}
+
+void metrics_server_stop(void) {
+    if (server_running) {
+        server_stop = 1;
+        pthread_join(server_thread, NULL);
+        server_running = false;
+    }
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        listen_fd = -1;
+    }
+
+    pthread_mutex_lock(&metrics_lock);
+    metrics_enabled = false;
+    free(entries);
+    free(slots);
+    entries = NULL;
+    slots = NULL;
+    entry_count = entry_capacity = slot_count = 0;
+    queue_depth = in_flight = completed = 0;
+    memset(rate_buckets, 0, sizeof(rate_buckets));
+    memset(rate_seconds, 0, sizeof(rate_seconds));
+    pthread_mutex_unlock(&metrics_lock);
+}
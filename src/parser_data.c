@@ -1,4 +1,7 @@
 
+#define _POSIX_C_SOURCE 200809L   /* posix_memalign */
+#define LOG_MODULE LOG_MOD_PARSER
+
  #include <stdio.h>
  #include <stdlib.h>
  #include <string.h>
@@ -6,364 +9,574 @@
  #include "file_process.h" 
  #include "log.h"          
  #include "cjson/cJSON.h"       
- bool parse_json_content(const char *json_content, test_case_t **test_cases, int *count) {
-    if (!json_content || !test_cases || !count) {
-        log_message(LOG_LVL_ERROR, "Invalid parameters for parse_json_content");
-        return false;
+/**
+ * @brief Phân tích một object JSON thành test case
+ *
+ * @param test_case_json Object JSON của test case
+ * @param i Vị trí của test case (dùng để sinh ID mặc định)
+ * @param current_test Test case nhận kết quả
+ * @param pool String pool của suite
+ */
+static void parse_test_case_object(cJSON *test_case_json, int i, test_case_t *current_test, string_pool_t *pool) {
+    // Xử lý ID
+    char id_buf[32];
+    const char *id_str = id_buf;
+    cJSON *id = cJSON_GetObjectItem(test_case_json, "id");
+    if (id && cJSON_IsString(id)) {
+        id_str = id->valuestring;
+        LOG_DEBUG("Processing test case ID: %s", id_str);
+    } else {
+        LOG_WARN("Test case at index %d has no valid ID", i);
+        snprintf(id_buf, sizeof(id_buf), "TC%03d", i+1); // ID mặc định
+        LOG_DEBUG("Assigned default ID: %s", id_str);
     }
+    current_test->id = string_pool_intern(pool, id_str);
     
-    // Log bắt đầu parse JSON
-    log_message(LOG_LVL_DEBUG, "Starting JSON parsing");
-    
-    cJSON *root = cJSON_Parse(json_content);
-    if (!root) {
-        log_message(LOG_LVL_ERROR, "Failed to parse JSON: %s", cJSON_GetErrorPtr());
-        return false;
+    // Xử lý name
+    cJSON *name = cJSON_GetObjectItem(test_case_json, "name");
+    if (name && cJSON_IsString(name)) {
+        current_test->name = string_pool_intern(pool, name->valuestring);
+        LOG_DEBUG("Test case %s name: %s", id_str, name->valuestring);
+    } else {
+        LOG_WARN("Test case %s has no valid name", id_str);
+        char name_buf[64];
+        snprintf(name_buf, sizeof(name_buf), "Unnamed Test %s", id_str);
+        current_test->name = string_pool_intern(pool, name_buf);
     }
     
-    // Xử lý JSON như triển khai trước đó
-    cJSON *test_cases_array = cJSON_GetObjectItem(root, "test_cases");
-    if (!test_cases_array || !cJSON_IsArray(test_cases_array)) {
-        log_message(LOG_LVL_ERROR, "JSON doesn't contain 'test_cases' array");
-        cJSON_Delete(root);
-        return false;
+    // Xử lý description
+    cJSON *description = cJSON_GetObjectItem(test_case_json, "description");
+    if (description && cJSON_IsString(description)) {
+        current_test->description = string_pool_intern(pool, description->valuestring);
+        LOG_DEBUG("Test case %s description processed", id_str);
+    } else {
+        LOG_WARN("Test case %s has no valid description", id_str);
+        current_test->description = 0; // Mô tả rỗng
     }
     
-    *count = cJSON_GetArraySize(test_cases_array);
-    if (*count <= 0) {
-        log_message(LOG_LVL_ERROR, "No test cases found in JSON");
-        cJSON_Delete(root);
-        return false;
+    // Xử lý target
+    cJSON *target = cJSON_GetObjectItem(test_case_json, "target");
+    if (target && cJSON_IsString(target)) {
+        current_test->target = string_pool_intern(pool, target->valuestring);
+        LOG_DEBUG("Test case %s target: %s", id_str, target->valuestring);
+    } else {
+        LOG_WARN("Test case %s has no valid target", id_str);
+        current_test->target = 0; // Target rỗng
     }
     
-    log_message(LOG_LVL_DEBUG, "Found %d test cases in JSON", *count);
+    // Xử lý timeout
+    cJSON *timeout = cJSON_GetObjectItem(test_case_json, "timeout");
+    if (timeout && cJSON_IsNumber(timeout)) {
+        current_test->timeout = timeout->valueint;
+        LOG_DEBUG("Test case %s timeout: %d ms", id_str, current_test->timeout);
+    } else {
+        current_test->timeout = 10000; // Mặc định 10 giây (10000 ms)
+        LOG_WARN("Test case %s has no valid timeout, setting default: 10000 ms", id_str);
+    }
     
-    // Cấp phát bộ nhớ cho mảng test cases
-    *test_cases = (test_case_t *)malloc(*count * sizeof(test_case_t));
-    if (!(*test_cases)) {
-        log_message(LOG_LVL_ERROR, "Memory allocation failed for test cases");
-        cJSON_Delete(root);
-        return false;
+    // Xử lý enabled
+    cJSON *enabled = cJSON_GetObjectItem(test_case_json, "enabled");
+    if (enabled && cJSON_IsBool(enabled)) {
+        current_test->enabled = cJSON_IsTrue(enabled);
+        LOG_DEBUG("Test case %s enabled: %s", id_str, current_test->enabled ? "true" : "false");
+    } else {
+        current_test->enabled = true; // Mặc định là enabled
+        LOG_WARN("Test case %s has no valid enabled flag, enabling by default", id_str);
     }
-    memset(*test_cases, 0, *count * sizeof(test_case_t));
     
-    // Xử lý từng test case
-    for (int i = 0; i < *count; i++) {
-        cJSON *test_case_json = cJSON_GetArrayItem(test_cases_array, i);
-        test_case_t *current_test = &((*test_cases)[i]);
-        
-        // Xử lý ID
-        cJSON *id = cJSON_GetObjectItem(test_case_json, "id");
-        if (id && cJSON_IsString(id)) {
-            strncpy(current_test->id, id->valuestring, sizeof(current_test->id) - 1);
-            current_test->id[sizeof(current_test->id) - 1] = '\0'; // Đảm bảo null-terminated
-            log_message(LOG_LVL_DEBUG, "Processing test case ID: %s", current_test->id);
-        } else {
-            log_message(LOG_LVL_WARN, "Test case at index %d has no valid ID", i);
-            snprintf(current_test->id, sizeof(current_test->id), "TC%03d", i+1); // ID mặc định
-            log_message(LOG_LVL_DEBUG, "Assigned default ID: %s", current_test->id);
-        }
-        
-        // Xử lý name
-        cJSON *name = cJSON_GetObjectItem(test_case_json, "name");
-        if (name && cJSON_IsString(name)) {
-            strncpy(current_test->name, name->valuestring, sizeof(current_test->name) - 1);
-            current_test->name[sizeof(current_test->name) - 1] = '\0'; // Đảm bảo null-terminated
-            log_message(LOG_LVL_DEBUG, "Test case %s name: %s", current_test->id, current_test->name);
-        } else {
-            log_message(LOG_LVL_WARN, "Test case %s has no valid name", current_test->id);
-            snprintf(current_test->name, sizeof(current_test->name), "Unnamed Test %s", current_test->id);
-        }
-        
-        // Xử lý description
-        cJSON *description = cJSON_GetObjectItem(test_case_json, "description");
-        if (description && cJSON_IsString(description)) {
-            strncpy(current_test->description, description->valuestring, sizeof(current_test->description) - 1);
-            current_test->description[sizeof(current_test->description) - 1] = '\0';
-            log_message(LOG_LVL_DEBUG, "Test case %s description processed", current_test->id);
-        } else {
-            log_message(LOG_LVL_WARN, "Test case %s has no valid description", current_test->id);
-            current_test->description[0] = '\0'; // Mô tả rỗng
-        }
-        
-        // Xử lý target
-        cJSON *target = cJSON_GetObjectItem(test_case_json, "target");
-        if (target && cJSON_IsString(target)) {
-            strncpy(current_test->target, target->valuestring, sizeof(current_test->target) - 1);
-            current_test->target[sizeof(current_test->target) - 1] = '\0';
-            log_message(LOG_LVL_DEBUG, "Test case %s target: %s", current_test->id, current_test->target);
-        } else {
-            log_message(LOG_LVL_WARN, "Test case %s has no valid target", current_test->id);
-            current_test->target[0] = '\0'; // Target rỗng
-        }
-        
-        // Xử lý timeout
-        cJSON *timeout = cJSON_GetObjectItem(test_case_json, "timeout");
-        if (timeout && cJSON_IsNumber(timeout)) {
-            current_test->timeout = timeout->valueint;
-            log_message(LOG_LVL_DEBUG, "Test case %s timeout: %d ms", current_test->id, current_test->timeout);
-        } else {
-            current_test->timeout = 10000; // Mặc định 10 giây (10000 ms)
-            log_message(LOG_LVL_WARN, "Test case %s has no valid timeout, setting default: 10000 ms", current_test->id);
-        }
-        
-        // Xử lý enabled
-        cJSON *enabled = cJSON_GetObjectItem(test_case_json, "enabled");
-        if (enabled && cJSON_IsBool(enabled)) {
-            current_test->enabled = cJSON_IsTrue(enabled);
-            log_message(LOG_LVL_DEBUG, "Test case %s enabled: %s", current_test->id, current_test->enabled ? "true" : "false");
-        } else {
-            current_test->enabled = true; // Mặc định là enabled
-            log_message(LOG_LVL_WARN, "Test case %s has no valid enabled flag, enabling by default", current_test->id);
-        }
-        
-        // Xử lý type (loại test case)
-        cJSON *type = cJSON_GetObjectItem(test_case_json, "type");
-        if (type && cJSON_IsString(type)) {
-            const char *type_str = type->valuestring;
-            if (strcmp(type_str, "ping") == 0) {
-                current_test->type = TEST_PING;
-                log_message(LOG_LVL_DEBUG, "Test case %s type: PING", current_test->id);
+    // Xử lý type (loại test case)
+    cJSON *type = cJSON_GetObjectItem(test_case_json, "type");
+    if (type && cJSON_IsString(type)) {
+        const char *type_str = type->valuestring;
+        if (strcmp(type_str, "ping") == 0) {
+            current_test->type = TEST_PING;
+            LOG_DEBUG("Test case %s type: PING", id_str);
+            
+            // Xử lý các tham số ping nếu có
+            cJSON *ping_params = cJSON_GetObjectItem(test_case_json, "ping_params");
+            if (ping_params && cJSON_IsObject(ping_params)) {
+                // Đọc count
+                cJSON *count_param = cJSON_GetObjectItem(ping_params, "count");
+                if (count_param && cJSON_IsNumber(count_param)) {
+                    current_test->params.ping.count = count_param->valueint;
+                } else {
+                    current_test->params.ping.count = 4; // Mặc định
+                }
+                
+                // Đọc size
+                cJSON *size_param = cJSON_GetObjectItem(ping_params, "size");
+                if (size_param && cJSON_IsNumber(size_param)) {
+                    current_test->params.ping.size = size_param->valueint;
+                } else {
+                    current_test->params.ping.size = 64; // Mặc định
+                }
+                
+                // Đọc interval
+                cJSON *interval_param = cJSON_GetObjectItem(ping_params, "interval");
+                if (interval_param && cJSON_IsNumber(interval_param)) {
+                    current_test->params.ping.interval = interval_param->valueint;
+                } else {
+                    current_test->params.ping.interval = 1000; // Mặc định 1 giây
+                }
                 
-                // Xử lý các tham số ping nếu có
-                cJSON *ping_params = cJSON_GetObjectItem(test_case_json, "ping_params");
-                if (ping_params && cJSON_IsObject(ping_params)) {
-                    // Đọc count
-                    cJSON *count_param = cJSON_GetObjectItem(ping_params, "count");
-                    if (count_param && cJSON_IsNumber(count_param)) {
-                        current_test->params.ping.count = count_param->valueint;
-                    } else {
-                        current_test->params.ping.count = 4; // Mặc định
-                    }
-                    
-                    // Đọc size
-                    cJSON *size_param = cJSON_GetObjectItem(ping_params, "size");
-                    if (size_param && cJSON_IsNumber(size_param)) {
-                        current_test->params.ping.size = size_param->valueint;
-                    } else {
-                        current_test->params.ping.size = 64; // Mặc định
-                    }
-                    
-                    // Đọc interval
-                    cJSON *interval_param = cJSON_GetObjectItem(ping_params, "interval");
-                    if (interval_param && cJSON_IsNumber(interval_param)) {
-                        current_test->params.ping.interval = interval_param->valueint;
-                    } else {
-                        current_test->params.ping.interval = 1000; // Mặc định 1 giây
-                    }
-                    
-                    // Đọc ipv6
-                    cJSON *ipv6_param = cJSON_GetObjectItem(ping_params, "ipv6");
-                    if (ipv6_param && cJSON_IsBool(ipv6_param)) {
-                        current_test->params.ping.ipv6 = cJSON_IsTrue(ipv6_param);
-                    } else {
-                        current_test->params.ping.ipv6 = false; // Mặc định IPv4
-                    }
-                    
-                    log_message(LOG_LVL_DEBUG, "Test case %s ping params processed", current_test->id);
+                // Đọc ipv6
+                cJSON *ipv6_param = cJSON_GetObjectItem(ping_params, "ipv6");
+                if (ipv6_param && cJSON_IsBool(ipv6_param)) {
+                    current_test->params.ping.ipv6 = cJSON_IsTrue(ipv6_param);
                 } else {
-                    log_message(LOG_LVL_WARN, "Test case %s missing ping parameters, using defaults", current_test->id);
-                    // Sử dụng giá trị mặc định
-                    current_test->params.ping.count = 4;
-                    current_test->params.ping.size = 64;
-                    current_test->params.ping.interval = 1000;
-                    current_test->params.ping.ipv6 = false;
+                    current_test->params.ping.ipv6 = false; // Mặc định IPv4
                 }
+                
+                LOG_DEBUG("Test case %s ping params processed", id_str);
+            } else {
+                LOG_WARN("Test case %s missing ping parameters, using defaults", id_str);
+                // Sử dụng giá trị mặc định
+                current_test->params.ping.count = 4;
+                current_test->params.ping.size = 64;
+                current_test->params.ping.interval = 1000;
+                current_test->params.ping.ipv6 = false;
             }
-            else if (strcmp(type_str, "throughput") == 0) {
-                current_test->type = TEST_THROUGHPUT;
-                log_message(LOG_LVL_DEBUG, "Test case %s type: THROUGHPUT", current_test->id);
+        }
+        else if (strcmp(type_str, "throughput") == 0) {
+            current_test->type = TEST_THROUGHPUT;
+            LOG_DEBUG("Test case %s type: THROUGHPUT", id_str);
+            
+            // Xử lý các tham số throughput nếu có
+            cJSON *throughput_params = cJSON_GetObjectItem(test_case_json, "throughput_params");
+            if (throughput_params && cJSON_IsObject(throughput_params)) {
+                // Đọc duration
+                cJSON *duration_param = cJSON_GetObjectItem(throughput_params, "duration");
+                if (duration_param && cJSON_IsNumber(duration_param)) {
+                    current_test->params.throughput.duration = duration_param->valueint;
+                } else {
+                    current_test->params.throughput.duration = 10; // Mặc định 10 giây
+                }
                 
-                // Xử lý các tham số throughput nếu có
-                cJSON *throughput_params = cJSON_GetObjectItem(test_case_json, "throughput_params");
-                if (throughput_params && cJSON_IsObject(throughput_params)) {
-                    // Đọc duration
-                    cJSON *duration_param = cJSON_GetObjectItem(throughput_params, "duration");
-                    if (duration_param && cJSON_IsNumber(duration_param)) {
-                        current_test->params.throughput.duration = duration_param->valueint;
-                    } else {
-                        current_test->params.throughput.duration = 10; // Mặc định 10 giây
-                    }
-                    
-                    // Đọc protocol
-                    cJSON *protocol_param = cJSON_GetObjectItem(throughput_params, "protocol");
-                    if (protocol_param && cJSON_IsString(protocol_param)) {
-                        strncpy(current_test->params.throughput.protocol, protocol_param->valuestring, 
-                                sizeof(current_test->params.throughput.protocol) - 1);
-                        current_test->params.throughput.protocol[sizeof(current_test->params.throughput.protocol) - 1] = '\0';
-                    } else {
-                        strcpy(current_test->params.throughput.protocol, "TCP"); // Mặc định TCP
-                    }
-                    
-                    // Đọc port
-                    cJSON *port_param = cJSON_GetObjectItem(throughput_params, "port");
-                    if (port_param && cJSON_IsNumber(port_param)) {
-                        current_test->params.throughput.port = port_param->valueint;
-                    } else {
-                        current_test->params.throughput.port = 5201; // Mặc định cổng iperf3
-                    }
-                    
-                    // Đọc buffer_size nếu có
-                    cJSON *buffer_param = cJSON_GetObjectItem(throughput_params, "buffer_size");
-                    if (buffer_param && cJSON_IsNumber(buffer_param)) {
-                        current_test->params.throughput.buffer_size = buffer_param->valueint;
-                    } else {
-                        current_test->params.throughput.buffer_size = 8192; // Mặc định 8KB
-                    }
-                    
-                    // Đọc bidirectional nếu có
-                    cJSON *bidir_param = cJSON_GetObjectItem(throughput_params, "bidirectional");
-                    if (bidir_param && cJSON_IsBool(bidir_param)) {
-                        current_test->params.throughput.bidirectional = cJSON_IsTrue(bidir_param);
-                    } else {
-                        current_test->params.throughput.bidirectional = false; // Mặc định một chiều
-                    }
-                    
-                    log_message(LOG_LVL_DEBUG, "Test case %s throughput params processed", current_test->id);
+                // Đọc protocol
+                cJSON *protocol_param = cJSON_GetObjectItem(throughput_params, "protocol");
+                if (protocol_param && cJSON_IsString(protocol_param)) {
+                    strncpy(current_test->params.throughput.protocol, protocol_param->valuestring, 
+                            sizeof(current_test->params.throughput.protocol) - 1);
+                    current_test->params.throughput.protocol[sizeof(current_test->params.throughput.protocol) - 1] = '\0';
                 } else {
-                    log_message(LOG_LVL_WARN, "Test case %s missing throughput parameters, using defaults", current_test->id);
-                    // Sử dụng giá trị mặc định
-                    current_test->params.throughput.duration = 10;
-                    strcpy(current_test->params.throughput.protocol, "TCP");
-                    current_test->params.throughput.port = 5201;
-                    current_test->params.throughput.buffer_size = 8192;
-                    current_test->params.throughput.bidirectional = false;
+                    strcpy(current_test->params.throughput.protocol, "TCP"); // Mặc định TCP
                 }
+                
+                // Đọc port
+                cJSON *port_param = cJSON_GetObjectItem(throughput_params, "port");
+                if (port_param && cJSON_IsNumber(port_param)) {
+                    current_test->params.throughput.port = port_param->valueint;
+                } else {
+                    current_test->params.throughput.port = 5201; // Mặc định cổng iperf3
+                }
+                
+                // Đọc buffer_size nếu có
+                cJSON *buffer_param = cJSON_GetObjectItem(throughput_params, "buffer_size");
+                if (buffer_param && cJSON_IsNumber(buffer_param)) {
+                    current_test->params.throughput.buffer_size = buffer_param->valueint;
+                } else {
+                    current_test->params.throughput.buffer_size = 8192; // Mặc định 8KB
+                }
+                
+                // Đọc bidirectional nếu có
+                cJSON *bidir_param = cJSON_GetObjectItem(throughput_params, "bidirectional");
+                if (bidir_param && cJSON_IsBool(bidir_param)) {
+                    current_test->params.throughput.bidirectional = cJSON_IsTrue(bidir_param);
+                } else {
+                    current_test->params.throughput.bidirectional = false; // Mặc định một chiều
+                }
+                
+                LOG_DEBUG("Test case %s throughput params processed", id_str);
+            } else {
+                LOG_WARN("Test case %s missing throughput parameters, using defaults", id_str);
+                // Sử dụng giá trị mặc định
+                current_test->params.throughput.duration = 10;
+                strcpy(current_test->params.throughput.protocol, "TCP");
+                current_test->params.throughput.port = 5201;
+                current_test->params.throughput.buffer_size = 8192;
+                current_test->params.throughput.bidirectional = false;
             }
-            else if (strcmp(type_str, "security") == 0) {
-                current_test->type = TEST_SECURITY;
-                log_message(LOG_LVL_DEBUG, "Test case %s type: SECURITY", current_test->id);
+        }
+        else if (strcmp(type_str, "security") == 0) {
+            current_test->type = TEST_SECURITY;
+            LOG_DEBUG("Test case %s type: SECURITY", id_str);
+            
+            // Xử lý các tham số security nếu có
+            cJSON *security_params = cJSON_GetObjectItem(test_case_json, "security_params");
+            if (security_params && cJSON_IsObject(security_params)) {
+                // Đọc method
+                cJSON *method_param = cJSON_GetObjectItem(security_params, "method");
+                if (method_param && cJSON_IsString(method_param)) {
+                    current_test->params.security.method = string_pool_intern(pool, method_param->valuestring);
+                } else {
+                    current_test->params.security.method = string_pool_intern(pool, "tls_scan"); // Mặc định
+                }
                 
-                // Xử lý các tham số security nếu có
-                cJSON *security_params = cJSON_GetObjectItem(test_case_json, "security_params");
-                if (security_params && cJSON_IsObject(security_params)) {
-                    // Đọc method
-                    cJSON *method_param = cJSON_GetObjectItem(security_params, "method");
-                    if (method_param && cJSON_IsString(method_param)) {
-                        strncpy(current_test->params.security.method, method_param->valuestring, 
-                                sizeof(current_test->params.security.method) - 1);
-                        current_test->params.security.method[sizeof(current_test->params.security.method) - 1] = '\0';
-                    } else {
-                        strcpy(current_test->params.security.method, "tls_scan"); // Mặc định
-                    }
-                    
-                    // Đọc port
-                    cJSON *port_param = cJSON_GetObjectItem(security_params, "port");
-                    if (port_param && cJSON_IsNumber(port_param)) {
-                        current_test->params.security.port = port_param->valueint;
-                    } else {
-                        current_test->params.security.port = 443; // Mặc định HTTPS 
-                    }
-                    
-                    // Đọc tls flag
-                    cJSON *tls_param = cJSON_GetObjectItem(security_params, "tls");
-                    if (tls_param && cJSON_IsBool(tls_param)) {
-                        current_test->params.security.tls = cJSON_IsTrue(tls_param);
-                    } else {
-                        current_test->params.security.tls = true; // Mặc định sử dụng TLS
-                    }
-                    
-                    log_message(LOG_LVL_DEBUG, "Test case %s security params processed", current_test->id);
+                // Đọc port
+                cJSON *port_param = cJSON_GetObjectItem(security_params, "port");
+                if (port_param && cJSON_IsNumber(port_param)) {
+                    current_test->params.security.port = port_param->valueint;
                 } else {
-                    log_message(LOG_LVL_WARN, "Test case %s missing security parameters, using defaults", current_test->id);
-                    // Sử dụng giá trị mặc định
-                    strcpy(current_test->params.security.method, "tls_scan");
-                    current_test->params.security.port = 443;
-                    current_test->params.security.tls = true;
+                    current_test->params.security.port = 443; // Mặc định HTTPS 
                 }
+                
+                // Đọc tls flag
+                cJSON *tls_param = cJSON_GetObjectItem(security_params, "tls");
+                if (tls_param && cJSON_IsBool(tls_param)) {
+                    current_test->params.security.tls = cJSON_IsTrue(tls_param);
+                } else {
+                    current_test->params.security.tls = true; // Mặc định sử dụng TLS
+                }
+                
+                LOG_DEBUG("Test case %s security params processed", id_str);
+            } else {
+                LOG_WARN("Test case %s missing security parameters, using defaults", id_str);
+                // Sử dụng giá trị mặc định
+                current_test->params.security.method = string_pool_intern(pool, "tls_scan");
+                current_test->params.security.port = 443;
+                current_test->params.security.tls = true;
             }
-            else {
-                current_test->type = TEST_OTHER;
-                log_message(LOG_LVL_DEBUG, "Test case %s type: OTHER (unrecognized type: %s)", current_test->id, type_str);
+        }
+        else {
+            current_test->type = TEST_OTHER;
+            LOG_DEBUG("Test case %s type: OTHER (unrecognized type: %s)", id_str, type_str);
+        }
+    } else {
+        current_test->type = TEST_OTHER;
+        LOG_WARN("Test case %s has no valid type, setting to OTHER", id_str);
+    }
+    
+    // Xử lý network_type (loại mạng)
+    cJSON *network = cJSON_GetObjectItem(test_case_json, "network");
+    if (network && cJSON_IsString(network)) {
+        const char *network_str = network->valuestring;
+        if (strcmp(network_str, "LAN") == 0) {
+            current_test->network_type = NETWORK_LAN;
+            LOG_DEBUG("Test case %s network: LAN", id_str);
+        } 
+        else if (strcmp(network_str, "WAN") == 0) {
+            current_test->network_type = NETWORK_WAN;
+            LOG_DEBUG("Test case %s network: WAN", id_str);
+        }
+        else if (strcmp(network_str, "BOTH") == 0) {
+            current_test->network_type = NETWORK_BOTH;
+            LOG_DEBUG("Test case %s network: BOTH", id_str);
+        }
+        else {
+            current_test->network_type = NETWORK_LAN; // Mặc định LAN
+            LOG_WARN("Test case %s has unrecognized network type: %s, setting to LAN", 
+                       id_str, network_str);
+        }
+    } else {
+        current_test->network_type = NETWORK_LAN; // Mặc định LAN
+        LOG_WARN("Test case %s has no valid network type, setting to LAN", id_str);
+    }
+    
+    // Xử lý extra_data
+    cJSON *extra_data = cJSON_GetObjectItem(test_case_json, "extra_data");
+    if (extra_data) {
+        // Nếu có trường extra_data, lưu dưới dạng chuỗi JSON
+        char *extra_json = cJSON_PrintUnformatted(extra_data);
+        if (extra_json) {
+            current_test->extra_data = string_pool_intern(pool, extra_json);
+            LOG_DEBUG("Test case %s extra_data processed", id_str);
+            free(extra_json);
+        } else {
+            current_test->extra_data = 0;
+            LOG_WARN("Failed to process extra_data for test case %s", id_str);
+        }
+    } else {
+        current_test->extra_data = 0;
+    }
+}
+
+/**
+ * @brief Phân tích một trục của matrix và thêm giá trị vào axis_values
+ *
+ * @return int Số giá trị đã thêm, -1 nếu lỗi
+ */
+static int parse_matrix_axis(cJSON *axis_json, test_axis_t axis, const char *matrix_id,
+                             uint32_t **values, size_t *value_count, size_t *value_capacity,
+                             string_pool_t *pool) {
+    if (!cJSON_IsArray(axis_json)) {
+        LOG_WARN("Matrix %s axis %d is not an array, ignoring", matrix_id, axis);
+        return 0;
+    }
+    
+    int added = 0;
+    cJSON *value = NULL;
+    cJSON_ArrayForEach(value, axis_json) {
+        uint32_t encoded;
+        if (axis == TEST_AXIS_TARGET && cJSON_IsString(value)) {
+            encoded = string_pool_intern(pool, value->valuestring);
+        } else if (axis == TEST_AXIS_SIZE && cJSON_IsNumber(value) && value->valueint > 0) {
+            encoded = (uint32_t)value->valueint;
+        } else if (axis == TEST_AXIS_NETWORK && cJSON_IsString(value)) {
+            if (strcmp(value->valuestring, "LAN") == 0) {
+                encoded = NETWORK_LAN;
+            } else if (strcmp(value->valuestring, "WAN") == 0) {
+                encoded = NETWORK_WAN;
+            } else if (strcmp(value->valuestring, "BOTH") == 0) {
+                encoded = NETWORK_BOTH;
+            } else {
+                LOG_WARN("Matrix %s has unrecognized network: %s", matrix_id, value->valuestring);
+                continue;
             }
         } else {
-            current_test->type = TEST_OTHER;
-            log_message(LOG_LVL_WARN, "Test case %s has no valid type, setting to OTHER", current_test->id);
+            LOG_WARN("Matrix %s has invalid value on axis %d, skipping", matrix_id, axis);
+            continue;
         }
         
-        // Xử lý network_type (loại mạng)
-        cJSON *network = cJSON_GetObjectItem(test_case_json, "network");
-        if (network && cJSON_IsString(network)) {
-            const char *network_str = network->valuestring;
-            if (strcmp(network_str, "LAN") == 0) {
-                current_test->network_type = NETWORK_LAN;
-                log_message(LOG_LVL_DEBUG, "Test case %s network: LAN", current_test->id);
-            } 
-            else if (strcmp(network_str, "WAN") == 0) {
-                current_test->network_type = NETWORK_WAN;
-                log_message(LOG_LVL_DEBUG, "Test case %s network: WAN", current_test->id);
+        if (*value_count == *value_capacity) {
+            size_t new_capacity = *value_capacity ? *value_capacity * 2 : 64;
+            uint32_t *new_values = (uint32_t *)realloc(*values, new_capacity * sizeof(uint32_t));
+            if (!new_values) {
+                LOG_ERROR("Memory allocation failed for matrix axis values");
+                return -1;
             }
-            else if (strcmp(network_str, "BOTH") == 0) {
-                current_test->network_type = NETWORK_BOTH;
-                log_message(LOG_LVL_DEBUG, "Test case %s network: BOTH", current_test->id);
+            *values = new_values;
+            *value_capacity = new_capacity;
+        }
+        (*values)[(*value_count)++] = encoded;
+        added++;
+    }
+    
+    return added;
+}
+
+/**
+ * @brief Phân tích mảng "matrices" thành tập matrix
+ *
+ * Mỗi phần tử có các trường giống một test case (làm mẫu) cùng object "axes"
+ * với các mảng "target", "size", "network".
+ */
+static bool parse_matrices_array(cJSON *matrices_array, test_matrix_set_t *set) {
+    static const char *axis_names[TEST_AXIS_COUNT] = { "target", "size", "network" };
+    
+    memset(set, 0, sizeof(*set));
+    
+    int count = cJSON_GetArraySize(matrices_array);
+    if (count <= 0) {
+        return true;
+    }
+    
+    set->matrices = (test_matrix_t *)calloc(count, sizeof(test_matrix_t));
+    string_pool_t pool;
+    if (!set->matrices || string_pool_init(&pool, 0) != 0) {
+        LOG_ERROR("Memory allocation failed for test matrices");
+        free(set->matrices);
+        set->matrices = NULL;
+        return false;
+    }
+    
+    size_t value_capacity = 0;
+    int i = 0;
+    cJSON *matrix_json = NULL;
+    cJSON_ArrayForEach(matrix_json, matrices_array) {
+        test_matrix_t *matrix = &set->matrices[i];
+        parse_test_case_object(matrix_json, i, &matrix->base, &pool);
+        // Chép id ra: intern giá trị trục có thể cấp phát lại pool.data
+        char matrix_id[64];
+        snprintf(matrix_id, sizeof(matrix_id), "%s", strtab_get(pool.data, matrix->base.id));
+        
+        cJSON *axes = cJSON_GetObjectItem(matrix_json, "axes");
+        for (int axis = 0; axis < TEST_AXIS_COUNT; axis++) {
+            cJSON *axis_json = axes ? cJSON_GetObjectItem(axes, axis_names[axis]) : NULL;
+            matrix->axis_offset[axis] = (uint32_t)set->axis_value_count;
+            if (!axis_json) {
+                continue;
             }
-            else {
-                current_test->network_type = NETWORK_LAN; // Mặc định LAN
-                log_message(LOG_LVL_WARN, "Test case %s has unrecognized network type: %s, setting to LAN", 
-                           current_test->id, network_str);
+            
+            int added = parse_matrix_axis(axis_json, (test_axis_t)axis, matrix_id, &set->axis_values,
+                                          &set->axis_value_count, &value_capacity, &pool);
+            if (added < 0) {
+                string_pool_free(&pool);
+                free_test_matrices(set);
+                return false;
             }
-        } else {
-            current_test->network_type = NETWORK_LAN; // Mặc định LAN
-            log_message(LOG_LVL_WARN, "Test case %s has no valid network type, setting to LAN", current_test->id);
+            matrix->axis_count[axis] = (uint32_t)added;
         }
         
-        // Xử lý extra_data
-        cJSON *extra_data = cJSON_GetObjectItem(test_case_json, "extra_data");
-        if (extra_data) {
-            // Nếu có trường extra_data, lưu dưới dạng chuỗi JSON
-            char *extra_json = cJSON_PrintUnformatted(extra_data);
-            if (extra_json) {
-                current_test->extra_data = strdup(extra_json);
-                log_message(LOG_LVL_DEBUG, "Test case %s extra_data processed", current_test->id);
-                free(extra_json);
-            } else {
-                current_test->extra_data = NULL;
-                log_message(LOG_LVL_WARN, "Failed to process extra_data for test case %s", current_test->id);
-            }
-        } else {
-            current_test->extra_data = NULL;
+        LOG_DEBUG("Matrix %s expands to %ld test cases", matrix_id, test_matrix_size(matrix));
+        i++;
+    }
+    set->count = i;
+    
+    set->strtab = string_pool_release(&pool, &set->strtab_size);
+    for (int m = 0; m < set->count; m++) {
+        set->matrices[m].base.strtab = set->strtab;
+    }
+    return true;
+}
+
+bool parse_json_suite(const char *json_content, test_case_t **test_cases, int *count,
+                      test_matrix_set_t *matrices) {
+    if (!json_content) {
+        LOG_ERROR("Invalid parameters for parse_json_suite");
+        return false;
+    }
+    return parse_json_suite_length(json_content, strlen(json_content), test_cases, count, matrices);
+}
+
+bool parse_json_suite_length(const char *json_content, size_t length, test_case_t **test_cases, int *count,
+                             test_matrix_set_t *matrices) {
+    if (!json_content || !test_cases || !count) {
+        LOG_ERROR("Invalid parameters for parse_json_suite");
+        return false;
+    }
+    
+    *test_cases = NULL;
+    if (matrices) {
+        memset(matrices, 0, sizeof(*matrices));
+    }
+    
+    // Log bắt đầu parse JSON
+    LOG_DEBUG("Starting JSON parsing");
+    
+    cJSON *root = cJSON_ParseWithLength(json_content, length);
+    if (!root) {
+        // Nội dung map không có '\0': chỉ in phần còn lại trong buffer quanh chỗ lỗi
+        const char *error = cJSON_GetErrorPtr();
+        size_t offset = error && error >= json_content && error <= json_content + length ?
+                        (size_t)(error - json_content) : length;
+        int shown = (int)(length - offset < 64 ? length - offset : 64);
+        LOG_ERROR("Failed to parse JSON at byte %zu: %.*s", offset, shown, json_content + offset);
+        return false;
+    }
+    
+    // Xử lý JSON như triển khai trước đó
+    cJSON *test_cases_array = cJSON_GetObjectItem(root, "test_cases");
+    if (!test_cases_array || !cJSON_IsArray(test_cases_array)) {
+        LOG_ERROR("JSON doesn't contain 'test_cases' array");
+        cJSON_Delete(root);
+        return false;
+    }
+    
+    // Test matrix (nếu người gọi cần)
+    cJSON *matrices_array = matrices ? cJSON_GetObjectItem(root, "matrices") : NULL;
+    if (matrices_array && cJSON_IsArray(matrices_array)) {
+        if (!parse_matrices_array(matrices_array, matrices)) {
+            cJSON_Delete(root);
+            return false;
         }
+        LOG_DEBUG("Found %d test matrices in JSON", matrices->count);
+    }
+    
+    *count = cJSON_GetArraySize(test_cases_array);
+    if (*count <= 0) {
+        cJSON_Delete(root);
+        if (matrices && matrices->count > 0) {
+            *count = 0;
+            return true;
+        }
+        LOG_ERROR("No test cases found in JSON");
+        return false;
+    }
+    
+    LOG_DEBUG("Found %d test cases in JSON", *count);
+    
+    // Cấp phát bộ nhớ cho mảng test cases
+    *test_cases = alloc_test_cases(*count);
+    if (!(*test_cases)) {
+        LOG_ERROR("Memory allocation failed for test cases");
+        cJSON_Delete(root);
+        if (matrices) {
+            free_test_matrices(matrices);
+        }
+        return false;
+    }
+    
+    // Các chuỗi của cả suite được intern vào một bảng chuỗi chung
+    string_pool_t pool;
+    if (string_pool_init(&pool, 0) != 0) {
+        free(*test_cases);
+        *test_cases = NULL;
+        cJSON_Delete(root);
+        if (matrices) {
+            free_test_matrices(matrices);
+        }
+        return false;
+    }
+    
+    // Xử lý từng test case
+    int i = 0;
+    cJSON *test_case_json = NULL;
+    cJSON_ArrayForEach(test_case_json, test_cases_array) {
+        parse_test_case_object(test_case_json, i, &((*test_cases)[i]), &pool);
+        i++;
     }
     
     cJSON_Delete(root);
-    log_message(LOG_LVL_DEBUG, "Completed parsing JSON test cases");
+    
+    if (attach_string_table(*test_cases, *count, &pool) != 0) {
+        LOG_ERROR("Failed to build string table for test cases");
+        free(*test_cases);
+        *test_cases = NULL;
+        if (matrices) {
+            free_test_matrices(matrices);
+        }
+        return false;
+    }
+    
+    // ID phải duy nhất để ánh xạ kết quả và yêu cầu chạy lại về đúng test case
+    test_case_index_t index;
+    int duplicates = test_case_index_build(&index, *test_cases, *count);
+    test_case_index_free(&index);
+    if (duplicates != 0) {
+        LOG_ERROR("Test suite has %d duplicate test case id(s)", duplicates);
+        free_test_cases(*test_cases, *count);
+        *test_cases = NULL;
+        if (matrices) {
+            free_test_matrices(matrices);
+        }
+        return false;
+    }
+    
+    LOG_DEBUG("Completed parsing JSON test cases");
     return true;
 }
+
+ bool parse_json_content(const char *json_content, test_case_t **test_cases, int *count) {
+     if (!json_content || !test_cases || !count) {
+         LOG_ERROR("Invalid parameters for parse_json_content");
+         return false;
+     }
+     
+     return parse_json_suite(json_content, test_cases, count, NULL);
+ }
  
  bool read_json_test_cases(const char *json_file, test_case_t **test_cases, int *count) {
      if (!json_file || !test_cases || !count) {
-         log_message(LOG_LVL_ERROR, "Invalid parameters for read_json_test_cases");
+         LOG_ERROR("Invalid parameters for read_json_test_cases");
          return false;
      }
      
-     log_message(LOG_LVL_DEBUG, "Reading JSON file: %s", json_file);
+     LOG_DEBUG("Reading JSON file: %s", json_file);
      
      // Kiểm tra file tồn tại
      if (!file_exists(json_file)) {
-         log_message(LOG_LVL_ERROR, "JSON file does not exist: %s", json_file);
+         LOG_ERROR("JSON file does not exist: %s", json_file);
          return false;
      }
      
-     // Đọc nội dung file JSON sử dụng file_process.c
-     char *json_content = NULL;
-     size_t content_size = 0;
-     
-     if (read_file(json_file, &json_content, &content_size) != 0) {
-         log_message(LOG_LVL_ERROR, "Failed to read JSON file: %s", json_file);
+     // Map file JSON (suite sinh tự động có thể lớn hàng trăm MB), không sao chép
+     file_view_t view;
+     if (file_view_open(json_file, &view) != 0) {
+         LOG_ERROR("Failed to read JSON file: %s", json_file);
          return false;
      }
      
-     log_message(LOG_LVL_DEBUG, "Successfully read %lu bytes from JSON file", 
-                (unsigned long)content_size);
+     LOG_DEBUG("Successfully read %lu bytes from JSON file", 
+                (unsigned long)view.size);
      
      // Parse nội dung JSON
-     bool result = parse_json_content(json_content, test_cases, count);
+     bool result = parse_json_suite_length(view.data, view.size, test_cases, count, NULL);
      
      // Giải phóng bộ nhớ
-     free(json_content);
+     file_view_release(&view);
      
      if (result) {
-         log_message(LOG_LVL_DEBUG, "Successfully parsed %d test cases from %s", 
+         LOG_DEBUG("Successfully parsed %d test cases from %s", 
                     *count, json_file);
      }
      
@@ -372,146 +585,429 @@
  
  // Triển khai các hàm khác từ parser_data.h...
  
- bool test_cases_to_json(const test_case_t *test_cases, int count, char *json_buffer, size_t buffer_size) {
-     if (!test_cases || count <= 0 || !json_buffer || buffer_size <= 0) {
-         log_message(LOG_LVL_ERROR, "Invalid parameters for test_cases_to_json");
+ bool test_case_write_json(json_writer_t *writer, const test_case_t *tc) {
+     if (!writer || !tc) {
          return false;
      }
      
-     log_message(LOG_LVL_DEBUG, "Converting %d test cases to JSON", count);
+     json_writer_begin_object(writer);
+     json_writer_field_string(writer, "id", test_case_id(tc));
+     json_writer_field_string(writer, "name", test_case_name(tc));
+     json_writer_field_string(writer, "description", test_case_description(tc));
+     json_writer_field_string(writer, "target", test_case_target(tc));
+     json_writer_field_int(writer, "timeout", tc->timeout);
+     json_writer_field_bool(writer, "enabled", tc->enabled);
+     
+     // Thêm loại test và tham số tương ứng
+     switch (tc->type) {
+         case TEST_PING:
+             json_writer_field_string(writer, "type", "ping");
+             json_writer_key(writer, "ping_params");
+             json_writer_begin_object(writer);
+             json_writer_field_int(writer, "count", tc->params.ping.count);
+             json_writer_field_int(writer, "size", tc->params.ping.size);
+             json_writer_field_int(writer, "interval", tc->params.ping.interval);
+             json_writer_field_bool(writer, "ipv6", tc->params.ping.ipv6);
+             json_writer_end_object(writer);
+             break;
+             
+         case TEST_THROUGHPUT:
+             json_writer_field_string(writer, "type", "throughput");
+             json_writer_key(writer, "throughput_params");
+             json_writer_begin_object(writer);
+             json_writer_field_int(writer, "duration", tc->params.throughput.duration);
+             json_writer_key(writer, "protocol");
+             json_writer_string_n(writer, tc->params.throughput.protocol,
+                                  strnlen(tc->params.throughput.protocol, sizeof(tc->params.throughput.protocol)));
+             json_writer_field_int(writer, "port", tc->params.throughput.port);
+             json_writer_end_object(writer);
+             break;
+             
+         case TEST_SECURITY:
+             json_writer_field_string(writer, "type", "security");
+             json_writer_key(writer, "security_params");
+             json_writer_begin_object(writer);
+             json_writer_field_string(writer, "method", test_case_security_method(tc));
+             json_writer_field_int(writer, "port", tc->params.security.port);
+             json_writer_end_object(writer);
+             break;
+             
+         default:
+             json_writer_field_string(writer, "type", "other");
+             break;
+     }
+     
+     // Thêm loại mạng
+     switch (tc->network_type) {
+         case NETWORK_LAN:
+             json_writer_field_string(writer, "network", "LAN");
+             break;
+         case NETWORK_WAN:
+             json_writer_field_string(writer, "network", "WAN");
+             break;
+         case NETWORK_BOTH:
+             json_writer_field_string(writer, "network", "BOTH");
+             break;
+     }
      
-     cJSON *root = cJSON_CreateObject();
-     if (!root) {
-         log_message(LOG_LVL_ERROR, "Failed to create JSON object");
+     // extra_data đã là JSON hợp lệ (do cJSON in ra khi parse), ghi nguyên văn
+     if (tc->extra_data) {
+         json_writer_key(writer, "extra_data");
+         json_writer_raw(writer, test_case_extra_data(tc), test_case_extra_data_size(tc));
+     }
+     
+     json_writer_end_object(writer);
+     return !writer->error;
+ }
+ 
+ bool test_cases_write_json(json_writer_t *writer, const test_case_t *test_cases, int count) {
+     if (!writer || (count > 0 && !test_cases) || count < 0) {
          return false;
      }
      
-     cJSON *test_cases_array = cJSON_CreateArray();
-     if (!test_cases_array) {
-         log_message(LOG_LVL_ERROR, "Failed to create JSON array");
-         cJSON_Delete(root);
+     json_writer_begin_object(writer);
+     json_writer_key(writer, "test_cases");
+     json_writer_begin_array(writer);
+     for (int i = 0; i < count && !writer->error; i++) {
+         test_case_write_json(writer, &test_cases[i]);
+     }
+     json_writer_end_array(writer);
+     json_writer_end_object(writer);
+     return !writer->error;
+ }
+ 
+ bool test_case_to_json(const test_case_t *test_case, char *json_buffer, size_t buffer_size) {
+     json_writer_t writer;
+     if (!test_case || json_writer_init_fixed(&writer, json_buffer, buffer_size) != 0) {
+         LOG_ERROR("Invalid parameters for test_case_to_json");
          return false;
      }
      
-     // Thêm mảng test_cases vào root
-     cJSON_AddItemToObject(root, "test_cases", test_cases_array);
+     test_case_write_json(&writer, test_case);
+     return json_writer_finish(&writer) == 0;
+ }
+ 
+ bool test_cases_to_json(const test_case_t *test_cases, int count, char *json_buffer, size_t buffer_size) {
+     json_writer_t writer;
+     if (!test_cases || count <= 0 || json_writer_init_fixed(&writer, json_buffer, buffer_size) != 0) {
+         LOG_ERROR("Invalid parameters for test_cases_to_json");
+         return false;
+     }
+     
+     LOG_DEBUG("Converting %d test cases to JSON", count);
+     
+     // Ghi thẳng vào buffer của người gọi, không dựng cây cJSON và không copy
+     test_cases_write_json(&writer, test_cases, count);
+     if (json_writer_finish(&writer) != 0) {
+         LOG_ERROR("Failed to convert test cases to JSON");
+         return false;
+     }
+     
+     LOG_DEBUG("Successfully converted test cases to JSON (%zu bytes)", writer.size);
+     return true;
+ }
+ 
+ void free_test_cases(test_case_t *test_cases, int count) {
+     if (!test_cases) {
+         return;
+     }
+     
+     LOG_DEBUG("Freeing memory for %d test cases", count);
+     
+     // Tất cả test cases trong mảng dùng chung một bảng chuỗi
+     if (count > 0 && test_cases[0].strtab) {
+         free((void *)test_cases[0].strtab);
+     }
+     
+     free(test_cases);
+ }
+ 
+ test_case_t *alloc_test_cases(int count) {
+     if (count <= 0) {
+         return NULL;
+     }
+     
+     void *mem = NULL;
+     if (posix_memalign(&mem, TEST_CASE_ALIGN, (size_t)count * sizeof(test_case_t)) != 0) {
+         return NULL;
+     }
+     memset(mem, 0, (size_t)count * sizeof(test_case_t));
+     return (test_case_t *)mem;
+ }
+ 
+ int attach_string_table(test_case_t *test_cases, int count, string_pool_t *pool) {
+     if (!test_cases || count <= 0 || !pool || !pool->data) {
+         return -1;
+     }
+     
+     const char *strtab = string_pool_release(pool, NULL);
+     if (!strtab) {
+         return -1;
+     }
+     
+     for (int i = 0; i < count; i++) {
+         test_cases[i].strtab = strtab;
+     }
+     return 0;
+ }  
+ 
+ /**
+  * @brief FNV-1a 32 bit của ID
+  */
+ static uint32_t hash_id(const char *id, size_t len) {
+     uint32_t hash = 2166136261u;
+     for (size_t i = 0; i < len; i++) {
+         hash ^= (unsigned char)id[i];
+         hash *= 16777619u;
+     }
+     return hash;
+ }
+ 
+ int test_case_index_build(test_case_index_t *index, const test_case_t *test_cases, int count) {
+     if (!index || (count > 0 && !test_cases) || count < 0) {
+         LOG_ERROR("Invalid parameters for test_case_index_build");
+         return -1;
+     }
+     
+     memset(index, 0, sizeof(*index));
+     index->test_cases = test_cases;
+     index->count = count;
      
-     // Chuyển đổi từng test case thành JSON
+     // Giữ tải <= 50% để chuỗi dò ngắn
+     index->slot_count = 16;
+     while (index->slot_count < (size_t)count * 2) {
+         index->slot_count *= 2;
+     }
+     index->slots = (int32_t *)calloc(index->slot_count, sizeof(int32_t));
+     if (!index->slots) {
+         LOG_ERROR("Memory allocation failed for test case index");
+         return -1;
+     }
+     
+     size_t mask = index->slot_count - 1;
+     int duplicates = 0;
      for (int i = 0; i < count; i++) {
          const test_case_t *tc = &test_cases[i];
-         cJSON *test_case_json = cJSON_CreateObject();
-         
-         if (!test_case_json) {
-             log_message(LOG_LVL_ERROR, "Failed to create JSON object for test case %d", i);
-             cJSON_Delete(root);
-             return false;
-         }
-         
-         // Thêm các trường của test case
-         cJSON_AddStringToObject(test_case_json, "id", tc->id);
-         cJSON_AddStringToObject(test_case_json, "name", tc->name);
-         cJSON_AddStringToObject(test_case_json, "description", tc->description);
-         cJSON_AddStringToObject(test_case_json, "target", tc->target);
-         cJSON_AddNumberToObject(test_case_json, "timeout", tc->timeout);
-         cJSON_AddBoolToObject(test_case_json, "enabled", tc->enabled);
+         const char *id = test_case_id(tc);
+         uint32_t len = strtab_len(tc->strtab, tc->id);
+         size_t pos = hash_id(id, len) & mask;
          
-         // Thêm loại test
-         switch (tc->type) {
-             case TEST_PING:
-                 cJSON_AddStringToObject(test_case_json, "type", "ping");
-                 
-                 // Thêm tham số ping
-                 cJSON *ping_params = cJSON_CreateObject();
-                 cJSON_AddNumberToObject(ping_params, "count", tc->params.ping.count);
-                 cJSON_AddNumberToObject(ping_params, "size", tc->params.ping.size);
-                 cJSON_AddNumberToObject(ping_params, "interval", tc->params.ping.interval);
-                 cJSON_AddBoolToObject(ping_params, "ipv6", tc->params.ping.ipv6);
-                 cJSON_AddItemToObject(test_case_json, "ping_params", ping_params);
-                 break;
-                 
-             case TEST_THROUGHPUT:
-                 cJSON_AddStringToObject(test_case_json, "type", "throughput");
-                 
-                 // Thêm tham số throughput
-                 cJSON *throughput_params = cJSON_CreateObject();
-                 cJSON_AddNumberToObject(throughput_params, "duration", tc->params.throughput.duration);
-                 cJSON_AddStringToObject(throughput_params, "protocol", tc->params.throughput.protocol);
-                 cJSON_AddNumberToObject(throughput_params, "port", tc->params.throughput.port);
-                 cJSON_AddItemToObject(test_case_json, "throughput_params", throughput_params);
-                 break;
-                 
-             case TEST_SECURITY:
-                 cJSON_AddStringToObject(test_case_json, "type", "security");
-                 
-                 // Thêm tham số security
-                 cJSON *security_params = cJSON_CreateObject();
-                 cJSON_AddStringToObject(security_params, "method", tc->params.security.method);
-                 cJSON_AddNumberToObject(security_params, "port", tc->params.security.port);
-                 cJSON_AddItemToObject(test_case_json, "security_params", security_params);
-                 break;
-                 
-             default:
-                 cJSON_AddStringToObject(test_case_json, "type", "other");
+         bool duplicate = false;
+         while (index->slots[pos]) {
+             const test_case_t *other = &test_cases[index->slots[pos] - 1];
+             if (strtab_len(other->strtab, other->id) == len && memcmp(test_case_id(other), id, len) == 0) {
+                 LOG_ERROR("Duplicate test case id %s (positions %d and %d)",
+                           id, index->slots[pos], i + 1);
+                 duplicate = true;
+                 duplicates++;
                  break;
+             }
+             pos = (pos + 1) & mask;
          }
-         
-         // Thêm loại mạng
-         switch (tc->network_type) {
-             case NETWORK_LAN:
-                 cJSON_AddStringToObject(test_case_json, "network", "LAN");
-                 break;
-             case NETWORK_WAN:
-                 cJSON_AddStringToObject(test_case_json, "network", "WAN");
-                 break;
-             case NETWORK_BOTH:
-                 cJSON_AddStringToObject(test_case_json, "network", "BOTH");
-                 break;
+         if (!duplicate) {
+             index->slots[pos] = i + 1;
          }
-         
-         // Thêm test_case_json vào mảng
-         cJSON_AddItemToArray(test_cases_array, test_case_json);
      }
      
-     // Convert JSON structure to string
-     char *json_str = cJSON_PrintUnformatted(root);
-     if (!json_str) {
-         log_message(LOG_LVL_ERROR, "Failed to convert JSON to string");
-         cJSON_Delete(root);
-         return false;
+     return duplicates;
+ }
+ 
+ int test_case_index_find(const test_case_index_t *index, const char *id) {
+     if (!index || !index->slots || !id) {
+         return -1;
      }
      
-     // Kiểm tra kích thước
-     if (strlen(json_str) >= buffer_size) {
-         log_message(LOG_LVL_ERROR, "JSON string too large for buffer");
-         free(json_str);
-         cJSON_Delete(root);
-         return false;
+     size_t len = strlen(id);
+     size_t mask = index->slot_count - 1;
+     size_t pos = hash_id(id, len) & mask;
+     while (index->slots[pos]) {
+         int i = index->slots[pos] - 1;
+         const test_case_t *tc = &index->test_cases[i];
+         if (strtab_len(tc->strtab, tc->id) == len && memcmp(test_case_id(tc), id, len) == 0) {
+             return i;
+         }
+         pos = (pos + 1) & mask;
+     }
+     return -1;
+ }
+ 
+ const test_case_t *find_test_case_by_id(const test_case_index_t *index, const char *id) {
+     int i = test_case_index_find(index, id);
+     return i >= 0 ? &index->test_cases[i] : NULL;
+ }
+ 
+ /**
+  * @brief Trộn một vùng nhớ vào hash FNV-1a 64 bit
+  */
+ static uint64_t hash_mix(uint64_t hash, const void *data, size_t size) {
+     const unsigned char *p = (const unsigned char *)data;
+     for (size_t i = 0; i < size; i++) {
+         hash ^= p[i];
+         hash *= 0x100000001b3ULL;
+     }
+     return hash;
+ }
+ 
+ /**
+  * @brief Trộn một chuỗi trong bảng chuỗi vào hash, kèm độ dài để tách các trường
+  */
+ static uint64_t hash_mix_ref(uint64_t hash, const char *strtab, str_ref_t ref) {
+     uint32_t len = strtab_len(strtab, ref);
+     hash = hash_mix(hash, &len, sizeof(len));
+     return hash_mix(hash, strtab_get(strtab, ref), len);
+ }
+ 
+ uint64_t test_case_hash(const test_case_t *tc) {
+     uint64_t hash = 0xcbf29ce484222325ULL;
+     if (!tc) {
+         return hash;
      }
      
-     // Copy vào buffer
-     strcpy(json_buffer, json_str);
-     
-     // Clean up
-     free(json_str);
-     cJSON_Delete(root);
+     int32_t scalars[5] = { tc->type, tc->network_type, tc->enabled, tc->flags, tc->timeout };
+     hash = hash_mix(hash, scalars, sizeof(scalars));
+     hash = hash_mix_ref(hash, tc->strtab, tc->id);
+     hash = hash_mix_ref(hash, tc->strtab, tc->target);
+     hash = hash_mix_ref(hash, tc->strtab, tc->name);
+     hash = hash_mix_ref(hash, tc->strtab, tc->description);
+     hash = hash_mix_ref(hash, tc->strtab, tc->extra_data);
      
-     log_message(LOG_LVL_DEBUG, "Successfully converted test cases to JSON");
-     return true;
+     // Băm từng trường của tham số thay vì cả union để không dính byte đệm
+     if (tc->type == TEST_PING) {
+         const ping_params_t *p = &tc->params.ping;
+         int32_t fields[4] = { p->count, p->size, p->interval, p->ipv6 };
+         hash = hash_mix(hash, fields, sizeof(fields));
+     } else if (tc->type == TEST_THROUGHPUT) {
+         const throughput_params_t *p = &tc->params.throughput;
+         int32_t fields[4] = { p->duration, p->port, p->buffer_size, p->bidirectional };
+         hash = hash_mix(hash, fields, sizeof(fields));
+         hash = hash_mix(hash, p->protocol, strnlen(p->protocol, sizeof(p->protocol)));
+     } else if (tc->type == TEST_SECURITY) {
+         const security_params_t *p = &tc->params.security;
+         int32_t fields[2] = { p->port, p->tls };
+         hash = hash_mix(hash, fields, sizeof(fields));
+         hash = hash_mix_ref(hash, tc->strtab, p->method);
+     }
+     return hash;
  }
  
- void free_test_cases(test_case_t *test_cases, int count) {
-     if (!test_cases) {
+ void test_case_index_free(test_case_index_t *index) {
+     if (!index) {
          return;
      }
      
-     log_message(LOG_LVL_DEBUG, "Freeing memory for %d test cases", count);
+     free(index->slots);
+     memset(index, 0, sizeof(*index));
+ }
+ 
+ long test_matrix_size(const test_matrix_t *matrix) {
+     if (!matrix) {
+         return 0;
+     }
      
-     for (int i = 0; i < count; i++) {
-         if (test_cases[i].extra_data) {
-             free(test_cases[i].extra_data);
-             test_cases[i].extra_data = NULL;
+     long size = 1;
+     for (int axis = 0; axis < TEST_AXIS_COUNT; axis++) {
+         if (matrix->axis_count[axis] > 0) {
+             size *= matrix->axis_count[axis];
          }
      }
+     return size;
+ }
+ 
+ long test_matrix_set_size(const test_matrix_set_t *set) {
+     long total = 0;
+     for (int m = 0; set && m < set->count; m++) {
+         total += test_matrix_size(&set->matrices[m]);
+     }
+     return total;
+ }
+ 
+ int test_matrix_item_init(test_matrix_item_t *item) {
+     if (!item) {
+         return -1;
+     }
+     memset(&item->test_case, 0, sizeof(item->test_case));
+     return string_pool_init(&item->strings, 512);
+ }
+ 
+ void test_matrix_item_free(test_matrix_item_t *item) {
+     if (item) {
+         string_pool_free(&item->strings);
+     }
+ }
+ 
+ bool test_matrix_expand(const test_matrix_set_t *set, int matrix_index, long index, test_matrix_item_t *item) {
+     if (!set || !item || matrix_index < 0 || matrix_index >= set->count) {
+         LOG_ERROR("Invalid parameters for test_matrix_expand");
+         return false;
+     }
      
-     free(test_cases);
- }  
\ No newline at end of file
+     const test_matrix_t *matrix = &set->matrices[matrix_index];
+     if (index < 0 || index >= test_matrix_size(matrix)) {
+         LOG_ERROR("Matrix index %ld out of range", index);
+         return false;
+     }
+     
+     // Giải mã index theo hệ cơ số hỗn hợp, trục cuối thay đổi nhanh nhất
+     uint32_t pick[TEST_AXIS_COUNT] = { 0 };
+     long rest = index;
+     for (int axis = TEST_AXIS_COUNT - 1; axis >= 0; axis--) {
+         if (matrix->axis_count[axis] > 0) {
+             pick[axis] = (uint32_t)(rest % matrix->axis_count[axis]);
+             rest /= matrix->axis_count[axis];
+         }
+     }
+     
+     const test_case_t *base = &matrix->base;
+     test_case_t *tc = &item->test_case;
+     *tc = *base;
+     
+     str_ref_t target = base->target;
+     if (matrix->axis_count[TEST_AXIS_TARGET] > 0) {
+         target = set->axis_values[matrix->axis_offset[TEST_AXIS_TARGET] + pick[TEST_AXIS_TARGET]];
+     }
+     if (matrix->axis_count[TEST_AXIS_SIZE] > 0) {
+         int size = (int)set->axis_values[matrix->axis_offset[TEST_AXIS_SIZE] + pick[TEST_AXIS_SIZE]];
+         if (tc->type == TEST_PING) {
+             tc->params.ping.size = size;
+         } else if (tc->type == TEST_THROUGHPUT) {
+             tc->params.throughput.buffer_size = size;
+         }
+     }
+     if (matrix->axis_count[TEST_AXIS_NETWORK] > 0) {
+         tc->network_type = (uint8_t)set->axis_values[matrix->axis_offset[TEST_AXIS_NETWORK] + pick[TEST_AXIS_NETWORK]];
+     }
+     
+     // Chuỗi của test case sinh ra được chép vào bảng chuỗi tạm của item
+     char id_buf[96];
+     snprintf(id_buf, sizeof(id_buf), "%s_%ld", strtab_get(set->strtab, base->id), index + 1);
+     
+     string_pool_reset(&item->strings);
+     tc->id = string_pool_intern(&item->strings, id_buf);
+     tc->name = string_pool_intern(&item->strings, strtab_get(set->strtab, base->name));
+     tc->description = base->description ?
+         string_pool_intern(&item->strings, strtab_get(set->strtab, base->description)) : 0;
+     tc->target = target ? string_pool_intern(&item->strings, strtab_get(set->strtab, target)) : 0;
+     tc->extra_data = base->extra_data ?
+         string_pool_intern(&item->strings, strtab_get(set->strtab, base->extra_data)) : 0;
+     if (tc->type == TEST_SECURITY) {
+         tc->params.security.method = string_pool_intern(&item->strings, test_case_security_method(base));
+     }
+     tc->strtab = item->strings.data;
+     
+     if (!tc->id || !tc->name) {
+         LOG_ERROR("Failed to build strings for matrix test case %s", id_buf);
+         return false;
+     }
+     return true;
+ }
+ 
+ void free_test_matrices(test_matrix_set_t *set) {
+     if (!set) {
+         return;
+     }
+     
+     free(set->matrices);
+     free(set->axis_values);
+     free(set->strtab);
+     memset(set, 0, sizeof(*set));
+ }
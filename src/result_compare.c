@@ -0,0 +1,589 @@
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "result_compare.h"
+#include "result_journal.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+
+/* Tên số đo trong diff JSON */
+static const char *metric_names[COMPARE_METRICS] = { "rtt_ms", "packet_loss", "bandwidth_mbps" };
+
+/* Độ lệch chuẩn tối thiểu theo số đo, tránh z vô hạn khi baseline không dao động */
+static const double metric_noise_floor[COMPARE_METRICS] = { 0.01, 0.1, 0.01 };
+
+/* +1: giá trị cao hơn là xấu, -1: thấp hơn là xấu */
+static const int metric_worse_sign[COMPARE_METRICS] = { 1, 1, -1 };
+
+void result_compare_init(result_compare_t *cmp) {
+    if (!cmp) {
+        return;
+    }
+
+    memset(cmp, 0, sizeof(*cmp));
+    cmp->threshold_pct = RESULT_COMPARE_DEFAULT_THRESHOLD;
+    cmp->loss_points = RESULT_COMPARE_DEFAULT_LOSS_POINTS;
+    cmp->alpha = RESULT_COMPARE_DEFAULT_ALPHA;
+}
+
+static uint32_t hash_id(const char *id) {
+    uint32_t hash = 2166136261u;
+    for (const char *p = id; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Vị trí của test ID trong bảng băm (ô trống nếu chưa có)
+ */
+static uint32_t slot_of(const result_compare_t *cmp, const char *test_id) {
+    uint32_t mask = cmp->slot_count - 1;
+    uint32_t pos = hash_id(test_id) & mask;
+    while (cmp->slots[pos] >= 0 && strcmp(cmp->entries[cmp->slots[pos]].test_id, test_id) != 0) {
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+const compare_entry_t *result_compare_find(const result_compare_t *cmp, const char *test_id) {
+    if (!cmp || !test_id || cmp->slot_count == 0) {
+        return NULL;
+    }
+
+    int index = cmp->slots[slot_of(cmp, test_id)];
+    return index >= 0 ? &cmp->entries[index] : NULL;
+}
+
+/**
+ * @brief Tìm hoặc tạo entry của một test ID
+ */
+static compare_entry_t *entry_for(result_compare_t *cmp, const char *test_id) {
+    if ((cmp->count + 1) * 2 > cmp->slot_count) {
+        int new_slot_count = cmp->slot_count ? cmp->slot_count * 2 : 64;
+        int *new_slots = (int *)malloc(new_slot_count * sizeof(int));
+        if (!new_slots) {
+            return NULL;
+        }
+        memset(new_slots, -1, new_slot_count * sizeof(int));
+        for (int e = 0; e < cmp->count; e++) {
+            uint32_t pos = hash_id(cmp->entries[e].test_id) & (new_slot_count - 1);
+            while (new_slots[pos] >= 0) {
+                pos = (pos + 1) & (new_slot_count - 1);
+            }
+            new_slots[pos] = e;
+        }
+        free(cmp->slots);
+        cmp->slots = new_slots;
+        cmp->slot_count = new_slot_count;
+    }
+
+    uint32_t pos = slot_of(cmp, test_id);
+    if (cmp->slots[pos] >= 0) {
+        return &cmp->entries[cmp->slots[pos]];
+    }
+
+    if (cmp->count == cmp->capacity) {
+        int new_capacity = cmp->capacity ? cmp->capacity * 2 : 32;
+        compare_entry_t *grown = (compare_entry_t *)realloc(cmp->entries, new_capacity * sizeof(compare_entry_t));
+        if (!grown) {
+            return NULL;
+        }
+        cmp->entries = grown;
+        cmp->capacity = new_capacity;
+    }
+
+    compare_entry_t *entry = &cmp->entries[cmp->count];
+    memset(entry, 0, sizeof(*entry));
+    snprintf(entry->test_id, sizeof(entry->test_id), "%s", test_id);
+    cmp->slots[pos] = cmp->count++;
+    return entry;
+}
+
+static int add_sample(compare_samples_t *samples, float value) {
+    if (isnan(value)) {
+        return 0;
+    }
+    if (samples->count == samples->capacity) {
+        int new_capacity = samples->capacity ? samples->capacity * 2 : 8;
+        float *grown = (float *)realloc(samples->values, new_capacity * sizeof(float));
+        if (!grown) {
+            return -1;
+        }
+        samples->values = grown;
+        samples->capacity = new_capacity;
+    }
+    samples->values[samples->count++] = value;
+    return 0;
+}
+
+/**
+ * @brief Ghi nhận một lần chạy; số đo NaN nghĩa là không áp dụng
+ */
+static int add_run(result_compare_t *cmp, compare_side_t side, const char *test_id, test_result_status_t status,
+                   float rtt, float loss, float bandwidth) {
+    if (!cmp || side < 0 || side >= COMPARE_SIDES || !test_id) {
+        return -1;
+    }
+
+    compare_entry_t *entry = entry_for(cmp, test_id);
+    if (!entry) {
+        LOG_ERROR("Memory allocation failed for result comparison");
+        return -1;
+    }
+
+    entry->runs[side]++;
+    entry->success[side] += status == TEST_RESULT_SUCCESS;
+    if (status == TEST_RESULT_ERROR) {
+        // Lỗi công cụ/cấu hình, không phải số đo của thiết bị
+        return 0;
+    }
+
+    if (add_sample(&entry->samples[side][COMPARE_RTT], rtt) != 0 ||
+        add_sample(&entry->samples[side][COMPARE_LOSS], loss) != 0 ||
+        add_sample(&entry->samples[side][COMPARE_BANDWIDTH], bandwidth) != 0) {
+        LOG_ERROR("Memory allocation failed for result comparison");
+        return -1;
+    }
+    return 0;
+}
+
+int result_compare_add_result(result_compare_t *cmp, compare_side_t side, const test_result_info_t *result) {
+    if (!result) {
+        return -1;
+    }
+
+    // Cùng quy ước với kho lịch sử để hai nguồn so sánh được với nhau
+    bool ping = test_result_has_ping_stats(result);
+    bool rtt = ping && result->data.ping.packets_received > 0;
+    return add_run(cmp, side, result->test_id, result->status,
+                   rtt ? result->data.ping.avg_rtt : NAN,
+                   ping ? result->data.ping.packet_loss : NAN,
+                   result->test_type == TEST_THROUGHPUT ? result->data.throughput.bandwidth : NAN);
+}
+
+int result_compare_add_row(result_compare_t *cmp, compare_side_t side, const result_store_row_t *row) {
+    if (!row) {
+        return -1;
+    }
+    return add_run(cmp, side, row->test_id, row->status, row->avg_rtt, row->packet_loss, row->bandwidth);
+}
+
+typedef struct {
+    result_compare_t *cmp;
+    compare_side_t side;
+} scan_context_t;
+
+static int add_row_cb(const result_store_row_t *row, void *context) {
+    scan_context_t *scan = (scan_context_t *)context;
+    return result_compare_add_row(scan->cmp, scan->side, row);
+}
+
+int result_compare_load(result_compare_t *cmp, compare_side_t side, const char *path,
+                        const result_store_filter_t *filter) {
+    if (!cmp || !path) {
+        return -1;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        LOG_ERROR("Failed to open %s: %s", path, strerror(errno));
+        return -1;
+    }
+    uint32_t magic = 0;
+    size_t got = fread(&magic, 1, sizeof(magic), file);
+    fclose(file);
+
+    if (got == sizeof(magic) && magic == RESULT_STORE_MAGIC) {
+        result_store_t store;
+        if (result_store_open(&store, path) != 0) {
+            return -1;
+        }
+        scan_context_t scan = { cmp, side };
+        long rows = result_store_scan(&store, filter, add_row_cb, &scan);
+        result_store_close(&store);
+        if (rows < 0) {
+            return -1;
+        }
+        LOG_DEBUG("Loaded %ld results from result store %s", rows, path);
+        return 0;
+    }
+
+    result_journal_records_t records;
+    if (result_journal_load_report(path, &records) != 0) {
+        return -1;
+    }
+    int ret = 0;
+    for (int i = 0; i < records.count && ret == 0; i++) {
+        ret = result_compare_add_result(cmp, side, &records.results[i]);
+    }
+    result_journal_records_free(&records);
+    return ret;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return x < y ? -1 : (x > y);
+}
+
+/**
+ * @brief Phân vị với nội suy tuyến tính trên mảng đã sắp xếp
+ */
+static double percentile(const double *sorted, int n, double p) {
+    double pos = p * (n - 1);
+    int lo = (int)pos;
+    if (lo >= n - 1) {
+        return sorted[n - 1];
+    }
+    return sorted[lo] + (pos - lo) * (sorted[lo + 1] - sorted[lo]);
+}
+
+static void compute_stats(const double *sorted, int n, compare_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    stats->n = n;
+    if (n == 0) {
+        stats->mean = stats->stddev = stats->p50 = stats->p95 = NAN;
+        return;
+    }
+
+    double sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += sorted[i];
+    }
+    stats->mean = sum / n;
+    double sq = 0;
+    for (int i = 0; i < n; i++) {
+        sq += (sorted[i] - stats->mean) * (sorted[i] - stats->mean);
+    }
+    stats->stddev = n > 1 ? sqrt(sq / (n - 1)) : 0;
+    stats->p50 = percentile(sorted, n, 0.50);
+    stats->p95 = percentile(sorted, n, 0.95);
+}
+
+static double upper_tail(double z) {
+    return 0.5 * erfc(z / sqrt(2.0));
+}
+
+/**
+ * @brief Kiểm định Mann-Whitney (xấp xỉ chuẩn, hiệu chỉnh hạng bằng nhau)
+ *
+ * @param high Lưu p một phía cho giả thuyết "hiện tại lớn hơn baseline"
+ * @param low Lưu p một phía cho giả thuyết "hiện tại nhỏ hơn baseline"
+ */
+static void mann_whitney(const double *base, int nb, const double *cur, int nc, double *high, double *low) {
+    int n = nb + nc;
+    double *all = (double *)malloc(n * sizeof(double));
+    int *from_current = (int *)malloc(n * sizeof(int));
+    if (!all || !from_current) {
+        free(all);
+        free(from_current);
+        *high = *low = NAN;
+        return;
+    }
+
+    // Hai mảng đã sắp xếp: trộn lại để gán hạng
+    int i = 0, j = 0, k = 0;
+    while (i < nb || j < nc) {
+        if (j >= nc || (i < nb && base[i] <= cur[j])) {
+            all[k] = base[i++];
+            from_current[k++] = 0;
+        } else {
+            all[k] = cur[j++];
+            from_current[k++] = 1;
+        }
+    }
+
+    double rank_sum = 0, ties = 0;
+    for (int start = 0; start < n;) {
+        int end = start;
+        while (end + 1 < n && all[end + 1] == all[start]) {
+            end++;
+        }
+        double rank = (start + end) / 2.0 + 1;
+        int t = end - start + 1;
+        ties += (double)t * t * t - t;
+        for (int r = start; r <= end; r++) {
+            if (from_current[r]) {
+                rank_sum += rank;
+            }
+        }
+        start = end + 1;
+    }
+    free(all);
+    free(from_current);
+
+    double u = rank_sum - nc * (nc + 1) / 2.0;
+    double mu = nb * (double)nc / 2.0;
+    double sigma = sqrt(nb * (double)nc / 12.0 * ((n + 1) - ties / ((double)n * (n - 1))));
+    if (sigma <= 0) {
+        *high = *low = 1.0;
+        return;
+    }
+    *high = upper_tail((u - mu - 0.5) / sigma);
+    *low = upper_tail((mu - u - 0.5) / sigma);
+}
+
+static double *sorted_copy(const compare_samples_t *samples) {
+    double *values = (double *)malloc((samples->count + 1) * sizeof(double));
+    if (!values) {
+        return NULL;
+    }
+    for (int i = 0; i < samples->count; i++) {
+        values[i] = samples->values[i];
+    }
+    qsort(values, samples->count, sizeof(double), compare_double);
+    return values;
+}
+
+bool result_compare_metric(const result_compare_t *cmp, const compare_entry_t *entry,
+                           compare_metric_t metric, compare_metric_result_t *out) {
+    if (!cmp || !entry || metric < 0 || metric >= COMPARE_METRICS || !out) {
+        return false;
+    }
+
+    const compare_samples_t *base_samples = &entry->samples[COMPARE_BASELINE][metric];
+    const compare_samples_t *cur_samples = &entry->samples[COMPARE_CURRENT][metric];
+    int nb = base_samples->count;
+    int nc = cur_samples->count;
+    if (nb == 0 && nc == 0) {
+        return false;
+    }
+
+    double *base = sorted_copy(base_samples);
+    double *cur = sorted_copy(cur_samples);
+    if (!base || !cur) {
+        free(base);
+        free(cur);
+        return false;
+    }
+
+    memset(out, 0, sizeof(*out));
+    compute_stats(base, nb, &out->side[COMPARE_BASELINE]);
+    compute_stats(cur, nc, &out->side[COMPARE_CURRENT]);
+    const compare_stats_t *b = &out->side[COMPARE_BASELINE];
+    const compare_stats_t *c = &out->side[COMPARE_CURRENT];
+    out->delta = c->p50 - b->p50;
+    out->change_pct = nb > 0 && nc > 0 && b->p50 != 0 ? 100.0 * out->delta / fabs(b->p50) : NAN;
+    out->p_value = NAN;
+
+    if (nc == 0 || nb == 0) {
+        out->verdict = nc == 0 ? COMPARE_MISSING : COMPARE_NEW;
+    } else if (nb < RESULT_COMPARE_MIN_SAMPLES) {
+        out->verdict = COMPARE_INSUFFICIENT;
+    } else {
+        // Ý nghĩa thống kê theo từng hướng
+        double p_high, p_low;
+        if (nc >= RESULT_COMPARE_MIN_SAMPLES) {
+            mann_whitney(base, nb, cur, nc, &p_high, &p_low);
+        } else {
+            double floor = fmax(metric_noise_floor[metric], 0.01 * fabs(b->mean));
+            double se = fmax(b->stddev, floor) * sqrt(1.0 / nc + 1.0 / nb);
+            double z = (c->mean - b->mean) / se;
+            p_high = upper_tail(z);
+            p_low = upper_tail(-z);
+        }
+        out->p_value = out->delta >= 0 ? p_high : p_low;
+
+        // Thay đổi đủ lớn để đáng quan tâm: điểm % với mất gói, % tương đối với số đo khác
+        bool up, down;
+        if (metric == COMPARE_LOSS) {
+            up = out->delta >= cmp->loss_points;
+            down = out->delta <= -cmp->loss_points;
+        } else if (!isnan(out->change_pct)) {
+            up = out->change_pct >= cmp->threshold_pct;
+            down = out->change_pct <= -cmp->threshold_pct;
+        } else {
+            up = out->delta > metric_noise_floor[metric];
+            down = out->delta < -metric_noise_floor[metric];
+        }
+
+        bool higher = up && p_high < cmp->alpha;
+        bool lower = down && p_low < cmp->alpha;
+        if (higher || lower) {
+            bool worse = (higher ? 1 : -1) == metric_worse_sign[metric];
+            out->verdict = worse ? COMPARE_REGRESSION : COMPARE_IMPROVEMENT;
+        } else {
+            out->verdict = COMPARE_UNCHANGED;
+        }
+    }
+
+    free(base);
+    free(cur);
+    return true;
+}
+
+compare_verdict_t result_compare_entry_verdict(const result_compare_t *cmp, const compare_entry_t *entry) {
+    if (entry->runs[COMPARE_CURRENT] == 0) {
+        return COMPARE_MISSING;
+    }
+    if (entry->runs[COMPARE_BASELINE] == 0) {
+        return COMPARE_NEW;
+    }
+
+    bool seen[COMPARE_NEW + 1] = { false };
+    for (int m = 0; m < COMPARE_METRICS; m++) {
+        compare_metric_result_t result;
+        if (result_compare_metric(cmp, entry, (compare_metric_t)m, &result)) {
+            seen[result.verdict] = true;
+        }
+    }
+
+    if (seen[COMPARE_REGRESSION]) return COMPARE_REGRESSION;
+    if (seen[COMPARE_IMPROVEMENT]) return COMPARE_IMPROVEMENT;
+    if (seen[COMPARE_UNCHANGED]) return COMPARE_UNCHANGED;
+    return COMPARE_INSUFFICIENT;
+}
+
+const char *compare_verdict_to_string(compare_verdict_t verdict) {
+    switch (verdict) {
+        case COMPARE_UNCHANGED: return "unchanged";
+        case COMPARE_IMPROVEMENT: return "improvement";
+        case COMPARE_REGRESSION: return "regression";
+        case COMPARE_INSUFFICIENT: return "insufficient_data";
+        case COMPARE_MISSING: return "missing";
+        case COMPARE_NEW: return "new";
+        default: return "unknown";
+    }
+}
+
+static void write_stats(json_writer_t *writer, const char *key, const compare_stats_t *stats) {
+    json_writer_key(writer, key);
+    json_writer_begin_object(writer);
+    json_writer_field_int(writer, "n", stats->n);
+    json_writer_field_double(writer, "mean", stats->mean);
+    json_writer_field_double(writer, "stddev", stats->stddev);
+    json_writer_field_double(writer, "p50", stats->p50);
+    json_writer_field_double(writer, "p95", stats->p95);
+    json_writer_end_object(writer);
+}
+
+void result_compare_write_json(const result_compare_t *cmp, json_writer_t *writer, const char *baseline_label,
+                               const char *current_label, compare_summary_t *summary) {
+    if (!cmp || !writer) {
+        return;
+    }
+
+    compare_summary_t totals;
+    memset(&totals, 0, sizeof(totals));
+    for (int e = 0; e < cmp->count; e++) {
+        totals.counts[result_compare_entry_verdict(cmp, &cmp->entries[e])]++;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    json_writer_begin_object(writer);
+    json_writer_field_int(writer, "generated_at_ms", (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000);
+    json_writer_field_string(writer, "baseline", baseline_label ? baseline_label : "");
+    json_writer_field_string(writer, "current", current_label ? current_label : "");
+
+    json_writer_key(writer, "thresholds");
+    json_writer_begin_object(writer);
+    json_writer_field_double(writer, "change_pct", cmp->threshold_pct);
+    json_writer_field_double(writer, "loss_points", cmp->loss_points);
+    json_writer_field_double(writer, "alpha", cmp->alpha);
+    json_writer_field_int(writer, "min_samples", RESULT_COMPARE_MIN_SAMPLES);
+    json_writer_end_object(writer);
+
+    json_writer_key(writer, "summary");
+    json_writer_begin_object(writer);
+    json_writer_field_int(writer, "tests", cmp->count);
+    for (int v = COMPARE_UNCHANGED; v <= COMPARE_NEW; v++) {
+        json_writer_field_int(writer, compare_verdict_to_string((compare_verdict_t)v), totals.counts[v]);
+    }
+    json_writer_end_object(writer);
+
+    json_writer_key(writer, "tests");
+    json_writer_begin_array(writer);
+    for (int e = 0; e < cmp->count; e++) {
+        const compare_entry_t *entry = &cmp->entries[e];
+        json_writer_begin_object(writer);
+        json_writer_field_string(writer, "test_id", entry->test_id);
+        json_writer_field_string(writer, "verdict", compare_verdict_to_string(result_compare_entry_verdict(cmp, entry)));
+        json_writer_field_int(writer, "baseline_runs", entry->runs[COMPARE_BASELINE]);
+        json_writer_field_int(writer, "baseline_success", entry->success[COMPARE_BASELINE]);
+        json_writer_field_int(writer, "current_runs", entry->runs[COMPARE_CURRENT]);
+        json_writer_field_int(writer, "current_success", entry->success[COMPARE_CURRENT]);
+
+        json_writer_key(writer, "metrics");
+        json_writer_begin_object(writer);
+        for (int m = 0; m < COMPARE_METRICS; m++) {
+            compare_metric_result_t result;
+            if (!result_compare_metric(cmp, entry, (compare_metric_t)m, &result)) {
+                continue;
+            }
+            json_writer_key(writer, metric_names[m]);
+            json_writer_begin_object(writer);
+            json_writer_field_string(writer, "verdict", compare_verdict_to_string(result.verdict));
+            write_stats(writer, "baseline", &result.side[COMPARE_BASELINE]);
+            write_stats(writer, "current", &result.side[COMPARE_CURRENT]);
+            json_writer_field_double(writer, "delta", result.delta);
+            json_writer_field_double(writer, "change_pct", result.change_pct);
+            json_writer_field_double(writer, "p_value", result.p_value);
+            json_writer_end_object(writer);
+        }
+        json_writer_end_object(writer);
+        json_writer_end_object(writer);
+    }
+    json_writer_end_array(writer);
+    json_writer_end_object(writer);
+    json_writer_raw(writer, "\n", 1);
+
+    if (summary) {
+        *summary = totals;
+    }
+}
+
+int result_compare_write_file(const result_compare_t *cmp, const char *path, const char *baseline_label,
+                              const char *current_label, compare_summary_t *summary) {
+    if (!cmp || !path) {
+        return -1;
+    }
+
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        LOG_ERROR("Failed to open comparison file %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    json_writer_t writer;
+    if (json_writer_init_file(&writer, file) != 0) {
+        fclose(file);
+        return -1;
+    }
+    result_compare_write_json(cmp, &writer, baseline_label, current_label, summary);
+    int ret = json_writer_finish(&writer);
+    json_writer_free(&writer);
+    if (fclose(file) != 0) {
+        ret = -1;
+    }
+
+    if (ret != 0) {
+        LOG_ERROR("Failed to write comparison file %s", path);
+    }
+    return ret;
+}
+
+void result_compare_free(result_compare_t *cmp) {
+    if (!cmp) {
+        return;
+    }
+
+    for (int e = 0; e < cmp->count; e++) {
+        for (int s = 0; s < COMPARE_SIDES; s++) {
+            for (int m = 0; m < COMPARE_METRICS; m++) {
+                free(cmp->entries[e].samples[s][m].values);
+            }
+        }
+    }
+    free(cmp->entries);
+    free(cmp->slots);
+    memset(cmp, 0, sizeof(*cmp));
+}
@@ -0,0 +1,459 @@
+
+#define _POSIX_C_SOURCE 200809L
+#define LOG_MODULE LOG_MOD_FILE
+
+#include "result_journal.h"
+#include "file_process.h"
+#include "log.h"
+#include "cjson/cJSON.h"
+#include <zlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static double elapsed_ms_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000.0 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/**
+ * @brief Cắt bỏ dòng cuối chưa ghi xong của journal cũ
+ */
+static int drop_partial_line(int fd, const char *path) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        return 0;
+    }
+
+    char buffer[4096];
+    off_t end = st.st_size;
+    while (end > 0) {
+        size_t chunk = end < (off_t)sizeof(buffer) ? (size_t)end : sizeof(buffer);
+        ssize_t n = pread(fd, buffer, chunk, end - (off_t)chunk);
+        if (n != (ssize_t)chunk) {
+            LOG_ERROR("Failed to read journal %s: %s", path, strerror(errno));
+            return -1;
+        }
+        for (size_t i = chunk; i > 0; i--) {
+            if (buffer[i - 1] == '\n') {
+                off_t keep = end - (off_t)chunk + (off_t)i;
+                if (keep == st.st_size) {
+                    return 0;
+                }
+                LOG_WARN("Dropping %lld bytes of incomplete record from journal %s",
+                         (long long)(st.st_size - keep), path);
+                return ftruncate(fd, keep);
+            }
+        }
+        end -= (off_t)chunk;
+    }
+
+    // Không có dòng hoàn chỉnh nào
+    LOG_WARN("Journal %s holds no complete record, starting over", path);
+    return ftruncate(fd, 0);
+}
+
+int result_journal_open(result_journal_t *journal, const char *path, bool append) {
+    if (!journal || !path) {
+        LOG_ERROR("Invalid parameters for result_journal_open");
+        return -1;
+    }
+
+    memset(journal, 0, sizeof(*journal));
+    // O_RDWR khi nối tiếp: cần đọc lại đuôi file để tìm dòng cắt dở
+    journal->fd = open(path, (append ? O_RDWR : O_WRONLY | O_TRUNC) | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (journal->fd == -1) {
+        LOG_ERROR("Failed to open journal %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    if ((append && drop_partial_line(journal->fd, path) != 0) ||
+        json_writer_init_buffer(&journal->line, 0) != 0) {
+        close(journal->fd);
+        journal->fd = -1;
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &journal->last_sync);
+    LOG_DEBUG("Result journal %s opened (%s)", path, append ? "append" : "new");
+    return 0;
+}
+
+int result_journal_append(result_journal_t *journal, const test_result_info_t *result) {
+    if (!journal || journal->fd == -1 || !result) {
+        return -1;
+    }
+
+    // Dựng cả dòng rồi ghi một lần: với O_APPEND dòng không bị xen kẽ hay tách đôi
+    json_writer_reset(&journal->line);
+    test_result_write_json(&journal->line, result);
+    json_writer_raw(&journal->line, "\n", 1);
+    if (json_writer_finish(&journal->line) != 0) {
+        LOG_ERROR("Failed to encode journal record for %s", result->test_id);
+        return -1;
+    }
+
+    size_t done = 0;
+    while (done < journal->line.size) {
+        ssize_t n = write(journal->fd, journal->line.data + done, journal->line.size - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Failed to append journal record for %s: %s", result->test_id, strerror(errno));
+            return -1;
+        }
+        done += (size_t)n;
+    }
+
+    journal->unsynced++;
+    if (journal->unsynced >= RESULT_JOURNAL_SYNC_RECORDS ||
+        elapsed_ms_since(&journal->last_sync) >= RESULT_JOURNAL_SYNC_INTERVAL_MS) {
+        return result_journal_sync(journal);
+    }
+    return 0;
+}
+
+int result_journal_sync(result_journal_t *journal) {
+    if (!journal || journal->fd == -1) {
+        return -1;
+    }
+    if (journal->unsynced == 0) {
+        return 0;
+    }
+
+    if (fdatasync(journal->fd) != 0) {
+        LOG_ERROR("Failed to sync result journal: %s", strerror(errno));
+        return -1;
+    }
+    journal->unsynced = 0;
+    clock_gettime(CLOCK_MONOTONIC, &journal->last_sync);
+    return 0;
+}
+
+void result_journal_close(result_journal_t *journal) {
+    if (!journal) {
+        return;
+    }
+
+    if (journal->fd != -1) {
+        result_journal_sync(journal);
+        close(journal->fd);
+    }
+    json_writer_free(&journal->line);
+    journal->fd = -1;
+}
+
+static test_result_status_t status_from_string(const char *status) {
+    if (strcmp(status, "SUCCESS") == 0) return TEST_RESULT_SUCCESS;
+    if (strcmp(status, "FAILED") == 0) return TEST_RESULT_FAILED;
+    if (strcmp(status, "TIMEOUT") == 0) return TEST_RESULT_TIMEOUT;
+    return TEST_RESULT_ERROR;
+}
+
+static test_type_t type_from_string(const char *type) {
+    if (strcmp(type, "ping") == 0) return TEST_PING;
+    if (strcmp(type, "throughput") == 0) return TEST_THROUGHPUT;
+    if (strcmp(type, "security") == 0) return TEST_SECURITY;
+    return TEST_OTHER;
+}
+
+static double number_field(cJSON *object, const char *key) {
+    cJSON *item = object ? cJSON_GetObjectItem(object, key) : NULL;
+    return item && cJSON_IsNumber(item) ? item->valuedouble : 0.0;
+}
+
+static const char *string_field(cJSON *object, const char *key) {
+    cJSON *item = object ? cJSON_GetObjectItem(object, key) : NULL;
+    return item && cJSON_IsString(item) ? item->valuestring : NULL;
+}
+
+/**
+ * @brief Khôi phục test_result_info_t từ một object JSON (ngược với test_result_write_json)
+ */
+static bool parse_object(cJSON *root, test_result_info_t *result) {
+    const char *test_id = string_field(root, "test_id");
+    const char *status = string_field(root, "status");
+    const char *type = string_field(root, "type");
+    if (!test_id || !status || !type) {
+        return false;
+    }
+
+    memset(result, 0, sizeof(*result));
+    snprintf(result->test_id, sizeof(result->test_id), "%s", test_id);
+    result->status = status_from_string(status);
+    result->test_type = type_from_string(type);
+    result->execution_time = (float)number_field(root, "execution_time_ms");
+    result->dns_time = (float)number_field(root, "dns_time_ms");
+    result->started_at = (int64_t)number_field(root, "started_at_ms");
+    result->finished_at = (int64_t)number_field(root, "finished_at_ms");
+    const char *details = string_field(root, "details");
+    test_result_set_details(result, details);
+
+    cJSON *data;
+    if ((data = cJSON_GetObjectItem(root, "sweep")) != NULL) {
+        result->is_sweep = true;
+        result->data.sweep.hosts_total = (int)number_field(data, "hosts_total");
+        result->data.sweep.hosts_reachable = (int)number_field(data, "hosts_reachable");
+    } else if ((data = cJSON_GetObjectItem(root, "ping")) != NULL) {
+        result->data.ping.packets_sent = (int)number_field(data, "packets_sent");
+        result->data.ping.packets_received = (int)number_field(data, "packets_received");
+        result->data.ping.min_rtt = (float)number_field(data, "min_rtt_ms");
+        result->data.ping.avg_rtt = (float)number_field(data, "avg_rtt_ms");
+        result->data.ping.max_rtt = (float)number_field(data, "max_rtt_ms");
+        result->data.ping.packet_loss = (float)number_field(data, "packet_loss");
+    } else if ((data = cJSON_GetObjectItem(root, "throughput")) != NULL) {
+        result->data.throughput.bandwidth = (float)number_field(data, "bandwidth_mbps");
+        result->data.throughput.jitter = (int)number_field(data, "jitter_ms");
+        result->data.throughput.packet_loss = (int)number_field(data, "packet_loss");
+        result->data.throughput.retransmits = (float)number_field(data, "retransmits");
+    } else if ((data = cJSON_GetObjectItem(root, "security")) != NULL) {
+        cJSON *passed = cJSON_GetObjectItem(data, "passed");
+        result->data.security.passed = passed && cJSON_IsTrue(passed);
+        result->data.security.vulnerabilities = (int)number_field(data, "vulnerabilities");
+        result->data.security.vuln_details = test_result_intern(string_field(data, "vuln_details"));
+    }
+
+    return true;
+}
+
+/**
+ * @brief Khôi phục test_result_info_t từ một dòng journal
+ */
+static bool parse_record(const char *line, size_t length, test_result_info_t *result) {
+    cJSON *root = cJSON_ParseWithLength(line, length);
+    if (!root) {
+        return false;
+    }
+
+    bool ok = parse_object(root, result);
+    cJSON_Delete(root);
+    return ok;
+}
+
+/* Dùng cho qsort: bảng kết quả đang được sắp xếp */
+static const test_result_info_t *sort_results;
+
+static int compare_order(const void *a, const void *b) {
+    int ia = *(const int *)a;
+    int ib = *(const int *)b;
+    int cmp = strcmp(sort_results[ia].test_id, sort_results[ib].test_id);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return ia < ib ? -1 : (ia > ib);
+}
+
+/**
+ * @brief Sắp xếp chỉ mục theo test_id để tìm kiếm nhị phân
+ */
+static void sort_records(result_journal_records_t *records) {
+    sort_results = records->results;
+    qsort(records->order, records->count, sizeof(int), compare_order);
+    sort_results = NULL;
+}
+
+int result_journal_load(const char *path, result_journal_records_t *records) {
+    if (!path || !records) {
+        LOG_ERROR("Invalid parameters for result_journal_load");
+        return -1;
+    }
+
+    memset(records, 0, sizeof(*records));
+    if (!file_exists(path)) {
+        return 0;
+    }
+
+    // Journal của các lần chạy dài được map và đọc tại chỗ, không sao chép
+    file_view_t view;
+    if (file_view_open(path, &view) != 0) {
+        LOG_ERROR("Failed to read journal %s", path);
+        return -1;
+    }
+    const char *content = view.data;
+    size_t size = view.size;
+
+    int lines = 0;
+    for (const char *p = content; (p = memchr(p, '\n', content + size - p)) != NULL; p++) {
+        lines++;
+    }
+
+    // Dòng cuối có thể thiếu '\n' nếu bị cắt dở
+    records->results = (test_result_info_t *)malloc((lines + 1) * sizeof(test_result_info_t));
+    records->order = (int *)malloc((lines + 1) * sizeof(int));
+    if (!records->results || !records->order) {
+        LOG_ERROR("Memory allocation failed for journal records");
+        file_view_release(&view);
+        result_journal_records_free(records);
+        return -1;
+    }
+
+    int skipped = 0;
+    const char *line = content;
+    const char *end = content + size;
+    while (line < end) {
+        const char *newline = memchr(line, '\n', end - line);
+        size_t length = (size_t)((newline ? newline : end) - line);
+        if (length > 0) {
+            if (parse_record(line, length, &records->results[records->count])) {
+                records->order[records->count] = records->count;
+                records->count++;
+            } else {
+                skipped++;
+            }
+        }
+        if (!newline) {
+            break;
+        }
+        line = newline + 1;
+    }
+    file_view_release(&view);
+
+    if (skipped > 0) {
+        LOG_WARN("Skipped %d malformed records in journal %s", skipped, path);
+    }
+
+    sort_records(records);
+
+    LOG_DEBUG("Loaded %d records from journal %s", records->count, path);
+    return 0;
+}
+
+/**
+ * @brief Đọc và giải nén toàn bộ file gzip (gzread đọc được cả file thường)
+ */
+static char *read_maybe_gzip(const char *path) {
+    gzFile in = gzopen(path, "rb");
+    if (!in) {
+        LOG_ERROR("Failed to open %s: %s", path, strerror(errno));
+        return NULL;
+    }
+
+    size_t capacity = 65536;
+    size_t used = 0;
+    char *data = (char *)malloc(capacity + 1);
+    int n = 0;
+    while (data && (n = gzread(in, data + used, (unsigned)(capacity - used))) > 0) {
+        used += (size_t)n;
+        if (used == capacity) {
+            capacity *= 2;
+            char *grown = (char *)realloc(data, capacity + 1);
+            if (!grown) {
+                free(data);
+            }
+            data = grown;
+        }
+    }
+    if (!data || n < 0) {
+        LOG_ERROR("Failed to read %s", path);
+        free(data);
+        gzclose(in);
+        return NULL;
+    }
+    gzclose(in);
+    data[used] = '\0';
+    return data;
+}
+
+int result_journal_load_report(const char *path, result_journal_records_t *records) {
+    if (!path || !records) {
+        LOG_ERROR("Invalid parameters for result_journal_load_report");
+        return -1;
+    }
+
+    memset(records, 0, sizeof(*records));
+    file_view_t view;
+    if (file_view_open(path, &view) != 0) {
+        return -1;
+    }
+
+    // Báo cáo JSON thường được parse thẳng từ vùng map, báo cáo .gz phải giải nén trước
+    cJSON *root = NULL;
+    if (view.size >= 2 && (unsigned char)view.data[0] == 0x1f && (unsigned char)view.data[1] == 0x8b) {
+        file_view_release(&view);
+        char *content = read_maybe_gzip(path);
+        if (!content) {
+            return -1;
+        }
+        root = cJSON_Parse(content);
+        free(content);
+    } else {
+        root = cJSON_ParseWithLength(view.data, view.size);
+        file_view_release(&view);
+    }
+    cJSON *list = root ? cJSON_GetObjectItem(root, "test_results") : NULL;
+    if (!list || !cJSON_IsArray(list)) {
+        LOG_ERROR("%s is not a summary report", path);
+        cJSON_Delete(root);
+        return -1;
+    }
+
+    int total = cJSON_GetArraySize(list);
+    records->results = (test_result_info_t *)malloc((total + 1) * sizeof(test_result_info_t));
+    records->order = (int *)malloc((total + 1) * sizeof(int));
+    if (!records->results || !records->order) {
+        LOG_ERROR("Memory allocation failed for report records");
+        cJSON_Delete(root);
+        result_journal_records_free(records);
+        return -1;
+    }
+
+    int skipped = 0;
+    cJSON *item;
+    cJSON_ArrayForEach(item, list) {
+        if (parse_object(item, &records->results[records->count])) {
+            records->order[records->count] = records->count;
+            records->count++;
+        } else {
+            skipped++;
+        }
+    }
+    cJSON_Delete(root);
+
+    if (skipped > 0) {
+        LOG_WARN("Skipped %d malformed results in report %s", skipped, path);
+    }
+    sort_records(records);
+
+    LOG_DEBUG("Loaded %d results from report %s", records->count, path);
+    return 0;
+}
+
+const test_result_info_t *result_journal_find(const result_journal_records_t *records, const char *test_id) {
+    if (!records || !test_id || records->count == 0) {
+        return NULL;
+    }
+
+    // Tìm vị trí đầu tiên có test_id lớn hơn, bản ghi cuối cùng của ID nằm ngay trước đó
+    int lo = 0;
+    int hi = records->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (strcmp(records->results[records->order[mid]].test_id, test_id) <= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (lo == 0) {
+        return NULL;
+    }
+    const test_result_info_t *found = &records->results[records->order[lo - 1]];
+    return strcmp(found->test_id, test_id) == 0 ? found : NULL;
+}
+
+void result_journal_records_free(result_journal_records_t *records) {
+    if (!records) {
+        return;
+    }
+
+    free(records->results);
+    free(records->order);
+    memset(records, 0, sizeof(*records));
+}
@@ -0,0 +1,568 @@
+
+#define _POSIX_C_SOURCE 200809L
+#define LOG_MODULE LOG_MOD_FILE
+
+#include "result_store.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Bit đánh dấu kết quả sweep trong cột kind (7 bit thấp là test_type_t) */
+#define KIND_SWEEP 0x80
+
+static size_t pad8(size_t n) {
+    return (n + 7) & ~(size_t)7;
+}
+
+/**
+ * @brief Vị trí các phần của một segment
+ */
+typedef struct {
+    const result_store_segment_t *header;
+    const uint32_t *dict_offsets;
+    const char *dict_strings;
+    const int64_t *timestamp;
+    const uint32_t *test_index;
+    const float *execution_time;
+    const float *min_rtt;
+    const float *avg_rtt;
+    const float *max_rtt;
+    const float *packet_loss;
+    const float *bandwidth;
+    const uint8_t *status;
+    const uint8_t *kind;
+} segment_view_t;
+
+/**
+ * @brief Kích thước segment với số dòng và từ điển cho trước
+ */
+static size_t segment_layout(const uint8_t *base, uint32_t rows, uint32_t dict_count, uint32_t dict_bytes,
+                             segment_view_t *view) {
+    size_t off = sizeof(result_store_segment_t);
+
+#define PLACE(field, type, count) \
+    do { \
+        if (view) view->field = (const type *)(base + off); \
+        off += pad8((size_t)(count) * sizeof(type)); \
+    } while (0)
+
+    PLACE(dict_offsets, uint32_t, dict_count);
+    PLACE(dict_strings, char, dict_bytes);
+    PLACE(timestamp, int64_t, rows);
+    PLACE(test_index, uint32_t, rows);
+    PLACE(execution_time, float, rows);
+    PLACE(min_rtt, float, rows);
+    PLACE(avg_rtt, float, rows);
+    PLACE(max_rtt, float, rows);
+    PLACE(packet_loss, float, rows);
+    PLACE(bandwidth, float, rows);
+    PLACE(status, uint8_t, rows);
+    PLACE(kind, uint8_t, rows);
+
+#undef PLACE
+
+    if (view) {
+        view->header = (const result_store_segment_t *)base;
+    }
+    return off;
+}
+
+/* Dùng cho qsort khi dựng từ điển */
+static const test_result_info_t *sort_results;
+
+static int compare_by_id(const void *a, const void *b) {
+    return strcmp(sort_results[*(const int *)a].test_id, sort_results[*(const int *)b].test_id);
+}
+
+static int64_t result_timestamp(const test_result_info_t *result) {
+    return result->started_at ? result->started_at : result->finished_at;
+}
+
+/**
+ * @brief Tìm điểm kết thúc của phần dữ liệu hợp lệ và cắt bỏ segment ghi dở phía sau
+ *
+ * @return off_t Vị trí ghi segment kế tiếp, 0 nếu file rỗng (cần ghi header), -1 nếu lỗi
+ */
+static off_t valid_end(int fd, const char *path) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return -1;
+    }
+    if (st.st_size == 0) {
+        return 0;
+    }
+
+    result_store_header_t file_header;
+    if (st.st_size < (off_t)sizeof(file_header) ||
+        pread(fd, &file_header, sizeof(file_header), 0) != (ssize_t)sizeof(file_header) ||
+        file_header.magic != RESULT_STORE_MAGIC || file_header.version != RESULT_STORE_VERSION) {
+        LOG_ERROR("%s is not a result store, refusing to append", path);
+        return -1;
+    }
+
+    off_t off = sizeof(result_store_header_t);
+    result_store_segment_t header;
+    while (off + (off_t)sizeof(header) <= st.st_size &&
+           pread(fd, &header, sizeof(header), off) == (ssize_t)sizeof(header) &&
+           header.magic == RESULT_STORE_SEGMENT_MAGIC &&
+           header.segment_size <= (uint64_t)(st.st_size - off) &&
+           segment_layout(NULL, header.row_count, header.dict_count, header.dict_bytes, NULL) == header.segment_size) {
+        off += header.segment_size;
+    }
+
+    if (off != st.st_size) {
+        LOG_WARN("Dropping %lld bytes of incomplete data from result store %s",
+                 (long long)(st.st_size - off), path);
+        if (ftruncate(fd, off) != 0) {
+            return -1;
+        }
+    }
+    return off;
+}
+
+int result_store_append(const char *path, const test_result_info_t *results, int count) {
+    if (!path || !results || count <= 0) {
+        LOG_ERROR("Invalid parameters for result_store_append");
+        return -1;
+    }
+
+    // Từ điển: các test ID khác nhau đã sắp xếp, mỗi dòng trỏ vào vị trí trong từ điển
+    int *order = (int *)malloc(count * sizeof(int));
+    uint32_t *row_index = (uint32_t *)malloc(count * sizeof(uint32_t));
+    uint32_t *dict_offsets = (uint32_t *)malloc(count * sizeof(uint32_t));
+    if (!order || !row_index || !dict_offsets) {
+        LOG_ERROR("Memory allocation failed for result store segment");
+        free(order);
+        free(row_index);
+        free(dict_offsets);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    sort_results = results;
+    qsort(order, count, sizeof(int), compare_by_id);
+    sort_results = NULL;
+
+    uint32_t dict_count = 0;
+    uint32_t dict_bytes = 0;
+    for (int k = 0; k < count; k++) {
+        const char *id = results[order[k]].test_id;
+        if (k == 0 || strcmp(id, results[order[k - 1]].test_id) != 0) {
+            dict_offsets[dict_count++] = dict_bytes;
+            dict_bytes += (uint32_t)strnlen(id, sizeof(results[0].test_id)) + 1;
+        }
+        row_index[order[k]] = dict_count - 1;
+    }
+
+    size_t size = segment_layout(NULL, (uint32_t)count, dict_count, dict_bytes, NULL);
+    uint8_t *segment = (uint8_t *)calloc(1, size);
+    if (!segment) {
+        LOG_ERROR("Memory allocation failed for result store segment");
+        free(order);
+        free(row_index);
+        free(dict_offsets);
+        return -1;
+    }
+
+    segment_view_t view;
+    segment_layout(segment, (uint32_t)count, dict_count, dict_bytes, &view);
+    result_store_segment_t *header = (result_store_segment_t *)segment;
+    header->magic = RESULT_STORE_SEGMENT_MAGIC;
+    header->row_count = (uint32_t)count;
+    header->dict_count = dict_count;
+    header->dict_bytes = dict_bytes;
+    header->segment_size = size;
+    header->min_timestamp = INT64_MAX;
+    header->max_timestamp = INT64_MIN;
+
+    memcpy((void *)view.dict_offsets, dict_offsets, dict_count * sizeof(uint32_t));
+    for (int k = 0; k < count; k++) {
+        const test_result_info_t *r = &results[order[k]];
+        if (k == 0 || strcmp(r->test_id, results[order[k - 1]].test_id) != 0) {
+            char *dst = (char *)view.dict_strings + dict_offsets[row_index[order[k]]];
+            size_t len = strnlen(r->test_id, sizeof(r->test_id));
+            memcpy(dst, r->test_id, len);
+            dst[len] = '\0';
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        const test_result_info_t *r = &results[i];
+        // Timeout/lỗi không có số đo: NaN để không tính là 0% mất gói
+        bool ping = test_result_has_ping_stats(r);
+        bool rtt = ping && r->data.ping.packets_received > 0;
+        int64_t ts = result_timestamp(r);
+
+        ((int64_t *)view.timestamp)[i] = ts;
+        ((uint32_t *)view.test_index)[i] = row_index[i];
+        ((float *)view.execution_time)[i] = r->execution_time;
+        ((float *)view.min_rtt)[i] = rtt ? r->data.ping.min_rtt : NAN;
+        ((float *)view.avg_rtt)[i] = rtt ? r->data.ping.avg_rtt : NAN;
+        ((float *)view.max_rtt)[i] = rtt ? r->data.ping.max_rtt : NAN;
+        ((float *)view.packet_loss)[i] = ping ? r->data.ping.packet_loss : NAN;
+        ((float *)view.bandwidth)[i] = r->test_type == TEST_THROUGHPUT ? r->data.throughput.bandwidth : NAN;
+        ((uint8_t *)view.status)[i] = (uint8_t)r->status;
+        ((uint8_t *)view.kind)[i] = (uint8_t)(r->test_type | (r->is_sweep ? KIND_SWEEP : 0));
+
+        if (ts < header->min_timestamp) header->min_timestamp = ts;
+        if (ts > header->max_timestamp) header->max_timestamp = ts;
+    }
+    free(order);
+    free(row_index);
+    free(dict_offsets);
+
+    int ret = -1;
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        LOG_ERROR("Failed to open result store %s: %s", path, strerror(errno));
+        free(segment);
+        return -1;
+    }
+
+    off_t end = valid_end(fd, path);
+    if (end == 0) {
+        result_store_header_t file_header = { RESULT_STORE_MAGIC, RESULT_STORE_VERSION, 0 };
+        if (ftruncate(fd, 0) == 0 &&
+            write(fd, &file_header, sizeof(file_header)) == (ssize_t)sizeof(file_header)) {
+            end = sizeof(file_header);
+        } else {
+            end = -1;
+        }
+    }
+    if (end > 0 && write(fd, segment, size) == (ssize_t)size && fdatasync(fd) == 0) {
+        ret = 0;
+    }
+    if (ret != 0) {
+        LOG_ERROR("Failed to append to result store %s: %s", path, strerror(errno));
+    } else {
+        LOG_DEBUG("Appended %d results (%u test ids, %zu bytes) to %s",
+                  count, dict_count, size, path);
+    }
+
+    close(fd);
+    free(segment);
+    return ret;
+}
+
+int result_store_open(result_store_t *store, const char *path) {
+    if (!store || !path) {
+        return -1;
+    }
+
+    memset(store, 0, sizeof(*store));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        LOG_ERROR("Failed to open result store %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(result_store_header_t)) {
+        LOG_ERROR("Result store %s is empty or unreadable", path);
+        close(fd);
+        return -1;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        LOG_ERROR("Failed to map result store %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    const result_store_header_t *header = (const result_store_header_t *)data;
+    if (header->magic != RESULT_STORE_MAGIC || header->version != RESULT_STORE_VERSION) {
+        LOG_ERROR("%s is not a result store (version %d)", path, RESULT_STORE_VERSION);
+        munmap(data, st.st_size);
+        return -1;
+    }
+
+    store->data = (const uint8_t *)data;
+    store->size = st.st_size;
+    return 0;
+}
+
+void result_store_close(result_store_t *store) {
+    if (!store || !store->data) {
+        return;
+    }
+
+    munmap((void *)store->data, store->size);
+    store->data = NULL;
+    store->size = 0;
+}
+
+/**
+ * @brief Tìm test ID trong từ điển đã sắp xếp của segment
+ */
+static int dict_find(const segment_view_t *view, const char *test_id) {
+    int lo = 0;
+    int hi = (int)view->header->dict_count - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        int cmp = strcmp(view->dict_strings + view->dict_offsets[mid], test_id);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Segment kế tiếp có thể chứa dòng khớp điều kiện lọc
+ *
+ * Segment nằm ngoài khoảng thời gian hoặc không có test ID cần tìm được bỏ
+ * qua chỉ nhờ header và từ điển.
+ *
+ * @param off Vị trí đọc, được đưa tới segment sau segment trả về
+ * @param wanted Lưu chỉ số từ điển của test_id (-1 nếu không lọc theo ID)
+ * @return bool false khi hết dữ liệu hợp lệ
+ */
+static bool next_segment(const result_store_t *store, size_t *off, int64_t from, int64_t to,
+                         const char *test_id, segment_view_t *view, int *wanted) {
+    while (*off + sizeof(result_store_segment_t) <= store->size) {
+        const result_store_segment_t *header = (const result_store_segment_t *)(store->data + *off);
+        if (header->magic != RESULT_STORE_SEGMENT_MAGIC || header->segment_size > store->size - *off ||
+            segment_layout(NULL, header->row_count, header->dict_count, header->dict_bytes, NULL) != header->segment_size) {
+            // Segment cuối ghi dở hoặc dữ liệu hỏng: dừng ở đây
+            LOG_WARN("Ignoring incomplete result store data at offset %zu", *off);
+            return false;
+        }
+        *off += header->segment_size;
+
+        // Bỏ qua cả segment chỉ nhờ min/max timestamp
+        if (header->row_count == 0 || header->max_timestamp < from || header->min_timestamp > to) {
+            continue;
+        }
+
+        segment_layout((const uint8_t *)header, header->row_count, header->dict_count, header->dict_bytes, view);
+        *wanted = -1;
+        if (test_id) {
+            *wanted = dict_find(view, test_id);
+            if (*wanted < 0) {
+                continue;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Tìm hoặc tạo nhóm của một test ID (bảng băm địa chỉ mở trên chỉ số nhóm)
+ */
+typedef struct {
+    result_store_group_t *groups;
+    int count;
+    int capacity;
+    int *slots;
+    int slot_count;
+} group_table_t;
+
+static uint32_t hash_id(const char *id) {
+    uint32_t hash = 2166136261u;
+    for (const char *p = id; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int group_for(group_table_t *table, const char *id) {
+    if ((table->count + 1) * 2 > table->slot_count) {
+        int new_slot_count = table->slot_count ? table->slot_count * 2 : 64;
+        int *new_slots = (int *)malloc(new_slot_count * sizeof(int));
+        if (!new_slots) {
+            return -1;
+        }
+        memset(new_slots, -1, new_slot_count * sizeof(int));
+        for (int g = 0; g < table->count; g++) {
+            uint32_t pos = hash_id(table->groups[g].test_id) & (new_slot_count - 1);
+            while (new_slots[pos] >= 0) {
+                pos = (pos + 1) & (new_slot_count - 1);
+            }
+            new_slots[pos] = g;
+        }
+        free(table->slots);
+        table->slots = new_slots;
+        table->slot_count = new_slot_count;
+    }
+
+    uint32_t mask = table->slot_count - 1;
+    uint32_t pos = hash_id(id) & mask;
+    while (table->slots[pos] >= 0) {
+        if (strcmp(table->groups[table->slots[pos]].test_id, id) == 0) {
+            return table->slots[pos];
+        }
+        pos = (pos + 1) & mask;
+    }
+
+    if (table->count == table->capacity) {
+        int new_capacity = table->capacity ? table->capacity * 2 : 32;
+        result_store_group_t *grown = (result_store_group_t *)realloc(table->groups, new_capacity * sizeof(result_store_group_t));
+        if (!grown) {
+            return -1;
+        }
+        table->groups = grown;
+        table->capacity = new_capacity;
+    }
+
+    result_store_group_t *group = &table->groups[table->count];
+    memset(group, 0, sizeof(*group));
+    snprintf(group->test_id, sizeof(group->test_id), "%s", id);
+    group->rtt_min = INFINITY;
+    group->rtt_max = -INFINITY;
+    table->slots[pos] = table->count;
+    return table->count++;
+}
+
+long result_store_query(const result_store_t *store, const result_store_filter_t *filter,
+                        result_store_group_t **groups, int *group_count) {
+    if (!store || !store->data || !groups || !group_count) {
+        LOG_ERROR("Invalid parameters for result_store_query");
+        return -1;
+    }
+
+    result_store_filter_t all = { NULL, 0, 0 };
+    if (!filter) {
+        filter = &all;
+    }
+    int64_t from = filter->from_ms;
+    int64_t to = filter->to_ms ? filter->to_ms : INT64_MAX;
+
+    group_table_t table;
+    memset(&table, 0, sizeof(table));
+    int *dict_map = NULL;
+    size_t dict_map_size = 0;
+    long matched = 0;
+    bool failed = false;
+
+    size_t off = sizeof(result_store_header_t);
+    segment_view_t view;
+    int wanted;
+    while (!failed && next_segment(store, &off, from, to, filter->test_id, &view, &wanted)) {
+        const result_store_segment_t *header = view.header;
+
+        // Ánh xạ chỉ số từ điển của segment sang nhóm, chỉ tạo khi gặp dòng khớp
+        if (header->dict_count > dict_map_size) {
+            int *grown = (int *)realloc(dict_map, header->dict_count * sizeof(int));
+            if (!grown) {
+                failed = true;
+                break;
+            }
+            dict_map = grown;
+            dict_map_size = header->dict_count;
+        }
+        memset(dict_map, -1, header->dict_count * sizeof(int));
+
+        for (uint32_t i = 0; i < header->row_count; i++) {
+            int64_t ts = view.timestamp[i];
+            uint32_t idx = view.test_index[i];
+            if (ts < from || ts > to || idx >= header->dict_count || (wanted >= 0 && idx != (uint32_t)wanted)) {
+                continue;
+            }
+
+            if (dict_map[idx] < 0) {
+                dict_map[idx] = group_for(&table, view.dict_strings + view.dict_offsets[idx]);
+                if (dict_map[idx] < 0) {
+                    failed = true;
+                    break;
+                }
+            }
+            result_store_group_t *group = &table.groups[dict_map[idx]];
+
+            if (group->runs == 0 || ts < group->first_ms) group->first_ms = ts;
+            if (group->runs == 0 || ts > group->last_ms) group->last_ms = ts;
+            group->runs++;
+            group->success += view.status[i] == TEST_RESULT_SUCCESS;
+            group->time_sum += view.execution_time[i];
+            if (!isnan(view.avg_rtt[i])) {
+                group->rtt_count++;
+                group->rtt_sum += view.avg_rtt[i];
+                if (view.min_rtt[i] < group->rtt_min) group->rtt_min = view.min_rtt[i];
+                if (view.max_rtt[i] > group->rtt_max) group->rtt_max = view.max_rtt[i];
+            }
+            if (!isnan(view.packet_loss[i])) {
+                group->loss_count++;
+                group->loss_sum += view.packet_loss[i];
+            }
+            if (!isnan(view.bandwidth[i])) {
+                group->bandwidth_count++;
+                group->bandwidth_sum += view.bandwidth[i];
+            }
+            matched++;
+        }
+    }
+
+    free(dict_map);
+    free(table.slots);
+    if (failed) {
+        LOG_ERROR("Memory allocation failed while querying result store");
+        free(table.groups);
+        return -1;
+    }
+
+    *groups = table.groups;
+    *group_count = table.count;
+    return matched;
+}
+
+long result_store_scan(const result_store_t *store, const result_store_filter_t *filter,
+                       result_store_row_cb callback, void *context) {
+    if (!store || !store->data || !callback) {
+        LOG_ERROR("Invalid parameters for result_store_scan");
+        return -1;
+    }
+
+    result_store_filter_t all = { NULL, 0, 0 };
+    if (!filter) {
+        filter = &all;
+    }
+    int64_t from = filter->from_ms;
+    int64_t to = filter->to_ms ? filter->to_ms : INT64_MAX;
+
+    long matched = 0;
+    size_t off = sizeof(result_store_header_t);
+    segment_view_t view;
+    int wanted;
+    while (next_segment(store, &off, from, to, filter->test_id, &view, &wanted)) {
+        for (uint32_t i = 0; i < view.header->row_count; i++) {
+            uint32_t idx = view.test_index[i];
+            result_store_row_t row;
+            row.timestamp = view.timestamp[i];
+            if (row.timestamp < from || row.timestamp > to || idx >= view.header->dict_count ||
+                (wanted >= 0 && idx != (uint32_t)wanted)) {
+                continue;
+            }
+
+            row.test_id = view.dict_strings + view.dict_offsets[idx];
+            row.status = (test_result_status_t)view.status[i];
+            row.test_type = (test_type_t)(view.kind[i] & ~KIND_SWEEP);
+            row.is_sweep = (view.kind[i] & KIND_SWEEP) != 0;
+            row.execution_time = view.execution_time[i];
+            row.min_rtt = view.min_rtt[i];
+            row.avg_rtt = view.avg_rtt[i];
+            row.max_rtt = view.max_rtt[i];
+            row.packet_loss = view.packet_loss[i];
+            row.bandwidth = view.bandwidth[i];
+            matched++;
+            if (callback(&row, context) != 0) {
+                return -1;
+            }
+        }
+    }
+    return matched;
+}
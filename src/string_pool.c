@@ -0,0 +1,168 @@
+
+#include "string_pool.h"
+#include "log.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define STRING_POOL_DEFAULT_CAPACITY 4096
+#define STRING_POOL_INITIAL_SLOTS 64
+
+static uint32_t hash_bytes(const char *str, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+int string_pool_init(string_pool_t *pool, size_t initial_capacity) {
+    if (!pool) {
+        return -1;
+    }
+
+    memset(pool, 0, sizeof(*pool));
+    pool->capacity = initial_capacity > 0 ? initial_capacity : STRING_POOL_DEFAULT_CAPACITY;
+    pool->data = (char *)malloc(pool->capacity);
+    pool->slot_count = STRING_POOL_INITIAL_SLOTS;
+    pool->slots = (uint32_t *)calloc(pool->slot_count, sizeof(uint32_t));
+
+    if (!pool->data || !pool->slots) {
+        LOG_ERROR("Memory allocation failed for string pool");
+        string_pool_free(pool);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Nhân đôi bảng intern khi vượt quá 50% tải
+ */
+static int grow_slots(string_pool_t *pool) {
+    size_t new_count = pool->slot_count * 2;
+    uint32_t *new_slots = (uint32_t *)calloc(new_count, sizeof(uint32_t));
+    if (!new_slots) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < pool->slot_count; i++) {
+        str_ref_t ref = pool->slots[i];
+        if (!ref) {
+            continue;
+        }
+        size_t pos = hash_bytes(pool->data + ref, strtab_len(pool->data, ref)) & (new_count - 1);
+        while (new_slots[pos]) {
+            pos = (pos + 1) & (new_count - 1);
+        }
+        new_slots[pos] = ref;
+    }
+
+    free(pool->slots);
+    pool->slots = new_slots;
+    pool->slot_count = new_count;
+    return 0;
+}
+
+str_ref_t string_pool_intern_n(string_pool_t *pool, const char *str, size_t len) {
+    if (!pool || !pool->data || (!str && len > 0) || len > UINT32_MAX - 16) {
+        return 0;
+    }
+
+    uint32_t hash = hash_bytes(str, len);
+    size_t mask = pool->slot_count - 1;
+    size_t pos = hash & mask;
+
+    // Tìm chuỗi đã intern
+    while (pool->slots[pos]) {
+        str_ref_t ref = pool->slots[pos];
+        if (strtab_len(pool->data, ref) == len && memcmp(pool->data + ref, str, len) == 0) {
+            return ref;
+        }
+        pos = (pos + 1) & mask;
+    }
+
+    // Thêm bản ghi mới: [len][bytes][\0], căn lề 4 byte
+    size_t entry = sizeof(uint32_t) + ((len + 1 + 3) & ~(size_t)3);
+    if (pool->size + entry > UINT32_MAX) {
+        LOG_ERROR("String pool exceeds 4 GB");
+        return 0;
+    }
+    if (pool->size + entry > pool->capacity) {
+        size_t new_capacity = pool->capacity * 2;
+        while (new_capacity < pool->size + entry) {
+            new_capacity *= 2;
+        }
+        char *new_data = (char *)realloc(pool->data, new_capacity);
+        if (!new_data) {
+            LOG_ERROR("Memory allocation failed while growing string pool");
+            return 0;
+        }
+        pool->data = new_data;
+        pool->capacity = new_capacity;
+    }
+
+    uint32_t len32 = (uint32_t)len;
+    char *dst = pool->data + pool->size;
+    memcpy(dst, &len32, sizeof(len32));
+    if (len > 0) {
+        memcpy(dst + sizeof(uint32_t), str, len);
+    }
+    memset(dst + sizeof(uint32_t) + len, 0, entry - sizeof(uint32_t) - len);
+
+    str_ref_t ref = (str_ref_t)(pool->size + sizeof(uint32_t));
+    pool->size += entry;
+    pool->slots[pos] = ref;
+    pool->used++;
+
+    if (pool->used * 2 > pool->slot_count && grow_slots(pool) != 0) {
+        LOG_WARN("Failed to grow string pool intern table");
+    }
+    return ref;
+}
+
+str_ref_t string_pool_intern(string_pool_t *pool, const char *str) {
+    return string_pool_intern_n(pool, str ? str : "", str ? strlen(str) : 0);
+}
+
+void string_pool_reset(string_pool_t *pool) {
+    if (!pool || !pool->slots) {
+        return;
+    }
+
+    pool->size = 0;
+    pool->used = 0;
+    memset(pool->slots, 0, pool->slot_count * sizeof(uint32_t));
+}
+
+char *string_pool_release(string_pool_t *pool, size_t *size) {
+    if (!pool) {
+        return NULL;
+    }
+
+    char *data = pool->data;
+    if (size) {
+        *size = pool->size;
+    }
+
+    // Thu gọn bảng chuỗi về đúng kích thước đã dùng
+    if (data && pool->size > 0 && pool->size < pool->capacity) {
+        char *shrunk = (char *)realloc(data, pool->size);
+        if (shrunk) {
+            data = shrunk;
+        }
+    }
+
+    pool->data = NULL;
+    string_pool_free(pool);
+    return data;
+}
+
+void string_pool_free(string_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+
+    free(pool->data);
+    free(pool->slots);
+    memset(pool, 0, sizeof(*pool));
+}
@@ -0,0 +1,483 @@
+
+#define _POSIX_C_SOURCE 200809L
+#define LOG_MODULE LOG_MOD_PARSER
+
+#include "suite_cache.h"
+#include "file_process.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char suite_cache_magic[4] = { 'T', 'D', 'S', 'C' };
+
+int suite_cache_path(const char *config_file, char *cache_path, size_t path_size) {
+    if (!config_file || !cache_path || path_size == 0) {
+        return -1;
+    }
+
+    int len = snprintf(cache_path, path_size, "%s%s", config_file, SUITE_CACHE_SUFFIX);
+    if (len < 0 || (size_t)len >= path_size) {
+        LOG_ERROR("Cache path too long for config %s", config_file);
+        return -1;
+    }
+    return 0;
+}
+
+uint64_t suite_cache_hash(const void *data, size_t size) {
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Lấy tất cả offset chuỗi của một test case
+ *
+ * @return size_t Số offset ghi vào refs
+ */
+static size_t collect_refs(const test_case_t *tc, str_ref_t refs[6]) {
+    size_t n = 0;
+    refs[n++] = tc->id;
+    refs[n++] = tc->target;
+    refs[n++] = tc->name;
+    refs[n++] = tc->description;
+    refs[n++] = tc->extra_data;
+    if (tc->type == TEST_SECURITY) {
+        refs[n++] = tc->params.security.method;
+    }
+    return n;
+}
+
+/**
+ * @brief Kiểm tra header cache có khớp với bố cục hiện tại và kích thước file không
+ */
+static bool validate_header(const suite_cache_header_t *header, size_t file_size) {
+    if (memcmp(header->magic, suite_cache_magic, sizeof(suite_cache_magic)) != 0) {
+        LOG_WARN("Suite cache has invalid magic");
+        return false;
+    }
+    if (header->version != SUITE_CACHE_VERSION || header->record_size != sizeof(test_case_t)) {
+        LOG_DEBUG("Suite cache version/layout mismatch (version %u, record %u)",
+                  header->version, header->record_size);
+        return false;
+    }
+
+    if (header->matrix_count > 0 && header->matrix_record_size != sizeof(test_matrix_t)) {
+        LOG_DEBUG("Suite cache matrix layout mismatch (record %u)", header->matrix_record_size);
+        return false;
+    }
+
+    uint64_t expected = sizeof(suite_cache_header_t) +
+                        (uint64_t)header->count * sizeof(test_case_t) + header->strtab_size +
+                        (uint64_t)header->matrix_count * sizeof(test_matrix_t) +
+                        header->axis_value_count * sizeof(uint32_t) + header->matrix_strtab_size;
+    bool has_cases = header->count > 0 && header->strtab_size > 0;
+    bool has_matrices = header->matrix_count > 0 && header->matrix_strtab_size > 0;
+    if ((!has_cases && (header->count > 0 || !has_matrices)) || expected != file_size) {
+        LOG_WARN("Suite cache is truncated or corrupted");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Kiểm tra offset chuỗi của test case nằm trong bảng chuỗi
+ */
+static bool refs_in_bounds(const test_case_t *tc, const char *strtab, uint64_t strtab_size) {
+    str_ref_t refs[6];
+    size_t ref_count = collect_refs(tc, refs);
+    for (size_t r = 0; r < ref_count; r++) {
+        if (refs[r] && (refs[r] < sizeof(uint32_t) || refs[r] >= strtab_size ||
+                        strtab_len(strtab, refs[r]) >= strtab_size - refs[r])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Tính kích thước bảng chuỗi theo offset lớn nhất mà test case dùng
+ */
+static size_t strtab_extent(const test_case_t *tc, size_t current) {
+    str_ref_t refs[6];
+    size_t ref_count = collect_refs(tc, refs);
+    for (size_t r = 0; r < ref_count; r++) {
+        size_t end = refs[r] ? (size_t)refs[r] + strtab_len(tc->strtab, refs[r]) + 1 : 0;
+        if (end > current) {
+            current = end;
+        }
+    }
+    return current;
+}
+
+/**
+ * @brief Nạp phần matrix của cache vào tập matrix
+ */
+static bool load_matrices(const suite_cache_header_t *header, const char *section, test_matrix_set_t *set) {
+    memset(set, 0, sizeof(*set));
+    if (header->matrix_count == 0) {
+        return true;
+    }
+
+    const char *values_src = section + header->matrix_count * sizeof(test_matrix_t);
+    const char *strtab_src = values_src + header->axis_value_count * sizeof(uint32_t);
+
+    set->matrices = (test_matrix_t *)malloc(header->matrix_count * sizeof(test_matrix_t));
+    set->axis_values = (uint32_t *)malloc(header->axis_value_count ? header->axis_value_count * sizeof(uint32_t) : 1);
+    set->strtab = (char *)malloc(header->matrix_strtab_size);
+    if (!set->matrices || !set->axis_values || !set->strtab) {
+        LOG_ERROR("Memory allocation failed for cached test matrices");
+        free_test_matrices(set);
+        return false;
+    }
+    memcpy(set->matrices, section, header->matrix_count * sizeof(test_matrix_t));
+    memcpy(set->axis_values, values_src, header->axis_value_count * sizeof(uint32_t));
+    memcpy(set->strtab, strtab_src, header->matrix_strtab_size);
+    set->count = (int)header->matrix_count;
+    set->axis_value_count = header->axis_value_count;
+    set->strtab_size = header->matrix_strtab_size;
+
+    for (int m = 0; m < set->count; m++) {
+        test_matrix_t *matrix = &set->matrices[m];
+        bool valid = refs_in_bounds(&matrix->base, set->strtab, set->strtab_size);
+        for (int axis = 0; valid && axis < TEST_AXIS_COUNT; axis++) {
+            valid = (uint64_t)matrix->axis_offset[axis] + matrix->axis_count[axis] <= set->axis_value_count;
+        }
+        for (uint32_t v = 0; valid && v < matrix->axis_count[TEST_AXIS_TARGET]; v++) {
+            test_case_t probe = matrix->base;
+            probe.target = set->axis_values[matrix->axis_offset[TEST_AXIS_TARGET] + v];
+            valid = probe.target != 0 && refs_in_bounds(&probe, set->strtab, set->strtab_size);
+        }
+        if (!valid) {
+            LOG_WARN("Suite cache matrix section is corrupted");
+            free_test_matrices(set);
+            return false;
+        }
+        matrix->base.strtab = set->strtab;
+    }
+    return true;
+}
+
+/**
+ * @brief Kiểm tra cache có còn ứng với nội dung file config không
+ *
+ * Đường nhanh chỉ so kích thước và mtime. Nếu mtime khác (vd: file bị touch,
+ * checkout lại) thì so hash nội dung để tránh parse lại khi nội dung không đổi.
+ */
+static bool source_matches(const char *config_file, const struct stat *st,
+                           const suite_cache_header_t *header, bool *mtime_stale, int view_flags) {
+    *mtime_stale = false;
+
+    if (header->source_size != (uint64_t)st->st_size) {
+        return false;
+    }
+    if (header->source_mtime_sec == (int64_t)st->st_mtim.tv_sec &&
+        header->source_mtime_nsec == (int64_t)st->st_mtim.tv_nsec) {
+        return true;
+    }
+
+    file_view_t view;
+    if (file_view_open_ex(config_file, &view, view_flags) != 0) {
+        return false;
+    }
+    bool match = suite_cache_hash(view.data, view.size) == header->source_hash;
+    file_view_release(&view);
+
+    *mtime_stale = match;
+    return match;
+}
+
+/**
+ * @brief Cập nhật mtime trong header để lần chạy sau đi đường nhanh
+ */
+static void refresh_header_mtime(const char *cache_path, const struct stat *st) {
+    int fd = open(cache_path, O_WRONLY);
+    if (fd == -1) {
+        return;
+    }
+
+    int64_t mtime[2] = { (int64_t)st->st_mtim.tv_sec, (int64_t)st->st_mtim.tv_nsec };
+    if (pwrite(fd, mtime, sizeof(mtime), offsetof(suite_cache_header_t, source_mtime_sec)) != sizeof(mtime)) {
+        LOG_WARN("Failed to refresh suite cache mtime: %s", strerror(errno));
+    }
+    close(fd);
+}
+
+/**
+ * @brief Nạp cache như suite_cache_load; view_flags dùng khi phải đọc file config để so hash
+ */
+static bool load_cache(const char *config_file, test_case_t **test_cases, int *count,
+                       test_matrix_set_t *matrices, int view_flags) {
+    if (!config_file || !test_cases || !count) {
+        LOG_ERROR("Invalid parameters for suite_cache_load");
+        return false;
+    }
+
+    char cache_path[512];
+    if (suite_cache_path(config_file, cache_path, sizeof(cache_path)) != 0) {
+        return false;
+    }
+
+    struct stat config_st;
+    if (stat(config_file, &config_st) != 0) {
+        LOG_ERROR("Failed to stat config %s: %s", config_file, strerror(errno));
+        return false;
+    }
+
+    int fd = open(cache_path, O_RDONLY);
+    if (fd == -1) {
+        LOG_DEBUG("No suite cache at %s", cache_path);
+        return false;
+    }
+
+    struct stat cache_st;
+    if (fstat(fd, &cache_st) != 0 || (size_t)cache_st.st_size < sizeof(suite_cache_header_t)) {
+        close(fd);
+        return false;
+    }
+
+    size_t map_size = (size_t)cache_st.st_size;
+    void *map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        LOG_WARN("Failed to map suite cache %s: %s", cache_path, strerror(errno));
+        return false;
+    }
+
+    const suite_cache_header_t *header = (const suite_cache_header_t *)map;
+    bool mtime_stale = false;
+    if (!validate_header(header, map_size) ||
+        (header->count == 0 && !matrices) ||
+        !source_matches(config_file, &config_st, header, &mtime_stale, view_flags)) {
+        LOG_DEBUG("Suite cache %s is stale", cache_path);
+        munmap(map, map_size);
+        return false;
+    }
+
+    const test_case_t *records = (const test_case_t *)((const char *)map + sizeof(suite_cache_header_t));
+    const char *strtab_src = (const char *)(records + header->count);
+
+    test_case_t *cases = NULL;
+    char *strtab = NULL;
+    if (header->count > 0) {
+        cases = alloc_test_cases((int)header->count);
+        strtab = (char *)malloc(header->strtab_size);
+        if (!cases || !strtab) {
+            LOG_ERROR("Memory allocation failed for cached test cases");
+            free(cases);
+            free(strtab);
+            munmap(map, map_size);
+            return false;
+        }
+        memcpy(cases, records, header->count * sizeof(test_case_t));
+        memcpy(strtab, strtab_src, header->strtab_size);
+    }
+
+    // Gắn lại bảng chuỗi, đồng thời kiểm tra offset không vượt ra ngoài bảng
+    for (uint32_t i = 0; i < header->count; i++) {
+        if (!refs_in_bounds(&cases[i], strtab, header->strtab_size)) {
+            LOG_WARN("Suite cache string table is corrupted");
+            free(cases);
+            free(strtab);
+            munmap(map, map_size);
+            return false;
+        }
+        cases[i].strtab = strtab;
+    }
+
+    if (matrices && !load_matrices(header, strtab_src + header->strtab_size, matrices)) {
+        free(cases);
+        free(strtab);
+        munmap(map, map_size);
+        return false;
+    }
+
+    *test_cases = cases;
+    *count = (int)header->count;
+    uint32_t matrix_count = header->matrix_count;
+    munmap(map, map_size);
+
+    if (mtime_stale) {
+        refresh_header_mtime(cache_path, &config_st);
+    }
+
+    LOG_DEBUG("Loaded %d test cases and %u matrices from suite cache %s",
+              *count, matrix_count, cache_path);
+    return true;
+}
+
+bool suite_cache_load(const char *config_file, test_case_t **test_cases, int *count,
+                      test_matrix_set_t *matrices) {
+    return load_cache(config_file, test_cases, count, matrices, 0);
+}
+
+int suite_cache_store(const char *config_file, const char *json_content, size_t content_size,
+                      const test_case_t *test_cases, int count, const test_matrix_set_t *matrices) {
+    int matrix_count = matrices ? matrices->count : 0;
+    if (!config_file || !json_content || count < 0 || (count > 0 && !test_cases) ||
+        (count == 0 && matrix_count == 0)) {
+        LOG_ERROR("Invalid parameters for suite_cache_store");
+        return -1;
+    }
+
+    char cache_path[512];
+    char temp_path[560];
+    if (suite_cache_path(config_file, cache_path, sizeof(cache_path)) != 0) {
+        return -1;
+    }
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp.%ld", cache_path, (long)getpid());
+
+    struct stat st;
+    if (stat(config_file, &st) != 0) {
+        LOG_ERROR("Failed to stat config %s: %s", config_file, strerror(errno));
+        return -1;
+    }
+    if ((size_t)st.st_size != content_size) {
+        // File config đã bị sửa sau khi đọc, không ghi cache sai lệch
+        LOG_WARN("Config %s changed while loading, skipping suite cache", config_file);
+        return -1;
+    }
+
+    suite_cache_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, suite_cache_magic, sizeof(suite_cache_magic));
+    header.version = SUITE_CACHE_VERSION;
+    header.record_size = sizeof(test_case_t);
+    header.count = (uint32_t)count;
+    header.source_size = (uint64_t)content_size;
+    header.source_mtime_sec = (int64_t)st.st_mtim.tv_sec;
+    header.source_mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+    header.source_hash = suite_cache_hash(json_content, content_size);
+
+    // Bảng chuỗi không lưu kích thước nên xác định theo offset lớn nhất đang dùng
+    const char *strtab = count > 0 ? test_cases[0].strtab : NULL;
+    size_t strtab_size = 0;
+    for (int i = 0; i < count; i++) {
+        if (test_cases[i].strtab != strtab) {
+            LOG_WARN("Test cases do not share one string table, skipping suite cache");
+            return -1;
+        }
+        strtab_size = strtab_extent(&test_cases[i], strtab_size);
+    }
+    if (count > 0 && (!strtab || strtab_size == 0)) {
+        return -1;
+    }
+    header.strtab_size = strtab_size;
+
+    if (matrix_count > 0) {
+        if (!matrices->strtab || matrices->strtab_size == 0) {
+            return -1;
+        }
+        header.matrix_count = (uint32_t)matrix_count;
+        header.matrix_record_size = sizeof(test_matrix_t);
+        header.axis_value_count = matrices->axis_value_count;
+        header.matrix_strtab_size = matrices->strtab_size;
+    }
+
+    FILE *file = fopen(temp_path, "wb");
+    if (!file) {
+        LOG_WARN("Failed to create suite cache %s: %s", temp_path, strerror(errno));
+        return -1;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    // Con trỏ strtab không có nghĩa trong file, được gắn lại khi nạp
+    for (int i = 0; ok && i < count; i++) {
+        test_case_t record = test_cases[i];
+        record.strtab = NULL;
+        ok = fwrite(&record, sizeof(record), 1, file) == 1;
+    }
+    if (ok && strtab_size > 0) {
+        ok = fwrite(strtab, 1, strtab_size, file) == strtab_size;
+    }
+    for (int m = 0; ok && m < matrix_count; m++) {
+        test_matrix_t record = matrices->matrices[m];
+        record.base.strtab = NULL;
+        ok = fwrite(&record, sizeof(record), 1, file) == 1;
+    }
+    if (ok && matrix_count > 0) {
+        ok = (matrices->axis_value_count == 0 ||
+              fwrite(matrices->axis_values, sizeof(uint32_t), matrices->axis_value_count, file) ==
+                  matrices->axis_value_count) &&
+             fwrite(matrices->strtab, 1, matrices->strtab_size, file) == matrices->strtab_size;
+    }
+
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok || rename(temp_path, cache_path) != 0) {
+        LOG_WARN("Failed to write suite cache %s: %s", cache_path, strerror(errno));
+        unlink(temp_path);
+        return -1;
+    }
+
+    LOG_DEBUG("Stored %d test cases and %d matrices in suite cache %s",
+              count, matrix_count, cache_path);
+    return 0;
+}
+
+int suite_cache_invalidate(const char *config_file) {
+    char cache_path[512];
+    if (suite_cache_path(config_file, cache_path, sizeof(cache_path)) != 0) {
+        return -1;
+    }
+
+    if (unlink(cache_path) != 0 && errno != ENOENT) {
+        LOG_ERROR("Failed to remove suite cache %s: %s", cache_path, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+bool read_test_cases_cached(const char *config_file, test_case_t **test_cases, int *count,
+                            test_matrix_set_t *matrices) {
+    return read_test_cases_cached_ex(config_file, test_cases, count, matrices, 0);
+}
+
+bool read_test_cases_cached_ex(const char *config_file, test_case_t **test_cases, int *count,
+                               test_matrix_set_t *matrices, int view_flags) {
+    if (!config_file || !test_cases || !count) {
+        LOG_ERROR("Invalid parameters for read_test_cases_cached");
+        return false;
+    }
+
+    if (load_cache(config_file, test_cases, count, matrices, view_flags)) {
+        return true;
+    }
+
+    // Cache không dùng được: parse JSON rồi ghi lại cache cho lần chạy sau
+    file_view_t view;
+    if (file_view_open_ex(config_file, &view, view_flags) != 0) {
+        LOG_ERROR("Failed to read JSON file: %s", config_file);
+        return false;
+    }
+
+    // Luôn parse cả matrix để cache đầy đủ, bất kể người gọi có dùng matrix hay không
+    test_matrix_set_t local_matrices;
+    test_matrix_set_t *parsed = matrices ? matrices : &local_matrices;
+    bool result = parse_json_suite_length(view.data, view.size, test_cases, count, parsed);
+    if (result) {
+        suite_cache_store(config_file, view.data, view.size, *test_cases, *count, parsed);
+        if (!matrices) {
+            free_test_matrices(&local_matrices);
+            if (*count == 0) {
+                LOG_ERROR("No test cases found in %s", config_file);
+                result = false;
+            }
+        }
+    }
+
+    file_view_release(&view);
+    return result;
+}
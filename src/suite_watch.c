@@ -0,0 +1,203 @@
+
+#define _POSIX_C_SOURCE 200809L
+#define LOG_MODULE LOG_MOD_PARSER
+
+#include "suite_watch.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+/**
+ * @brief Thời gian chờ để gộp các sự kiện của một lần lưu file (ms)
+ */
+#define SUITE_WATCH_SETTLE_MS 100
+
+int suite_watch_init(suite_watch_t *watch, const char *config_file) {
+    if (!watch || !config_file) {
+        LOG_ERROR("Invalid parameters for suite_watch_init");
+        return -1;
+    }
+
+    memset(watch, 0, sizeof(*watch));
+    watch->fd = -1;
+    watch->wd = -1;
+
+    char dir[512];
+    const char *slash = strrchr(config_file, '/');
+    const char *name = slash ? slash + 1 : config_file;
+    if (slash) {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - config_file), config_file);
+        if (dir[0] == '\0') {
+            strcpy(dir, "/");
+        }
+    } else {
+        strcpy(dir, ".");
+    }
+    if (strlen(name) >= sizeof(watch->name)) {
+        LOG_ERROR("Config file name too long to watch: %s", config_file);
+        return -1;
+    }
+    strcpy(watch->name, name);
+
+    watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch->fd == -1) {
+        LOG_ERROR("Failed to initialize inotify: %s", strerror(errno));
+        return -1;
+    }
+
+    watch->wd = inotify_add_watch(watch->fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (watch->wd == -1) {
+        LOG_ERROR("Failed to watch %s: %s", dir, strerror(errno));
+        suite_watch_close(watch);
+        return -1;
+    }
+
+    LOG_DEBUG("Watching %s for changes to %s", dir, watch->name);
+    return 0;
+}
+
+/**
+ * @brief Đọc hết các sự kiện đang chờ
+ *
+ * @return int 1 nếu có sự kiện liên quan đến file config, 0 nếu không, -1 nếu lỗi
+ */
+static int drain_events(suite_watch_t *watch) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int relevant = 0;
+
+    for (;;) {
+        ssize_t len = read(watch->fd, buffer, sizeof(buffer));
+        if (len == -1) {
+            if (errno == EAGAIN) {
+                return relevant;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Failed to read inotify events: %s", strerror(errno));
+            return -1;
+        }
+
+        for (char *ptr = buffer; ptr < buffer + len;) {
+            const struct inotify_event *event = (const struct inotify_event *)ptr;
+            if (event->len > 0 && strcmp(event->name, watch->name) == 0) {
+                relevant = 1;
+            }
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+int suite_watch_wait(suite_watch_t *watch, int timeout_ms) {
+    if (!watch || watch->fd == -1) {
+        return -1;
+    }
+
+    struct pollfd pfd = { .fd = watch->fd, .events = POLLIN, .revents = 0 };
+    int ready = poll(&pfd, 1, timeout_ms);
+    if (ready <= 0) {
+        if (ready == -1 && errno != EINTR) {
+            LOG_ERROR("Failed to poll inotify: %s", strerror(errno));
+            return -1;
+        }
+        return 0;
+    }
+
+    int changed = drain_events(watch);
+    if (changed != 1) {
+        return changed;
+    }
+
+    // Một lần lưu có thể sinh nhiều sự kiện (truncate, ghi, rename), chờ cho yên rồi mới báo
+    while (poll(&pfd, 1, SUITE_WATCH_SETTLE_MS) > 0) {
+        if (drain_events(watch) == -1) {
+            return -1;
+        }
+    }
+
+    LOG_DEBUG("Config file %s changed", watch->name);
+    return 1;
+}
+
+void suite_watch_close(suite_watch_t *watch) {
+    if (!watch) {
+        return;
+    }
+
+    if (watch->fd != -1) {
+        close(watch->fd);
+    }
+    watch->fd = -1;
+    watch->wd = -1;
+}
+
+int suite_diff_compute(const test_case_t *old_cases, int old_count,
+                       const test_case_t *new_cases, int new_count, suite_diff_t *diff) {
+    if (!diff || old_count < 0 || new_count < 0 || (old_count > 0 && !old_cases) ||
+        (new_count > 0 && !new_cases)) {
+        LOG_ERROR("Invalid parameters for suite_diff_compute");
+        return -1;
+    }
+
+    memset(diff, 0, sizeof(*diff));
+    diff->added = (int *)malloc((new_count + 1) * sizeof(int));
+    diff->changed = (int *)malloc((new_count + 1) * sizeof(int));
+    diff->removed = (int *)malloc((old_count + 1) * sizeof(int));
+    diff->old_to_new = (int *)malloc((old_count + 1) * sizeof(int));
+    bool *matched = (bool *)calloc(new_count + 1, sizeof(bool));
+
+    test_case_index_t index;
+    if (!diff->added || !diff->changed || !diff->removed || !diff->old_to_new || !matched ||
+        test_case_index_build(&index, new_cases, new_count) < 0) {
+        LOG_ERROR("Memory allocation failed for suite diff");
+        free(matched);
+        suite_diff_free(diff);
+        return -1;
+    }
+
+    for (int i = 0; i < old_count; i++) {
+        int j = test_case_index_find(&index, test_case_id(&old_cases[i]));
+        diff->old_to_new[i] = j;
+        if (j < 0) {
+            diff->removed[diff->removed_count++] = i;
+            continue;
+        }
+
+        matched[j] = true;
+        if (test_case_hash(&old_cases[i]) != test_case_hash(&new_cases[j])) {
+            diff->changed[diff->changed_count++] = j;
+        } else {
+            diff->unchanged_count++;
+        }
+    }
+
+    for (int j = 0; j < new_count; j++) {
+        if (!matched[j]) {
+            diff->added[diff->added_count++] = j;
+        }
+    }
+
+    free(matched);
+    test_case_index_free(&index);
+
+    LOG_DEBUG("Suite diff: %d added, %d changed, %d removed, %d unchanged",
+              diff->added_count, diff->changed_count, diff->removed_count, diff->unchanged_count);
+    return 0;
+}
+
+void suite_diff_free(suite_diff_t *diff) {
+    if (!diff) {
+        return;
+    }
+
+    free(diff->added);
+    free(diff->changed);
+    free(diff->removed);
+    free(diff->old_to_new);
+    memset(diff, 0, sizeof(*diff));
+}
@@ -0,0 +1,122 @@
+
+#define _POSIX_C_SOURCE 200809L
+#define LOG_MODULE LOG_MOD_PARSER
+
+#include "target_range.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+/**
+ * @brief Phân tích một địa chỉ IPv4 sang thứ tự byte của host
+ */
+static bool parse_ipv4(const char *text, size_t len, uint32_t *address) {
+    char buffer[INET_ADDRSTRLEN];
+    if (len == 0 || len >= sizeof(buffer)) {
+        return false;
+    }
+    memcpy(buffer, text, len);
+    buffer[len] = '\0';
+
+    struct in_addr addr;
+    if (inet_pton(AF_INET, buffer, &addr) != 1) {
+        return false;
+    }
+    *address = ntohl(addr.s_addr);
+    return true;
+}
+
+/**
+ * @brief Phân tích số nguyên thập phân trong [0, max]
+ */
+static bool parse_number(const char *text, long max, long *value) {
+    if (*text < '0' || *text > '9') {
+        return false;
+    }
+    char *end = NULL;
+    long n = strtol(text, &end, 10);
+    if (*end != '\0' || n < 0 || n > max) {
+        return false;
+    }
+    *value = n;
+    return true;
+}
+
+int target_range_parse(const char *target, target_range_t *range) {
+    if (!target || !range) {
+        return -1;
+    }
+
+    const char *slash = strchr(target, '/');
+    const char *dash = strchr(target, '-');
+    uint32_t first = 0;
+
+    if (slash) {
+        long prefix = 0;
+        if (!parse_ipv4(target, (size_t)(slash - target), &first) || !parse_number(slash + 1, 32, &prefix)) {
+            LOG_ERROR("Invalid CIDR target: %s", target);
+            return -1;
+        }
+
+        uint32_t mask = prefix == 0 ? 0 : 0xFFFFFFFFu << (32 - prefix);
+        range->first = first & mask;
+        range->last = range->first | ~mask;
+        // Bỏ địa chỉ network và broadcast, trừ /31 và /32 (RFC 3021)
+        if (prefix < 31) {
+            range->first++;
+            range->last--;
+        }
+    } else if (dash) {
+        // Tên host cũng có thể chứa '-', chỉ coi là dải khi vế trái là địa chỉ IPv4
+        if (!parse_ipv4(target, (size_t)(dash - target), &first)) {
+            return 0;
+        }
+
+        uint32_t last = 0;
+        long last_octet = 0;
+        if (parse_ipv4(dash + 1, strlen(dash + 1), &last)) {
+            range->last = last;
+        } else if (parse_number(dash + 1, 255, &last_octet)) {
+            range->last = (first & 0xFFFFFF00u) | (uint32_t)last_octet;
+        } else {
+            LOG_ERROR("Invalid address range target: %s", target);
+            return -1;
+        }
+        range->first = first;
+
+        if (range->last < range->first) {
+            LOG_ERROR("Address range %s ends before it starts", target);
+            return -1;
+        }
+    } else {
+        return 0;
+    }
+
+    if (target_range_size(range) > TARGET_RANGE_MAX_HOSTS) {
+        LOG_ERROR("Target %s covers %llu hosts, limit is %d",
+                  target, (unsigned long long)target_range_size(range), TARGET_RANGE_MAX_HOSTS);
+        return -1;
+    }
+    return 1;
+}
+
+void target_range_iter_init(target_range_iter_t *iter, const target_range_t *range) {
+    iter->range = *range;
+    iter->position = 0;
+}
+
+bool target_range_iter_next(target_range_iter_t *iter, uint32_t *address) {
+    if (!iter || iter->position >= target_range_size(&iter->range)) {
+        return false;
+    }
+    *address = iter->range.first + (uint32_t)iter->position++;
+    return true;
+}
+
+int target_range_format(uint32_t address, char *buffer, size_t buffer_size) {
+    struct in_addr addr;
+    addr.s_addr = htonl(address);
+    return inet_ntop(AF_INET, &addr, buffer, (socklen_t)buffer_size) ? 0 : -1;
+}
@@ -0,0 +1,313 @@
+
+#define _POSIX_C_SOURCE 200809L
+#define LOG_MODULE LOG_MOD_TC
+
+#include "target_resolve.h"
+#include "target_range.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+
+/**
+ * @brief Một mục trong cache phân giải
+ */
+typedef struct {
+    char *name;                 /**< Tên target (NULL = slot trống) */
+    int family;                 /**< AF_INET hoặc AF_INET6 */
+    int error;                  /**< Mã lỗi getaddrinfo của lần phân giải cuối, 0 nếu thành công */
+    resolved_target_t result;   /**< Kết quả phân giải */
+} resolve_entry_t;
+
+static resolve_entry_t *resolve_slots = NULL;
+static size_t resolve_slot_count = 0;
+static size_t resolve_used = 0;
+static int resolve_ttl = RESOLVE_DEFAULT_TTL;
+static pthread_mutex_t resolve_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t hash_target(const char *name, int family) {
+    uint32_t hash = 2166136261u ^ (uint32_t)family;
+    for (const char *p = name; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Tìm mục của target, tạo mới nếu chưa có (phải giữ resolve_mutex)
+ */
+static resolve_entry_t *find_or_insert(const char *name, int family) {
+    if (resolve_slot_count > 0) {
+        size_t mask = resolve_slot_count - 1;
+        size_t pos = hash_target(name, family) & mask;
+        while (resolve_slots[pos].name) {
+            if (resolve_slots[pos].family == family && strcmp(resolve_slots[pos].name, name) == 0) {
+                return &resolve_slots[pos];
+            }
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    // Mục mới: mở rộng bảng khi vượt 50% tải
+    if ((resolve_used + 1) * 2 > resolve_slot_count) {
+        size_t new_count = resolve_slot_count ? resolve_slot_count * 2 : 64;
+        resolve_entry_t *new_slots = (resolve_entry_t *)calloc(new_count, sizeof(resolve_entry_t));
+        if (!new_slots) {
+            LOG_ERROR("Memory allocation failed for resolver cache");
+            return NULL;
+        }
+        for (size_t i = 0; i < resolve_slot_count; i++) {
+            if (!resolve_slots[i].name) {
+                continue;
+            }
+            size_t pos = hash_target(resolve_slots[i].name, resolve_slots[i].family) & (new_count - 1);
+            while (new_slots[pos].name) {
+                pos = (pos + 1) & (new_count - 1);
+            }
+            new_slots[pos] = resolve_slots[i];
+        }
+        free(resolve_slots);
+        resolve_slots = new_slots;
+        resolve_slot_count = new_count;
+    }
+
+    size_t mask = resolve_slot_count - 1;
+    size_t pos = hash_target(name, family) & mask;
+    while (resolve_slots[pos].name) {
+        pos = (pos + 1) & mask;
+    }
+
+    resolve_slots[pos].name = strdup(name);
+    if (!resolve_slots[pos].name) {
+        return NULL;
+    }
+    resolve_slots[pos].family = family;
+    resolve_slots[pos].error = EAI_AGAIN;
+    resolve_used++;
+    return &resolve_slots[pos];
+}
+
+/**
+ * @brief Phân giải một tên (không giữ mutex trong lúc gọi getaddrinfo)
+ *
+ * @return int 0 nếu thành công, mã lỗi getaddrinfo nếu thất bại
+ */
+static int resolve_name(const char *name, int family, resolved_target_t *result) {
+    struct addrinfo hints;
+    struct addrinfo *info = NULL;
+    struct timespec start, end;
+
+    memset(result, 0, sizeof(*result));
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = family;
+    hints.ai_socktype = SOCK_RAW;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int rc = getaddrinfo(name, NULL, &hints, &info);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    result->dns_time = (end.tv_sec - start.tv_sec) * 1000.0f + (end.tv_nsec - start.tv_nsec) / 1e6f;
+    result->resolved_at = time(NULL);
+    if (rc != 0) {
+        return rc;
+    }
+
+    memcpy(&result->addr, info->ai_addr, info->ai_addrlen);
+    result->addr_len = info->ai_addrlen;
+    const void *raw = family == AF_INET6 ? (const void *)&((struct sockaddr_in6 *)info->ai_addr)->sin6_addr
+                                         : (const void *)&((struct sockaddr_in *)info->ai_addr)->sin_addr;
+    inet_ntop(family, raw, result->address, sizeof(result->address));
+    freeaddrinfo(info);
+    return 0;
+}
+
+/**
+ * @brief Kiểm tra target có phải địa chỉ IP (không cần DNS)
+ */
+static bool is_literal(const char *name, int family) {
+    unsigned char buf[sizeof(struct in6_addr)];
+    return inet_pton(family, name, buf) == 1;
+}
+
+/**
+ * @brief Trạng thái chung của nhóm luồng phân giải
+ *
+ * Tên lấy từ mục cache (cấp phát riêng) nên vẫn hợp lệ khi bảng được mở rộng;
+ * worker tìm lại mục theo tên khi ghi kết quả.
+ */
+typedef struct {
+    const char **names;         /**< Tên các target cần phân giải */
+    int *families;              /**< Họ địa chỉ tương ứng */
+    int count;                  /**< Số target */
+    int next;                   /**< Target kế tiếp chưa được nhận */
+    int failures;               /**< Số target phân giải thất bại */
+} prefetch_job_t;
+
+static void *prefetch_worker(void *arg) {
+    prefetch_job_t *job = (prefetch_job_t *)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&resolve_mutex);
+        if (job->next >= job->count) {
+            pthread_mutex_unlock(&resolve_mutex);
+            return NULL;
+        }
+        int i = job->next++;
+        pthread_mutex_unlock(&resolve_mutex);
+
+        resolved_target_t result;
+        int rc = resolve_name(job->names[i], job->families[i], &result);
+
+        pthread_mutex_lock(&resolve_mutex);
+        resolve_entry_t *entry = find_or_insert(job->names[i], job->families[i]);
+        if (entry) {
+            entry->error = rc;
+            entry->result = result;
+        }
+        if (rc != 0) {
+            job->failures++;
+        }
+        pthread_mutex_unlock(&resolve_mutex);
+
+        if (rc != 0) {
+            LOG_WARN("Failed to resolve %s: %s", job->names[i], gai_strerror(rc));
+        } else {
+            LOG_DEBUG("Resolved %s -> %s in %.2f ms", job->names[i], result.address, result.dns_time);
+        }
+    }
+}
+
+int target_resolve_prefetch(const test_case_t *test_cases, int count) {
+    if (count < 0 || (count > 0 && !test_cases)) {
+        LOG_ERROR("Invalid parameters for target_resolve_prefetch");
+        return -1;
+    }
+
+    prefetch_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.names = (const char **)malloc((count + 1) * sizeof(char *));
+    job.families = (int *)malloc((count + 1) * sizeof(int));
+    if (!job.names || !job.families) {
+        LOG_ERROR("Memory allocation failed for resolver prefetch");
+        free(job.names);
+        free(job.families);
+        return -1;
+    }
+
+    // Gom các target cần phân giải, mỗi tên chỉ một lần
+    pthread_mutex_lock(&resolve_mutex);
+    for (int i = 0; i < count; i++) {
+        const test_case_t *tc = &test_cases[i];
+        const char *target = test_case_target(tc);
+        int family = (tc->type == TEST_PING && tc->params.ping.ipv6) ? AF_INET6 : AF_INET;
+        target_range_t range;
+        if (target[0] == '\0' || is_literal(target, family) || target_range_parse(target, &range) != 0) {
+            continue;
+        }
+
+        size_t before = resolve_used;
+        resolve_entry_t *entry = find_or_insert(target, family);
+        if (entry && resolve_used > before) {
+            job.names[job.count] = entry->name;
+            job.families[job.count] = family;
+            job.count++;
+        }
+    }
+    pthread_mutex_unlock(&resolve_mutex);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int workers = job.count < RESOLVE_MAX_WORKERS ? job.count : RESOLVE_MAX_WORKERS;
+    pthread_t threads[RESOLVE_MAX_WORKERS];
+    int started = 0;
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&threads[i], NULL, prefetch_worker, &job) == 0) {
+            started++;
+        }
+    }
+    if (started == 0 && job.count > 0) {
+        // Không tạo được luồng: phân giải ngay trên luồng hiện tại
+        prefetch_worker(&job);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (job.count > 0) {
+        LOG_DEBUG("Resolved %d targets with %d workers in %.2f ms (%d failed)",
+                  job.count, started ? started : 1,
+                  (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6, job.failures);
+    }
+
+    free(job.names);
+    free(job.families);
+    return job.failures;
+}
+
+int target_resolve(const char *target, bool ipv6, resolved_target_t *resolved) {
+    if (!target || !resolved || target[0] == '\0') {
+        return -1;
+    }
+
+    int family = ipv6 ? AF_INET6 : AF_INET;
+    if (is_literal(target, family)) {
+        if (resolve_name(target, family, resolved) != 0) {
+            return -1;
+        }
+        // Không có truy vấn DNS, chỉ là chuyển đổi chuỗi
+        resolved->dns_time = 0;
+        return 0;
+    }
+
+    time_t now = time(NULL);
+    pthread_mutex_lock(&resolve_mutex);
+    resolve_entry_t *entry = find_or_insert(target, family);
+    if (entry && entry->error == 0 && now - entry->result.resolved_at < resolve_ttl) {
+        *resolved = entry->result;
+        resolved->cached = true;
+        // Lần gọi này không chờ DNS, thời gian lúc nạp đã được tính ở lần trước
+        resolved->dns_time = 0;
+        pthread_mutex_unlock(&resolve_mutex);
+        return 0;
+    }
+    pthread_mutex_unlock(&resolve_mutex);
+
+    // Chưa có hoặc đã quá TTL: phân giải lại
+    int rc = resolve_name(target, family, resolved);
+    if (rc != 0) {
+        LOG_ERROR("Failed to resolve %s: %s", target, gai_strerror(rc));
+    }
+
+    pthread_mutex_lock(&resolve_mutex);
+    entry = find_or_insert(target, family);
+    if (entry) {
+        entry->error = rc;
+        entry->result = *resolved;
+    }
+    pthread_mutex_unlock(&resolve_mutex);
+    return rc == 0 ? 0 : -1;
+}
+
+void target_resolve_set_ttl(int seconds) {
+    pthread_mutex_lock(&resolve_mutex);
+    resolve_ttl = seconds > 0 ? seconds : 0;
+    pthread_mutex_unlock(&resolve_mutex);
+}
+
+void target_resolve_clear(void) {
+    pthread_mutex_lock(&resolve_mutex);
+    for (size_t i = 0; i < resolve_slot_count; i++) {
+        free(resolve_slots[i].name);
+    }
+    free(resolve_slots);
+    resolve_slots = NULL;
+    resolve_slot_count = 0;
+    resolve_used = 0;
+    pthread_mutex_unlock(&resolve_mutex);
+}
@@ -1,8 +1,12 @@
 
 #define _POSIX_C_SOURCE 200809L   /* Thêm để đảm bảo định nghĩa POSIX đầy đủ */
+#define LOG_MODULE LOG_MOD_TC
 
 #include "tc.h"
 #include "log.h"
+#include "target_range.h"
+#include "target_resolve.h"
+#include "gzip_writer.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,6 +16,8 @@
 #include <sys/time.h>
 #include <signal.h>
 #include <errno.h>
+#include <arpa/inet.h>
+#include <pthread.h>
 
 // Biến đếm thời gian thực thi
 static struct timeval start_time, end_time;
@@ -19,6 +25,11 @@ static struct timeval start_time, end_time;
 // Biến xử lý timeout
 static volatile int timeout_occurred = 0;
 
+// Bảng chuỗi dùng chung cho target/message của các kết quả test
+static string_pool_t result_strings;
+static bool result_strings_ready = false;
+static pthread_mutex_t result_strings_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /**
  * @brief Handler cho tín hiệu SIGALRM (dùng cho timeout)
  */
@@ -57,7 +68,7 @@ static int set_timeout(int timeout_ms) {
     memset(&sa, 0, sizeof(sa));
     sa.sa_handler = &timeout_handler;
     if (sigaction(SIGALRM, &sa, NULL) < 0) {
-        log_message(LOG_LVL_ERROR, "Failed to set signal handler for timeout");
+        LOG_ERROR("Failed to set signal handler for timeout");
         return -1;
     }
     
@@ -69,7 +80,7 @@ static int set_timeout(int timeout_ms) {
     
     // Bắt đầu timer
     if (setitimer(ITIMER_REAL, &timer, NULL) < 0) {
-        log_message(LOG_LVL_ERROR, "Failed to set timer for timeout");
+        LOG_ERROR("Failed to set timer for timeout");
         return -1;
     }
     
@@ -120,9 +131,9 @@ static int parse_ping_result(const char *output, ping_result_t *result) {
             num_start--;
         }
         result->packets_sent = atoi(num_start);
-        log_message(LOG_LVL_DEBUG, "Ping packets sent: %d", result->packets_sent);
+        LOG_DEBUG("Ping packets sent: %d", result->packets_sent);
     } else {
-        log_message(LOG_LVL_WARN, "Could not find 'packets transmitted' in ping output");
+        LOG_WARN("Could not find 'packets transmitted' in ping output");
     }
     
     // Parse số gói tin nhận
@@ -167,9 +178,9 @@ static int parse_ping_result(const char *output, ping_result_t *result) {
             }
         }
         
-        log_message(LOG_LVL_DEBUG, "Ping packets received: %d", result->packets_received);
+        LOG_DEBUG("Ping packets received: %d", result->packets_received);
     } else {
-        log_message(LOG_LVL_WARN, "Could not find 'received' in ping output");
+        LOG_WARN("Could not find 'received' in ping output");
     }
     
     // Parse tỷ lệ mất gói
@@ -182,12 +193,12 @@ static int parse_ping_result(const char *output, ping_result_t *result) {
                 num_start--;
             }
             result->packet_loss = atof(num_start);
-            log_message(LOG_LVL_DEBUG, "Ping packet loss: %.1f%%", result->packet_loss);
+            LOG_DEBUG("Ping packet loss: %.1f%%", result->packet_loss);
         }
     } else if (result->packets_sent > 0) {
         // Tính tỷ lệ mất gói nếu không tìm thấy trong output
         result->packet_loss = 100.0f * (result->packets_sent - result->packets_received) / result->packets_sent;
-        log_message(LOG_LVL_DEBUG, "Calculated ping packet loss: %.1f%%", result->packet_loss);
+        LOG_DEBUG("Calculated ping packet loss: %.1f%%", result->packet_loss);
     }
     
     // Parse RTT min/avg/max
@@ -205,29 +216,153 @@ static int parse_ping_result(const char *output, ping_result_t *result) {
             // Đọc các giá trị
             if (sscanf(values_start, "%f/%f/%f", 
                       &result->min_rtt, &result->avg_rtt, &result->max_rtt) == 3) {
-                log_message(LOG_LVL_DEBUG, "Ping RTT min/avg/max: %.3f/%.3f/%.3f ms", 
+                LOG_DEBUG("Ping RTT min/avg/max: %.3f/%.3f/%.3f ms", 
                            result->min_rtt, result->avg_rtt, result->max_rtt);
             } else {
-                log_message(LOG_LVL_WARN, "Failed to parse RTT values: %s", values_start);
+                LOG_WARN("Failed to parse RTT values: %s", values_start);
             }
         } else {
-            log_message(LOG_LVL_WARN, "Could not find '=' in rtt line");
+            LOG_WARN("Could not find '=' in rtt line");
         }
     } else {
-        log_message(LOG_LVL_WARN, "Could not find 'rtt min/avg/max' in ping output");
+        LOG_WARN("Could not find 'rtt min/avg/max' in ping output");
     }
     
     // QUAN TRỌNG: Đặt giá trị packets_received bằng với packets_sent nếu có RTT và packet loss = 0
     // Đây là trường hợp đặc biệt khi phân tích không tìm được số gói đã nhận
     if (result->packets_received == 0 && result->min_rtt > 0 && result->packets_sent > 0) {
         result->packets_received = result->packets_sent;
-        log_message(LOG_LVL_DEBUG, "Fixed received packets count to %d based on successful RTT values", result->packets_received);
+        LOG_DEBUG("Fixed received packets count to %d based on successful RTT values", result->packets_received);
     }
     
     // Kiểm tra điều kiện thành công - nếu nhận được ít nhất 1 gói tin hoặc có RTT
     return (result->packets_received > 0 || result->min_rtt > 0) ? 0 : -1;
 }
 
+/**
+ * @brief Ghi một đoạn host không trả lời vào chi tiết kết quả sweep
+ *
+ * Các host liên tiếp được gộp thành dạng a.b.c.d-a.b.c.e; khi buffer đầy thì
+ * chỉ đếm số đoạn bị bỏ qua.
+ */
+static void append_unreachable(char *list, size_t list_size, size_t *len, uint32_t first, uint32_t last,
+                               int *omitted) {
+    char first_str[INET_ADDRSTRLEN], last_str[INET_ADDRSTRLEN];
+    char entry[2 * INET_ADDRSTRLEN + 4];
+    
+    target_range_format(first, first_str, sizeof(first_str));
+    if (first == last) {
+        snprintf(entry, sizeof(entry), "%s%s", *len ? ", " : "", first_str);
+    } else {
+        target_range_format(last, last_str, sizeof(last_str));
+        snprintf(entry, sizeof(entry), "%s%s-%s", *len ? ", " : "", first_str, last_str);
+    }
+    LOG_DEBUG("Sweep unreachable: %s", entry + (*len ? 2 : 0));
+    
+    // Chừa chỗ cho hậu tố "(+N more)"
+    size_t entry_len = strlen(entry);
+    if (*omitted > 0 || *len + entry_len + 24 >= list_size) {
+        (*omitted)++;
+        return;
+    }
+    memcpy(list + *len, entry, entry_len + 1);
+    *len += entry_len;
+}
+
+/**
+ * @brief Thực thi ping test trên một dải địa chỉ
+ *
+ * Địa chỉ được sinh lần lượt từ bộ duyệt, mỗi lô PING_SWEEP_BATCH tiến trình
+ * ping chạy song song. Kết quả chỉ giữ số host trả lời và danh sách host lỗi.
+ */
+static int execute_ping_sweep(test_case_t *test_case, const target_range_t *range, test_result_info_t *result) {
+    FILE *pipes[PING_SWEEP_BATCH];
+    uint32_t addresses[PING_SWEEP_BATCH];
+    char address_str[INET_ADDRSTRLEN];
+    char ping_cmd[256];
+    
+    // Thời gian chờ tối đa cho mỗi host (giây, làm tròn lên)
+    int deadline = (test_case->timeout + 999) / 1000;
+    if (deadline < 1) {
+        deadline = 1;
+    }
+    
+    result->is_sweep = true;
+    result->data.sweep.hosts_total = (int)target_range_size(range);
+    LOG_DEBUG("Sweeping %s (%d hosts)", test_case_target(test_case), result->data.sweep.hosts_total);
+    
+    // Danh sách host lỗi, ghép sau phần tóm tắt khi kết thúc
+    char unreachable[TEST_RESULT_DETAILS_SIZE - 160];
+    size_t unreachable_len = 0;
+    unreachable[0] = '\0';
+    int omitted = 0;
+    bool in_run = false;
+    uint32_t run_first = 0, run_last = 0;
+    
+    start_timer();
+    
+    target_range_iter_t iter;
+    target_range_iter_init(&iter, range);
+    bool more = true;
+    while (more) {
+        // Khởi chạy một lô ping
+        int batch = 0;
+        while (batch < PING_SWEEP_BATCH && (more = target_range_iter_next(&iter, &addresses[batch]))) {
+            target_range_format(addresses[batch], address_str, sizeof(address_str));
+            snprintf(ping_cmd, sizeof(ping_cmd), "ping -c %d -s %d -i %.1f -w %d %s >/dev/null 2>&1",
+                     test_case->params.ping.count, test_case->params.ping.size,
+                     test_case->params.ping.interval / 1000.0f, deadline, address_str);
+            pipes[batch] = popen(ping_cmd, "r");
+            if (!pipes[batch]) {
+                LOG_WARN("Failed to execute ping command: %s", ping_cmd);
+            }
+            batch++;
+        }
+        
+        // Thu kết quả theo đúng thứ tự địa chỉ
+        for (int i = 0; i < batch; i++) {
+            int exit_code = pipes[i] ? pclose(pipes[i]) : -1;
+            if (exit_code != -1 && WIFEXITED(exit_code) && WEXITSTATUS(exit_code) == 0) {
+                result->data.sweep.hosts_reachable++;
+                if (in_run) {
+                    append_unreachable(unreachable, sizeof(unreachable), &unreachable_len, run_first, run_last, &omitted);
+                    in_run = false;
+                }
+            } else if (in_run && addresses[i] == run_last + 1) {
+                run_last = addresses[i];
+            } else {
+                if (in_run) {
+                    append_unreachable(unreachable, sizeof(unreachable), &unreachable_len, run_first, run_last, &omitted);
+                }
+                run_first = run_last = addresses[i];
+                in_run = true;
+            }
+        }
+    }
+    if (in_run) {
+        append_unreachable(unreachable, sizeof(unreachable), &unreachable_len, run_first, run_last, &omitted);
+    }
+    
+    result->execution_time = stop_timer();
+    
+    // Chỉ danh sách host lỗi được lưu dạng text, phần tóm tắt dựng lại từ data.sweep
+    result->reason = RESULT_REASON_SWEEP;
+    if (unreachable_len > 0) {
+        if (omitted > 0) {
+            snprintf(unreachable + unreachable_len, sizeof(unreachable) - unreachable_len, " (+%d more)", omitted);
+        }
+        result->message = test_result_intern(unreachable);
+    }
+    
+    result->status = result->data.sweep.hosts_reachable > 0 ? TEST_RESULT_SUCCESS : TEST_RESULT_FAILED;
+    if (LOG_ENABLED(LOG_LVL_DEBUG)) {
+        char details[TEST_RESULT_DETAILS_SIZE];
+        test_result_format_details(result, details, sizeof(details));
+        LOG_DEBUG("%s", details);
+    }
+    return 0;
+}
+
 /**
  * @brief Thực thi ping test
  * 
@@ -237,25 +372,44 @@ static int parse_ping_result(const char *output, ping_result_t *result) {
  */
 int execute_ping_test(test_case_t *test_case, test_result_info_t *result) {
     if (!test_case || !result || test_case->type != TEST_PING) {
-        log_message(LOG_LVL_ERROR, "Invalid parameters for ping test");
+        LOG_ERROR("Invalid parameters for ping test");
         return -1;
     }
     
     // Khởi tạo kết quả
     memset(result, 0, sizeof(test_result_info_t));
-    strncpy(result->test_id, test_case->id, sizeof(result->test_id) - 1);
+    strncpy(result->test_id, test_case_id(test_case), sizeof(result->test_id) - 1);
     result->test_id[sizeof(result->test_id) - 1] = '\0';
     result->test_type = TEST_PING;
     result->status = TEST_RESULT_ERROR;
+    result->target = test_result_intern(test_case_target(test_case));
     
     // Kiểm tra target
-    if (strlen(test_case->target) == 0) {
-        log_message(LOG_LVL_ERROR, "Empty target for ping test case %s", test_case->id);
-        snprintf(result->result_details, sizeof(result->result_details), 
-                "Invalid target: empty string");
+    if (test_case_target(test_case)[0] == '\0') {
+        LOG_ERROR("Empty target for ping test case %s", test_case_id(test_case));
+        result->reason = RESULT_REASON_EMPTY_TARGET;
         return -1;
     }
     
+    // Target dạng CIDR hoặc dải địa chỉ được quét thành một kết quả tổng hợp
+    target_range_t range;
+    int range_status = target_range_parse(test_case_target(test_case), &range);
+    if (range_status < 0) {
+        result->reason = RESULT_REASON_INVALID_RANGE;
+        return -1;
+    }
+    if (range_status > 0) {
+        return execute_ping_sweep(test_case, &range, result);
+    }
+    
+    // Dùng địa chỉ đã phân giải trước để thời gian DNS không lẫn vào thời gian đo
+    resolved_target_t resolved;
+    if (target_resolve(test_case_target(test_case), test_case->params.ping.ipv6, &resolved) != 0) {
+        result->reason = RESULT_REASON_RESOLVE_FAILED;
+        return 0;
+    }
+    result->dns_time = resolved.dns_time;
+    
     // Tạo lệnh ping
     char ping_cmd[512];
     const char *ping_cmd_base = test_case->params.ping.ipv6 ? "ping6" : "ping";
@@ -267,16 +421,16 @@ int execute_ping_test(test_case_t *test_case, test_result_info_t *result) {
              test_case->params.ping.count,
              test_case->params.ping.size,
              test_case->params.ping.interval / 1000.0f,  // Chuyển ms sang giây
-             test_case->target);
+             resolved.address);
     
-    log_message(LOG_LVL_DEBUG, "Executing ping command: %s", ping_cmd);
+    LOG_DEBUG("Executing ping command: %s", ping_cmd);
     
     // Mở pipe để đọc output từ lệnh ping
     FILE *pipe = popen(ping_cmd, "r");
     if (!pipe) {
-        log_message(LOG_LVL_ERROR, "Failed to execute ping command: %s", ping_cmd);
-        snprintf(result->result_details, sizeof(result->result_details), 
-                 "Failed to execute ping command: %s", strerror(errno));
+        LOG_ERROR("Failed to execute ping command: %s", ping_cmd);
+        result->reason = RESULT_REASON_EXEC_FAILED;
+        result->message = test_result_intern(strerror(errno));
         return -1;
     }
     
@@ -287,7 +441,7 @@ int execute_ping_test(test_case_t *test_case, test_result_info_t *result) {
     // Bắt đầu đếm thời gian và thiết lập timeout
     start_timer();
     if (set_timeout(test_case->timeout) != 0) {
-        log_message(LOG_LVL_WARN, "Failed to set timeout for ping test");
+        LOG_WARN("Failed to set timeout for ping test");
     }
     
     // Đọc output từ pipe
@@ -302,7 +456,7 @@ int execute_ping_test(test_case_t *test_case, test_result_info_t *result) {
                 break;
             }
             if (ferror(pipe) && errno != EINTR) {
-                log_message(LOG_LVL_ERROR, "Error reading from pipe: %s", strerror(errno));
+                LOG_ERROR("Error reading from pipe: %s", strerror(errno));
                 break;
             }
         } else {
@@ -324,18 +478,16 @@ int execute_ping_test(test_case_t *test_case, test_result_info_t *result) {
     
     // Xử lý trường hợp timeout
     if (timeout_occurred) {
-        log_message(LOG_LVL_WARN, "Ping test timed out after %.1f ms", result->execution_time);
+        LOG_WARN("Ping test timed out after %.1f ms", result->execution_time);
         result->status = TEST_RESULT_TIMEOUT;
-        snprintf(result->result_details, sizeof(result->result_details), 
-                 "Ping test to %s timed out after %.1f ms", 
-                 test_case->target, result->execution_time);
+        result->reason = RESULT_REASON_PING_TIMEOUT;
         return 0;
     }
     
     // Xử lý kết quả dựa vào exit code và output
     if (WIFEXITED(exit_code)) {
         int status = WEXITSTATUS(exit_code);
-        log_message(LOG_LVL_DEBUG, "Ping command exited with status %d", status);
+        LOG_DEBUG("Ping command exited with status %d", status);
         
         // Parse output nếu có
         if (bytes_read > 0) {
@@ -343,38 +495,43 @@ int execute_ping_test(test_case_t *test_case, test_result_info_t *result) {
                 // Nếu parse thành công (có nhận được gói) thì đặt trạng thái SUCCESS
                 result->status = TEST_RESULT_SUCCESS;
                 
-                // Tạo thông tin chi tiết
-                snprintf(result->result_details, sizeof(result->result_details), 
-                         "Ping to %s completed. Packets: %d/%d, Loss: %.1f%%, RTT min/avg/max: %.3f/%.3f/%.3f ms", 
-                         test_case->target, 
-                         result->data.ping.packets_received, 
-                         result->data.ping.packets_sent,
-                         result->data.ping.packet_loss, 
-                         result->data.ping.min_rtt, 
-                         result->data.ping.avg_rtt, 
-                         result->data.ping.max_rtt);
+                result->reason = RESULT_REASON_PING_DONE;
             } else {
                 // Nếu parse thất bại (không nhận được gói nào) thì đặt trạng thái FAILED
                 result->status = TEST_RESULT_FAILED;
-                snprintf(result->result_details, sizeof(result->result_details), 
-                         "Ping to %s failed. All packets lost.", test_case->target);
+                result->reason = RESULT_REASON_PING_ALL_LOST;
             }
         } else {
             // Không có output
             result->status = TEST_RESULT_ERROR;
-            snprintf(result->result_details, sizeof(result->result_details), 
-                     "No output from ping command");
+            result->reason = RESULT_REASON_NO_OUTPUT;
         }
     } else {
         // Lệnh ping không kết thúc đúng cách
         result->status = TEST_RESULT_ERROR;
-        snprintf(result->result_details, sizeof(result->result_details), 
-                 "Ping command did not exit properly");
+        result->reason = RESULT_REASON_ABNORMAL_EXIT;
     }
     
     return 0;
 }
 
+/**
+ * @brief Thời điểm hiện tại tính bằng ms kể từ epoch
+ */
+static int64_t wall_clock_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Ghi thời điểm bắt đầu/kết thúc vào kết quả (sau khi các hàm con đã memset kết quả)
+ */
+static void stamp_result(test_result_info_t *result, int64_t started_at) {
+    result->started_at = started_at;
+    result->finished_at = wall_clock_ms();
+}
+
 /**
  * @brief Thực thi test case
  * 
@@ -384,54 +541,57 @@ int execute_ping_test(test_case_t *test_case, test_result_info_t *result) {
  */
 int execute_test_case(test_case_t *test_case, test_result_info_t *result) {
     if (!test_case || !result) {
-        log_message(LOG_LVL_ERROR, "Invalid parameters for execute_test_case");
+        LOG_ERROR("Invalid parameters for execute_test_case");
         return -1;
     }
     
+    int64_t started_at = wall_clock_ms();
+    
     // Kiểm tra trạng thái enabled
     if (!test_case->enabled) {
-        log_message(LOG_LVL_WARN, "Test case %s is disabled, skipping execution", test_case->id);
+        LOG_WARN("Test case %s is disabled, skipping execution", test_case_id(test_case));
         
         // Khởi tạo kết quả mặc định cho test case bị disable
         memset(result, 0, sizeof(test_result_info_t));
-        strncpy(result->test_id, test_case->id, sizeof(result->test_id) - 1);
+        strncpy(result->test_id, test_case_id(test_case), sizeof(result->test_id) - 1);
         result->test_id[sizeof(result->test_id) - 1] = '\0';
         result->test_type = test_case->type;
         result->status = TEST_RESULT_ERROR;
-        snprintf(result->result_details, sizeof(result->result_details), 
-                "Test case is disabled");
+        result->reason = RESULT_REASON_DISABLED;
+        stamp_result(result, started_at);
         
         return 0;
     }
     
-    log_message(LOG_LVL_DEBUG, "Executing test case %s (%s)", test_case->id, test_case->name);
+    LOG_DEBUG("Executing test case %s (%s)", test_case_id(test_case), test_case_name(test_case));
     
     // Chỉ thực thi test ping, bỏ qua các loại test khác
     int ret = -1;
     if (test_case->type == TEST_PING) {
         ret = execute_ping_test(test_case, result);
+        stamp_result(result, started_at);
     } else {
         // Đối với các loại test khác, tạo kết quả với thông báo "not supported"
-        log_message(LOG_LVL_WARN, "Only ping test is currently supported. Skipping test case %s of type %d", 
-                   test_case->id, test_case->type);
+        LOG_WARN("Only ping test is currently supported. Skipping test case %s of type %d", 
+                   test_case_id(test_case), test_case->type);
         
         memset(result, 0, sizeof(test_result_info_t));
-        strncpy(result->test_id, test_case->id, sizeof(result->test_id) - 1);
+        strncpy(result->test_id, test_case_id(test_case), sizeof(result->test_id) - 1);
         result->test_id[sizeof(result->test_id) - 1] = '\0';
         result->test_type = test_case->type;
         result->status = TEST_RESULT_ERROR;
-        snprintf(result->result_details, sizeof(result->result_details), 
-                "Only ping test is currently supported");
+        result->reason = RESULT_REASON_UNSUPPORTED;
+        stamp_result(result, started_at);
         
         // Trả về 0 để không gây lỗi cho toàn bộ quy trình
         return 0;
     }
     
     if (ret == 0) {
-        log_message(LOG_LVL_DEBUG, "Test case %s completed with status: %d", 
-                   test_case->id, result->status);
+        LOG_DEBUG("Test case %s completed with status: %d", 
+                   test_case_id(test_case), result->status);
     } else {
-        log_message(LOG_LVL_ERROR, "Failed to execute test case %s", test_case->id);
+        LOG_ERROR("Failed to execute test case %s", test_case_id(test_case));
     }
     
     return ret;
@@ -447,32 +607,31 @@ int execute_test_case(test_case_t *test_case, test_result_info_t *result) {
  */
 int execute_test_case_by_network(test_case_t *test_case, network_type_t network_type, test_result_info_t *result) {
     if (!test_case || !result) {
-        log_message(LOG_LVL_ERROR, "Invalid parameters for execute_test_case_by_network");
+        LOG_ERROR("Invalid parameters for execute_test_case_by_network");
         return -1;
     }
     
     // Kiểm tra test case có được cấu hình cho loại mạng này không
     if (test_case->network_type != network_type && test_case->network_type != NETWORK_BOTH) {
-        log_message(LOG_LVL_WARN, "Test case %s is not configured for network type %d", 
-                   test_case->id, network_type);
+        LOG_WARN("Test case %s is not configured for network type %d", 
+                   test_case_id(test_case), network_type);
         
         // Khởi tạo kết quả mặc định
         memset(result, 0, sizeof(test_result_info_t));
-        strncpy(result->test_id, test_case->id, sizeof(result->test_id) - 1);
+        strncpy(result->test_id, test_case_id(test_case), sizeof(result->test_id) - 1);
         result->test_id[sizeof(result->test_id) - 1] = '\0';
         result->test_type = test_case->type;
         result->status = TEST_RESULT_ERROR;
-        snprintf(result->result_details, sizeof(result->result_details), 
-                "Test case is not configured for this network type");
+        result->reason = RESULT_REASON_WRONG_NETWORK;
         
         return -1;
     }
     
     // Ta có thể cấu hình interface mạng dựa vào loại mạng
     if (network_type == NETWORK_LAN) {
-        log_message(LOG_LVL_DEBUG, "Executing test case %s on LAN", test_case->id);
+        LOG_DEBUG("Executing test case %s on LAN", test_case_id(test_case));
     } else if (network_type == NETWORK_WAN) {
-        log_message(LOG_LVL_DEBUG, "Executing test case %s on WAN", test_case->id);
+        LOG_DEBUG("Executing test case %s on WAN", test_case_id(test_case));
     }
     
     // Thực thi test case
@@ -495,6 +654,265 @@ const char* test_result_status_to_string(test_result_status_t status) {
     }
 }
 
+const char* test_type_to_string(test_type_t type) {
+    switch (type) {
+        case TEST_PING: return "ping";
+        case TEST_THROUGHPUT: return "throughput";
+        case TEST_SECURITY: return "security";
+        default: return "other";
+    }
+}
+
+bool test_result_has_ping_stats(const test_result_info_t *result) {
+    return result && result->test_type == TEST_PING && !result->is_sweep && result->data.ping.packets_sent > 0;
+}
+
+str_ref_t test_result_intern(const char *text) {
+    if (!text || text[0] == '\0') {
+        return 0;
+    }
+
+    pthread_mutex_lock(&result_strings_mutex);
+    str_ref_t ref = 0;
+    if (result_strings_ready || string_pool_init(&result_strings, 0) == 0) {
+        result_strings_ready = true;
+        ref = string_pool_intern(&result_strings, text);
+    }
+    pthread_mutex_unlock(&result_strings_mutex);
+    return ref;
+}
+
+void test_result_set_details(test_result_info_t *result, const char *text) {
+    if (!result) {
+        return;
+    }
+    result->reason = RESULT_REASON_TEXT;
+    result->message = test_result_intern(text);
+}
+
+void test_result_strings_free(void) {
+    pthread_mutex_lock(&result_strings_mutex);
+    if (result_strings_ready) {
+        string_pool_free(&result_strings);
+        result_strings_ready = false;
+    }
+    pthread_mutex_unlock(&result_strings_mutex);
+}
+
+int test_result_format_details(const test_result_info_t *result, char *buffer, size_t size) {
+    if (!result || !buffer || size == 0) {
+        return -1;
+    }
+
+    // Giữ mutex trong lúc đọc vì bảng chuỗi có thể được cấp phát lại khi intern
+    pthread_mutex_lock(&result_strings_mutex);
+    const char *strtab = result_strings_ready ? result_strings.data : NULL;
+    const char *target = strtab_get(strtab, result->target);
+    const char *message = strtab_get(strtab, result->message);
+    int len;
+
+    switch (result->reason) {
+        case RESULT_REASON_TEXT:
+            len = snprintf(buffer, size, "%s", message);
+            break;
+        case RESULT_REASON_EMPTY_TARGET:
+            len = snprintf(buffer, size, "Invalid target: empty string");
+            break;
+        case RESULT_REASON_INVALID_RANGE:
+            len = snprintf(buffer, size, "Invalid target range: %s", target);
+            break;
+        case RESULT_REASON_RESOLVE_FAILED:
+            len = snprintf(buffer, size, "Failed to resolve target %s", target);
+            break;
+        case RESULT_REASON_EXEC_FAILED:
+            len = snprintf(buffer, size, "Failed to execute ping command: %s", message);
+            break;
+        case RESULT_REASON_PING_TIMEOUT:
+            len = snprintf(buffer, size, "Ping test to %s timed out after %.1f ms", target, result->execution_time);
+            break;
+        case RESULT_REASON_PING_DONE:
+            len = snprintf(buffer, size,
+                           "Ping to %s completed. Packets: %d/%d, Loss: %.1f%%, RTT min/avg/max: %.3f/%.3f/%.3f ms",
+                           target,
+                           result->data.ping.packets_received,
+                           result->data.ping.packets_sent,
+                           result->data.ping.packet_loss,
+                           result->data.ping.min_rtt,
+                           result->data.ping.avg_rtt,
+                           result->data.ping.max_rtt);
+            break;
+        case RESULT_REASON_PING_ALL_LOST:
+            len = snprintf(buffer, size, "Ping to %s failed. All packets lost.", target);
+            break;
+        case RESULT_REASON_NO_OUTPUT:
+            len = snprintf(buffer, size, "No output from ping command");
+            break;
+        case RESULT_REASON_ABNORMAL_EXIT:
+            len = snprintf(buffer, size, "Ping command did not exit properly");
+            break;
+        case RESULT_REASON_SWEEP:
+            len = snprintf(buffer, size, "Sweep of %s: %d/%d hosts reachable", target,
+                           result->data.sweep.hosts_reachable, result->data.sweep.hosts_total);
+            if (message[0] != '\0' && len >= 0 && (size_t)len < size) {
+                int tail = snprintf(buffer + len, size - len, ". Unreachable: %s", message);
+                len = tail >= 0 ? len + tail : tail;
+            }
+            break;
+        case RESULT_REASON_DISABLED:
+            len = snprintf(buffer, size, "Test case is disabled");
+            break;
+        case RESULT_REASON_UNSUPPORTED:
+            len = snprintf(buffer, size, "Only ping test is currently supported");
+            break;
+        case RESULT_REASON_WRONG_NETWORK:
+            len = snprintf(buffer, size, "Test case is not configured for this network type");
+            break;
+        default:
+            buffer[0] = '\0';
+            len = 0;
+            break;
+    }
+
+    pthread_mutex_unlock(&result_strings_mutex);
+    return len;
+}
+
+/**
+ * @brief Chép một chuỗi trong bảng chuỗi kết quả ra buffer (bảng có thể được cấp phát lại khi intern)
+ */
+static void copy_result_string(str_ref_t ref, char *buffer, size_t size) {
+    pthread_mutex_lock(&result_strings_mutex);
+    snprintf(buffer, size, "%s", strtab_get(result_strings_ready ? result_strings.data : NULL, ref));
+    pthread_mutex_unlock(&result_strings_mutex);
+}
+
+bool test_result_write_json(json_writer_t *writer, const test_result_info_t *result) {
+    if (!writer || !result) {
+        return false;
+    }
+
+    json_writer_begin_object(writer);
+    json_writer_field_string(writer, "test_id", result->test_id);
+    json_writer_field_string(writer, "type", test_type_to_string(result->test_type));
+    json_writer_field_string(writer, "status", test_result_status_to_string(result->status));
+    json_writer_field_float(writer, "execution_time_ms", result->execution_time);
+    json_writer_field_float(writer, "dns_time_ms", result->dns_time);
+    json_writer_field_int(writer, "started_at_ms", result->started_at);
+    json_writer_field_int(writer, "finished_at_ms", result->finished_at);
+    char details[TEST_RESULT_DETAILS_SIZE];
+    test_result_format_details(result, details, sizeof(details));
+    json_writer_field_string(writer, "details", details);
+
+    switch (result->test_type) {
+        case TEST_PING:
+            if (result->is_sweep) {
+                json_writer_key(writer, "sweep");
+                json_writer_begin_object(writer);
+                json_writer_field_int(writer, "hosts_total", result->data.sweep.hosts_total);
+                json_writer_field_int(writer, "hosts_reachable", result->data.sweep.hosts_reachable);
+                json_writer_end_object(writer);
+            } else if (test_result_has_ping_stats(result)) {
+                // Không có block khi ping chưa in thống kê (timeout, lỗi), RTT chỉ khi có gói trả lời
+                json_writer_key(writer, "ping");
+                json_writer_begin_object(writer);
+                json_writer_field_int(writer, "packets_sent", result->data.ping.packets_sent);
+                json_writer_field_int(writer, "packets_received", result->data.ping.packets_received);
+                if (result->data.ping.packets_received > 0) {
+                    json_writer_field_float(writer, "min_rtt_ms", result->data.ping.min_rtt);
+                    json_writer_field_float(writer, "avg_rtt_ms", result->data.ping.avg_rtt);
+                    json_writer_field_float(writer, "max_rtt_ms", result->data.ping.max_rtt);
+                }
+                json_writer_field_float(writer, "packet_loss", result->data.ping.packet_loss);
+                json_writer_end_object(writer);
+            }
+            break;
+
+        case TEST_THROUGHPUT:
+            json_writer_key(writer, "throughput");
+            json_writer_begin_object(writer);
+            json_writer_field_float(writer, "bandwidth_mbps", result->data.throughput.bandwidth);
+            json_writer_field_int(writer, "jitter_ms", result->data.throughput.jitter);
+            json_writer_field_int(writer, "packet_loss", result->data.throughput.packet_loss);
+            json_writer_field_float(writer, "retransmits", result->data.throughput.retransmits);
+            json_writer_end_object(writer);
+            break;
+
+        case TEST_SECURITY:
+            json_writer_key(writer, "security");
+            json_writer_begin_object(writer);
+            json_writer_field_bool(writer, "passed", result->data.security.passed);
+            json_writer_field_int(writer, "vulnerabilities", result->data.security.vulnerabilities);
+            char vuln_details[TEST_RESULT_DETAILS_SIZE];
+            copy_result_string(result->data.security.vuln_details, vuln_details, sizeof(vuln_details));
+            json_writer_field_string(writer, "vuln_details", vuln_details);
+            json_writer_end_object(writer);
+            break;
+
+        default:
+            break;
+    }
+
+    json_writer_end_object(writer);
+    return !writer->error;
+}
+
+int test_result_to_json(test_result_info_t *result, char *json_buffer, size_t buffer_size) {
+    json_writer_t writer;
+    if (!result || json_writer_init_fixed(&writer, json_buffer, buffer_size) != 0) {
+        LOG_ERROR("Invalid parameters for test_result_to_json");
+        return -1;
+    }
+
+    test_result_write_json(&writer, result);
+    return json_writer_finish(&writer);
+}
+
+/**
+ * @brief Ghi nội dung báo cáo tổng hợp vào writer (chưa gọi finish)
+ */
+static void write_summary_report(json_writer_t *writer, const test_result_info_t *results, int count) {
+    // Thống kê theo trạng thái và khoảng thời gian của lần chạy
+    static const char *status_keys[] = { "success", "failed", "timeout", "error" };
+    int status_counts[TEST_RESULT_ERROR + 1] = {0};
+    double total_time = 0;
+    int64_t first_start = 0, last_finish = 0;
+    for (int i = 0; i < count; i++) {
+        if (results[i].status <= TEST_RESULT_ERROR) {
+            status_counts[results[i].status]++;
+        }
+        total_time += results[i].execution_time + results[i].dns_time;
+        if (results[i].started_at && (!first_start || results[i].started_at < first_start)) {
+            first_start = results[i].started_at;
+        }
+        if (results[i].finished_at > last_finish) {
+            last_finish = results[i].finished_at;
+        }
+    }
+    
+    json_writer_begin_object(writer);
+    json_writer_field_int(writer, "generated_at_ms", wall_clock_ms());
+    json_writer_key(writer, "summary");
+    json_writer_begin_object(writer);
+    json_writer_field_int(writer, "total", count);
+    for (int s = TEST_RESULT_SUCCESS; s <= TEST_RESULT_ERROR; s++) {
+        json_writer_field_int(writer, status_keys[s], status_counts[s]);
+    }
+    json_writer_field_double(writer, "total_time_ms", total_time);
+    json_writer_field_int(writer, "started_at_ms", first_start);
+    json_writer_field_int(writer, "finished_at_ms", last_finish);
+    json_writer_end_object(writer);
+    
+    // Mỗi kết quả kèm số liệu dạng số của loại test tương ứng
+    json_writer_key(writer, "test_results");
+    json_writer_begin_array(writer);
+    for (int i = 0; i < count; i++) {
+        test_result_write_json(writer, &results[i]);
+    }
+    json_writer_end_array(writer);
+    json_writer_end_object(writer);
+    json_writer_raw(writer, "\n", 1);
+}
+
 /**
  * @brief Tạo báo cáo tổng hợp từ các kết quả test
  * 
@@ -505,34 +923,95 @@ const char* test_result_status_to_string(test_result_status_t status) {
  */
 int generate_summary_report(test_result_info_t *results, int count, const char *filename) {
     if (!results || count <= 0 || !filename) {
-        log_message(LOG_LVL_ERROR, "Invalid parameters for generate_summary_report");
+        LOG_ERROR("Invalid parameters for generate_summary_report");
         return -1;
     }
     
-    log_message(LOG_LVL_DEBUG, "Generating summary report to %s", filename);
+    LOG_DEBUG("Generating summary report to %s", filename);
     
     FILE *file = fopen(filename, "w");
     if (!file) {
-        log_message(LOG_LVL_ERROR, "Failed to open report file %s: %s", 
+        LOG_ERROR("Failed to open report file %s: %s", 
                    filename, strerror(errno));
         return -1;
     }
     
-    // Tạo báo cáo dạng JSON đơn giản
-    fprintf(file, "{\n  \"test_results\": [\n");
-    
-    for (int i = 0; i < count; i++) {
-        fprintf(file, "    {\n");
-        fprintf(file, "      \"test_id\": \"%s\",\n", results[i].test_id);
-        fprintf(file, "      \"status\": \"%s\",\n", test_result_status_to_string(results[i].status));
-        fprintf(file, "      \"details\": \"%s\"\n", results[i].result_details);
-        fprintf(file, "    }%s\n", (i < count - 1) ? "," : "");
+    json_writer_t writer;
+    if (json_writer_init_file(&writer, file) != 0) {
+        fclose(file);
+        return -1;
     }
     
-    fprintf(file, "  ]\n}\n");
+    write_summary_report(&writer, results, count);
+    int ret = json_writer_finish(&writer);
+    json_writer_free(&writer);
+    if (fclose(file) != 0) {
+        ret = -1;
+    }
     
-    fclose(file);
-    log_message(LOG_LVL_DEBUG, "Successfully generated report: %s", filename);
+    if (ret != 0) {
+        LOG_ERROR("Failed to write report file %s", filename);
+        return -1;
+    }
+    LOG_DEBUG("Successfully generated report: %s", filename);
     
     return 0;
+}
+
+/**
+ * @brief Chuyển khối đầu ra của json_writer sang bộ nén gzip
+ */
+static int gzip_sink(void *context, const void *data, size_t len) {
+    return gzip_writer_write((gzip_writer_t *)context, data, len);
+}
+
+/**
+ * @brief Tạo báo cáo tổng hợp nén gzip
+ * 
+ * @param results Mảng kết quả test
+ * @param count Số lượng kết quả
+ * @param filename Đường dẫn đến file báo cáo (.json.gz)
+ * @param level Mức nén 1-9
+ * @return int 0 nếu thành công, -1 nếu thất bại
+ */
+int generate_summary_report_gz(test_result_info_t *results, int count, const char *filename, int level) {
+    if (!results || count <= 0 || !filename) {
+        LOG_ERROR("Invalid parameters for generate_summary_report_gz");
+        return -1;
+    }
+    
+    LOG_DEBUG("Generating compressed summary report to %s (level %d)", filename, level);
+    
+    // Bộ nén chứa buffer đầu ra 64KB: cấp phát động thay vì đặt trên stack
+    gzip_writer_t *gz = (gzip_writer_t *)malloc(sizeof(gzip_writer_t));
+    if (!gz) {
+        LOG_ERROR("Memory allocation failed for report compression");
+        return -1;
+    }
+    if (gzip_writer_open(gz, filename, level) != 0) {
+        free(gz);
+        return -1;
+    }
+    
+    json_writer_t writer;
+    int ret = json_writer_init_sink(&writer, gzip_sink, gz);
+    if (ret == 0) {
+        write_summary_report(&writer, results, count);
+        ret = json_writer_finish(&writer);
+        json_writer_free(&writer);
+    }
+    if (gzip_writer_close(gz) != 0) {
+        ret = -1;
+    }
+    
+    if (ret != 0) {
+        LOG_ERROR("Failed to write report file %s", filename);
+        unlink(filename);
+    } else {
+        LOG_DEBUG("Successfully generated report: %s (%llu -> %llu bytes)", filename,
+                  (unsigned long long)gz->bytes_in, (unsigned long long)gz->bytes_out);
+    }
+    free(gz);
+    
+    return ret;
 }
\ No newline at end of file
@@ -7,6 +7,10 @@
  #include <stdlib.h>
  #include <string.h>
  #include <assert.h>
+ #include <stdbool.h>
+ #include <time.h>
+ #include <fcntl.h>
+ #include <sys/stat.h>
  #include "include/file_process.h"
  
  // Đường dẫn file test để tránh ảnh hưởng đến file thật
@@ -427,6 +431,276 @@ void test_read_file_chunk() {
     printf("=> Kiểm tra đọc từng phần của file hoàn tất.\n");
 }
 
+static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/**
+ * @brief Tổng các byte, để buộc đọc hết nội dung
+ */
+static unsigned long checksum(const char *data, size_t size) {
+    unsigned long sum = 0;
+    for (size_t i = 0; i < size; i++) {
+        sum += (unsigned char)data[i];
+    }
+    return sum;
+}
+
+/**
+ * @brief Ghi file có nội dung thay đổi theo từng khối 64 KB
+ */
+static void write_pattern_file(const char *path, size_t size) {
+    FILE *file = fopen(path, "wb");
+    char block[65536];
+    for (size_t i = 0; i < sizeof(block); i++) {
+        block[i] = (char)(' ' + (i * 7) % 64);
+    }
+    for (size_t written = 0; file && written < size; written += sizeof(block)) {
+        block[0] = (char)(written >> 16);
+        size_t n = size - written < sizeof(block) ? size - written : sizeof(block);
+        fwrite(block, 1, n, file);
+    }
+    if (file) {
+        fclose(file);
+    }
+}
+
+/**
+ * @brief Kiểm tra view chỉ đọc của file (mmap hoặc đọc vào buffer)
+ */
+void test_file_view() {
+    printf("\n--- Kiểm tra file_view (mmap) ---\n");
+    
+    // File nhỏ: đọc vào buffer, có '\0' ở cuối
+    const char *small = "{\"test_cases\": []}\n";
+    write_file(TEST_FILE, small, strlen(small));
+    file_view_t view;
+    if (file_view_open(TEST_FILE, &view) == 0 && !view.mapped && view.size == strlen(small) &&
+        memcmp(view.data, small, view.size) == 0 && view.data[view.size] == '\0') {
+        printf("   ✓ File nhỏ được đọc vào buffer\n");
+    } else {
+        printf("   ✗ View của file nhỏ sai\n");
+    }
+    file_view_release(&view);
+    file_view_release(&view);
+    
+    // File lớn: map thẳng, nội dung giống read_file
+    size_t big_size = FILE_VIEW_MMAP_MIN * 4 + 123;
+    char *big = (char *)malloc(big_size);
+    for (size_t i = 0; i < big_size; i++) {
+        big[i] = (char)('a' + i % 26);
+    }
+    write_file(TEST_FILE, big, big_size);
+    if (file_view_open(TEST_FILE, &view) == 0 && view.mapped && view.size == big_size &&
+        memcmp(view.data, big, big_size) == 0) {
+        printf("   ✓ File lớn được map, nội dung đúng\n");
+    } else {
+        printf("   ✗ View của file lớn sai\n");
+    }
+    file_view_release(&view);
+    free(big);
+    
+    // procfs báo kích thước 0 nhưng có nội dung: đọc tuần tự đến EOF
+    char *buffer = NULL;
+    size_t size = 0;
+    if (file_view_open("/proc/self/status", &view) == 0 && !view.mapped && view.size > 0 &&
+        strstr(view.data, "Pid:") && read_file("/proc/self/status", &buffer, &size) == 0 && size > 0) {
+        printf("   ✓ File procfs được đọc đủ (%lu byte)\n", (unsigned long)view.size);
+    } else {
+        printf("   ✗ Không đọc được file procfs\n");
+    }
+    file_view_release(&view);
+    free(buffer);
+    
+    if (file_view_open("file_khong_ton_tai.txt", &view) != 0 && view.data == NULL) {
+        printf("   ✓ File không tồn tại bị từ chối\n");
+    } else {
+        printf("   ✗ Mở được view của file không tồn tại\n");
+    }
+    
+    // FILE_VIEW_COPY: file lớn vẫn được chép vào buffer, cắt ngắn file sau đó không ảnh hưởng view
+    size_t copy_size = FILE_VIEW_MMAP_MIN * 2;
+    write_pattern_file(TEST_FILE, copy_size);
+    if (file_view_open_ex(TEST_FILE, &view, FILE_VIEW_COPY) == 0 && !view.mapped && view.size == copy_size) {
+        unsigned long before = checksum(view.data, view.size);
+        write_file(TEST_FILE, "", 0);
+        if (checksum(view.data, view.size) == before) {
+            printf("   ✓ FILE_VIEW_COPY không map file lớn, view còn nguyên sau khi file bị cắt ngắn\n");
+        } else {
+            printf("   ✗ View đổi nội dung sau khi file bị cắt ngắn\n");
+        }
+    } else {
+        printf("   ✗ FILE_VIEW_COPY vẫn map file hoặc đọc sai\n");
+    }
+    file_view_release(&view);
+    
+    delete_file(TEST_FILE);
+    printf("=> Kiểm tra file_view hoàn tất.\n");
+}
+
+/**
+ * @brief So sánh file_view với read_file trên file 256 MB (chỉ chạy với --bench)
+ */
+void bench_file_view() {
+    printf("\n--- Đo tốc độ file_view ---\n");
+    size_t bench_size = 256UL * 1024 * 1024;
+    write_pattern_file(TEST_FILE, bench_size);
+    
+    // File đã nằm trong page cache sau khi ghi
+    char *buffer = NULL;
+    size_t size = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned long read_sum = 0;
+    if (read_file(TEST_FILE, &buffer, &size) == 0) {
+        read_sum = checksum(buffer, size);
+        free(buffer);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double read_ms = elapsed_ms(&start, &end);
+    
+    file_view_t view;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned long view_sum = 0;
+    if (file_view_open(TEST_FILE, &view) == 0) {
+        view_sum = checksum(view.data, view.size);
+        file_view_release(&view);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double view_ms = elapsed_ms(&start, &end);
+    
+    printf("   File %lu MB: read_file %.0f ms, file_view %.0f ms%s\n", (unsigned long)(bench_size >> 20),
+           read_ms, view_ms, read_sum == view_sum ? "" : " (nội dung khác nhau)");
+    delete_file(TEST_FILE);
+}
+
+/**
+ * @brief Cách sao chép cũ (fread/fwrite qua buffer 4 KB trên stack), làm mốc so sánh
+ */
+static int copy_stdio_4k(const char *src_path, const char *dest_path) {
+    FILE *src = fopen(src_path, "rb");
+    FILE *dest = src ? fopen(dest_path, "wb") : NULL;
+    int ret = src && dest ? 0 : -1;
+    char buffer[4096];
+    size_t n;
+    while (ret == 0 && (n = fread(buffer, 1, sizeof(buffer), src)) > 0) {
+        if (fwrite(buffer, 1, n, dest) != n) {
+            ret = -1;
+        }
+    }
+    if (src) {
+        fclose(src);
+    }
+    if (dest) {
+        fclose(dest);
+    }
+    return ret;
+}
+
+/**
+ * @brief Kiểm tra giữ mode/mtime, file procfs và nội dung bản sao của file nhiều MB
+ */
+void test_copy_file_kernel() {
+    printf("\n--- Kiểm tra sao chép file trong kernel ---\n");
+    
+    // Giữ mode và mtime
+    const char *content = "preserve me\n";
+    write_file(TEST_FILE, content, strlen(content));
+    chmod(TEST_FILE, 0640);
+    struct timespec times[2] = { { 1000000000, 0 }, { 1234567890, 123456789 } };
+    utimensat(AT_FDCWD, TEST_FILE, times, 0);
+    write_file(TEST_FILE_COPY, "old content that is longer\n", 27);
+    chmod(TEST_FILE_COPY, 0600);
+    
+    struct stat src_st, dest_st;
+    char *buffer = NULL;
+    size_t size = 0;
+    if (copy_file_ex(TEST_FILE, TEST_FILE_COPY, COPY_FILE_PRESERVE_MODE | COPY_FILE_PRESERVE_TIMES) == 0 &&
+        stat(TEST_FILE, &src_st) == 0 && stat(TEST_FILE_COPY, &dest_st) == 0 &&
+        (dest_st.st_mode & 07777) == 0640 && dest_st.st_mtim.tv_sec == src_st.st_mtim.tv_sec &&
+        dest_st.st_mtim.tv_nsec == src_st.st_mtim.tv_nsec &&
+        read_file(TEST_FILE_COPY, &buffer, &size) == 0 && size == strlen(content) &&
+        memcmp(buffer, content, size) == 0) {
+        printf("   ✓ Giữ mode 0640 và mtime, file đích cũ bị ghi đè hoàn toàn\n");
+    } else {
+        printf("   ✗ Không giữ được mode/mtime hoặc nội dung sai\n");
+    }
+    free(buffer);
+    buffer = NULL;
+    
+    if (copy_file(TEST_FILE, TEST_FILE) != 0 && get_file_size(TEST_FILE) == (long)strlen(content)) {
+        printf("   ✓ Sao chép file lên chính nó bị từ chối, nội dung còn nguyên\n");
+    } else {
+        printf("   ✗ Sao chép file lên chính nó làm hỏng file\n");
+    }
+    
+    // procfs báo kích thước 0: vẫn phải sao chép đủ nội dung
+    if (copy_file("/proc/self/status", TEST_FILE_COPY) == 0 &&
+        read_file(TEST_FILE_COPY, &buffer, &size) == 0 && size > 0 && strstr(buffer, "Pid:")) {
+        printf("   ✓ File procfs được sao chép đủ (%lu byte)\n", (unsigned long)size);
+    } else {
+        printf("   ✗ Sao chép file procfs bị thiếu nội dung\n");
+    }
+    free(buffer);
+    
+    // File vài MB: bản sao giống hệt file nguồn
+    size_t big_size = 4UL * 1024 * 1024 + 123;
+    write_pattern_file(TEST_FILE, big_size);
+    file_view_t src_view, dest_view;
+    if (copy_file(TEST_FILE, TEST_FILE_COPY) == 0 && file_view_open(TEST_FILE, &src_view) == 0) {
+        if (file_view_open(TEST_FILE_COPY, &dest_view) == 0) {
+            if (dest_view.size == big_size && memcmp(src_view.data, dest_view.data, big_size) == 0) {
+                printf("   ✓ Bản sao %lu byte giống hệt file nguồn\n", (unsigned long)big_size);
+            } else {
+                printf("   ✗ Bản sao khác file nguồn\n");
+            }
+            file_view_release(&dest_view);
+        } else {
+            printf("   ✗ Không mở được bản sao\n");
+        }
+        file_view_release(&src_view);
+    } else {
+        printf("   ✗ Sao chép file lớn thất bại\n");
+    }
+    
+    delete_file(TEST_FILE);
+    delete_file(TEST_FILE_COPY);
+    printf("=> Kiểm tra sao chép file trong kernel hoàn tất.\n");
+}
+
+/**
+ * @brief Đo tốc độ sao chép file 512 MB so với cách cũ (chỉ chạy với --bench)
+ */
+void bench_copy_file() {
+    printf("\n--- Đo tốc độ sao chép file ---\n");
+    size_t bench_size = 512UL * 1024 * 1024;
+    write_pattern_file(TEST_FILE, bench_size);
+    
+    // File nguồn đã nằm trong page cache sau khi ghi
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int stdio_ret = copy_stdio_4k(TEST_FILE, TEST_FILE_COPY);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double stdio_ms = elapsed_ms(&start, &end);
+    delete_file(TEST_FILE_COPY);
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int kernel_ret = copy_file(TEST_FILE, TEST_FILE_COPY);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double kernel_ms = elapsed_ms(&start, &end);
+    
+    double mb = (double)(bench_size >> 20);
+    if (stdio_ret == 0 && kernel_ret == 0) {
+        printf("   File %.0f MB: fread/fwrite 4 KB %.0f ms (%.0f MB/s), copy_file %.0f ms (%.0f MB/s)\n",
+               mb, stdio_ms, mb * 1000 / stdio_ms, kernel_ms, mb * 1000 / kernel_ms);
+    } else {
+        printf("   Sao chép file %.0f MB thất bại\n", mb);
+    }
+    
+    delete_file(TEST_FILE);
+    delete_file(TEST_FILE_COPY);
+}
+
 /**
  * @brief Kiểm tra xử lý lỗi
  */
@@ -466,7 +740,10 @@ void test_error_handling() {
     printf("=> Kiểm tra xử lý lỗi hoàn tất.\n");
 }
 
-int main() {
+int main(int argc, char **argv) {
+    // --bench: đo thêm tốc độ trên file hàng trăm MB (không chạy mặc định)
+    bool bench = argc > 1 && strcmp(argv[1], "--bench") == 0;
+    
     printf("\n=================================================\n");
     printf("      KIỂM THỬ MODULE FILE_PROCESS.C\n");
     printf("=================================================\n");
@@ -478,8 +755,15 @@ int main() {
     test_directory_operations();
     test_temp_file();
     test_read_file_chunk();
+    test_file_view();
+    test_copy_file_kernel();
     test_error_handling();
     
+    if (bench) {
+        bench_file_view();
+        bench_copy_file();
+    }
+    
     printf("\n=================================================\n");
     printf("      HOÀN TẤT KIỂM THỬ FILE_PROCESS.C\n");
     printf("=================================================\n");
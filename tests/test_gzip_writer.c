@@ -0,0 +1,275 @@
+/**
+ * @file test_gzip_writer.c
+ * @brief Kiểm thử bộ ghi gzip dạng luồng, báo cáo nén và xoay vòng log
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <zlib.h>
+ #include "gzip_writer.h"
+ #include "tc.h"
+ #include "file_process.h"
+ #include "log.h"
+ #include "cjson/cJSON.h"
+
+ #define TEST_GZ_FILE "test_gzip_writer.gz"
+ #define TEST_SRC_FILE "test_gzip_writer.txt"
+ #define TEST_REPORT_FILE "test_gzip_report.json.gz"
+ #define TEST_LOG_FILE "test_gzip_writer.log"
+
+ /**
+  * @brief Giải nén toàn bộ file gzip bằng zlib (gzread)
+  */
+ static char *gunzip_file(const char *path, size_t *size) {
+     gzFile in = gzopen(path, "rb");
+     if (!in) {
+         return NULL;
+     }
+
+     size_t capacity = 1 << 16, used = 0;
+     char *data = (char *)malloc(capacity + 1);
+     int n;
+     while (data && (n = gzread(in, data + used, (unsigned)(capacity - used))) > 0) {
+         used += (size_t)n;
+         if (used == capacity) {
+             capacity *= 2;
+             char *grown = (char *)realloc(data, capacity + 1);
+             if (!grown) {
+                 free(data);
+             }
+             data = grown;
+         }
+     }
+     int err = 0;
+     gzerror(in, &err);
+     gzclose(in);
+     if (!data || err != Z_OK) {
+         free(data);
+         return NULL;
+     }
+     data[used] = '\0';
+     *size = used;
+     return data;
+ }
+
+ /**
+  * @brief Kiểm tra ghi nhiều khối và giải nén lại đúng dữ liệu
+  */
+ void test_stream_roundtrip() {
+     printf("\n--- Kiểm tra nén dạng luồng ---\n");
+
+     gzip_writer_t *gz = (gzip_writer_t *)malloc(sizeof(gzip_writer_t));
+     if (!gz || gzip_writer_open(gz, TEST_GZ_FILE, GZIP_DEFAULT_LEVEL) != 0) {
+         printf("   ✗ Không mở được bộ ghi gzip\n");
+         free(gz);
+         return;
+     }
+
+     // 8MB dữ liệu dạng log, ghi theo khối nhỏ lẻ để qua nhiều lần deflate
+     const size_t total = 8u << 20;
+     char line[96];
+     size_t written = 0;
+     unsigned long crc = crc32(0L, Z_NULL, 0);
+     for (int i = 0; written < total; i++) {
+         int len = snprintf(line, sizeof(line), "[2026-01-01 00:00:00] DEBUG: Test %d finished in %d ms\n", i, i % 997);
+         if (gzip_writer_write(gz, line, (size_t)len) != 0) {
+             break;
+         }
+         crc = crc32(crc, (const Bytef *)line, (uInt)len);
+         written += (size_t)len;
+     }
+     uint64_t bytes_in = gz->bytes_in;
+     int closed = gzip_writer_close(gz);
+     uint64_t bytes_out = gz->bytes_out;
+     free(gz);
+
+     if (closed == 0 && bytes_in == written) {
+         printf("   ✓ Ghi %zu byte thành công\n", written);
+     } else {
+         printf("   ✗ Ghi dữ liệu thất bại\n");
+     }
+
+     long file_size = get_file_size(TEST_GZ_FILE);
+     if (file_size > 0 && (uint64_t)file_size == bytes_out && bytes_out * 5 < bytes_in) {
+         printf("   ✓ Tỷ lệ nén %.1fx (%ld byte)\n", (double)bytes_in / bytes_out, file_size);
+     } else {
+         printf("   ✗ Kích thước file nén bất thường (%ld byte)\n", file_size);
+     }
+
+     size_t size = 0;
+     char *data = gunzip_file(TEST_GZ_FILE, &size);
+     if (data && size == written && crc32(crc32(0L, Z_NULL, 0), (const Bytef *)data, (uInt)size) == crc) {
+         printf("   ✓ Giải nén bằng zlib khớp dữ liệu gốc\n");
+     } else {
+         printf("   ✗ Dữ liệu giải nén không khớp\n");
+     }
+     free(data);
+ }
+
+ /**
+  * @brief Kiểm tra nén file theo khối và giới hạn mức nén
+  */
+ void test_compress_file() {
+     printf("\n--- Kiểm tra nén file ---\n");
+
+     const char *content = "line one\nline two\nline three\n";
+     write_file(TEST_SRC_FILE, content, strlen(content));
+
+     size_t size = 0;
+     char *data = NULL;
+     if (gzip_compress_file(TEST_SRC_FILE, TEST_GZ_FILE, 99) == 0 &&
+         (data = gunzip_file(TEST_GZ_FILE, &size)) != NULL && strcmp(data, content) == 0) {
+         printf("   ✓ Nén file (mức nén ngoài khoảng được giới hạn) và giải nén khớp\n");
+     } else {
+         printf("   ✗ Nén file thất bại\n");
+     }
+     free(data);
+
+     write_file(TEST_SRC_FILE, "", 0);
+     data = NULL;
+     if (gzip_compress_file(TEST_SRC_FILE, TEST_GZ_FILE, 1) == 0 &&
+         (data = gunzip_file(TEST_GZ_FILE, &size)) != NULL && size == 0) {
+         printf("   ✓ File rỗng tạo ra file gzip hợp lệ\n");
+     } else {
+         printf("   ✗ Nén file rỗng thất bại\n");
+     }
+     free(data);
+
+     if (gzip_compress_file("khong_ton_tai.txt", TEST_GZ_FILE, 6) == -1) {
+         printf("   ✓ File nguồn không tồn tại báo lỗi\n");
+     } else {
+         printf("   ✗ File nguồn không tồn tại không báo lỗi\n");
+     }
+     delete_file(TEST_SRC_FILE);
+ }
+
+ /**
+  * @brief Kiểm tra báo cáo tổng hợp nén gzip
+  */
+ void test_compressed_report() {
+     printf("\n--- Kiểm tra báo cáo nén gzip ---\n");
+
+     int count = 2000;
+     test_result_info_t *results = (test_result_info_t *)calloc(count, sizeof(test_result_info_t));
+     if (!results) {
+         printf("   ✗ Không cấp phát được kết quả\n");
+         return;
+     }
+     for (int i = 0; i < count; i++) {
+         snprintf(results[i].test_id, sizeof(results[i].test_id), "T%d", i);
+         results[i].test_type = TEST_PING;
+         results[i].status = i % 10 ? TEST_RESULT_SUCCESS : TEST_RESULT_FAILED;
+         results[i].execution_time = 10.5f;
+         results[i].data.ping.packets_sent = 4;
+         results[i].data.ping.packets_received = 4;
+         results[i].data.ping.avg_rtt = 1.25f;
+         char host[32];
+         snprintf(host, sizeof(host), "host-%d", i % 64);
+         results[i].reason = RESULT_REASON_PING_DONE;
+         results[i].target = test_result_intern(host);
+     }
+
+     if (generate_summary_report_gz(results, count, TEST_REPORT_FILE, GZIP_DEFAULT_LEVEL) != 0) {
+         printf("   ✗ Tạo báo cáo nén thất bại\n");
+         free(results);
+         return;
+     }
+
+     size_t size = 0;
+     char *data = gunzip_file(TEST_REPORT_FILE, &size);
+     cJSON *root = data ? cJSON_Parse(data) : NULL;
+     cJSON *summary = root ? cJSON_GetObjectItem(root, "summary") : NULL;
+     cJSON *list = root ? cJSON_GetObjectItem(root, "test_results") : NULL;
+     if (summary && cJSON_GetObjectItem(summary, "total")->valueint == count &&
+         cJSON_GetObjectItem(summary, "failed")->valueint == count / 10 &&
+         cJSON_GetArraySize(list) == count) {
+         printf("   ✓ Báo cáo giải nén là JSON hợp lệ với %d kết quả\n", count);
+     } else {
+         printf("   ✗ Nội dung báo cáo nén sai\n");
+     }
+
+     long compressed = get_file_size(TEST_REPORT_FILE);
+     if (compressed > 0 && (size_t)compressed * 5 < size) {
+         printf("   ✓ Báo cáo %zu byte nén còn %ld byte\n", size, compressed);
+     } else {
+         printf("   ✗ Báo cáo nén không nhỏ hơn đáng kể (%ld / %zu byte)\n", compressed, size);
+     }
+
+     cJSON_Delete(root);
+     free(data);
+     free(results);
+     delete_file(TEST_REPORT_FILE);
+ }
+
+ /**
+  * @brief Kiểm tra xoay vòng log kèm nén
+  */
+ void test_rotate_log() {
+     printf("\n--- Kiểm tra xoay vòng log ---\n");
+
+     log_message(LOG_LVL_DEBUG, "line before rotation");
+     if (rotate_log_file(GZIP_DEFAULT_LEVEL) != 0) {
+         printf("   ✗ Xoay vòng log thất bại\n");
+         return;
+     }
+     log_message(LOG_LVL_DEBUG, "line after rotation");
+
+     // Tìm file lưu trữ <log>.<timestamp>.gz
+     char command[256];
+     snprintf(command, sizeof(command), "ls %s.*.gz 2>/dev/null", TEST_LOG_FILE);
+     FILE *ls = popen(command, "r");
+     char archive[256] = "";
+     if (ls) {
+         if (fgets(archive, sizeof(archive), ls)) {
+             archive[strcspn(archive, "\n")] = '\0';
+         }
+         pclose(ls);
+     }
+
+     size_t size = 0;
+     char *data = archive[0] ? gunzip_file(archive, &size) : NULL;
+     if (data && strstr(data, "line before rotation") && !strstr(data, "line after rotation")) {
+         printf("   ✓ Log cũ được nén thành %s\n", archive);
+     } else {
+         printf("   ✗ Không tìm thấy log cũ đã nén\n");
+     }
+     free(data);
+
+     char *current = NULL;
+     if (read_file(TEST_LOG_FILE, &current, &size) == 0 && strstr(current, "line after rotation") &&
+         !strstr(current, "line before rotation")) {
+         printf("   ✓ Log mới chỉ chứa dòng ghi sau khi xoay vòng\n");
+     } else {
+         printf("   ✗ Log mới không đúng\n");
+     }
+     free(current);
+
+     if (archive[0]) {
+         delete_file(archive);
+     }
+ }
+
+ int main() {
+     printf("\n=================================================\n");
+     printf("      KIỂM THỬ MODULE GZIP_WRITER.C\n");
+     printf("=================================================\n");
+
+     set_log_file(TEST_LOG_FILE);
+     set_log_level(LOG_LVL_DEBUG);
+     init_logger();
+
+     test_stream_roundtrip();
+     test_compress_file();
+     test_compressed_report();
+     test_rotate_log();
+
+     delete_file(TEST_GZ_FILE);
+     delete_file(TEST_LOG_FILE);
+
+     printf("\n=================================================\n");
+     printf("      HOÀN TẤT KIỂM THỬ GZIP_WRITER.C\n");
+     printf("=================================================\n");
+
+     return 0;
+ }
@@ -0,0 +1,410 @@
+/**
+ * @file test_json_writer.c
+ * @brief Kiểm thử bộ ghi JSON dạng luồng
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include "json_writer.h"
+ #include "parser_data.h"
+ #include "tc.h"
+ #include "file_process.h"
+ #include "log.h"
+ #include "cjson/cJSON.h"
+
+ #define TEST_OUTPUT_FILE "test_json_writer_output.json"
+ #define BENCH_CASES 10000
+ #define BENCH_ROUNDS 5
+
+ static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+     return (end->tv_sec - start->tv_sec) * 1000.0 + (end->tv_nsec - start->tv_nsec) / 1e6;
+ }
+
+ /**
+  * @brief Kiểm tra escape ký tự đặc biệt và ký tự điều khiển
+  */
+ void test_escaping() {
+     printf("\n--- Kiểm tra escape chuỗi ---\n");
+
+     json_writer_t writer;
+     json_writer_init_buffer(&writer, 0);
+     json_writer_begin_array(&writer);
+     json_writer_string(&writer, "quote\" backslash\\ slash/");
+     json_writer_string(&writer, "tab\t nl\n cr\r bs\b ff\f");
+     json_writer_string_n(&writer, "nul\0x\x01\x1f", 7);
+     json_writer_string(&writer, "tiếng Việt");
+     json_writer_string(&writer, NULL);
+     json_writer_end_array(&writer);
+
+     const char *expected = "[\"quote\\\" backslash\\\\ slash/\","
+                            "\"tab\\t nl\\n cr\\r bs\\b ff\\f\","
+                            "\"nul\\u0000x\\u0001\\u001f\","
+                            "\"tiếng Việt\",null]";
+     if (json_writer_finish(&writer) == 0 && strcmp(writer.data, expected) == 0) {
+         printf("   ✓ Escape đúng theo RFC 8259, UTF-8 được giữ nguyên\n");
+     } else {
+         printf("   ✗ Escape sai: %s\n", writer.data);
+     }
+     json_writer_free(&writer);
+ }
+
+ /**
+  * @brief Kiểm tra lồng object/array, dấu phẩy và các kiểu giá trị
+  */
+ void test_nesting_and_values() {
+     printf("\n--- Kiểm tra lồng nhau và kiểu giá trị ---\n");
+
+     json_writer_t writer;
+     json_writer_init_buffer(&writer, 8);  // buffer nhỏ để buộc mở rộng nhiều lần
+     json_writer_begin_object(&writer);
+     json_writer_field_int(&writer, "i", -42);
+     json_writer_field_double(&writer, "d", 1.5);
+     json_writer_field_double(&writer, "whole", 3.0);
+     json_writer_field_float(&writer, "f", 0.015f);
+     json_writer_field_double(&writer, "nan", 0.0 / 0.0);
+     json_writer_field_bool(&writer, "b", false);
+     json_writer_key(&writer, "empty");
+     json_writer_begin_array(&writer);
+     json_writer_end_array(&writer);
+     json_writer_key(&writer, "nested");
+     json_writer_begin_array(&writer);
+     json_writer_begin_object(&writer);
+     json_writer_end_object(&writer);
+     json_writer_int(&writer, 1);
+     json_writer_null(&writer);
+     json_writer_raw(&writer, "{\"r\":1}", 7);
+     json_writer_end_array(&writer);
+     json_writer_end_object(&writer);
+
+     const char *expected = "{\"i\":-42,\"d\":1.5,\"whole\":3,\"f\":0.015,\"nan\":null,\"b\":false,"
+                            "\"empty\":[],\"nested\":[{},1,null,{\"r\":1}]}";
+     size_t len = 0;
+     if (json_writer_finish(&writer) == 0) {
+         char *json = json_writer_release(&writer, &len);
+         if (json && strcmp(json, expected) == 0 && len == strlen(expected)) {
+             printf("   ✓ Dấu phẩy, lồng nhau và kiểu giá trị chính xác\n");
+         } else {
+             printf("   ✗ Kết quả không đúng: %s\n", json ? json : "(null)");
+         }
+         free(json);
+     } else {
+         printf("   ✗ json_writer_finish báo lỗi\n");
+     }
+     json_writer_free(&writer);
+
+     printf("2. Kiểm tra container chưa đóng...\n");
+     json_writer_init_buffer(&writer, 0);
+     json_writer_begin_object(&writer);
+     if (json_writer_finish(&writer) == -1) {
+         printf("   ✓ Báo lỗi khi còn object chưa đóng\n");
+     } else {
+         printf("   ✗ Không phát hiện object chưa đóng\n");
+     }
+     json_writer_free(&writer);
+ }
+
+ /**
+  * @brief Kiểm tra buffer cố định: vừa đủ và tràn
+  */
+ void test_fixed_buffer() {
+     printf("\n--- Kiểm tra buffer cố định ---\n");
+
+     char buffer[16];
+     json_writer_t writer;
+
+     // {"a":"1234567"} dài 15 byte, cộng '\0' vừa đủ 16
+     json_writer_init_fixed(&writer, buffer, sizeof(buffer));
+     json_writer_begin_object(&writer);
+     json_writer_field_string(&writer, "a", "1234567");
+     json_writer_end_object(&writer);
+     if (json_writer_finish(&writer) == 0 && strcmp(buffer, "{\"a\":\"1234567\"}") == 0) {
+         printf("   ✓ Ghi vừa khít buffer cố định\n");
+     } else {
+         printf("   ✗ Ghi vào buffer cố định sai\n");
+     }
+
+     json_writer_init_fixed(&writer, buffer, sizeof(buffer));
+     json_writer_begin_object(&writer);
+     json_writer_field_string(&writer, "a", "12345678");
+     json_writer_end_object(&writer);
+     if (json_writer_finish(&writer) == -1 && strlen(buffer) < sizeof(buffer)) {
+         printf("   ✓ Báo lỗi khi tràn buffer, không ghi quá kích thước\n");
+     } else {
+         printf("   ✗ Không phát hiện tràn buffer\n");
+     }
+ }
+
+ /**
+  * @brief Kiểm tra ghi ra FILE* và fd với dữ liệu lớn hơn buffer trung gian
+  */
+ void test_file_output() {
+     printf("\n--- Kiểm tra ghi ra FILE* và fd ---\n");
+
+     // Chuỗi dài hơn JSON_WRITER_STAGING_SIZE để kiểm tra token vượt buffer trung gian
+     size_t big_len = JSON_WRITER_STAGING_SIZE + 100;
+     char *big = (char *)malloc(big_len + 1);
+     memset(big, 'x', big_len);
+     big[big_len] = '\0';
+
+     for (int mode = 0; mode < 2; mode++) {
+         json_writer_t writer;
+         FILE *file = NULL;
+         int fd = -1;
+         if (mode == 0) {
+             file = fopen(TEST_OUTPUT_FILE, "w");
+             json_writer_init_file(&writer, file);
+         } else {
+             fd = open(TEST_OUTPUT_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+             json_writer_init_fd(&writer, fd);
+         }
+
+         json_writer_begin_array(&writer);
+         for (int i = 0; i < 20000; i++) {
+             json_writer_int(&writer, i);
+         }
+         json_writer_string(&writer, big);
+         json_writer_end_array(&writer);
+         int rc = json_writer_finish(&writer);
+         size_t written = writer.flushed;
+         json_writer_free(&writer);
+         if (file) {
+             fclose(file);
+         }
+         if (fd >= 0) {
+             close(fd);
+         }
+
+         char *content = NULL;
+         size_t size = 0;
+         bool ok = rc == 0 && read_file(TEST_OUTPUT_FILE, &content, &size) == 0 && size == written;
+         if (ok) {
+             cJSON *root = cJSON_Parse(content);
+             ok = root && cJSON_GetArraySize(root) == 20001 &&
+                  strlen(cJSON_GetArrayItem(root, 20000)->valuestring) == big_len;
+             cJSON_Delete(root);
+         }
+         free(content);
+
+         if (ok) {
+             printf("   ✓ Ghi ra %s thành công (%zu bytes), cJSON đọc lại được\n", mode == 0 ? "FILE*" : "fd", written);
+         } else {
+             printf("   ✗ Ghi ra %s thất bại\n", mode == 0 ? "FILE*" : "fd");
+         }
+     }
+
+     free(big);
+     delete_file(TEST_OUTPUT_FILE);
+ }
+
+ /**
+  * @brief Kiểm tra test_case_to_json, test_cases_to_json và test_result_to_json
+  */
+ void test_serialisers() {
+     printf("\n--- Kiểm tra các hàm chuyển đổi sang JSON ---\n");
+
+     const char *config = "{\"test_cases\": ["
+                          "{\"id\": \"J1\", \"name\": \"Quote \\\" and \\\\\", \"type\": \"throughput\","
+                          " \"target\": \"10.0.0.1\", \"throughput_params\": {\"duration\": 5, \"protocol\": \"UDP\", \"port\": 5201}},"
+                          "{\"id\": \"J2\", \"name\": \"Extra\", \"type\": \"other\", \"extra_data\": {\"k\": [1, 2]}}"
+                          "]}";
+     test_case_t *cases = NULL;
+     int count = 0;
+     if (!parse_json_content(config, &cases, &count) || count != 2) {
+         printf("   ✗ Không phân tích được cấu hình mẫu\n");
+         return;
+     }
+
+     char buffer[1024];
+     if (test_case_to_json(&cases[0], buffer, sizeof(buffer))) {
+         cJSON *root = cJSON_Parse(buffer);
+         cJSON *params = root ? cJSON_GetObjectItem(root, "throughput_params") : NULL;
+         if (root && strcmp(cJSON_GetObjectItem(root, "name")->valuestring, "Quote \" and \\") == 0 &&
+             params && strcmp(cJSON_GetObjectItem(params, "protocol")->valuestring, "UDP") == 0) {
+             printf("   ✓ test_case_to_json tạo JSON hợp lệ và escape đúng\n");
+         } else {
+             printf("   ✗ test_case_to_json tạo JSON sai: %s\n", buffer);
+         }
+         cJSON_Delete(root);
+     } else {
+         printf("   ✗ test_case_to_json thất bại\n");
+     }
+
+     if (test_cases_to_json(cases, count, buffer, sizeof(buffer))) {
+         test_case_t *cases2 = NULL;
+         int count2 = 0;
+         if (parse_json_content(buffer, &cases2, &count2) && count2 == 2 &&
+             test_case_hash(&cases[0]) == test_case_hash(&cases2[0]) &&
+             test_case_hash(&cases[1]) == test_case_hash(&cases2[1])) {
+             printf("   ✓ test_cases_to_json giữ nguyên dữ liệu khi đọc lại (kể cả extra_data)\n");
+         } else {
+             printf("   ✗ Dữ liệu khác sau khi đọc lại: %s\n", buffer);
+         }
+         free_test_cases(cases2, count2);
+     } else {
+         printf("   ✗ test_cases_to_json thất bại\n");
+     }
+
+     if (!test_cases_to_json(cases, count, buffer, 32)) {
+         printf("   ✓ test_cases_to_json báo lỗi khi buffer quá nhỏ\n");
+     } else {
+         printf("   ✗ test_cases_to_json không báo lỗi khi buffer quá nhỏ\n");
+     }
+     free_test_cases(cases, count);
+
+     test_result_info_t result;
+     memset(&result, 0, sizeof(result));
+     strcpy(result.test_id, "R1");
+     result.test_type = TEST_PING;
+     result.status = TEST_RESULT_FAILED;
+     result.execution_time = 12.5f;
+     test_result_set_details(&result, "Line 1\nHost \"gw\" down");
+     result.data.ping.packets_sent = 4;
+     result.data.ping.packet_loss = 100.0f;
+     if (test_result_to_json(&result, buffer, sizeof(buffer)) == 0) {
+         cJSON *root = cJSON_Parse(buffer);
+         cJSON *ping = root ? cJSON_GetObjectItem(root, "ping") : NULL;
+         if (root && strcmp(cJSON_GetObjectItem(root, "status")->valuestring, "FAILED") == 0 &&
+             strcmp(cJSON_GetObjectItem(root, "details")->valuestring, "Line 1\nHost \"gw\" down") == 0 &&
+             ping && cJSON_GetObjectItem(ping, "packets_sent")->valueint == 4 &&
+             !cJSON_GetObjectItem(ping, "avg_rtt_ms")) {
+             printf("   ✓ test_result_to_json tạo JSON hợp lệ, không có RTT khi mất hết gói\n");
+         } else {
+             printf("   ✗ test_result_to_json tạo JSON sai: %s\n", buffer);
+         }
+         cJSON_Delete(root);
+     } else {
+         printf("   ✗ test_result_to_json thất bại\n");
+     }
+ }
+
+ /**
+  * @brief Dựng cây cJSON cho mảng test cases (cách làm cũ) để so sánh
+  */
+ static char *cjson_serialise(const test_case_t *cases, int count) {
+     cJSON *root = cJSON_CreateObject();
+     cJSON *array = cJSON_CreateArray();
+     cJSON_AddItemToObject(root, "test_cases", array);
+     for (int i = 0; i < count; i++) {
+         const test_case_t *tc = &cases[i];
+         cJSON *item = cJSON_CreateObject();
+         cJSON_AddStringToObject(item, "id", test_case_id(tc));
+         cJSON_AddStringToObject(item, "name", test_case_name(tc));
+         cJSON_AddStringToObject(item, "description", test_case_description(tc));
+         cJSON_AddStringToObject(item, "target", test_case_target(tc));
+         cJSON_AddNumberToObject(item, "timeout", tc->timeout);
+         cJSON_AddBoolToObject(item, "enabled", tc->enabled);
+         cJSON_AddStringToObject(item, "type", "ping");
+         cJSON *params = cJSON_CreateObject();
+         cJSON_AddNumberToObject(params, "count", tc->params.ping.count);
+         cJSON_AddNumberToObject(params, "size", tc->params.ping.size);
+         cJSON_AddNumberToObject(params, "interval", tc->params.ping.interval);
+         cJSON_AddBoolToObject(params, "ipv6", tc->params.ping.ipv6);
+         cJSON_AddItemToObject(item, "ping_params", params);
+         cJSON_AddStringToObject(item, "network", "LAN");
+         cJSON_AddItemToArray(array, item);
+     }
+     char *json = cJSON_PrintUnformatted(root);
+     cJSON_Delete(root);
+     return json;
+ }
+
+ /**
+  * @brief So sánh tốc độ giữa writer dạng luồng và cây cJSON
+  */
+ void test_benchmark() {
+     printf("\n--- Benchmark: json_writer so với cJSON (%d test cases) ---\n", BENCH_CASES);
+
+     // Dựng cấu hình mẫu rồi phân tích để có mảng test cases thật
+     json_writer_t config;
+     json_writer_init_buffer(&config, 0);
+     json_writer_begin_object(&config);
+     json_writer_key(&config, "test_cases");
+     json_writer_begin_array(&config);
+     for (int i = 0; i < BENCH_CASES; i++) {
+         char id[32], target[32];
+         snprintf(id, sizeof(id), "B%05d", i);
+         snprintf(target, sizeof(target), "10.%d.%d.%d", (i >> 16) & 255, (i >> 8) & 255, i & 255);
+         json_writer_begin_object(&config);
+         json_writer_field_string(&config, "id", id);
+         json_writer_field_string(&config, "name", "Benchmark ping");
+         json_writer_field_string(&config, "description", "Ping with \"quoted\" text");
+         json_writer_field_string(&config, "type", "ping");
+         json_writer_field_string(&config, "target", target);
+         json_writer_end_object(&config);
+     }
+     json_writer_end_array(&config);
+     json_writer_end_object(&config);
+     json_writer_finish(&config);
+
+     test_case_t *cases = NULL;
+     int count = 0;
+     if (!parse_json_content(config.data, &cases, &count) || count != BENCH_CASES) {
+         printf("   ✗ Không tạo được dữ liệu benchmark\n");
+         json_writer_free(&config);
+         return;
+     }
+     json_writer_free(&config);
+
+     struct timespec start, end;
+     double writer_ms = 0, cjson_ms = 0;
+     size_t writer_len = 0, cjson_len = 0;
+     bool ok = true;
+
+     for (int round = 0; round < BENCH_ROUNDS; round++) {
+         json_writer_t writer;
+         clock_gettime(CLOCK_MONOTONIC, &start);
+         json_writer_init_buffer(&writer, 0);
+         ok = ok && test_cases_write_json(&writer, cases, count) && json_writer_finish(&writer) == 0;
+         clock_gettime(CLOCK_MONOTONIC, &end);
+         writer_ms += elapsed_ms(&start, &end);
+         writer_len = writer.size;
+         json_writer_free(&writer);
+
+         clock_gettime(CLOCK_MONOTONIC, &start);
+         char *json = cjson_serialise(cases, count);
+         clock_gettime(CLOCK_MONOTONIC, &end);
+         cjson_ms += elapsed_ms(&start, &end);
+         cjson_len = json ? strlen(json) : 0;
+         free(json);
+     }
+
+     printf("   json_writer: %.2f ms/lần (%zu bytes)\n", writer_ms / BENCH_ROUNDS, writer_len);
+     printf("   cJSON:       %.2f ms/lần (%zu bytes)\n", cjson_ms / BENCH_ROUNDS, cjson_len);
+     if (ok && writer_len > 0) {
+         printf("   ✓ json_writer ghi %d test cases, thời gian cJSON / json_writer = %.1fx\n",
+                count, writer_ms > 0 ? cjson_ms / writer_ms : 0.0);
+     } else {
+         printf("   ✗ json_writer báo lỗi khi ghi dữ liệu benchmark\n");
+     }
+
+     free_test_cases(cases, count);
+ }
+
+ int main() {
+     printf("\n=================================================\n");
+     printf("      KIỂM THỬ MODULE JSON_WRITER.C\n");
+     printf("=================================================\n");
+
+     set_log_file("test_json_writer.log");
+     set_log_level(LOG_LVL_WARN);
+     init_logger();
+
+     test_escaping();
+     test_nesting_and_values();
+     test_fixed_buffer();
+     test_file_output();
+     test_serialisers();
+     test_benchmark();
+
+     delete_file("test_json_writer.log");
+
+     printf("\n=================================================\n");
+     printf("      HOÀN TẤT KIỂM THỬ JSON_WRITER.C\n");
+     printf("=================================================\n");
+
+     return 0;
+ }
@@ -6,9 +6,17 @@
  #include <stdio.h>
  #include <stdlib.h>
  #include <string.h>
+ #include <stdbool.h>
  #include <pthread.h>
  #include <unistd.h>
  #include <assert.h>
+ #include <time.h>
+ #include <dirent.h>
+ #include <sys/stat.h>
+ #include <zlib.h>
+ // Biên dịch file kiểm thử như bản release để kiểm tra LOG_DEBUG bị loại bỏ;
+ // các kiểm thử khác gọi log_message trực tiếp nên không bị ảnh hưởng
+ #define LOG_COMPILE_LEVEL 2
  #include "log.h"
  #include "file_process.h"
  
@@ -231,6 +239,87 @@
      return NULL;
  }
  
+ #define BENCH_LINES_PER_THREAD 5000
+ 
+ /**
+  * @brief Hàm chạy trong thread khi đo tốc độ ghi log
+  */
+ void* bench_log_function(void* arg) {
+     thread_data_t* data = (thread_data_t*)arg;
+     
+     for (int i = 0; i < data->message_count; i++) {
+         log_message(LOG_LVL_DEBUG, "Bench thread %d - line %d value %.3f", data->thread_id, i, i * 0.5);
+     }
+     
+     return NULL;
+ }
+ 
+ /**
+  * @brief Đo số dòng log/giây với số thread cho trước, trả về true nếu đủ số dòng
+  */
+ static bool bench_logging(int thread_count, bool async, double *lines_per_sec) {
+     if (file_exists(TEST_LOG_FILE)) {
+         delete_file(TEST_LOG_FILE);
+     }
+     // Bật sau khi xóa file để fd của luồng ghi trỏ vào file mới
+     if (async) {
+         log_async_start(LOG_ASYNC_SLOTS, LOG_OVERFLOW_BLOCK);
+     }
+     
+     pthread_t threads[8];
+     thread_data_t thread_data[8];
+     struct timespec start, end;
+     clock_gettime(CLOCK_MONOTONIC, &start);
+     for (int i = 0; i < thread_count; i++) {
+         thread_data[i].thread_id = i;
+         thread_data[i].message_count = BENCH_LINES_PER_THREAD;
+         pthread_create(&threads[i], NULL, bench_log_function, &thread_data[i]);
+     }
+     for (int i = 0; i < thread_count; i++) {
+         pthread_join(threads[i], NULL);
+     }
+     log_async_stop();
+     clock_gettime(CLOCK_MONOTONIC, &end);
+     
+     double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+     int total = thread_count * BENCH_LINES_PER_THREAD;
+     *lines_per_sec = elapsed > 0 ? total / elapsed : 0;
+     
+     char *log_content = NULL;
+     size_t content_size = 0;
+     int lines = 0;
+     if (read_file(TEST_LOG_FILE, &log_content, &content_size) == 0) {
+         for (const char *pos = strstr(log_content, "Bench thread"); pos; pos = strstr(pos + 1, "Bench thread")) {
+             lines++;
+         }
+         free(log_content);
+     }
+     return lines == total;
+ }
+ 
+ /**
+  * @brief In bảng số dòng log/giây theo số thread, ghi trực tiếp và bất đồng bộ
+  */
+ static void bench_logging_table(void) {
+     const int thread_counts[] = {1, 2, 4, 8};
+     bool complete = true;
+     
+     printf("   Số dòng log/giây (%d dòng mỗi thread):\n", BENCH_LINES_PER_THREAD);
+     printf("   Threads         Trực tiếp      Bất đồng bộ\n");
+     for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++) {
+         double sync_rate = 0, async_rate = 0;
+         complete &= bench_logging(thread_counts[i], false, &sync_rate);
+         complete &= bench_logging(thread_counts[i], true, &async_rate);
+         printf("   %-8d %16.0f %16.0f\n", thread_counts[i], sync_rate, async_rate);
+     }
+     
+     if (complete) {
+         printf("   ✓ Mọi dòng log trong phép đo đều được ghi\n");
+     } else {
+         printf("   ✗ Thiếu dòng log trong phép đo\n");
+     }
+ }
+ 
  /**
   * @brief Kiểm tra ghi log đa luồng
   */
@@ -314,6 +403,9 @@
                 printf("   ✗ Không thể đọc file log\n");
             }
             
+            printf("5. Đo tốc độ ghi log theo số thread...\n");
+            bench_logging_table();
+            
             printf("=> Kiểm tra ghi log đa luồng hoàn tất.\n");
         }
         
@@ -448,6 +540,635 @@
             printf("=> Kiểm tra đổi file log khi đang chạy hoàn tất.\n");
         }
         
+ /**
+  * @brief Đếm số lần xuất hiện của một chuỗi trong nội dung
+  */
+ static int count_occurrences(const char *content, const char *needle) {
+     int count = 0;
+     for (const char *pos = strstr(content, needle); pos; pos = strstr(pos + 1, needle)) {
+         count++;
+     }
+     return count;
+ }
+ 
+ /**
+  * @brief Hàm chạy trong thread khi ghi log bất đồng bộ (không delay)
+  */
+ void* async_log_function(void* arg) {
+     thread_data_t* data = (thread_data_t*)arg;
+     
+     for (int i = 0; i < data->message_count; i++) {
+         log_message(LOG_LVL_DEBUG, "Async thread %d - Message %d", data->thread_id, i);
+     }
+     
+     return NULL;
+ }
+ 
+ /**
+  * @brief Kiểm tra ghi log bất đồng bộ qua luồng nền
+  */
+ void test_async_logging() {
+     printf("\n--- Kiểm tra ghi log bất đồng bộ ---\n");
+     
+     if (file_exists(TEST_LOG_FILE)) {
+         delete_file(TEST_LOG_FILE);
+     }
+     
+     // Ring nhỏ với chính sách chờ: producer phải chờ luồng ghi nhưng không mất dòng nào
+     printf("1. Bật logger bất đồng bộ (64 dòng, chờ khi đầy)\n");
+     if (log_async_start(64, LOG_OVERFLOW_BLOCK) != 0) {
+         printf("   ✗ Không bật được logger bất đồng bộ\n");
+         return;
+     }
+     
+     const int per_thread = 500;
+     pthread_t threads[THREAD_COUNT];
+     thread_data_t thread_data[THREAD_COUNT];
+     for (int i = 0; i < THREAD_COUNT; i++) {
+         thread_data[i].thread_id = i;
+         thread_data[i].message_count = per_thread;
+         pthread_create(&threads[i], NULL, async_log_function, &thread_data[i]);
+     }
+     for (int i = 0; i < THREAD_COUNT; i++) {
+         pthread_join(threads[i], NULL);
+     }
+     log_flush();
+     
+     printf("2. Kiểm tra các dòng sau log_flush...\n");
+     char *log_content = NULL;
+     size_t content_size = 0;
+     if (read_file(TEST_LOG_FILE, &log_content, &content_size) == 0) {
+         // Mỗi thread: đủ số dòng và đúng thứ tự
+         bool ordered = true;
+         int total = 0;
+         char search_str[64];
+         for (int i = 0; i < THREAD_COUNT; i++) {
+             const char *pos = log_content;
+             for (int j = 0; j < per_thread; j++) {
+                 snprintf(search_str, sizeof(search_str), "Async thread %d - Message %d\n", i, j);
+                 const char *next = strstr(pos, search_str);
+                 if (!next) {
+                     ordered = false;
+                     break;
+                 }
+                 pos = next + strlen(search_str);
+                 total++;
+             }
+         }
+         if (ordered && total == THREAD_COUNT * per_thread &&
+             count_occurrences(log_content, "DEBUG: Async thread") == total) {
+             printf("   ✓ Đủ %d dòng, đúng thứ tự trong từng thread\n", total);
+         } else {
+             printf("   ✗ Thiếu hoặc sai thứ tự (%d/%d dòng)\n", total, THREAD_COUNT * per_thread);
+         }
+         free(log_content);
+     } else {
+         printf("   ✗ Không thể đọc file log\n");
+     }
+     
+     // Đổi file khi đang bất đồng bộ: dòng trước thuộc file cũ, dòng sau thuộc file mới
+     printf("3. Đổi file log khi đang ghi bất đồng bộ...\n");
+     const char *second_log = "test_log_async2.log";
+     log_message(LOG_LVL_WARN, "Async before switch");
+     set_log_file(second_log);
+     log_message(LOG_LVL_WARN, "Async after switch");
+     log_flush();
+     char *content1 = NULL, *content2 = NULL;
+     size_t size1 = 0, size2 = 0;
+     if (read_file(TEST_LOG_FILE, &content1, &size1) == 0 && read_file(second_log, &content2, &size2) == 0 &&
+         strstr(content1, "Async before switch") && !strstr(content1, "Async after switch") &&
+         strstr(content2, "Async after switch") && !strstr(content2, "Async before switch")) {
+         printf("   ✓ Các dòng được ghi vào đúng file\n");
+     } else {
+         printf("   ✗ Dòng log bị ghi sai file\n");
+     }
+     free(content1);
+     free(content2);
+     delete_file(second_log);
+     set_log_file(TEST_LOG_FILE);
+     log_async_stop();
+     
+     // Ring rất nhỏ với chính sách bỏ dòng: mọi dòng hoặc được ghi hoặc được đếm là bị bỏ
+     printf("4. Ghi dồn với ring 4 dòng, bỏ dòng khi đầy...\n");
+     delete_file(TEST_LOG_FILE);
+     const int burst = 5000;
+     log_async_start(4, LOG_OVERFLOW_DROP);
+     for (int i = 0; i < burst; i++) {
+         log_message(LOG_LVL_DEBUG, "Burst message %d", i);
+     }
+     unsigned long dropped = log_async_dropped();
+     log_async_stop();
+     
+     if (read_file(TEST_LOG_FILE, &log_content, &content_size) == 0) {
+         int written = count_occurrences(log_content, "Burst message");
+         bool notice = dropped == 0 || strstr(log_content, "log lines dropped") != NULL;
+         printf("   - Đã ghi %d dòng, bỏ %lu dòng\n", written, dropped);
+         if (written + (int)dropped == burst && notice) {
+             printf("   ✓ Số dòng ghi + bỏ khớp, có thông báo dòng bị bỏ\n");
+         } else {
+             printf("   ✗ Mất dòng log không được đếm\n");
+         }
+         free(log_content);
+     } else {
+         printf("   ✗ Không thể đọc file log\n");
+     }
+     
+     // Sau khi dừng, log quay lại ghi trực tiếp
+     printf("5. Ghi log sau khi dừng chế độ bất đồng bộ...\n");
+     log_message(LOG_LVL_WARN, "Synchronous again");
+     if (read_file(TEST_LOG_FILE, &log_content, &content_size) == 0) {
+         printf("   %s\n", strstr(log_content, "WARN: Synchronous again") ?
+                "✓ Dòng log được ghi ngay" : "✗ Dòng log chưa được ghi");
+         free(log_content);
+     } else {
+         printf("   ✗ Không thể đọc file log\n");
+     }
+     
+     printf("=> Kiểm tra ghi log bất đồng bộ hoàn tất.\n");
+ }
+ 
+ static int evaluated_args = 0;
+ 
+ /**
+  * @brief Tham số có tác dụng phụ để biết tham số của lời gọi log có được tính hay không
+  */
+ static int count_evaluation(void) {
+     return ++evaluated_args;
+ }
+ 
+ /**
+  * @brief Kiểm tra macro log: kiểm tra mức trước khi tính tham số, bỏ DEBUG khi biên dịch
+  */
+ void test_log_macros() {
+     printf("\n--- Kiểm tra macro log ---\n");
+     
+     if (file_exists(TEST_LOG_FILE)) {
+         delete_file(TEST_LOG_FILE);
+     }
+     
+     set_log_level(LOG_LVL_ERROR);
+     evaluated_args = 0;
+     LOG_WARN("Macro WARN filtered %d", count_evaluation());
+     printf("   - Tham số không được tính khi level bị tắt lúc chạy: %s\n",
+            evaluated_args == 0 ? "✓ OK" : "✗ Sai");
+     
+     set_log_level(LOG_LVL_DEBUG);
+     LOG_WARN("Macro WARN enabled %d", count_evaluation());
+     LOG_DEBUG("Macro DEBUG compiled out %d", count_evaluation());
+     printf("   - LOG_DEBUG bị loại khi LOG_COMPILE_LEVEL = 2: %s\n",
+            evaluated_args == 1 ? "✓ OK" : "✗ Sai");
+     
+     char *log_content = NULL;
+     size_t content_size = 0;
+     if (read_file(TEST_LOG_FILE, &log_content, &content_size) == 0) {
+         bool ok = strstr(log_content, "WARN: Macro WARN enabled 1") && !strstr(log_content, "Macro WARN filtered") &&
+                   !strstr(log_content, "Macro DEBUG compiled out");
+         printf("   - Nội dung log: %s\n", ok ? "✓ OK" : "✗ Sai");
+         free(log_content);
+     } else {
+         printf("   ✗ Không thể đọc file log\n");
+     }
+     
+     // Chi phí của một lời gọi log bị tắt
+     const int iterations = 10000000;
+     struct timespec start, end;
+     set_log_level(LOG_LVL_WARN);
+     clock_gettime(CLOCK_MONOTONIC, &start);
+     for (int i = 0; i < iterations; i++) {
+         log_message(LOG_LVL_DEBUG, "Disabled %d %s %.3f", i, "value", i * 0.5);
+     }
+     clock_gettime(CLOCK_MONOTONIC, &end);
+     double function_ns = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / iterations;
+     // volatile để đo phép kiểm tra lúc chạy thay vì lời gọi bị loại lúc biên dịch
+     volatile int runtime_level = LOG_LVL_DEBUG;
+     clock_gettime(CLOCK_MONOTONIC, &start);
+     for (int i = 0; i < iterations; i++) {
+         LOG_AT(runtime_level, "Disabled %d %s %.3f", i, "value", i * 0.5);
+     }
+     clock_gettime(CLOCK_MONOTONIC, &end);
+     double macro_ns = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / iterations;
+     set_log_level(LOG_LVL_DEBUG);
+     printf("   - Lời gọi DEBUG bị tắt: log_message %.2f ns, macro %.2f ns\n", function_ns, macro_ns);
+     
+     printf("=> Kiểm tra macro log hoàn tất.\n");
+ }
+ 
+ #define ROTATE_DIR "test_log_rotate"
+ #define ROTATE_LOG ROTATE_DIR "/rotate.log"
+ 
+ /**
+  * @brief Liệt kê các bản lưu trữ rotate.log.* (đã sắp xếp), trả về số bản
+  */
+ static int list_archives(char names[][64], int max, int *compressed) {
+     int count = 0;
+     *compressed = 0;
+     DIR *dir = opendir(ROTATE_DIR);
+     struct dirent *entry;
+     while (dir && (entry = readdir(dir)) != NULL) {
+         if (strncmp(entry->d_name, "rotate.log.", 11) == 0 && count < max) {
+             snprintf(names[count++], 64, "%.63s", entry->d_name);
+             if (strstr(entry->d_name, ".gz")) {
+                 (*compressed)++;
+             }
+         }
+     }
+     if (dir) {
+         closedir(dir);
+     }
+     qsort(names, count, 64, (int (*)(const void *, const void *))strcmp);
+     return count;
+ }
+ 
+ /**
+  * @brief Đọc toàn bộ file (giải nén nếu là .gz)
+  */
+ static char *read_archive(const char *path) {
+     gzFile gz = gzopen(path, "rb");
+     if (!gz) {
+         return NULL;
+     }
+     size_t capacity = 65536, used = 0;
+     char *data = (char *)malloc(capacity);
+     int n;
+     while (data && (n = gzread(gz, data + used, capacity - used - 1)) > 0) {
+         used += n;
+         if (capacity - used < 1024) {
+             capacity *= 2;
+             char *grown = (char *)realloc(data, capacity);
+             if (!grown) {
+                 free(data);
+                 data = NULL;
+                 break;
+             }
+             data = grown;
+         }
+     }
+     gzclose(gz);
+     if (data) {
+         data[used] = '\0';
+     }
+     return data;
+ }
+ 
+ /**
+  * @brief Xóa thư mục kiểm thử xoay vòng
+  */
+ static void remove_rotate_dir(void) {
+     char names[64][64];
+     int compressed;
+     int count = list_archives(names, 64, &compressed);
+     char path[128];
+     for (int i = 0; i < count; i++) {
+         snprintf(path, sizeof(path), "%s/%s", ROTATE_DIR, names[i]);
+         unlink(path);
+     }
+     unlink(ROTATE_LOG);
+     rmdir(ROTATE_DIR);
+ }
+ 
+ /**
+  * @brief Ghi log qua nhiều lần xoay vòng theo kích thước, kiểm tra số bản giữ lại và tính liên tục
+  */
+ static void check_size_rotation(bool async) {
+     remove_rotate_dir();
+     mkdir(ROTATE_DIR, 0755);
+     set_log_file(ROTATE_LOG);
+     log_set_rotation(4096, 0, 3, 6);
+     if (async) {
+         log_async_start(64, LOG_OVERFLOW_BLOCK);
+     }
+     
+     const int lines = 400;
+     for (int i = 0; i < lines; i++) {
+         log_message(LOG_LVL_WARN, "Rotation line %04d padding padding padding padding", i);
+     }
+     if (async) {
+         log_async_stop();
+     }
+     log_rotation_wait();
+     
+     char names[64][64];
+     int compressed = 0;
+     int count = list_archives(names, 64, &compressed);
+     printf("   - %s: %d bản lưu trữ, %d bản đã nén\n", async ? "Bất đồng bộ" : "Trực tiếp", count, compressed);
+     
+     // Các bản giữ lại cùng file hiện tại phải là một đoạn liên tục kết thúc ở dòng cuối
+     char *current = NULL;
+     size_t size = 0;
+     read_file(ROTATE_LOG, &current, &size);
+     char *all = NULL;
+     size_t all_len = 0;
+     for (int i = 0; i <= count; i++) {
+         char path[128];
+         char *part;
+         if (i < count) {
+             snprintf(path, sizeof(path), "%s/%s", ROTATE_DIR, names[i]);
+             part = read_archive(path);
+         } else {
+             part = current ? strdup(current) : NULL;
+         }
+         if (part) {
+             size_t len = strlen(part);
+             all = (char *)realloc(all, all_len + len + 1);
+             memcpy(all + all_len, part, len + 1);
+             all_len += len;
+             free(part);
+         }
+     }
+     
+     int first = -1, expected = -1;
+     bool contiguous = all != NULL;
+     for (const char *pos = all ? strstr(all, "Rotation line ") : NULL; pos; pos = strstr(pos + 1, "Rotation line ")) {
+         int n = atoi(pos + 14);
+         if (first < 0) {
+             first = expected = n;
+         }
+         if (n != expected) {
+             contiguous = false;
+         }
+         expected = n + 1;
+     }
+     
+     if (count == 3 && compressed == 3 && size < 4096 + 256 && contiguous && expected == lines && first > 0) {
+         printf("   ✓ Giữ 3 bản nén, file hiện tại < giới hạn, dòng %d..%d liên tục\n", first, lines - 1);
+     } else {
+         printf("   ✗ Xoay vòng theo kích thước sai (bản lưu trữ %d, nén %d, file %zu byte, liên tục %d, dòng %d..%d)\n",
+                count, compressed, size, contiguous, first, expected - 1);
+     }
+     free(current);
+     free(all);
+ }
+ 
+ /**
+  * @brief Kiểm tra xoay vòng log theo kích thước và tuổi
+  */
+ void test_log_rotation() {
+     printf("\n--- Kiểm tra xoay vòng log ---\n");
+     
+     printf("1. Xoay vòng theo kích thước 4 KB, giữ 3 bản...\n");
+     check_size_rotation(false);
+     check_size_rotation(true);
+     
+     printf("2. Xoay vòng theo tuổi 1 giây, không nén...\n");
+     remove_rotate_dir();
+     mkdir(ROTATE_DIR, 0755);
+     set_log_file(ROTATE_LOG);
+     log_set_rotation(0, 1, 0, 0);
+     log_message(LOG_LVL_WARN, "Aged line");
+     sleep(2);
+     log_message(LOG_LVL_WARN, "Fresh line");
+     log_rotation_wait();
+     
+     char names[64][64];
+     int compressed = 0;
+     int count = list_archives(names, 64, &compressed);
+     char *current = NULL;
+     size_t size = 0;
+     char path[128];
+     char *archived = NULL;
+     if (count == 1) {
+         snprintf(path, sizeof(path), "%s/%s", ROTATE_DIR, names[0]);
+         read_file(path, &archived, &size);
+     }
+     read_file(ROTATE_LOG, &current, &size);
+     if (count == 1 && compressed == 0 && archived && strstr(archived, "Aged line") &&
+         current && strstr(current, "Fresh line") && !strstr(current, "Aged line")) {
+         printf("   ✓ Log cũ hơn 1 giây được xoay vòng (%s)\n", names[0]);
+     } else {
+         printf("   ✗ Xoay vòng theo tuổi sai (%d bản lưu trữ)\n", count);
+     }
+     free(archived);
+     free(current);
+     
+     log_set_rotation(0, 0, 0, 0);
+     set_log_file(TEST_LOG_FILE);
+     remove_rotate_dir();
+     
+     printf("=> Kiểm tra xoay vòng log hoàn tất.\n");
+ }
+ 
+ /**
+  * @brief Kiểm tra các định dạng timestamp
+  */
+ void test_log_timestamp() {
+     printf("\n--- Kiểm tra định dạng timestamp ---\n");
+     
+     if (file_exists(TEST_LOG_FILE)) {
+         delete_file(TEST_LOG_FILE);
+     }
+     
+     log_message(LOG_LVL_WARN, "Timestamp seconds");
+     set_log_timestamp(LOG_TS_MILLIS);
+     log_message(LOG_LVL_WARN, "Timestamp millis");
+     set_log_timestamp(LOG_TS_MONO_MICROS);
+     log_message(LOG_LVL_WARN, "Timestamp mono");
+     set_log_timestamp(LOG_TS_SECONDS);
+     
+     char *log_content = NULL;
+     size_t content_size = 0;
+     if (read_file(TEST_LOG_FILE, &log_content, &content_size) != 0) {
+         printf("   ✗ Không thể đọc file log\n");
+         return;
+     }
+     
+     int year, month, day, hour, minute, second, millis;
+     unsigned long mono_sec, mono_usec;
+     char tail[64];
+     char *line = strstr(log_content, "Timestamp seconds");
+     while (line && line > log_content && line[-1] != '\n') {
+         line--;
+     }
+     line = line ? strtok(line, "\n") : NULL;
+     bool seconds_ok = line && sscanf(line, "[%4d-%2d-%2d %2d:%2d:%2d] %63[^\n]", &year, &month, &day,
+                                      &hour, &minute, &second, tail) == 7 &&
+                       strcmp(tail, "WARN: Timestamp seconds") == 0;
+     line = strtok(NULL, "\n");
+     bool millis_ok = line && sscanf(line, "[%4d-%2d-%2d %2d:%2d:%2d.%3d] %63[^\n]", &year, &month, &day,
+                                     &hour, &minute, &second, &millis, tail) == 8 &&
+                      line[24] == ']' && strcmp(tail, "WARN: Timestamp millis") == 0;
+     line = strtok(NULL, "\n");
+     bool mono_ok = line && sscanf(line, "[%4d-%2d-%2d %2d:%2d:%2d] [%lu.%6lu] %63[^\n]", &year, &month, &day,
+                                   &hour, &minute, &second, &mono_sec, &mono_usec, tail) == 9 &&
+                    strstr(line, ".") && strcmp(tail, "WARN: Timestamp mono") == 0;
+     
+     printf("   - [YYYY-mm-dd HH:MM:SS]: %s\n", seconds_ok ? "✓ OK" : "✗ Sai");
+     printf("   - [YYYY-mm-dd HH:MM:SS.mmm]: %s\n", millis_ok ? "✓ OK" : "✗ Sai");
+     printf("   - [YYYY-mm-dd HH:MM:SS] [monotonic µs]: %s\n", mono_ok ? "✓ OK" : "✗ Sai");
+     free(log_content);
+     
+     printf("=> Kiểm tra định dạng timestamp hoàn tất.\n");
+ }
+ 
+ static long elapsed_ns(const struct timespec *start, const struct timespec *end) {
+     return (end->tv_sec - start->tv_sec) * 1000000000L + (end->tv_nsec - start->tv_nsec);
+ }
+ 
+ // Một điểm gọi duy nhất cho mọi dòng của "cơn bão" log
+ static void log_storm_line(int i) {
+     LOG_WARN("Storm line %d", i);
+ }
+ 
+ /**
+  * @brief Kiểm tra giới hạn tốc độ theo điểm gọi
+  */
+ void test_log_rate_limit() {
+     printf("\n--- Kiểm tra giới hạn tốc độ theo điểm gọi ---\n");
+     
+     if (file_exists(TEST_LOG_FILE)) {
+         delete_file(TEST_LOG_FILE);
+     }
+     
+     // 5 dòng liên tiếp, sau đó 10 dòng/giây
+     log_set_rate_limit(5, 10);
+     struct timespec start, end;
+     clock_gettime(CLOCK_MONOTONIC, &start);
+     for (int i = 0; i < 1000; i++) {
+         log_storm_line(i);
+     }
+     clock_gettime(CLOCK_MONOTONIC, &end);
+     usleep(250000);
+     log_storm_line(1000);
+     LOG_WARN("Other site line");
+     
+     char *log_content = NULL;
+     size_t content_size = 0;
+     if (read_file(TEST_LOG_FILE, &log_content, &content_size) != 0) {
+         printf("   ✗ Không thể đọc file log\n");
+         log_set_rate_limit(0, 0);
+         return;
+     }
+     
+     int written = 0;
+     for (char *pos = strstr(log_content, "WARN: Storm line "); pos; pos = strstr(pos + 1, "WARN: Storm line ")) {
+         written++;
+     }
+     unsigned int suppressed = 0;
+     char *notice = strstr(log_content, "WARN: Suppressed ");
+     bool notice_ok = notice && sscanf(notice, "WARN: Suppressed %u messages like \"Storm line %%d\"", &suppressed) == 1;
+     char *last = strstr(log_content, "Storm line 1000");
+     
+     if (written >= 5 && written <= 8 && notice_ok && last && notice < last &&
+         (unsigned int)written + suppressed == 1001) {
+         printf("   ✓ %d/1001 dòng được ghi, dòng báo %u dòng bị bỏ đứng trước dòng kế tiếp\n", written, suppressed);
+     } else {
+         printf("   ✗ Giới hạn sai: %d dòng được ghi, báo %u dòng bị bỏ\n", written, suppressed);
+     }
+     if (strstr(log_content, "Other site line")) {
+         printf("   ✓ Điểm gọi khác không bị ảnh hưởng\n");
+     } else {
+         printf("   ✗ Điểm gọi khác bị chặn\n");
+     }
+     free(log_content);
+     
+     long storm_ns = elapsed_ns(&start, &end) / 1000;
+     clock_gettime(CLOCK_MONOTONIC, &start);
+     for (int i = 0; i < 1000; i++) {
+         log_message(LOG_LVL_WARN, "Unlimited line %d", i);
+     }
+     clock_gettime(CLOCK_MONOTONIC, &end);
+     long write_ns = elapsed_ns(&start, &end) / 1000;
+     printf("   Dòng bị giới hạn: %ld ns/dòng, dòng ghi file: %ld ns/dòng\n", storm_ns, write_ns);
+     if (storm_ns < write_ns) {
+         printf("   ✓ Dòng bị giới hạn không tốn I/O\n");
+     } else {
+         printf("   ✗ Dòng bị giới hạn không rẻ hơn dòng được ghi\n");
+     }
+     
+     log_set_rate_limit(0, 0);
+     printf("=> Kiểm tra giới hạn tốc độ hoàn tất.\n");
+ }
+ 
+ /**
+  * @brief Kiểm tra gộp các dòng lặp lại liên tiếp
+  */
+ void test_log_dedup() {
+     printf("\n--- Kiểm tra gộp dòng lặp lại ---\n");
+     
+     if (file_exists(TEST_LOG_FILE)) {
+         delete_file(TEST_LOG_FILE);
+     }
+     
+     log_set_dedup(1);
+     for (int i = 0; i < 50; i++) {
+         log_message(LOG_LVL_WARN, "Could not find '%s' in ping output", "rtt min/avg/max");
+     }
+     log_message(LOG_LVL_WARN, "Different line %d", 1);
+     log_message(LOG_LVL_WARN, "Different line %d", 2);
+     log_message(LOG_LVL_ERROR, "Different line %d", 2);
+     log_message(LOG_LVL_ERROR, "Pending line");
+     log_message(LOG_LVL_ERROR, "Pending line");
+     log_message(LOG_LVL_ERROR, "Pending line");
+     log_flush();
+     log_set_dedup(0);
+     
+     char *log_content = NULL;
+     size_t content_size = 0;
+     if (read_file(TEST_LOG_FILE, &log_content, &content_size) != 0) {
+         printf("   ✗ Không thể đọc file log\n");
+         return;
+     }
+     
+     int copies = 0;
+     for (char *pos = strstr(log_content, "in ping output"); pos; pos = strstr(pos + 1, "in ping output")) {
+         copies++;
+     }
+     char *summary = strstr(log_content, "WARN: Last message repeated 49 times\n");
+     char *next = strstr(log_content, "Different line 1");
+     if (copies == 1 && summary && next && summary < next) {
+         printf("   ✓ 50 dòng giống nhau thành 1 dòng và \"Last message repeated 49 times\"\n");
+     } else {
+         printf("   ✗ Gộp sai (%d bản sao)\n", copies);
+     }
+     
+     if (strstr(log_content, "Different line 2") && strstr(log_content, "ERROR: Different line 2")) {
+         printf("   ✓ Dòng khác nội dung hoặc khác mức không bị gộp\n");
+     } else {
+         printf("   ✗ Dòng khác nội dung hoặc khác mức bị gộp\n");
+     }
+     
+     if (strstr(log_content, "ERROR: Last message repeated 2 times\n")) {
+         printf("   ✓ log_flush ghi ra số lần lặp đang đếm\n");
+     } else {
+         printf("   ✗ log_flush không ghi số lần lặp đang đếm\n");
+     }
+     free(log_content);
+     
+     // Chế độ bất đồng bộ: luồng ghi gộp dòng, producer không giữ khóa nào
+     delete_file(TEST_LOG_FILE);
+     log_async_start(64, LOG_OVERFLOW_BLOCK);
+     log_set_dedup(1);
+     for (int i = 0; i < 200; i++) {
+         log_message(LOG_LVL_WARN, "Async repeated line");
+     }
+     log_message(LOG_LVL_WARN, "Async other line");
+     log_message(LOG_LVL_WARN, "Async pending line");
+     log_message(LOG_LVL_WARN, "Async pending line");
+     log_flush();
+     log_set_dedup(0);
+     log_async_stop();
+     
+     log_content = NULL;
+     if (read_file(TEST_LOG_FILE, &log_content, &content_size) == 0) {
+         copies = 0;
+         for (char *pos = strstr(log_content, "Async repeated line"); pos; pos = strstr(pos + 1, "Async repeated line")) {
+             copies++;
+         }
+         summary = strstr(log_content, "WARN: Last message repeated 199 times\n");
+         next = strstr(log_content, "Async other line");
+         if (copies == 1 && summary && next && summary < next &&
+             strstr(log_content, "WARN: Last message repeated 1 times\n")) {
+             printf("   ✓ Chế độ bất đồng bộ: luồng ghi gộp 200 dòng và ghi số lần lặp khi log_flush\n");
+         } else {
+             printf("   ✗ Chế độ bất đồng bộ gộp sai (%d bản sao)\n", copies);
+         }
+         free(log_content);
+     } else {
+         printf("   ✗ Không thể đọc file log\n");
+     }
+     
+     printf("=> Kiểm tra gộp dòng lặp lại hoàn tất.\n");
+ }
+ 
         /**
          * @brief Hàm main chạy tất cả các bài kiểm thử
          */
@@ -461,9 +1182,15 @@
             test_log_levels();
             test_log_filtering();
             test_log_format();
+            test_log_timestamp();
+            test_log_macros();
             test_multithreaded_logging();
             test_log_stability();
             test_change_log_file();
+            test_async_logging();
+            test_log_rotation();
+            test_log_rate_limit();
+            test_log_dedup();
             
             // Dọn dẹp
             cleanup_logger();
@@ -0,0 +1,394 @@
+/**
+ * @file test_log_binary.c
+ * @brief Kiểm thử log nhị phân và bộ giải mã
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <stdbool.h>
+ #include <stdint.h>
+ #include <errno.h>
+ #include <pthread.h>
+ #include <unistd.h>
+ #include <time.h>
+ #include <dirent.h>
+ #include <sys/stat.h>
+ #include "log.h"
+ #include "log_binary.h"
+ #include "file_process.h"
+
+ #define TEXT_LOG "test_log_binary.log"
+ #define BINARY_LOG "test_log_binary.blog"
+ #define ROTATE_DIR "test_log_binary_rotate"
+ #define ROTATE_LOG ROTATE_DIR "/rotate.blog"
+ #define BENCH_LINES_PER_THREAD 20000
+
+ /**
+  * @brief Giải mã file log nhị phân vào bộ nhớ
+  */
+ static char *decode_to_string(const char *path, long *lines) {
+     char *text = NULL;
+     size_t size = 0;
+     FILE *out = open_memstream(&text, &size);
+     if (!out) {
+         return NULL;
+     }
+     *lines = log_binary_decode_file(path, out);
+     fclose(out);
+     return text;
+ }
+
+ static long file_size(const char *path) {
+     struct stat st;
+     return stat(path, &st) == 0 ? (long)st.st_size : -1;
+ }
+
+ static int count_occurrences(const char *content, const char *needle) {
+     int count = 0;
+     for (const char *pos = strstr(content, needle); pos; pos = strstr(pos + 1, needle)) {
+         count++;
+     }
+     return count;
+ }
+
+ /**
+  * @brief Kiểm tra suy ra kiểu tham số từ chuỗi định dạng
+  */
+ void test_parse_format() {
+     printf("\n--- Kiểm tra phân tích chuỗi định dạng ---\n");
+
+     unsigned char types[LOG_SITE_MAX_ARGS];
+     int count = log_binary_parse_format("id %s: %d/%ld %llu %zu %.2f %p 100%%", types, LOG_SITE_MAX_ARGS);
+     const unsigned char expected[] = { LOG_ARG_STRING, LOG_ARG_INT, LOG_ARG_LONG, LOG_ARG_LLONG,
+                                        LOG_ARG_SIZE, LOG_ARG_DOUBLE, LOG_ARG_POINTER };
+     if (count == (int)sizeof(expected) && memcmp(types, expected, sizeof(expected)) == 0) {
+         printf("   ✓ Kiểu tham số của %%s %%d %%ld %%llu %%zu %%.2f %%p đúng, bỏ qua %%%%\n");
+     } else {
+         printf("   ✗ Kiểu tham số sai (%d phần tử)\n", count);
+     }
+
+     count = log_binary_parse_format("%*d %.*s %.5s", types, LOG_SITE_MAX_ARGS);
+     const unsigned char starred[] = { LOG_ARG_INT, LOG_ARG_INT, LOG_ARG_INT, LOG_ARG_STRING_STAR,
+                                       LOG_ARG_STRING_PREC, 5 };
+     if (count == (int)sizeof(starred) && memcmp(types, starred, sizeof(starred)) == 0) {
+         printf("   ✓ '*' thành tham số int, độ chính xác của chuỗi được giữ lại\n");
+     } else {
+         printf("   ✗ Sai với '*' hoặc độ chính xác (%d phần tử)\n", count);
+     }
+
+     if (log_binary_parse_format("%n", types, LOG_SITE_MAX_ARGS) < 0 &&
+         log_binary_parse_format("%m", types, LOG_SITE_MAX_ARGS) < 0 &&
+         log_binary_parse_format("%1$d", types, LOG_SITE_MAX_ARGS) < 0 &&
+         log_binary_parse_format("%ls", types, LOG_SITE_MAX_ARGS) < 0 &&
+         log_binary_parse_format("%d %d %d", types, 2) < 0 &&
+         log_binary_parse_format("trailing %", types, LOG_SITE_MAX_ARGS) < 0) {
+         printf("   ✓ Định dạng không hỗ trợ hoặc quá nhiều tham số bị từ chối\n");
+     } else {
+         printf("   ✗ Chấp nhận định dạng không hỗ trợ\n");
+     }
+ }
+
+ /**
+  * @brief Các lời gọi log mẫu, chạy ở cả hai chế độ để so sánh
+  */
+ static void log_samples(int round, const char *dynamic_format) {
+     const char *null_string = NULL;
+     char unterminated[4] = { 'a', 'b', 'c', 'd' };
+     LOG_DEBUG("Sample %d: int %d neg %i unsigned %u hex %#x oct %o char %c", round, -42, -7, 3000000000u, 255, 8, 'Z');
+     LOG_WARN("Sample %d: long %ld ulong %lu llong %lld ullong %llu size %zu ptrdiff %td intmax %jd",
+              round, -1234567890123L, 18446744073709551615UL, -9000000000000LL, 12345678901234ULL,
+              (size_t)4096, (ptrdiff_t)-16, (intmax_t)77);
+     LOG_ERROR("Sample %d: float %.3f %e %g %10.2f|%-8.1f| long double %.4Lf", round, 3.14159, 1e-9, 0.5,
+               2.5, -1.25, (long double)2.71828);
+     LOG_DEBUG("Sample %d: string '%s' padded '%-10s' '%8s' null %s", round, "hello", "left", "right", null_string);
+     LOG_DEBUG("Sample %d: star width '%*d' '%-*d' precision '%.*f' '%.*s' '%.3s'", round, 6, 42, 6, 42, 2, 1.23456,
+               3, unterminated, unterminated);
+     LOG_DEBUG("Sample %d: pointer %p percent 100%% hh %hhd h %hd", round, (void *)0x1234, (signed char)-3, (short)300);
+     LOG_DEBUG("Sample %d: empty '%s' no args after", round, "");
+     errno = ENOENT;
+     LOG_DEBUG("Sample %d: errno style %m is written as text", round);
+     log_message(LOG_LVL_WARN, "Sample %d: direct log_message %s", round, "call");
+     if (dynamic_format) {
+         LOG_DEBUG(dynamic_format, round);
+     }
+ }
+
+ /**
+  * @brief Bỏ phần "[timestamp]" của mỗi dòng, chỉ giữ " LEVEL: nội dung"
+  */
+ static char *strip_timestamps(const char *text) {
+     char *out = (char *)malloc(strlen(text) + 1);
+     size_t pos = 0;
+     for (const char *line = text; out && *line;) {
+         const char *end = strchr(line, '\n');
+         size_t len = end ? (size_t)(end - line + 1) : strlen(line);
+         const char *body = memchr(line, ']', len);
+         body = body ? body + 1 : line;
+         memcpy(out + pos, body, len - (size_t)(body - line));
+         pos += len - (size_t)(body - line);
+         line += len;
+     }
+     if (out) {
+         out[pos] = '\0';
+     }
+     return out;
+ }
+
+ /**
+  * @brief Kiểm tra giải mã ra đúng nội dung của chế độ text
+  */
+ void test_round_trip() {
+     printf("\n--- Kiểm tra ghi nhị phân và giải mã ---\n");
+
+     unlink(TEXT_LOG);
+     unlink(BINARY_LOG);
+     char dynamic_format[32];
+
+     set_log_file(TEXT_LOG);
+     set_log_format(LOG_FORMAT_TEXT);
+     strcpy(dynamic_format, "Sample %d: first dynamic");
+     log_samples(1, dynamic_format);
+     strcpy(dynamic_format, "Sample %d: second dynamic");
+     log_samples(1, dynamic_format);
+
+     set_log_file(BINARY_LOG);
+     set_log_format(LOG_FORMAT_BINARY);
+     strcpy(dynamic_format, "Sample %d: first dynamic");
+     log_samples(1, dynamic_format);
+     // Cùng điểm gọi, chuỗi định dạng khác: không được dùng lại id cũ
+     strcpy(dynamic_format, "Sample %d: second dynamic");
+     log_samples(1, dynamic_format);
+     set_log_format(LOG_FORMAT_TEXT);
+     set_log_file(TEXT_LOG);
+
+     char *expected_raw = NULL;
+     size_t expected_size = 0;
+     long lines = 0;
+     char *decoded_raw = decode_to_string(BINARY_LOG, &lines);
+     if (read_file(TEXT_LOG, &expected_raw, &expected_size) != 0 || !decoded_raw) {
+         printf("   ✗ Không đọc được log text hoặc log nhị phân\n");
+         free(expected_raw);
+         free(decoded_raw);
+         return;
+     }
+
+     char *expected = strip_timestamps(expected_raw);
+     char *decoded = strip_timestamps(decoded_raw);
+     if (lines == 20 && expected && decoded && strcmp(expected, decoded) == 0) {
+         printf("   ✓ %ld dòng giải mã giống hệt log text (không tính timestamp)\n", lines);
+     } else {
+         printf("   ✗ Nội dung giải mã khác log text (%ld dòng)\n", lines);
+         printf("--- text ---\n%s--- decoded ---\n%s", expected ? expected : "", decoded ? decoded : "");
+     }
+
+     int year, month, day, hour, minute, second;
+     char level[8];
+     if (sscanf(decoded_raw, "[%d-%d-%d %d:%d:%d] %7[A-Z]: Sample 1", &year, &month, &day, &hour, &minute,
+                &second, level) == 7 && strcmp(level, "DEBUG") == 0 && year >= 2020) {
+         printf("   ✓ Timestamp và mức log đúng định dạng text\n");
+     } else {
+         printf("   ✗ Header dòng giải mã sai\n");
+     }
+
+     long text_size = file_size(TEXT_LOG), binary_size = file_size(BINARY_LOG);
+     printf("   - Kích thước: text %ld byte, nhị phân %ld byte\n", text_size, binary_size);
+
+     free(expected);
+     free(decoded);
+     free(expected_raw);
+     free(decoded_raw);
+
+     // Timestamp có mili giây và monotonic được giải mã theo chế độ lúc ghi
+     unlink(BINARY_LOG);
+     set_log_file(BINARY_LOG);
+     set_log_format(LOG_FORMAT_BINARY);
+     set_log_timestamp(LOG_TS_MILLIS);
+     LOG_WARN("Millis line %d", 1);
+     set_log_timestamp(LOG_TS_MONO_MICROS);
+     LOG_WARN("Mono line %d", 2);
+     set_log_timestamp(LOG_TS_SECONDS);
+     set_log_format(LOG_FORMAT_TEXT);
+     set_log_file(TEXT_LOG);
+
+     decoded_raw = decode_to_string(BINARY_LOG, &lines);
+     int millis = -1;
+     unsigned long mono_sec = 0, mono_usec = 0;
+     const char *mono = decoded_raw ? strstr(decoded_raw, "\n[") : NULL;
+     if (lines == 2 && sscanf(decoded_raw, "[%*d-%*d-%*d %*d:%*d:%*d.%3d] WARN: Millis line 1", &millis) == 1 &&
+         mono && sscanf(mono + 1, "[%*d-%*d-%*d %*d:%*d:%*d] [%lu.%6lu] WARN: Mono line 2", &mono_sec, &mono_usec) == 2 &&
+         mono_sec > 0) {
+         printf("   ✓ Timestamp mili giây và monotonic được giữ lại\n");
+     } else {
+         printf("   ✗ Timestamp mili giây hoặc monotonic sai\n");
+     }
+     free(decoded_raw);
+
+     // Log text không phải log nhị phân
+     decoded_raw = decode_to_string(TEXT_LOG, &lines);
+     printf("   %s\n", lines < 0 ? "✓ Log text bị từ chối" : "✗ Log text được giải mã");
+     free(decoded_raw);
+
+     unlink(TEXT_LOG);
+     unlink(BINARY_LOG);
+ }
+
+ /**
+  * @brief Kiểm tra mỗi bản lưu trữ sau khi xoay vòng tự giải mã được
+  */
+ void test_binary_rotation() {
+     printf("\n--- Kiểm tra xoay vòng log nhị phân ---\n");
+
+     mkdir(ROTATE_DIR, 0755);
+     set_log_file(ROTATE_LOG);
+     set_log_format(LOG_FORMAT_BINARY);
+     log_set_rotation(4096, 0, 0, 6);
+     const int total = 1000;
+     for (int i = 0; i < total; i++) {
+         LOG_DEBUG("Rotated binary line %d of %s", i, "test");
+     }
+     log_set_rotation(0, 0, 0, 0);
+     log_rotation_wait();
+     set_log_format(LOG_FORMAT_TEXT);
+     set_log_file(TEXT_LOG);
+
+     long decoded = 0;
+     int files = 0;
+     bool all_ok = true;
+     DIR *dir = opendir(ROTATE_DIR);
+     struct dirent *entry;
+     while (dir && (entry = readdir(dir)) != NULL) {
+         if (entry->d_name[0] == '.') {
+             continue;
+         }
+         char path[300];
+         snprintf(path, sizeof(path), "%s/%s", ROTATE_DIR, entry->d_name);
+         long lines = 0;
+         char *text = decode_to_string(path, &lines);
+         // Luồng nén nền cũng ghi log vào file, chỉ đếm các dòng của vòng lặp
+         if (lines < 0 || !text) {
+             all_ok = false;
+         } else {
+             decoded += count_occurrences(text, "DEBUG: Rotated binary line");
+         }
+         files++;
+         free(text);
+         unlink(path);
+     }
+     if (dir) {
+         closedir(dir);
+     }
+     rmdir(ROTATE_DIR);
+
+     if (all_ok && files > 2 && decoded == total) {
+         printf("   ✓ %d file (kể cả .gz) đều tự giải mã được, đủ %ld dòng\n", files, decoded);
+     } else {
+         printf("   ✗ Bản lưu trữ không giải mã được hoặc thiếu dòng (%d file, %ld dòng)\n", files, decoded);
+     }
+ }
+
+ typedef struct {
+     int thread_id;
+ } bench_args_t;
+
+ static void *bench_thread(void *arg) {
+     bench_args_t *args = (bench_args_t *)arg;
+     for (int i = 0; i < BENCH_LINES_PER_THREAD; i++) {
+         LOG_DEBUG("Bench thread %d - line %d value %.3f target %s", args->thread_id, i, i * 0.5, "10.0.0.1");
+     }
+     return NULL;
+ }
+
+ /**
+  * @brief Đo số dòng/giây và số byte ghi với một định dạng log
+  */
+ static double bench_format(int format, int threads, long *bytes, long *lines) {
+     const char *path = format == LOG_FORMAT_BINARY ? BINARY_LOG : TEXT_LOG;
+     unlink(path);
+     set_log_file(path);
+     set_log_format(format);
+     log_async_start(LOG_ASYNC_SLOTS, LOG_OVERFLOW_BLOCK);
+
+     pthread_t ids[8];
+     bench_args_t args[8];
+     struct timespec start, end;
+     clock_gettime(CLOCK_MONOTONIC, &start);
+     for (int i = 0; i < threads; i++) {
+         args[i].thread_id = i;
+         pthread_create(&ids[i], NULL, bench_thread, &args[i]);
+     }
+     for (int i = 0; i < threads; i++) {
+         pthread_join(ids[i], NULL);
+     }
+     log_async_stop();
+     clock_gettime(CLOCK_MONOTONIC, &end);
+     set_log_format(LOG_FORMAT_TEXT);
+
+     *bytes = file_size(path);
+     *lines = 0;
+     if (format == LOG_FORMAT_BINARY) {
+         char *text = decode_to_string(path, lines);
+         *lines = text ? count_occurrences(text, "Bench thread") : 0;
+         free(text);
+     } else {
+         char *text = NULL;
+         size_t size = 0;
+         if (read_file(path, &text, &size) == 0) {
+             *lines = count_occurrences(text, "Bench thread");
+             free(text);
+         }
+     }
+     unlink(path);
+
+     double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+     return elapsed > 0 ? threads * BENCH_LINES_PER_THREAD / elapsed : 0;
+ }
+
+ /**
+  * @brief So sánh tốc độ và dung lượng ghi giữa log text và log nhị phân
+  */
+ void test_binary_benchmark() {
+     printf("\n--- Đo tốc độ log text và nhị phân (bất đồng bộ) ---\n");
+
+     const int thread_counts[] = { 1, 4 };
+     bool complete = true;
+     printf("   Threads     Text dòng/s   Nhị phân dòng/s   Text byte   Nhị phân byte\n");
+     for (size_t i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); i++) {
+         long text_bytes, binary_bytes, text_lines, binary_lines;
+         double text_rate = bench_format(LOG_FORMAT_TEXT, thread_counts[i], &text_bytes, &text_lines);
+         double binary_rate = bench_format(LOG_FORMAT_BINARY, thread_counts[i], &binary_bytes, &binary_lines);
+         printf("   %-7d %15.0f %17.0f %11ld %15ld\n", thread_counts[i], text_rate, binary_rate, text_bytes,
+                binary_bytes);
+         long total = (long)thread_counts[i] * BENCH_LINES_PER_THREAD;
+         complete &= text_lines == total && binary_lines == total && binary_bytes < text_bytes;
+     }
+     set_log_file(TEXT_LOG);
+
+     if (complete) {
+         printf("   ✓ Đủ mọi dòng ở cả hai chế độ, log nhị phân nhỏ hơn log text\n");
+     } else {
+         printf("   ✗ Thiếu dòng hoặc log nhị phân không nhỏ hơn\n");
+     }
+ }
+
+ int main() {
+     printf("\n=================================================\n");
+     printf("      KIỂM THỬ MODULE LOG_BINARY.C\n");
+     printf("=================================================\n");
+
+     set_log_level(LOG_LVL_DEBUG);
+
+     test_parse_format();
+     test_round_trip();
+     test_binary_rotation();
+     test_binary_benchmark();
+
+     cleanup_logger();
+     unlink(TEXT_LOG);
+
+     printf("\n=================================================\n");
+     printf("      HOÀN TẤT KIỂM THỬ LOG_BINARY.C\n");
+     printf("=================================================\n");
+
+     return 0;
+ }
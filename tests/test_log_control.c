@@ -0,0 +1,279 @@
+/**
+ * @file test_log_control.c
+ * @brief Kiểm thử đổi mức log theo module khi đang chạy (SIGUSR2, socket điều khiển)
+ */
+
+ // Các LOG_* trong file này thuộc module tc
+ #define LOG_MODULE LOG_MOD_TC
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <stdbool.h>
+ #include <signal.h>
+ #include <unistd.h>
+ #include <time.h>
+ #include <sys/socket.h>
+ #include <sys/stat.h>
+ #include <sys/un.h>
+ #include "log.h"
+ #include "log_control.h"
+ #include "file_process.h"
+
+ #define CONTROL_LOG "test_log_control.log"
+ #define CONTROL_LOG_2 "test_log_control_2.log"
+ #define CONTROL_SOCKET "test_log_control.ctl"
+ #define BENCH_CALLS 10000000
+
+ static char *read_text(const char *path) {
+     char *content = NULL;
+     size_t size = 0;
+     if (read_file(path, &content, &size) != 0) {
+         return NULL;
+     }
+     return content;
+ }
+
+ /**
+  * @brief Mức riêng của module chỉ ảnh hưởng điểm gọi của module đó
+  */
+ void test_module_levels() {
+     printf("\n--- Kiểm tra mức log theo module ---\n");
+     unlink(CONTROL_LOG);
+     set_log_file(CONTROL_LOG);
+     set_log_level(LOG_LVL_WARN);
+     set_log_module_level(LOG_MOD_TC, LOG_LVL_DEBUG);
+
+     LOG_DEBUG("tc debug visible");
+     log_message(LOG_LVL_DEBUG, "core debug hidden");
+     log_message(LOG_LVL_WARN, "core warn visible");
+
+     set_log_module_level(LOG_MOD_TC, LOG_LVL_ERROR);
+     int evaluated = 0;
+     LOG_WARN("tc warn hidden %d", ++evaluated);
+
+     char *content = read_text(CONTROL_LOG);
+     if (content && strstr(content, "tc debug visible") && !strstr(content, "core debug hidden") &&
+         strstr(content, "core warn visible") && !strstr(content, "tc warn hidden")) {
+         printf("   ✓ Module tc ghi theo mức riêng, module core theo mức chung\n");
+     } else {
+         printf("   ✗ Mức theo module sai: %s\n", content ? content : "(không đọc được)");
+     }
+     free(content);
+
+     if (evaluated == 0) {
+         printf("   ✓ Tham số của dòng bị tắt không được tính\n");
+     } else {
+         printf("   ✗ Tham số của dòng bị tắt vẫn được tính\n");
+     }
+
+     int is_override = 0;
+     set_log_module_level(LOG_MOD_TC, -1);
+     if (get_log_module_level(LOG_MOD_TC, &is_override) == LOG_LVL_WARN && !is_override &&
+         set_log_module_level(LOG_MOD_COUNT, LOG_LVL_DEBUG) != 0 &&
+         log_module_from_name("parser") == LOG_MOD_PARSER && log_module_from_name("bogus") < 0) {
+         printf("   ✓ Bỏ mức riêng trả module về mức chung, module/tên sai bị từ chối\n");
+     } else {
+         printf("   ✗ Bỏ mức riêng hoặc kiểm tra đầu vào sai\n");
+     }
+ }
+
+ /**
+  * @brief SIGUSR2 bật DEBUG rồi trả về mức trước đó
+  */
+ void test_sigusr2_toggle() {
+     printf("\n--- Kiểm tra SIGUSR2 ---\n");
+     set_log_level(LOG_LVL_ERROR);
+     log_control_start(NULL);
+
+     raise(SIGUSR2);
+     bool raised = logger_config.log_level == LOG_LVL_DEBUG && LOG_ENABLED(LOG_LVL_DEBUG);
+     raise(SIGUSR2);
+     bool restored = logger_config.log_level == LOG_LVL_ERROR && !LOG_ENABLED(LOG_LVL_WARN);
+     log_control_stop();
+
+     if (raised && restored) {
+         printf("   ✓ SIGUSR2 bật DEBUG, lần sau trả về ERROR\n");
+     } else {
+         printf("   ✗ SIGUSR2 không đổi mức đúng (bật %d, trả về %d)\n", raised, restored);
+     }
+ }
+
+ /**
+  * @brief Gửi các lệnh qua socket điều khiển và đọc hết phản hồi
+  */
+ static char *send_commands(const char *commands, int expected_lines) {
+     int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+     struct sockaddr_un addr;
+     memset(&addr, 0, sizeof(addr));
+     addr.sun_family = AF_UNIX;
+     strcpy(addr.sun_path, CONTROL_SOCKET);
+     if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+         if (fd >= 0) {
+             close(fd);
+         }
+         return NULL;
+     }
+     write(fd, commands, strlen(commands));
+
+     static char replies[2048];
+     size_t used = 0;
+     int lines = 0;
+     while (lines < expected_lines && used < sizeof(replies) - 1) {
+         ssize_t n = read(fd, replies + used, sizeof(replies) - 1 - used);
+         if (n <= 0) {
+             break;
+         }
+         for (ssize_t i = 0; i < n; i++) {
+             lines += replies[used + i] == '\n';
+         }
+         used += (size_t)n;
+     }
+     replies[used] = '\0';
+     close(fd);
+     return replies;
+ }
+
+ /**
+  * @brief Đổi mức log và file log qua socket điều khiển
+  */
+ void test_control_socket() {
+     printf("\n--- Kiểm tra socket điều khiển ---\n");
+     unlink(CONTROL_LOG);
+     unlink(CONTROL_LOG_2);
+     set_log_file(CONTROL_LOG);
+     set_log_level(LOG_LVL_WARN);
+
+     if (log_control_start(CONTROL_SOCKET) != 0) {
+         printf("   ✗ Không mở được socket điều khiển\n");
+         return;
+     }
+
+     char *replies = send_commands("level tc debug\nlevel error\nlevel\nlevel bogus 3\nfrobnicate\n", 5);
+     if (replies && strstr(replies, "OK global=warn") && strstr(replies, "tc=debug*") &&
+         strstr(replies, "OK global=error core=error parser=error tc=debug* file=error remote=error\n") &&
+         strstr(replies, "ERR module must be") && strstr(replies, "ERR unknown command")) {
+         printf("   ✓ Lệnh level đổi mức chung và mức của module, lệnh sai trả về ERR\n");
+     } else {
+         printf("   ✗ Phản hồi sai: %s\n", replies ? replies : "(không kết nối được)");
+     }
+
+     if (LOG_ENABLED(LOG_LVL_DEBUG) && logger_config.log_level == LOG_LVL_ERROR) {
+         printf("   ✓ Mức mới có hiệu lực ngay ở điểm gọi\n");
+     } else {
+         printf("   ✗ Mức mới chưa có hiệu lực\n");
+     }
+
+     replies = send_commands("file " CONTROL_LOG_2 "\n", 1);
+     LOG_DEBUG("line after switching file");
+     char *content = read_text(CONTROL_LOG_2);
+     if (replies && strstr(replies, "OK file=" CONTROL_LOG_2) && content &&
+         strstr(content, "line after switching file")) {
+         printf("   ✓ Lệnh file chuyển log sang file mới\n");
+     } else {
+         printf("   ✗ Lệnh file không chuyển file log\n");
+     }
+     free(content);
+
+     log_control_stop();
+     if (access(CONTROL_SOCKET, F_OK) != 0) {
+         printf("   ✓ Socket được xóa khi dừng\n");
+     } else {
+         printf("   ✗ Socket còn lại sau khi dừng\n");
+     }
+     set_log_module_level(LOG_MOD_TC, -1);
+     set_log_file(CONTROL_LOG);
+ }
+
+ /**
+  * @brief Tạo socket lắng nghe tại CONTROL_SOCKET như một tiến trình khác
+  */
+ static int listen_as_other() {
+     int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+     struct sockaddr_un addr;
+     memset(&addr, 0, sizeof(addr));
+     addr.sun_family = AF_UNIX;
+     strcpy(addr.sun_path, CONTROL_SOCKET);
+     if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 1) != 0) {
+         if (fd >= 0) {
+             close(fd);
+         }
+         return -1;
+     }
+     return fd;
+ }
+
+ /**
+  * @brief Quyền của socket và xử lý socket của tiến trình khác / socket cũ
+  */
+ void test_socket_ownership() {
+     printf("\n--- Kiểm tra quyền và chủ sở hữu socket ---\n");
+     unlink(CONTROL_SOCKET);
+
+     int other = listen_as_other();
+     if (other < 0) {
+         printf("   ✗ Không tạo được socket của tiến trình khác\n");
+         return;
+     }
+     struct stat st;
+     if (log_control_start(CONTROL_SOCKET) == -1 && stat(CONTROL_SOCKET, &st) == 0) {
+         printf("   ✓ Socket đang được tiến trình khác lắng nghe không bị chiếm\n");
+     } else {
+         printf("   ✗ Socket của tiến trình khác bị thay thế\n");
+     }
+     log_control_stop();
+
+     // Đóng mà không xóa: giống socket còn lại sau khi chương trình bị kill
+     close(other);
+     if (log_control_start(CONTROL_SOCKET) == 0 && stat(CONTROL_SOCKET, &st) == 0 &&
+         (st.st_mode & 0777) == (S_IRUSR | S_IWUSR)) {
+         printf("   ✓ Socket cũ được thay thế, socket mới có quyền 0600\n");
+     } else {
+         printf("   ✗ Không thay thế được socket cũ hoặc quyền sai\n");
+     }
+     log_control_stop();
+ }
+
+ /**
+  * @brief Chi phí kiểm tra mức của dòng bị tắt
+  */
+ void test_disabled_cost() {
+     printf("\n--- Đo chi phí dòng log bị tắt ---\n");
+     set_log_level(LOG_LVL_ERROR);
+     struct timespec start, end;
+     clock_gettime(CLOCK_MONOTONIC, &start);
+     for (int i = 0; i < BENCH_CALLS; i++) {
+         LOG_DEBUG("disabled %d", i);
+     }
+     clock_gettime(CLOCK_MONOTONIC, &end);
+     double ns = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / BENCH_CALLS;
+     printf("   %.2f ns/lời gọi\n", ns);
+     if (ns < 20) {
+         printf("   ✓ Dòng bị tắt chỉ tốn một phép đọc atomic relaxed và một phép so sánh\n");
+     } else {
+         printf("   ✗ Dòng bị tắt tốn quá nhiều thời gian\n");
+     }
+     set_log_level(LOG_LVL_DEBUG);
+ }
+
+ int main() {
+     printf("\n=================================================\n");
+     printf("      KIỂM THỬ LOG_CONTROL.C\n");
+     printf("=================================================\n");
+
+     test_module_levels();
+     test_sigusr2_toggle();
+     test_control_socket();
+     test_socket_ownership();
+     test_disabled_cost();
+
+     cleanup_logger();
+     unlink(CONTROL_LOG);
+     unlink(CONTROL_LOG_2);
+
+     printf("\n=================================================\n");
+     printf("      HOÀN TẤT KIỂM THỬ LOG_CONTROL.C\n");
+     printf("=================================================\n");
+
+     return 0;
+ }
@@ -0,0 +1,320 @@
+/**
+ * @file test_log_flight.c
+ * @brief Kiểm thử flight recorder của logger
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <stdbool.h>
+ #include <signal.h>
+ #include <unistd.h>
+ #include <time.h>
+ #include <pthread.h>
+ #include <sys/wait.h>
+ #include "log.h"
+ #include "log_flight.h"
+ #include "file_process.h"
+
+ #define FLIGHT_LOG "test_log_flight.log"
+ #define FLIGHT_DUMP "test_log_flight.flight"
+ #define BENCH_LINES 200000
+
+ static char *read_text(const char *path) {
+     char *content = NULL;
+     size_t size = 0;
+     if (read_file(path, &content, &size) != 0) {
+         return NULL;
+     }
+     return content;
+ }
+
+ static int count_occurrences(const char *content, const char *needle) {
+     int count = 0;
+     for (const char *pos = strstr(content, needle); pos; pos = strstr(pos + 1, needle)) {
+         count++;
+     }
+     return count;
+ }
+
+ static void reset_files(void) {
+     unlink(FLIGHT_LOG);
+     unlink(FLIGHT_DUMP);
+ }
+
+ /**
+  * @brief Ring giữ dòng DEBUG dù file log chỉ ghi ERROR, dump chỉ ghi phần mới
+  */
+ void test_capture_and_dump() {
+     printf("\n--- Kiểm tra ghi nhận và dump ---\n");
+     reset_files();
+     set_log_file(FLIGHT_LOG);
+     set_log_level(LOG_LVL_ERROR);
+
+     if (log_flight_start(64 * 1024, FLIGHT_DUMP) != 0) {
+         printf("   ✗ Không bật được flight recorder\n");
+         return;
+     }
+     LOG_DEBUG("flight debug line %d", 1);
+     LOG_WARN("flight warn line %d", 2);
+     LOG_ERROR("flight error line %d", 3);
+
+     char *file = read_text(FLIGHT_LOG);
+     if (file && !strstr(file, "flight debug line") && !strstr(file, "flight warn line") &&
+         strstr(file, "flight error line 3")) {
+         printf("   ✓ File log chỉ có dòng ERROR\n");
+     } else {
+         printf("   ✗ File log sai: %s\n", file ? file : "(không đọc được)");
+     }
+     free(file);
+
+     if (log_flight_dump("manual") == 0) {
+         char *dump = read_text(FLIGHT_DUMP);
+         if (dump && strstr(dump, "===== flight recorder: manual =====") &&
+             strstr(dump, "DEBUG: flight debug line 1") && strstr(dump, "WARN: flight warn line 2") &&
+             strstr(dump, "ERROR: flight error line 3")) {
+             printf("   ✓ Dump có đủ dòng ở mọi mức\n");
+         } else {
+             printf("   ✗ Nội dung dump sai: %s\n", dump ? dump : "(không đọc được)");
+         }
+         free(dump);
+     } else {
+         printf("   ✗ log_flight_dump thất bại\n");
+     }
+
+     LOG_DEBUG("flight after dump");
+     log_flight_dump("second");
+     char *dump = read_text(FLIGHT_DUMP);
+     if (dump && count_occurrences(dump, "flight debug line 1") == 1 &&
+         count_occurrences(dump, "flight after dump") == 1 && strstr(dump, "flight recorder: second")) {
+         printf("   ✓ Lần dump sau chỉ ghi các dòng mới\n");
+     } else {
+         printf("   ✗ Lần dump sau lặp lại dòng cũ hoặc thiếu dòng mới\n");
+     }
+     free(dump);
+
+     log_flight_stop();
+     set_log_level(LOG_LVL_ERROR);
+     int evaluated = 0;
+     LOG_DEBUG("not built %d", ++evaluated);
+     if (evaluated == 0 && log_flight_dump("stopped") != 0) {
+         printf("   ✓ Tắt recorder: DEBUG không còn được dựng, dump bị từ chối\n");
+     } else {
+         printf("   ✗ Recorder vẫn hoạt động sau khi tắt\n");
+     }
+     set_log_level(LOG_LVL_DEBUG);
+ }
+
+ /**
+  * @brief Ring nhỏ chỉ giữ các dòng mới nhất, dump bắt đầu ở đầu một dòng
+  */
+ void test_ring_wrap() {
+     printf("\n--- Kiểm tra ring bị ghi đè ---\n");
+     reset_files();
+     set_log_file(FLIGHT_LOG);
+     set_log_level(LOG_LVL_NONE);
+
+     log_flight_start(4096, FLIGHT_DUMP);
+     for (int i = 0; i < 500; i++) {
+         LOG_DEBUG("wrap line %04d", i);
+     }
+     log_flight_dump("wrap");
+     log_flight_stop();
+
+     char *dump = read_text(FLIGHT_DUMP);
+     const char *body = dump ? strchr(dump, '\n') : NULL;
+     long size = body ? (long)strlen(body + 1) : -1;
+     if (body && strstr(body, "wrap line 0499\n") && !strstr(body, "wrap line 0000") &&
+         body[1] == '[' && size > 3000 && size <= 4096) {
+         printf("   ✓ Dump giữ %ld byte mới nhất, bắt đầu ở đầu dòng\n", size);
+     } else {
+         printf("   ✗ Dump sau khi ring bị ghi đè sai (%ld byte)\n", size);
+     }
+     free(dump);
+     set_log_level(LOG_LVL_DEBUG);
+ }
+
+ #define RECORD_THREADS 4
+ #define RECORD_LINES 5000
+
+ static void *record_lines(void *arg) {
+     int thread = (int)(long)arg;
+     for (int i = 0; i < RECORD_LINES; i++) {
+         LOG_DEBUG("thread %d line %05d", thread, i);
+     }
+     return NULL;
+ }
+
+ /**
+  * @brief Nhiều luồng ghi cùng lúc: mỗi dòng giữ một vùng riêng của ring, không dòng nào bị trộn
+  */
+ void test_concurrent_record() {
+     printf("\n--- Kiểm tra nhiều luồng ghi vào ring ---\n");
+     reset_files();
+     set_log_file(FLIGHT_LOG);
+     set_log_level(LOG_LVL_NONE);
+
+     log_flight_start(65536, FLIGHT_DUMP);
+     pthread_t threads[RECORD_THREADS];
+     for (long t = 0; t < RECORD_THREADS; t++) {
+         pthread_create(&threads[t], NULL, record_lines, (void *)t);
+     }
+     for (int t = 0; t < RECORD_THREADS; t++) {
+         pthread_join(threads[t], NULL);
+     }
+     log_flight_dump("threads");
+     log_flight_stop();
+
+     char *dump = read_text(FLIGHT_DUMP);
+     char *line = dump ? strchr(dump, '\n') : NULL;
+     int lines = 0, broken = 0;
+     while (line && line[1] != '\0') {
+         line++;
+         char *end = strchr(line, '\n');
+         int thread, number;
+         const char *text = strstr(line, "thread ");
+         if (line[0] != '[' || !end || !text || text > end ||
+             sscanf(text, "thread %d line %d", &thread, &number) != 2 || memchr(text, '[', end - text)) {
+             broken++;
+         }
+         lines++;
+         line = end;
+     }
+     if (lines > 500 && broken == 0) {
+         printf("   ✓ %d luồng ghi đồng thời, %d dòng trong dump đều nguyên vẹn\n", RECORD_THREADS, lines);
+     } else {
+         printf("   ✗ Dump có %d/%d dòng bị trộn\n", broken, lines);
+     }
+     free(dump);
+     set_log_level(LOG_LVL_DEBUG);
+ }
+
+ /**
+  * @brief SIGUSR1 dump và chương trình chạy tiếp
+  */
+ void test_sigusr1_dump() {
+     printf("\n--- Kiểm tra dump khi nhận SIGUSR1 ---\n");
+     reset_files();
+     set_log_file(FLIGHT_LOG);
+
+     log_flight_start(16 * 1024, FLIGHT_DUMP);
+     LOG_DEBUG("before usr1");
+     raise(SIGUSR1);
+     LOG_DEBUG("after usr1");
+     log_flight_dump("end");
+     log_flight_stop();
+
+     char *dump = read_text(FLIGHT_DUMP);
+     const char *usr1 = dump ? strstr(dump, "flight recorder: SIGUSR1") : NULL;
+     const char *end = dump ? strstr(dump, "flight recorder: end") : NULL;
+     if (usr1 && end && strstr(usr1, "before usr1") < end && strstr(end, "after usr1")) {
+         printf("   ✓ SIGUSR1 dump các dòng trước đó, chương trình chạy tiếp\n");
+     } else {
+         printf("   ✗ SIGUSR1 không dump đúng\n");
+     }
+     free(dump);
+ }
+
+ /**
+  * @brief Tiến trình con bị crash vẫn dump được ring trước khi kết thúc
+  */
+ static void check_crash(int sig, const char *name) {
+     reset_files();
+     fflush(stdout);
+     pid_t pid = fork();
+     if (pid == 0) {
+         set_log_file(FLIGHT_LOG);
+         set_log_level(LOG_LVL_ERROR);
+         log_flight_start(16 * 1024, FLIGHT_DUMP);
+         LOG_DEBUG("last words before %s", name);
+         if (sig == SIGSEGV) {
+             volatile int *null_pointer = NULL;
+             *null_pointer = 1;
+         }
+         abort();
+     }
+
+     int status = 0;
+     waitpid(pid, &status, 0);
+     char *dump = read_text(FLIGHT_DUMP);
+     char header[64];
+     char line[64];
+     snprintf(header, sizeof(header), "flight recorder: %s", name);
+     snprintf(line, sizeof(line), "last words before %s", name);
+     if (WIFSIGNALED(status) && WTERMSIG(status) == sig && dump && strstr(dump, header) && strstr(dump, line)) {
+         printf("   ✓ %s: dump có dòng DEBUG cuối, tiến trình vẫn kết thúc bởi tín hiệu\n", name);
+     } else {
+         printf("   ✗ %s: không dump hoặc tiến trình không kết thúc đúng (status %d)\n", name, status);
+     }
+     free(dump);
+ }
+
+ void test_crash_dump() {
+     printf("\n--- Kiểm tra dump khi crash ---\n");
+     check_crash(SIGSEGV, "SIGSEGV");
+     check_crash(SIGABRT, "SIGABRT");
+ }
+
+ static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+     return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+ }
+
+ /**
+  * @brief Chi phí một dòng DEBUG chỉ vào ring so với ghi cả file
+  */
+ void test_flight_benchmark() {
+     printf("\n--- Đo chi phí flight recorder ---\n");
+     reset_files();
+     set_log_file(FLIGHT_LOG);
+     struct timespec start, end;
+
+     set_log_level(LOG_LVL_ERROR);
+     log_flight_start(LOG_FLIGHT_SIZE, FLIGHT_DUMP);
+     clock_gettime(CLOCK_MONOTONIC, &start);
+     for (int i = 0; i < BENCH_LINES; i++) {
+         LOG_DEBUG("bench line %d value %s", i, "payload");
+     }
+     clock_gettime(CLOCK_MONOTONIC, &end);
+     double ring_ns = elapsed_ns(&start, &end) / BENCH_LINES;
+     log_flight_stop();
+
+     set_log_level(LOG_LVL_DEBUG);
+     log_async_start(LOG_ASYNC_SLOTS, LOG_OVERFLOW_BLOCK);
+     clock_gettime(CLOCK_MONOTONIC, &start);
+     for (int i = 0; i < BENCH_LINES; i++) {
+         LOG_DEBUG("bench line %d value %s", i, "payload");
+     }
+     log_flush();
+     clock_gettime(CLOCK_MONOTONIC, &end);
+     double file_ns = elapsed_ns(&start, &end) / BENCH_LINES;
+     log_async_stop();
+
+     printf("   Chỉ ring: %.0f ns/dòng, ghi file (bất đồng bộ): %.0f ns/dòng\n", ring_ns, file_ns);
+     if (ring_ns < file_ns) {
+         printf("   ✓ Giữ dòng DEBUG trong ring rẻ hơn ghi ra file\n");
+     } else {
+         printf("   ✗ Ring chậm hơn ghi file\n");
+     }
+ }
+
+ int main() {
+     printf("\n=================================================\n");
+     printf("      KIỂM THỬ FLIGHT RECORDER (LOG_FLIGHT.C)\n");
+     printf("=================================================\n");
+
+     test_capture_and_dump();
+     test_ring_wrap();
+     test_concurrent_record();
+     test_sigusr1_dump();
+     test_crash_dump();
+     test_flight_benchmark();
+
+     cleanup_logger();
+     reset_files();
+
+     printf("\n=================================================\n");
+     printf("      HOÀN TẤT KIỂM THỬ LOG_FLIGHT.C\n");
+     printf("=================================================\n");
+
+     return 0;
+ }
@@ -0,0 +1,233 @@
+/**
+ * @file test_metrics_server.c
+ * @brief Kiểm thử endpoint OpenMetrics
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <unistd.h>
+ #include <pthread.h>
+ #include <sys/socket.h>
+ #include <netinet/in.h>
+ #include <arpa/inet.h>
+ #include "metrics_server.h"
+ #include "file_process.h"
+ #include "log.h"
+
+ static void make_ping(test_result_info_t *result, const char *id, float rtt, float loss) {
+     memset(result, 0, sizeof(*result));
+     snprintf(result->test_id, sizeof(result->test_id), "%s", id);
+     result->test_type = TEST_PING;
+     result->status = TEST_RESULT_SUCCESS;
+     result->execution_time = 250.0f;
+     result->data.ping.packets_sent = 4;
+     result->data.ping.packets_received = 4;
+     result->data.ping.avg_rtt = rtt;
+     result->data.ping.packet_loss = loss;
+ }
+
+ /**
+  * @brief Gửi một request HTTP tới 127.0.0.1:port, trả về toàn bộ phản hồi
+  */
+ static char *http_get(int port, const char *path) {
+     int fd = socket(AF_INET, SOCK_STREAM, 0);
+     struct sockaddr_in addr;
+     memset(&addr, 0, sizeof(addr));
+     addr.sin_family = AF_INET;
+     addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+     addr.sin_port = htons((uint16_t)port);
+     if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+         if (fd >= 0) {
+             close(fd);
+         }
+         return NULL;
+     }
+
+     char request[128];
+     int len = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: localhost\r\n\r\n", path);
+     if (write(fd, request, len) != len) {
+         close(fd);
+         return NULL;
+     }
+
+     size_t capacity = 65536, used = 0;
+     char *response = (char *)malloc(capacity);
+     ssize_t n;
+     while (response && (n = read(fd, response + used, capacity - used - 1)) > 0) {
+         used += (size_t)n;
+     }
+     close(fd);
+     if (response) {
+         response[used] = '\0';
+     }
+     return response;
+ }
+
+ /**
+  * @brief Kiểm tra định dạng OpenMetrics của trạng thái trong bộ nhớ
+  */
+ void test_render() {
+     printf("\n--- Kiểm tra định dạng OpenMetrics ---\n");
+
+     metrics_enable();
+     test_result_info_t result;
+     for (int i = 1; i <= 100; i++) {
+         metrics_test_started(100 - i);
+         make_ping(&result, "P\"1", (float)i, 0.0f);
+         metrics_record_result(&result);
+     }
+     // Lần sau bị timeout trước khi ping in thống kê: mất gói không còn được công bố
+     metrics_test_started(0);
+     make_ping(&result, "P2", 10.0f, 25.0f);
+     metrics_record_result(&result);
+     metrics_test_started(0);
+     memset(&result, 0, sizeof(result));
+     strcpy(result.test_id, "P2");
+     result.test_type = TEST_PING;
+     result.status = TEST_RESULT_TIMEOUT;
+     metrics_record_result(&result);
+     metrics_test_started(3);
+     memset(&result, 0, sizeof(result));
+     strcpy(result.test_id, "T1");
+     result.test_type = TEST_THROUGHPUT;
+     result.status = TEST_RESULT_FAILED;
+     result.data.throughput.bandwidth = 42.5f;
+     metrics_record_result(&result);
+     metrics_test_started(2);
+
+     char *text = NULL;
+     size_t length = 0;
+     if (metrics_render(&text, &length) != 0) {
+         printf("   ✗ Không định dạng được số liệu\n");
+         return;
+     }
+
+     if (strstr(text, "device_test_queue_depth 2\n") && strstr(text, "device_test_in_flight 1\n") &&
+         strstr(text, "device_test_completed_total 103\n") && strstr(text, "device_test_tests_per_second ")) {
+         printf("   ✓ Có độ dài hàng đợi, số test đang chạy, tổng số và tốc độ\n");
+     } else {
+         printf("   ✗ Thiếu số liệu của bộ chạy\n");
+     }
+
+     if (strstr(text, "device_test_rtt_milliseconds{test_id=\"P\\\"1\",quantile=\"0.5\"} 50.5\n") &&
+         strstr(text, "device_test_rtt_milliseconds{test_id=\"P\\\"1\",quantile=\"0.99\"} 99.01") &&
+         strstr(text, "device_test_rtt_milliseconds_count{test_id=\"P\\\"1\"} 100\n") &&
+         strstr(text, "device_test_rtt_milliseconds_sum{test_id=\"P\\\"1\"} 5050\n")) {
+         printf("   ✓ Phân vị RTT, count và sum đúng, label được escape\n");
+     } else {
+         printf("   ✗ Số liệu RTT sai\n");
+     }
+
+     if (strstr(text, "device_test_status{test_id=\"T1\",device_test_status=\"FAILED\"} 1\n") &&
+         strstr(text, "device_test_status{test_id=\"T1\",device_test_status=\"SUCCESS\"} 0\n") &&
+         strstr(text, "device_test_runs_total{test_id=\"P\\\"1\",status=\"SUCCESS\"} 100\n") &&
+         strstr(text, "device_test_bandwidth_mbps{test_id=\"T1\"} 42.5\n") &&
+         strstr(text, "device_test_packet_loss_percent{test_id=\"P\\\"1\"} 0\n") &&
+         !strstr(text, "device_test_packet_loss_percent{test_id=\"T1\"}")) {
+         printf("   ✓ Trạng thái, số lần chạy, băng thông và mất gói đúng\n");
+     } else {
+         printf("   ✗ Số liệu theo test ID sai\n");
+     }
+
+     if (strstr(text, "device_test_status{test_id=\"P2\",device_test_status=\"TIMEOUT\"} 1\n") &&
+         strstr(text, "device_test_rtt_milliseconds_count{test_id=\"P2\"} 1\n") &&
+         !strstr(text, "device_test_packet_loss_percent{test_id=\"P2\"}")) {
+         printf("   ✓ Ping bị timeout không công bố mất gói 0%%\n");
+     } else {
+         printf("   ✗ Ping bị timeout vẫn công bố mất gói\n");
+     }
+
+     if (strstr(text, "# TYPE device_test_rtt_milliseconds summary\n# UNIT device_test_rtt_milliseconds milliseconds\n") &&
+         length > 6 && strcmp(text + length - 6, "# EOF\n") == 0) {
+         printf("   ✓ Có TYPE/UNIT và kết thúc bằng # EOF\n");
+     } else {
+         printf("   ✗ Cấu trúc OpenMetrics sai\n");
+     }
+     free(text);
+ }
+
+ static volatile int writer_stop = 0;
+
+ static void *record_loop(void *arg) {
+     (void)arg;
+     test_result_info_t result;
+     make_ping(&result, "BUSY", 1.0f, 0.0f);
+     while (!writer_stop) {
+         metrics_test_started(0);
+         metrics_record_result(&result);
+     }
+     return NULL;
+ }
+
+ /**
+  * @brief Kiểm tra phục vụ qua HTTP trong khi luồng khác đang ghi nhận kết quả
+  */
+ void test_http() {
+     printf("\n--- Kiểm tra endpoint HTTP ---\n");
+
+     int port = metrics_server_start(0);
+     if (port <= 0) {
+         printf("   ✗ Không mở được cổng\n");
+         return;
+     }
+     printf("   ✓ Lắng nghe trên 127.0.0.1:%d\n", port);
+
+     pthread_t writer;
+     pthread_create(&writer, NULL, record_loop, NULL);
+
+     bool ok = true;
+     for (int i = 0; i < 20; i++) {
+         char *response = http_get(port, "/metrics");
+         if (!response || strncmp(response, "HTTP/1.1 200 OK\r\n", 17) != 0 ||
+             !strstr(response, "application/openmetrics-text") || !strstr(response, "# EOF\n")) {
+             ok = false;
+         }
+         free(response);
+     }
+     writer_stop = 1;
+     pthread_join(writer, NULL);
+     if (ok) {
+         printf("   ✓ 20 lần scrape đầy đủ trong khi đang ghi kết quả\n");
+     } else {
+         printf("   ✗ Phản hồi /metrics sai\n");
+     }
+
+     char *response = http_get(port, "/other");
+     if (response && strncmp(response, "HTTP/1.1 404", 12) == 0) {
+         printf("   ✓ Đường dẫn khác trả về 404\n");
+     } else {
+         printf("   ✗ Đường dẫn khác không trả về 404\n");
+     }
+     free(response);
+
+     metrics_server_stop();
+     response = http_get(port, "/metrics");
+     if (!response) {
+         printf("   ✓ Đóng cổng sau khi dừng\n");
+     } else {
+         printf("   ✗ Cổng vẫn mở sau khi dừng\n");
+     }
+     free(response);
+ }
+
+ int main() {
+     printf("\n=================================================\n");
+     printf("      KIỂM THỬ MODULE METRICS_SERVER.C\n");
+     printf("=================================================\n");
+
+     set_log_file("test_metrics_server.log");
+     set_log_level(LOG_LVL_DEBUG);
+     init_logger();
+
+     test_render();
+     test_http();
+
+     delete_file("test_metrics_server.log");
+
+     printf("\n=================================================\n");
+     printf("      HOÀN TẤT KIỂM THỬ METRICS_SERVER.C\n");
+     printf("=================================================\n");
+
+     return 0;
+ }
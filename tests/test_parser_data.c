@@ -7,6 +7,7 @@
  #include <stdlib.h>
  #include <string.h>
  #include <assert.h>
+ #include <time.h>
  #include "parser_data.h"
  #include "file_process.h"
  #include "log.h"
@@ -14,6 +15,8 @@
  #define TEST_DATA_FILE "test_data.json"
  #define TEST_OUTPUT_FILE "test_output.json"
  #define TEST_DEFAULT_FILE "test_default.json"
+ #define INDEX_BENCH_CASES 100000
+ #define INDEX_BENCH_LINEAR 1000
  
  /**
   * @brief Thiết lập môi trường kiểm thử
@@ -176,31 +179,31 @@
          
          // Kiểm tra dữ liệu của test case đầu tiên
          printf("2. Kiểm tra dữ liệu test case đầu tiên (TC001)...\n");
-         if (strcmp(test_cases[0].id, "TC001") == 0) {
-             printf("   ✓ ID test case chính xác: %s\n", test_cases[0].id);
+         if (strcmp(test_case_id(&test_cases[0]), "TC001") == 0) {
+             printf("   ✓ ID test case chính xác: %s\n", test_case_id(&test_cases[0]));
          } else {
-             printf("   ✗ ID test case không chính xác, kỳ vọng: TC001, thực tế: %s\n", test_cases[0].id);
+             printf("   ✗ ID test case không chính xác, kỳ vọng: TC001, thực tế: %s\n", test_case_id(&test_cases[0]));
          }
          
          // Kiểm tra các trường cơ bản
-         if (strcmp(test_cases[0].name, "Local Server Ping Test") == 0) {
+         if (strcmp(test_case_name(&test_cases[0]), "Local Server Ping Test") == 0) {
              printf("   ✓ Tên test case chính xác\n");
          } else {
              printf("   ✗ Tên test case không chính xác\n");
          }
          
-         if (strcmp(test_cases[0].description, "Test connectivity to local server") == 0) {
+         if (strcmp(test_case_description(&test_cases[0]), "Test connectivity to local server") == 0) {
              printf("   ✓ Mô tả test case chính xác\n");
          } else {
              printf("   ✗ Mô tả test case không chính xác, kỳ vọng: 'Test connectivity to local server', thực tế: '%s'\n", 
-                    test_cases[0].description);
+                    test_case_description(&test_cases[0]));
          }
          
-         if (strcmp(test_cases[0].target, "192.168.1.100") == 0) {
+         if (strcmp(test_case_target(&test_cases[0]), "192.168.1.100") == 0) {
              printf("   ✓ Target test case chính xác\n");
          } else {
              printf("   ✗ Target test case không chính xác, kỳ vọng: '192.168.1.100', thực tế: '%s'\n", 
-                    test_cases[0].target);
+                    test_case_target(&test_cases[0]));
          }
          
          if (test_cases[0].timeout == 5000) {
@@ -298,25 +301,25 @@
          printf("   ✓ Phân tích thành công %d test cases từ chuỗi JSON\n", count);
          
          // Kiểm tra dữ liệu của test case
-         if (strcmp(test_cases[0].id, "TC004") == 0) {
-             printf("   ✓ ID test case chính xác: %s\n", test_cases[0].id);
+         if (strcmp(test_case_id(&test_cases[0]), "TC004") == 0) {
+             printf("   ✓ ID test case chính xác: %s\n", test_case_id(&test_cases[0]));
          } else {
-             printf("   ✗ ID test case không chính xác, kỳ vọng: TC004, thực tế: %s\n", test_cases[0].id);
+             printf("   ✗ ID test case không chính xác, kỳ vọng: TC004, thực tế: %s\n", test_case_id(&test_cases[0]));
          }
          
          // Kiểm tra các trường cơ bản mới
-         if (strcmp(test_cases[0].description, "A custom test case") == 0) {
+         if (strcmp(test_case_description(&test_cases[0]), "A custom test case") == 0) {
              printf("   ✓ Mô tả test case chính xác\n");
          } else {
              printf("   ✗ Mô tả test case không chính xác, kỳ vọng: 'A custom test case', thực tế: '%s'\n", 
-                    test_cases[0].description);
+                    test_case_description(&test_cases[0]));
          }
          
-         if (strcmp(test_cases[0].target, "localhost") == 0) {
+         if (strcmp(test_case_target(&test_cases[0]), "localhost") == 0) {
              printf("   ✓ Target test case chính xác\n");
          } else {
              printf("   ✗ Target test case không chính xác, kỳ vọng: 'localhost', thực tế: '%s'\n", 
-                    test_cases[0].target);
+                    test_case_target(&test_cases[0]));
          }
          
          if (test_cases[0].timeout == 1000) {
@@ -365,7 +368,7 @@
          printf("2. Kiểm tra các giá trị mặc định cho TC005...\n");
          test_case_t *tc5 = NULL;
          for (int i = 0; i < count; i++) {
-             if (strcmp(test_cases[i].id, "TC005") == 0) {
+             if (strcmp(test_case_id(&test_cases[i]), "TC005") == 0) {
                  tc5 = &test_cases[i];
                  break;
              }
@@ -375,17 +378,17 @@
              printf("   ✓ Tìm thấy test case TC005\n");
              
              // Description mặc định là rỗng
-             if (strlen(tc5->description) == 0) {
+             if (strlen(test_case_description(tc5)) == 0) {
                  printf("   ✓ Mô tả mặc định là rỗng\n");
              } else {
-                 printf("   ✗ Mô tả mặc định không đúng, kỳ vọng: '', thực tế: '%s'\n", tc5->description);
+                 printf("   ✗ Mô tả mặc định không đúng, kỳ vọng: '', thực tế: '%s'\n", test_case_description(tc5));
              }
              
              // Target mặc định là rỗng
-             if (strlen(tc5->target) == 0) {
+             if (strlen(test_case_target(tc5)) == 0) {
                  printf("   ✓ Target mặc định là rỗng\n");
              } else {
-                 printf("   ✗ Target mặc định không đúng, kỳ vọng: '', thực tế: '%s'\n", tc5->target);
+                 printf("   ✗ Target mặc định không đúng, kỳ vọng: '', thực tế: '%s'\n", test_case_target(tc5));
              }
              
              // Timeout mặc định là 10000
@@ -435,11 +438,11 @@
          printf("3. Kiểm tra ID mặc định cho test case thiếu ID...\n");
          bool found_missing_id = false;
          for (int i = 0; i < count; i++) {
-             if (strncmp(test_cases[i].id, "TC", 2) == 0 && 
-                 test_cases[i].id[2] >= '0' && test_cases[i].id[2] <= '9' &&
-                 strcmp(test_cases[i].name, "Missing ID Test") == 0) {
+             if (strncmp(test_case_id(&test_cases[i]), "TC", 2) == 0 && 
+                 test_case_id(&test_cases[i])[2] >= '0' && test_case_id(&test_cases[i])[2] <= '9' &&
+                 strcmp(test_case_name(&test_cases[i]), "Missing ID Test") == 0) {
                  found_missing_id = true;
-                 printf("   ✓ ID mặc định được tạo: %s\n", test_cases[i].id);
+                 printf("   ✓ ID mặc định được tạo: %s\n", test_case_id(&test_cases[i]));
                  break;
              }
          }
@@ -522,11 +525,11 @@
                      }
                      
                      // So sánh ID test case đầu tiên
-                     if (strcmp(test_cases[0].id, test_cases2[0].id) == 0) {
+                     if (strcmp(test_case_id(&test_cases[0]), test_case_id(&test_cases2[0])) == 0) {
                          printf("   ✓ ID test case nhất quán\n");
                      } else {
                          printf("   ✗ ID test case không nhất quán, ban đầu: %s, sau chuyển đổi: %s\n", 
-                               test_cases[0].id, test_cases2[0].id);
+                               test_case_id(&test_cases[0]), test_case_id(&test_cases2[0]));
                      }
                      
                      // Giải phóng bộ nhớ
@@ -642,14 +645,14 @@ void test_extra_data() {
         printf("   ✓ Phân tích thành công JSON với extra_data\n");
         
         // Kiểm tra ID
-        if (strcmp(test_cases[0].id, "TC008") == 0) {
-            printf("   ✓ ID test case chính xác: %s\n", test_cases[0].id);
+        if (strcmp(test_case_id(&test_cases[0]), "TC008") == 0) {
+            printf("   ✓ ID test case chính xác: %s\n", test_case_id(&test_cases[0]));
         } else {
-            printf("   ✗ ID test case không chính xác, kỳ vọng: TC008, thực tế: %s\n", test_cases[0].id);
+            printf("   ✗ ID test case không chính xác, kỳ vọng: TC008, thực tế: %s\n", test_case_id(&test_cases[0]));
         }
         
         // Kiểm tra extra_data
-        if (test_cases[0].extra_data != NULL) {
+        if (test_case_extra_data(&test_cases[0]) != NULL) {
             printf("   ✓ extra_data được trích xuất\n");
             
             // Kiểm tra chuỗi JSON trong extra_data có chứa các giá trị kỳ vọng
@@ -657,7 +660,7 @@ void test_extra_data() {
             int found_count = 0;
             
             for (int i = 0; i < sizeof(expected_values) / sizeof(expected_values[0]); i++) {
-                if (strstr(test_cases[0].extra_data, expected_values[i]) != NULL) {
+                if (strstr(test_case_extra_data(&test_cases[0]), expected_values[i]) != NULL) {
                     found_count++;
                 }
             }
@@ -667,10 +670,10 @@ void test_extra_data() {
             
             // In một phần extra_data
             printf("   - Một phần extra_data:\n");
-            int preview_length = strlen(test_cases[0].extra_data) < 100 ? 
-                                 strlen(test_cases[0].extra_data) : 100;
+            int preview_length = strlen(test_case_extra_data(&test_cases[0])) < 100 ? 
+                                 strlen(test_case_extra_data(&test_cases[0])) : 100;
             char preview[101];
-            strncpy(preview, test_cases[0].extra_data, preview_length);
+            strncpy(preview, test_case_extra_data(&test_cases[0]), preview_length);
             preview[preview_length] = '\0';
             printf("%s...\n", preview);
         } else {
@@ -729,15 +732,15 @@ void test_integration() {
             printf("   - Đọc được %d test case(s)\n", count);
             
             // Kiểm tra ID của test case
-            if (count > 0 && strcmp(test_cases[0].id, "TC006") == 0) {
+            if (count > 0 && strcmp(test_case_id(&test_cases[0]), "TC006") == 0) {
                 printf("   ✓ ID test case chính xác\n");
             } else {
                 printf("   ✗ ID test case không chính xác\n");
             }
             
             // Kiểm tra các trường bổ sung để xác nhận tích hợp hoàn chỉnh
-            if (strcmp(test_cases[0].description, "Testing integration") == 0 &&
-                strcmp(test_cases[0].target, "localhost") == 0 &&
+            if (strcmp(test_case_description(&test_cases[0]), "Testing integration") == 0 &&
+                strcmp(test_case_target(&test_cases[0]), "localhost") == 0 &&
                 test_cases[0].timeout == 1000 &&
                 test_cases[0].enabled == true) {
                 printf("   ✓ Các trường bổ sung của test case được trích xuất chính xác\n");
@@ -772,8 +775,8 @@ void test_integration() {
             
             for (int i = 0; i < count; i++) {
                 log_message(LOG_LVL_DEBUG, "Test case %d: ID=%s, Name=%s, Desc=%s, Target=%s, Timeout=%d, Enabled=%s",
-                           i+1, test_cases[i].id, test_cases[i].name, test_cases[i].description,
-                           test_cases[i].target, test_cases[i].timeout,
+                           i+1, test_case_id(&test_cases[i]), test_case_name(&test_cases[i]), test_case_description(&test_cases[i]),
+                           test_case_target(&test_cases[i]), test_cases[i].timeout,
                            test_cases[i].enabled ? "true" : "false");
             }
             
@@ -829,6 +832,179 @@ void test_integration() {
     printf("=> Kiểm tra tích hợp với các module khác hoàn tất.\n");
 }
 
+/**
+ * @brief Kiểm tra test matrix được sinh lười theo chỉ số
+ */
+void test_matrix_expansion() {
+    printf("\n--- Kiểm tra test matrix ---\n");
+    
+    const char *json = "{\"test_cases\": [],"
+                       " \"matrices\": [{\"id\": \"M1\", \"name\": \"Ping sweep\", \"type\": \"ping\","
+                       "  \"target\": \"10.0.0.1\", \"ping_params\": {\"count\": 2},"
+                       "  \"axes\": {\"target\": [\"10.0.0.1\", \"10.0.0.2\", \"10.0.0.3\"],"
+                       "            \"size\": [64, 1400], \"network\": [\"LAN\", \"WAN\"]}}]}";
+    
+    test_case_t *test_cases = NULL;
+    int count = -1;
+    test_matrix_set_t matrices;
+    
+    printf("1. Phân tích suite chỉ có matrix...\n");
+    if (!parse_json_suite(json, &test_cases, &count, &matrices) || count != 0 || matrices.count != 1) {
+        printf("   ✗ Không phân tích được matrix\n");
+        return;
+    }
+    printf("   ✓ Phân tích được %d matrix\n", matrices.count);
+    
+    long total = test_matrix_set_size(&matrices);
+    if (total == 12) {
+        printf("   ✓ Matrix sinh ra %ld test cases (3 x 2 x 2)\n", total);
+    } else {
+        printf("   ✗ Số test case không đúng, kỳ vọng: 12, thực tế: %ld\n", total);
+    }
+    
+    printf("2. Sinh test case theo chỉ số...\n");
+    test_matrix_item_t item;
+    test_matrix_item_init(&item);
+    
+    // Trục cuối (network) thay đổi nhanh nhất: index 7 = target[1], size[1], network[1]
+    if (test_matrix_expand(&matrices, 0, 7, &item) &&
+        strcmp(test_case_id(&item.test_case), "M1_8") == 0 &&
+        strcmp(test_case_target(&item.test_case), "10.0.0.2") == 0 &&
+        item.test_case.params.ping.size == 1400 && item.test_case.params.ping.count == 2 &&
+        item.test_case.network_type == NETWORK_WAN) {
+        printf("   ✓ Test case %s: %s, size %d\n", test_case_id(&item.test_case),
+               test_case_target(&item.test_case), item.test_case.params.ping.size);
+    } else {
+        printf("   ✗ Test case sinh ra không đúng\n");
+    }
+    
+    if (!test_matrix_expand(&matrices, 0, total, &item)) {
+        printf("   ✓ Chỉ số vượt phạm vi bị từ chối\n");
+    } else {
+        printf("   ✗ Chỉ số vượt phạm vi vẫn được chấp nhận\n");
+    }
+    
+    test_matrix_item_free(&item);
+    free_test_matrices(&matrices);
+    
+    printf("3. parse_json_content vẫn yêu cầu test_cases không rỗng...\n");
+    if (!parse_json_content(json, &test_cases, &count)) {
+        printf("   ✓ Suite chỉ có matrix bị từ chối khi không yêu cầu matrix\n");
+    } else {
+        printf("   ✗ parse_json_content chấp nhận suite rỗng\n");
+        free_test_cases(test_cases, count);
+    }
+    
+    printf("4. Giá trị trục sai sau nhiều target (pool được cấp phát lại)...\n");
+    char big_json[32768];
+    int len = snprintf(big_json, sizeof(big_json),
+                       "{\"test_cases\": [], \"matrices\": [{\"id\": \"M2\", \"type\": \"ping\","
+                       " \"target\": \"10.0.0.1\", \"axes\": {\"target\": [");
+    for (int t = 0; t < 300; t++) {
+        len += snprintf(big_json + len, sizeof(big_json) - len, "\"host-%03d.example.internal.lan\", ", t);
+    }
+    snprintf(big_json + len, sizeof(big_json) - len, "5, \"last.example.internal.lan\"]}}]}");
+    if (parse_json_suite(big_json, &test_cases, &count, &matrices) && matrices.count == 1 &&
+        test_matrix_set_size(&matrices) == 301) {
+        printf("   ✓ Bỏ qua giá trị sai, giữ 301 target\n");
+    } else {
+        printf("   ✗ Matrix có nhiều target phân tích sai\n");
+    }
+    free_test_cases(test_cases, count);
+    free_test_matrices(&matrices);
+    
+    printf("=> Kiểm tra test matrix hoàn tất.\n");
+}
+
+/**
+ * @brief Kiểm tra bảng chỉ mục ID và phát hiện ID trùng lặp
+ */
+void test_index_lookup() {
+    printf("\n--- Kiểm tra tra cứu test case theo ID ---\n");
+    
+    printf("1. Phát hiện ID trùng lặp khi nạp...\n");
+    const char *dup_json = "{\"test_cases\": ["
+                           "{\"id\": \"DUP1\", \"name\": \"A\", \"type\": \"ping\", \"target\": \"10.0.0.1\"},"
+                           "{\"id\": \"DUP2\", \"name\": \"B\", \"type\": \"ping\", \"target\": \"10.0.0.2\"},"
+                           "{\"id\": \"DUP1\", \"name\": \"C\", \"type\": \"ping\", \"target\": \"10.0.0.3\"}]}";
+    test_case_t *test_cases = NULL;
+    int count = 0;
+    if (!parse_json_content(dup_json, &test_cases, &count)) {
+        printf("   ✓ Suite có ID trùng lặp bị từ chối\n");
+    } else {
+        printf("   ✗ Suite có ID trùng lặp vẫn được chấp nhận\n");
+        free_test_cases(test_cases, count);
+    }
+    
+    printf("2. Benchmark tra cứu với %d test cases...\n", INDEX_BENCH_CASES);
+    test_cases = alloc_test_cases(INDEX_BENCH_CASES);
+    string_pool_t pool;
+    if (!test_cases || string_pool_init(&pool, 0) != 0) {
+        printf("   ✗ Không cấp phát được bộ nhớ cho benchmark\n");
+        free(test_cases);
+        return;
+    }
+    char id[32];
+    for (int i = 0; i < INDEX_BENCH_CASES; i++) {
+        snprintf(id, sizeof(id), "BENCH_%06d", i);
+        test_cases[i].id = string_pool_intern(&pool, id);
+        test_cases[i].type = TEST_PING;
+    }
+    attach_string_table(test_cases, INDEX_BENCH_CASES, &pool);
+    
+    struct timespec t0, t1, t2;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    test_case_index_t index;
+    int duplicates = test_case_index_build(&index, test_cases, INDEX_BENCH_CASES);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    
+    int found = 0;
+    for (int i = 0; i < INDEX_BENCH_CASES; i++) {
+        snprintf(id, sizeof(id), "BENCH_%06d", (i * 7919) % INDEX_BENCH_CASES);
+        if (test_case_index_find(&index, id) == (i * 7919) % INDEX_BENCH_CASES) {
+            found++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    double build_ms = (t1.tv_sec - t0.tv_sec) * 1000.0 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+    double lookup_ns = ((t2.tv_sec - t1.tv_sec) * 1e9 + (t2.tv_nsec - t1.tv_nsec)) / INDEX_BENCH_CASES;
+    
+    if (duplicates == 0 && found == INDEX_BENCH_CASES) {
+        printf("   ✓ Xây chỉ mục: %.2f ms, tra cứu: %.0f ns/lần (%d/%d tìm thấy)\n",
+               build_ms, lookup_ns, found, INDEX_BENCH_CASES);
+    } else {
+        printf("   ✗ Tra cứu sai: %d/%d tìm thấy, %d trùng lặp\n", found, INDEX_BENCH_CASES, duplicates);
+    }
+    
+    // So sánh với quét tuyến tính trên một mẫu nhỏ
+    int linear_found = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < INDEX_BENCH_LINEAR; i++) {
+        snprintf(id, sizeof(id), "BENCH_%06d", (i * 7919) % INDEX_BENCH_CASES);
+        for (int j = 0; j < INDEX_BENCH_CASES; j++) {
+            if (strcmp(test_case_id(&test_cases[j]), id) == 0) {
+                linear_found++;
+                break;
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double linear_ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / INDEX_BENCH_LINEAR;
+    printf("   Quét tuyến tính: %.0f ns/lần (%d mẫu), nhanh hơn %.0f lần\n",
+           linear_ns, linear_found, lookup_ns > 0 ? linear_ns / lookup_ns : 0.0);
+    
+    if (find_test_case_by_id(&index, "BENCH_100000") == NULL && test_case_index_find(&index, "") == -1) {
+        printf("   ✓ ID không tồn tại trả về NULL/-1\n");
+    } else {
+        printf("   ✗ ID không tồn tại vẫn được tìm thấy\n");
+    }
+    
+    test_case_index_free(&index);
+    free_test_cases(test_cases, INDEX_BENCH_CASES);
+    
+    printf("=> Kiểm tra tra cứu test case theo ID hoàn tất.\n");
+}
+
 /**
  * @brief Hàm main chạy tất cả các bài kiểm thử
  */
@@ -853,6 +1029,8 @@ int main() {
     // Chạy các bài kiểm thử mới
     test_default_values();
     test_extra_data();
+    test_matrix_expansion();
+    test_index_lookup();
     
     // Dọn dẹp môi trường kiểm thử
     cleanup_test_environment();
@@ -0,0 +1,309 @@
+/**
+ * @file test_result_compare.c
+ * @brief Kiểm thử so sánh kết quả với baseline và phát hiện hồi quy
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <math.h>
+ #include "result_compare.h"
+ #include "result_store.h"
+ #include "file_process.h"
+ #include "log.h"
+ #include "cjson/cJSON.h"
+
+ #define TEST_STORE_FILE "test_result_compare.rstore"
+ #define TEST_REPORT_FILE "test_result_compare_report.json"
+ #define TEST_DIFF_FILE "test_result_compare_diff.json"
+
+ static void make_ping(test_result_info_t *result, const char *id, float rtt, float loss, int64_t ts) {
+     memset(result, 0, sizeof(*result));
+     snprintf(result->test_id, sizeof(result->test_id), "%s", id);
+     result->test_type = TEST_PING;
+     result->status = TEST_RESULT_SUCCESS;
+     result->execution_time = 1000.0f;
+     result->data.ping.packets_sent = 10;
+     result->data.ping.packets_received = (int)(10 - loss / 10);
+     result->data.ping.min_rtt = rtt * 0.8f;
+     result->data.ping.avg_rtt = rtt;
+     result->data.ping.max_rtt = rtt * 1.3f;
+     result->data.ping.packet_loss = loss;
+     result->started_at = ts;
+ }
+
+ static void make_throughput(test_result_info_t *result, const char *id, float bandwidth, int64_t ts) {
+     memset(result, 0, sizeof(*result));
+     snprintf(result->test_id, sizeof(result->test_id), "%s", id);
+     result->test_type = TEST_THROUGHPUT;
+     result->status = TEST_RESULT_SUCCESS;
+     result->data.throughput.bandwidth = bandwidth;
+     result->started_at = ts;
+ }
+
+ /* Dao động nhỏ, lặp lại được, quanh giá trị gốc */
+ static float jitter(int i, float base) {
+     return base * (1.0f + 0.02f * (float)((i * 7) % 5 - 2));
+ }
+
+ /**
+  * @brief Baseline 20 lần chạy trong kho lịch sử, mỗi lần 4 test
+  */
+ static int build_history() {
+     delete_file(TEST_STORE_FILE);
+     test_result_info_t run[4];
+     for (int i = 0; i < 20; i++) {
+         int64_t ts = 1700000000000LL + i * 60000LL;
+         make_ping(&run[0], "RTT_UP", jitter(i, 10.0f), 0.0f, ts);
+         make_ping(&run[1], "STABLE", jitter(i, 5.0f), 0.0f, ts);
+         make_throughput(&run[2], "BW", jitter(i, 90.0f), ts);
+         make_ping(&run[3], "GONE", jitter(i, 3.0f), 0.0f, ts);
+         if (result_store_append(TEST_STORE_FILE, run, 4) != 0) {
+             return -1;
+         }
+     }
+     return 0;
+ }
+
+ static compare_verdict_t metric_verdict(const result_compare_t *cmp, const char *id, compare_metric_t metric,
+                                         compare_metric_result_t *out) {
+     const compare_entry_t *entry = result_compare_find(cmp, id);
+     if (!entry || !result_compare_metric(cmp, entry, metric, out)) {
+         return (compare_verdict_t)-1;
+     }
+     return out->verdict;
+ }
+
+ /**
+  * @brief Kiểm tra một lần chạy so với lịch sử trong kho
+  */
+ void test_run_against_history() {
+     printf("\n--- Kiểm tra so sánh một lần chạy với kho lịch sử ---\n");
+
+     if (build_history() != 0) {
+         printf("   ✗ Không tạo được kho lịch sử\n");
+         return;
+     }
+
+     result_compare_t cmp;
+     result_compare_init(&cmp);
+     if (result_compare_load(&cmp, COMPARE_BASELINE, TEST_STORE_FILE, NULL) != 0) {
+         printf("   ✗ Không nạp được baseline từ kho\n");
+         return;
+     }
+
+     test_result_info_t current[5];
+     make_ping(&current[0], "RTT_UP", 14.0f, 20.0f, 0);     // RTT +40%, mất gói 20 điểm
+     make_ping(&current[1], "STABLE", 5.1f, 0.0f, 0);       // trong dao động bình thường
+     make_throughput(&current[2], "BW", 60.0f, 0);          // băng thông giảm 33%
+     make_ping(&current[3], "NEW", 1.0f, 0.0f, 0);
+     make_ping(&current[4], "STABLE", 5.0f, 0.0f, 0);
+     current[4].status = TEST_RESULT_ERROR;                 // lỗi không góp mẫu
+     for (int i = 0; i < 5; i++) {
+         result_compare_add_result(&cmp, COMPARE_CURRENT, &current[i]);
+     }
+
+     printf("1. Ghép theo test ID...\n");
+     const compare_entry_t *stable = result_compare_find(&cmp, "STABLE");
+     if (cmp.count == 5 && stable && stable->runs[COMPARE_BASELINE] == 20 && stable->runs[COMPARE_CURRENT] == 2 &&
+         stable->samples[COMPARE_CURRENT][COMPARE_RTT].count == 1 && !result_compare_find(&cmp, "NONE")) {
+         printf("   ✓ 5 test ID, kết quả ERROR được đếm nhưng không góp mẫu\n");
+     } else {
+         printf("   ✗ Ghép test ID sai (%d)\n", cmp.count);
+     }
+
+     printf("2. Phát hiện hồi quy...\n");
+     compare_metric_result_t r;
+     if (metric_verdict(&cmp, "RTT_UP", COMPARE_RTT, &r) == COMPARE_REGRESSION && r.p_value < 0.001 &&
+         fabs(r.change_pct - 40.0) < 3.0 && r.side[COMPARE_BASELINE].n == 20) {
+         printf("   ✓ RTT tăng 40%% là hồi quy (p=%.2g)\n", r.p_value);
+     } else {
+         printf("   ✗ Không phát hiện hồi quy RTT\n");
+     }
+     if (metric_verdict(&cmp, "RTT_UP", COMPARE_LOSS, &r) == COMPARE_REGRESSION && fabs(r.delta - 20.0) < 1e-6) {
+         printf("   ✓ Mất gói tăng từ 0 lên 20%% là hồi quy\n");
+     } else {
+         printf("   ✗ Không phát hiện hồi quy mất gói\n");
+     }
+     if (metric_verdict(&cmp, "BW", COMPARE_BANDWIDTH, &r) == COMPARE_REGRESSION && r.change_pct < -30.0) {
+         printf("   ✓ Băng thông giảm là hồi quy\n");
+     } else {
+         printf("   ✗ Không phát hiện hồi quy băng thông\n");
+     }
+     if (metric_verdict(&cmp, "STABLE", COMPARE_RTT, &r) == COMPARE_UNCHANGED) {
+         printf("   ✓ Dao động trong phạm vi lịch sử không bị báo\n");
+     } else {
+         printf("   ✗ Báo nhầm hồi quy cho test ổn định\n");
+     }
+
+     printf("3. Kết luận theo test ID...\n");
+     if (result_compare_entry_verdict(&cmp, result_compare_find(&cmp, "RTT_UP")) == COMPARE_REGRESSION &&
+         result_compare_entry_verdict(&cmp, result_compare_find(&cmp, "STABLE")) == COMPARE_UNCHANGED &&
+         result_compare_entry_verdict(&cmp, result_compare_find(&cmp, "GONE")) == COMPARE_MISSING &&
+         result_compare_entry_verdict(&cmp, result_compare_find(&cmp, "NEW")) == COMPARE_NEW) {
+         printf("   ✓ regression / unchanged / missing / new đúng\n");
+     } else {
+         printf("   ✗ Kết luận theo test ID sai\n");
+     }
+
+     printf("4. Ghi diff JSON...\n");
+     compare_summary_t summary;
+     cJSON *root = NULL;
+     char *content = NULL;
+     size_t size = 0;
+     if (result_compare_write_file(&cmp, TEST_DIFF_FILE, TEST_STORE_FILE, "current", &summary) == 0 &&
+         read_file(TEST_DIFF_FILE, &content, &size) == 0) {
+         root = cJSON_Parse(content);
+     }
+     cJSON *sum = root ? cJSON_GetObjectItem(root, "summary") : NULL;
+     cJSON *tests = root ? cJSON_GetObjectItem(root, "tests") : NULL;
+     cJSON *first = tests ? cJSON_GetArrayItem(tests, 0) : NULL;
+     cJSON *metrics = first ? cJSON_GetObjectItem(first, "metrics") : NULL;
+     cJSON *rtt = metrics ? cJSON_GetObjectItem(metrics, "rtt_ms") : NULL;
+     cJSON *base = rtt ? cJSON_GetObjectItem(rtt, "baseline") : NULL;
+     if (sum && summary.counts[COMPARE_REGRESSION] == 2 &&
+         cJSON_GetObjectItem(sum, "regression")->valueint == 2 &&
+         cJSON_GetObjectItem(sum, "missing")->valueint == 1 &&
+         strcmp(cJSON_GetObjectItem(first, "verdict")->valuestring, "regression") == 0 &&
+         base && cJSON_GetObjectItem(base, "p95") && cJSON_GetObjectItem(base, "n")->valueint == 20) {
+         printf("   ✓ Diff có tổng hợp, phân vị và kết luận từng số đo\n");
+     } else {
+         printf("   ✗ Nội dung diff JSON sai\n");
+     }
+     cJSON_Delete(root);
+     free(content);
+
+     result_compare_free(&cmp);
+ }
+
+ /**
+  * @brief Kiểm tra so sánh hai báo cáo tổng hợp và trường hợp thiếu mẫu
+  */
+ void test_reports() {
+     printf("\n--- Kiểm tra so sánh với báo cáo tổng hợp ---\n");
+
+     // Báo cáo có 5 lần chạy của cùng test ID (ví dụ lặp lại), RTT khoảng 20ms
+     test_result_info_t results[6];
+     for (int i = 0; i < 5; i++) {
+         make_ping(&results[i], "P", jitter(i, 20.0f), 0.0f, 1700000000000LL + i);
+     }
+     make_ping(&results[5], "ONCE", 8.0f, 0.0f, 1700000000000LL);
+     if (generate_summary_report(results, 6, TEST_REPORT_FILE) != 0) {
+         printf("   ✗ Không tạo được báo cáo\n");
+         return;
+     }
+
+     result_compare_t cmp;
+     result_compare_init(&cmp);
+     if (result_compare_load(&cmp, COMPARE_BASELINE, TEST_REPORT_FILE, NULL) != 0) {
+         printf("   ✗ Không nạp được baseline từ báo cáo\n");
+         return;
+     }
+
+     // Lần chạy hiện tại cải thiện RTT rõ rệt với đủ mẫu: Mann-Whitney
+     test_result_info_t current;
+     for (int i = 0; i < 5; i++) {
+         make_ping(&current, "P", jitter(i, 12.0f), 0.0f, 0);
+         result_compare_add_result(&cmp, COMPARE_CURRENT, &current);
+     }
+     make_ping(&current, "ONCE", 30.0f, 0.0f, 0);
+     result_compare_add_result(&cmp, COMPARE_CURRENT, &current);
+
+     compare_metric_result_t r;
+     if (metric_verdict(&cmp, "P", COMPARE_RTT, &r) == COMPARE_IMPROVEMENT && r.p_value < 0.05 &&
+         r.side[COMPARE_CURRENT].n == 5) {
+         printf("   ✓ RTT giảm với 5 mẫu mỗi bên là cải thiện (p=%.3f)\n", r.p_value);
+     } else {
+         printf("   ✗ Không nhận ra cải thiện RTT\n");
+     }
+     if (metric_verdict(&cmp, "ONCE", COMPARE_RTT, &r) == COMPARE_INSUFFICIENT && isnan(r.p_value)) {
+         printf("   ✓ Baseline một mẫu không đủ để kết luận hồi quy\n");
+     } else {
+         printf("   ✗ Kết luận với baseline một mẫu sai\n");
+     }
+
+     // Ngưỡng thay đổi chặn các thay đổi nhỏ dù có ý nghĩa thống kê
+     result_compare_free(&cmp);
+     result_compare_init(&cmp);
+     cmp.threshold_pct = 50.0;
+     result_compare_load(&cmp, COMPARE_BASELINE, TEST_REPORT_FILE, NULL);
+     for (int i = 0; i < 5; i++) {
+         make_ping(&current, "P", jitter(i, 24.0f), 0.0f, 0);
+         result_compare_add_result(&cmp, COMPARE_CURRENT, &current);
+     }
+     if (metric_verdict(&cmp, "P", COMPARE_RTT, &r) == COMPARE_UNCHANGED && r.p_value < 0.05) {
+         printf("   ✓ Thay đổi 20%% dưới ngưỡng 50%% không bị báo\n");
+     } else {
+         printf("   ✗ Ngưỡng thay đổi không được áp dụng\n");
+     }
+     result_compare_free(&cmp);
+
+     result_compare_init(&cmp);
+     if (result_compare_load(&cmp, COMPARE_BASELINE, "khong_ton_tai.json", NULL) == -1) {
+         printf("   ✓ Baseline không tồn tại báo lỗi\n");
+     } else {
+         printf("   ✗ Baseline không tồn tại không báo lỗi\n");
+     }
+     result_compare_free(&cmp);
+ }
+
+ /**
+  * @brief Kiểm tra lần chạy hiện tại bị timeout không bị coi là cải thiện mất gói
+  */
+ void test_timed_out_run() {
+     printf("\n--- Kiểm tra lần chạy bị timeout ---\n");
+
+     result_compare_t cmp;
+     result_compare_init(&cmp);
+     test_result_info_t run;
+     for (int i = 0; i < 20; i++) {
+         make_ping(&run, "LOSSY", jitter(i, 10.0f), 5.0f, 0);
+         result_compare_add_result(&cmp, COMPARE_BASELINE, &run);
+     }
+
+     // Timeout trước khi ping in thống kê: không có số đo nào
+     for (int i = 0; i < 5; i++) {
+         memset(&run, 0, sizeof(run));
+         snprintf(run.test_id, sizeof(run.test_id), "LOSSY");
+         run.test_type = TEST_PING;
+         run.status = TEST_RESULT_TIMEOUT;
+         result_compare_add_result(&cmp, COMPARE_CURRENT, &run);
+     }
+
+     const compare_entry_t *entry = result_compare_find(&cmp, "LOSSY");
+     compare_metric_result_t r;
+     if (entry && entry->runs[COMPARE_CURRENT] == 5 && entry->samples[COMPARE_CURRENT][COMPARE_LOSS].count == 0 &&
+         entry->samples[COMPARE_CURRENT][COMPARE_RTT].count == 0 &&
+         metric_verdict(&cmp, "LOSSY", COMPARE_LOSS, &r) != COMPARE_IMPROVEMENT &&
+         result_compare_entry_verdict(&cmp, entry) != COMPARE_IMPROVEMENT) {
+         printf("   ✓ Timeout không góp mẫu mất gói 0%% và không được báo là cải thiện\n");
+     } else {
+         printf("   ✗ Timeout bị tính là mất gói 0%%\n");
+     }
+     result_compare_free(&cmp);
+ }
+
+ int main() {
+     printf("\n=================================================\n");
+     printf("      KIỂM THỬ MODULE RESULT_COMPARE.C\n");
+     printf("=================================================\n");
+
+     set_log_file("test_result_compare.log");
+     set_log_level(LOG_LVL_DEBUG);
+     init_logger();
+
+     test_run_against_history();
+     test_reports();
+    test_timed_out_run();
+
+     delete_file(TEST_STORE_FILE);
+     delete_file(TEST_REPORT_FILE);
+     delete_file(TEST_DIFF_FILE);
+     delete_file("test_result_compare.log");
+
+     printf("\n=================================================\n");
+     printf("      HOÀN TẤT KIỂM THỬ RESULT_COMPARE.C\n");
+     printf("=================================================\n");
+
+     return 0;
+ }
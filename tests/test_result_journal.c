@@ -0,0 +1,242 @@
+/**
+ * @file test_result_journal.c
+ * @brief Kiểm thử journal kết quả dạng NDJSON
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include "result_journal.h"
+ #include "file_process.h"
+ #include "log.h"
+
+ #define TEST_JOURNAL_FILE "test_result_journal.ndjson"
+
+ static void make_result(test_result_info_t *result, const char *id, test_type_t type, test_result_status_t status) {
+     memset(result, 0, sizeof(*result));
+     snprintf(result->test_id, sizeof(result->test_id), "%s", id);
+     result->test_type = type;
+     result->status = status;
+     result->execution_time = 12.5f;
+ }
+
+ /**
+  * @brief Kiểm tra ghi và đọc lại đầy đủ các loại kết quả
+  */
+ void test_append_and_load() {
+     printf("\n--- Kiểm tra ghi và đọc lại journal ---\n");
+
+     result_journal_t journal;
+     if (result_journal_open(&journal, TEST_JOURNAL_FILE, false) != 0) {
+         printf("   ✗ Không mở được journal\n");
+         return;
+     }
+
+     test_result_info_t result;
+     make_result(&result, "P1", TEST_PING, TEST_RESULT_SUCCESS);
+     result.dns_time = 3.25f;
+     result.data.ping.packets_sent = 4;
+     result.data.ping.packets_received = 3;
+     result.data.ping.avg_rtt = 1.5f;
+     result.data.ping.packet_loss = 25.0f;
+     test_result_set_details(&result, "RTT \"ok\"\nline two");
+     result_journal_append(&journal, &result);
+
+     make_result(&result, "S1", TEST_PING, TEST_RESULT_FAILED);
+     result.is_sweep = true;
+     result.data.sweep.hosts_total = 254;
+     result.data.sweep.hosts_reachable = 10;
+     result_journal_append(&journal, &result);
+
+     make_result(&result, "T1", TEST_THROUGHPUT, TEST_RESULT_TIMEOUT);
+     result.data.throughput.bandwidth = 94.5f;
+     result.data.throughput.jitter = 2;
+     result_journal_append(&journal, &result);
+
+     make_result(&result, "X1", TEST_SECURITY, TEST_RESULT_ERROR);
+     result.data.security.vulnerabilities = 2;
+     result.data.security.vuln_details = test_result_intern("telnet open");
+     result_journal_append(&journal, &result);
+
+     printf("1. Bản ghi hiển thị ngay trong file trước khi đóng journal...\n");
+     char *content = NULL;
+     size_t size = 0;
+     int lines = 0;
+     if (read_file(TEST_JOURNAL_FILE, &content, &size) == 0) {
+         for (size_t i = 0; i < size; i++) {
+             lines += content[i] == '\n';
+         }
+         free(content);
+     }
+     if (lines == 4) {
+         printf("   ✓ Journal có 4 dòng ngay khi ghi xong\n");
+     } else {
+         printf("   ✗ Journal có %d dòng, mong đợi 4\n", lines);
+     }
+     result_journal_close(&journal);
+
+     printf("2. Đọc lại journal...\n");
+     result_journal_records_t records;
+     if (result_journal_load(TEST_JOURNAL_FILE, &records) != 0 || records.count != 4) {
+         printf("   ✗ Đọc lại journal thất bại (%d bản ghi)\n", records.count);
+         result_journal_records_free(&records);
+         return;
+     }
+
+     const test_result_info_t *p = &records.results[0];
+     char details[TEST_RESULT_DETAILS_SIZE];
+     test_result_format_details(p, details, sizeof(details));
+     if (strcmp(p->test_id, "P1") == 0 && p->status == TEST_RESULT_SUCCESS && p->test_type == TEST_PING &&
+         p->data.ping.packets_received == 3 && p->data.ping.avg_rtt == 1.5f && p->dns_time == 3.25f &&
+         p->reason == RESULT_REASON_TEXT && strcmp(details, "RTT \"ok\"\nline two") == 0) {
+         printf("   ✓ Kết quả ping khôi phục chính xác\n");
+     } else {
+         printf("   ✗ Kết quả ping khôi phục sai\n");
+     }
+
+     const test_result_info_t *s = &records.results[1];
+     const test_result_info_t *t = &records.results[2];
+     const test_result_info_t *x = &records.results[3];
+     if (s->is_sweep && s->data.sweep.hosts_total == 254 && s->data.sweep.hosts_reachable == 10 &&
+         t->status == TEST_RESULT_TIMEOUT && t->data.throughput.bandwidth == 94.5f &&
+         x->test_type == TEST_SECURITY && x->data.security.vulnerabilities == 2 &&
+         x->data.security.vuln_details == test_result_intern("telnet open")) {
+         printf("   ✓ Kết quả sweep, throughput và security khôi phục chính xác\n");
+     } else {
+         printf("   ✗ Kết quả sweep, throughput hoặc security khôi phục sai\n");
+     }
+
+     if (result_journal_find(&records, "T1") == t && result_journal_find(&records, "Z9") == NULL) {
+         printf("   ✓ Tìm kết quả theo test ID chính xác\n");
+     } else {
+         printf("   ✗ Tìm kết quả theo test ID sai\n");
+     }
+     result_journal_records_free(&records);
+ }
+
+ /**
+  * @brief Kiểm tra tiếp tục journal có dòng cuối bị cắt dở
+  */
+ void test_resume_after_crash() {
+     printf("\n--- Kiểm tra tiếp tục sau khi bị dừng giữa chừng ---\n");
+
+     // Mô phỏng crash: dòng cuối chỉ ghi được một nửa
+     int fd = open(TEST_JOURNAL_FILE, O_WRONLY | O_APPEND);
+     const char *torn = "{\"test_id\":\"P2\",\"type\":\"pi";
+     if (fd < 0 || write(fd, torn, strlen(torn)) != (ssize_t)strlen(torn)) {
+         printf("   ✗ Không tạo được dòng cắt dở\n");
+     }
+     if (fd >= 0) {
+         close(fd);
+     }
+
+     result_journal_records_t records;
+     if (result_journal_load(TEST_JOURNAL_FILE, &records) == 0 && records.count == 4) {
+         printf("   ✓ Dòng cắt dở bị bỏ qua khi đọc\n");
+     } else {
+         printf("   ✗ Đọc journal có dòng cắt dở sai\n");
+     }
+     result_journal_records_free(&records);
+
+     result_journal_t journal;
+     if (result_journal_open(&journal, TEST_JOURNAL_FILE, true) != 0) {
+         printf("   ✗ Không mở được journal để ghi tiếp\n");
+         return;
+     }
+     test_result_info_t result;
+     make_result(&result, "P2", TEST_PING, TEST_RESULT_SUCCESS);
+     result_journal_append(&journal, &result);
+     make_result(&result, "T1", TEST_THROUGHPUT, TEST_RESULT_SUCCESS);
+     result_journal_append(&journal, &result);
+     result_journal_close(&journal);
+
+     if (result_journal_load(TEST_JOURNAL_FILE, &records) == 0 && records.count == 6 &&
+         strcmp(records.results[4].test_id, "P2") == 0) {
+         printf("   ✓ Ghi tiếp sau khi cắt bỏ dòng dở, không mất bản ghi cũ\n");
+     } else {
+         printf("   ✗ Ghi tiếp journal sai (%d bản ghi)\n", records.count);
+     }
+
+     const test_result_info_t *t1 = result_journal_find(&records, "T1");
+     if (t1 && t1->status == TEST_RESULT_SUCCESS) {
+         printf("   ✓ Test ID ghi nhiều lần trả về bản ghi mới nhất\n");
+     } else {
+         printf("   ✗ Không trả về bản ghi mới nhất của test ID\n");
+     }
+     result_journal_records_free(&records);
+
+     printf("2. Mở journal mới (không tiếp tục) xóa bản ghi cũ...\n");
+     if (result_journal_open(&journal, TEST_JOURNAL_FILE, false) == 0) {
+         result_journal_close(&journal);
+     }
+     if (result_journal_load(TEST_JOURNAL_FILE, &records) == 0 && records.count == 0) {
+         printf("   ✓ Journal mới rỗng\n");
+     } else {
+         printf("   ✗ Journal mới còn bản ghi cũ\n");
+     }
+     result_journal_records_free(&records);
+ }
+
+ /**
+  * @brief Kiểm tra fdatasync định kỳ theo số bản ghi
+  */
+ void test_periodic_sync() {
+     printf("\n--- Kiểm tra fdatasync định kỳ ---\n");
+
+     result_journal_t journal;
+     if (result_journal_open(&journal, TEST_JOURNAL_FILE, false) != 0) {
+         printf("   ✗ Không mở được journal\n");
+         return;
+     }
+
+     test_result_info_t result;
+     make_result(&result, "R", TEST_OTHER, TEST_RESULT_SUCCESS);
+     bool ok = true;
+     for (int i = 1; i <= RESULT_JOURNAL_SYNC_RECORDS; i++) {
+         result_journal_append(&journal, &result);
+         int expected = i % RESULT_JOURNAL_SYNC_RECORDS;
+         if (journal.unsynced != expected) {
+             ok = false;
+         }
+     }
+     result_journal_close(&journal);
+
+     if (ok) {
+         printf("   ✓ fdatasync sau mỗi %d bản ghi\n", RESULT_JOURNAL_SYNC_RECORDS);
+     } else {
+         printf("   ✗ Số bản ghi chưa đồng bộ không đúng\n");
+     }
+
+     result_journal_records_t records;
+     delete_file(TEST_JOURNAL_FILE);
+     if (result_journal_load(TEST_JOURNAL_FILE, &records) == 0 && records.count == 0) {
+         printf("   ✓ Journal không tồn tại được coi là rỗng\n");
+     } else {
+         printf("   ✗ Đọc journal không tồn tại báo lỗi\n");
+     }
+ }
+
+ int main() {
+     printf("\n=================================================\n");
+     printf("      KIỂM THỬ MODULE RESULT_JOURNAL.C\n");
+     printf("=================================================\n");
+
+     set_log_file("test_result_journal.log");
+     set_log_level(LOG_LVL_DEBUG);
+     init_logger();
+
+     test_append_and_load();
+     test_resume_after_crash();
+     test_periodic_sync();
+
+     delete_file(TEST_JOURNAL_FILE);
+     delete_file("test_result_journal.log");
+
+     printf("\n=================================================\n");
+     printf("      HOÀN TẤT KIỂM THỬ RESULT_JOURNAL.C\n");
+     printf("=================================================\n");
+
+     return 0;
+ }
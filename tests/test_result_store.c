@@ -0,0 +1,323 @@
+/**
+ * @file test_result_store.c
+ * @brief Kiểm thử kho kết quả nhị phân dạng cột
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <sys/stat.h>
+ #include "result_store.h"
+ #include "result_journal.h"
+ #include "file_process.h"
+ #include "log.h"
+
+ #define TEST_STORE_FILE "test_result_store.rstore"
+ #define TEST_TIMEOUT_STORE_FILE "test_result_store_timeout.rstore"
+ #define TEST_JOURNAL_FILE "test_result_store.ndjson"
+ #define BENCH_SEGMENTS 50
+ #define BENCH_ROWS_PER_SEGMENT 2000
+ #define BENCH_TEST_IDS 200
+
+ static const int64_t base_ms = 1700000000000LL;
+
+ static void make_ping(test_result_info_t *result, const char *id, int64_t ts, float avg_rtt, bool success) {
+     memset(result, 0, sizeof(*result));
+     snprintf(result->test_id, sizeof(result->test_id), "%s", id);
+     result->test_type = TEST_PING;
+     result->status = success ? TEST_RESULT_SUCCESS : TEST_RESULT_FAILED;
+     result->started_at = ts;
+     result->finished_at = ts + 10;
+     result->execution_time = 10.0f;
+     result->data.ping.packets_sent = 4;
+     result->data.ping.packets_received = success ? 4 : 0;
+     result->data.ping.min_rtt = avg_rtt - 1.0f;
+     result->data.ping.avg_rtt = avg_rtt;
+     result->data.ping.max_rtt = avg_rtt + 1.0f;
+     result->data.ping.packet_loss = success ? 0.0f : 100.0f;
+ }
+
+ static const result_store_group_t *find_group(const result_store_group_t *groups, int count, const char *id) {
+     for (int g = 0; g < count; g++) {
+         if (strcmp(groups[g].test_id, id) == 0) {
+             return &groups[g];
+         }
+     }
+     return NULL;
+ }
+
+ /**
+  * @brief Kiểm tra ghi nhiều segment và truy vấn theo test ID, khoảng thời gian
+  */
+ void test_append_and_query() {
+     printf("\n--- Kiểm tra ghi và truy vấn kho kết quả ---\n");
+     delete_file(TEST_STORE_FILE);
+
+     // Lần chạy 1: P1 thành công, P1 thất bại, T1 throughput
+     test_result_info_t run1[3];
+     make_ping(&run1[0], "P1", base_ms, 5.0f, true);
+     make_ping(&run1[1], "P1", base_ms + 1000, 0.0f, false);
+     memset(&run1[2], 0, sizeof(run1[2]));
+     strcpy(run1[2].test_id, "T1");
+     run1[2].test_type = TEST_THROUGHPUT;
+     run1[2].status = TEST_RESULT_SUCCESS;
+     run1[2].started_at = base_ms + 2000;
+     run1[2].data.throughput.bandwidth = 90.0f;
+
+     // Lần chạy 2, một giờ sau
+     test_result_info_t run2[2];
+     make_ping(&run2[0], "P1", base_ms + 3600000, 7.0f, true);
+     make_ping(&run2[1], "P2", base_ms + 3600000, 2.0f, true);
+
+     if (result_store_append(TEST_STORE_FILE, run1, 3) == 0 && result_store_append(TEST_STORE_FILE, run2, 2) == 0) {
+         printf("   ✓ Ghi hai segment thành công\n");
+     } else {
+         printf("   ✗ Ghi segment thất bại\n");
+         return;
+     }
+
+     result_store_t store;
+     if (result_store_open(&store, TEST_STORE_FILE) != 0) {
+         printf("   ✗ Không mở được kho kết quả\n");
+         return;
+     }
+
+     result_store_group_t *groups = NULL;
+     int group_count = 0;
+     long rows = result_store_query(&store, NULL, &groups, &group_count);
+     const result_store_group_t *p1 = find_group(groups, group_count, "P1");
+     const result_store_group_t *t1 = find_group(groups, group_count, "T1");
+     if (rows == 5 && group_count == 3 && p1 && p1->runs == 3 && p1->success == 2 &&
+         p1->rtt_count == 2 && p1->rtt_sum == 12.0 && p1->rtt_min == 4.0f && p1->rtt_max == 8.0f &&
+         p1->loss_count == 3 && p1->first_ms == base_ms && p1->last_ms == base_ms + 3600000 &&
+         t1 && t1->bandwidth_count == 1 && t1->bandwidth_sum == 90.0 && t1->rtt_count == 0) {
+         printf("   ✓ Tổng hợp toàn bộ kho chính xác\n");
+     } else {
+         printf("   ✗ Tổng hợp toàn bộ kho sai (%ld dòng, %d nhóm)\n", rows, group_count);
+     }
+     free(groups);
+
+     result_store_filter_t by_id = { "P2", 0, 0 };
+     rows = result_store_query(&store, &by_id, &groups, &group_count);
+     if (rows == 1 && group_count == 1 && strcmp(groups[0].test_id, "P2") == 0) {
+         printf("   ✓ Lọc theo test ID chính xác\n");
+     } else {
+         printf("   ✗ Lọc theo test ID sai\n");
+     }
+     free(groups);
+
+     result_store_filter_t by_time = { "P1", base_ms + 500, base_ms + 3600000 - 1 };
+     rows = result_store_query(&store, &by_time, &groups, &group_count);
+     if (rows == 1 && group_count == 1 && groups[0].success == 0) {
+         printf("   ✓ Lọc theo khoảng thời gian chính xác\n");
+     } else {
+         printf("   ✗ Lọc theo khoảng thời gian sai (%ld dòng)\n", rows);
+     }
+     free(groups);
+
+     result_store_filter_t missing = { "NOPE", 0, 0 };
+     rows = result_store_query(&store, &missing, &groups, &group_count);
+     if (rows == 0 && group_count == 0) {
+         printf("   ✓ Test ID không tồn tại trả về rỗng\n");
+     } else {
+         printf("   ✗ Test ID không tồn tại trả về dữ liệu\n");
+     }
+     free(groups);
+     result_store_close(&store);
+ }
+
+ /**
+  * @brief Ping bị timeout không có số đo mất gói (không được tính là 0%)
+  */
+ void test_timeout_ping() {
+     printf("\n--- Kiểm tra ping bị timeout ---\n");
+     delete_file(TEST_TIMEOUT_STORE_FILE);
+
+     test_result_info_t runs[2];
+     make_ping(&runs[0], "P3", base_ms, 5.0f, true);
+     runs[0].data.ping.packets_received = 19;
+     runs[0].data.ping.packets_sent = 20;
+     runs[0].data.ping.packet_loss = 5.0f;
+     memset(&runs[1], 0, sizeof(runs[1]));
+     strcpy(runs[1].test_id, "P3");
+     runs[1].test_type = TEST_PING;
+     runs[1].status = TEST_RESULT_TIMEOUT;
+     runs[1].reason = RESULT_REASON_PING_TIMEOUT;
+     runs[1].started_at = base_ms + 1000;
+
+     result_store_t store;
+     result_store_group_t *groups = NULL;
+     int group_count = 0;
+     if (result_store_append(TEST_TIMEOUT_STORE_FILE, runs, 2) != 0 || result_store_open(&store, TEST_TIMEOUT_STORE_FILE) != 0) {
+         printf("   ✗ Không ghi/mở được kho kết quả\n");
+         return;
+     }
+     long rows = result_store_query(&store, NULL, &groups, &group_count);
+     if (rows == 2 && group_count == 1 && groups[0].runs == 2 && groups[0].loss_count == 1 &&
+         groups[0].loss_sum == 5.0 && groups[0].rtt_count == 1) {
+         printf("   ✓ Lần timeout không thêm số đo mất gói 0%%\n");
+     } else {
+         printf("   ✗ Lần timeout bị tính vào mất gói (%ld lần, tổng %.1f)\n",
+                group_count ? groups[0].loss_count : -1L, group_count ? groups[0].loss_sum : -1.0);
+     }
+     free(groups);
+     result_store_close(&store);
+     delete_file(TEST_TIMEOUT_STORE_FILE);
+ }
+
+ /**
+  * @brief Kiểm tra segment cuối bị cắt dở khi đọc và khi ghi tiếp
+  */
+ void test_truncated_segment() {
+     printf("\n--- Kiểm tra segment bị cắt dở ---\n");
+
+     struct stat st;
+     stat(TEST_STORE_FILE, &st);
+     off_t good_size = st.st_size;
+
+     test_result_info_t result;
+     make_ping(&result, "P3", base_ms + 7200000, 3.0f, true);
+     result_store_append(TEST_STORE_FILE, &result, 1);
+     stat(TEST_STORE_FILE, &st);
+     if (truncate(TEST_STORE_FILE, good_size + (st.st_size - good_size) / 2) != 0) {
+         printf("   ✗ Không cắt được file\n");
+         return;
+     }
+
+     result_store_t store;
+     result_store_group_t *groups = NULL;
+     int group_count = 0;
+     long rows = -1;
+     if (result_store_open(&store, TEST_STORE_FILE) == 0) {
+         rows = result_store_query(&store, NULL, &groups, &group_count);
+         free(groups);
+         result_store_close(&store);
+     }
+     if (rows == 5) {
+         printf("   ✓ Segment cắt dở bị bỏ qua khi đọc\n");
+     } else {
+         printf("   ✗ Đọc kho có segment cắt dở sai (%ld dòng)\n", rows);
+     }
+
+     result_store_append(TEST_STORE_FILE, &result, 1);
+     rows = -1;
+     if (result_store_open(&store, TEST_STORE_FILE) == 0) {
+         rows = result_store_query(&store, NULL, &groups, &group_count);
+         free(groups);
+         result_store_close(&store);
+     }
+     if (rows == 6) {
+         printf("   ✓ Ghi tiếp sau khi loại bỏ segment cắt dở\n");
+     } else {
+         printf("   ✗ Ghi tiếp sau segment cắt dở sai (%ld dòng)\n", rows);
+     }
+
+     write_file(TEST_JOURNAL_FILE, "not a store", 11);
+     if (result_store_open(&store, TEST_JOURNAL_FILE) != 0 && result_store_append(TEST_JOURNAL_FILE, &result, 1) != 0) {
+         printf("   ✓ Từ chối file không phải kho kết quả\n");
+     } else {
+         printf("   ✗ Không phát hiện file sai định dạng\n");
+     }
+     delete_file(TEST_JOURNAL_FILE);
+ }
+
+ /**
+  * @brief So sánh kích thước và tốc độ truy vấn với journal JSON
+  */
+ void test_benchmark() {
+     int total = BENCH_SEGMENTS * BENCH_ROWS_PER_SEGMENT;
+     printf("\n--- Benchmark: kho dạng cột so với NDJSON (%d kết quả) ---\n", total);
+     delete_file(TEST_STORE_FILE);
+
+     test_result_info_t *batch = (test_result_info_t *)malloc(BENCH_ROWS_PER_SEGMENT * sizeof(test_result_info_t));
+     result_journal_t journal;
+     if (!batch || result_journal_open(&journal, TEST_JOURNAL_FILE, false) != 0) {
+         printf("   ✗ Không chuẩn bị được dữ liệu benchmark\n");
+         free(batch);
+         return;
+     }
+
+     for (int s = 0; s < BENCH_SEGMENTS; s++) {
+         for (int r = 0; r < BENCH_ROWS_PER_SEGMENT; r++) {
+             char id[32];
+             snprintf(id, sizeof(id), "PING_%03d", r % BENCH_TEST_IDS);
+             make_ping(&batch[r], id, base_ms + (int64_t)s * 3600000 + r, 1.0f + (r % 50), r % 10 != 0);
+             batch[r].reason = RESULT_REASON_PING_DONE;
+             batch[r].target = test_result_intern(id);
+             result_journal_append(&journal, &batch[r]);
+         }
+         result_store_append(TEST_STORE_FILE, batch, BENCH_ROWS_PER_SEGMENT);
+     }
+     result_journal_close(&journal);
+     free(batch);
+
+     struct stat store_st, json_st;
+     stat(TEST_STORE_FILE, &store_st);
+     stat(TEST_JOURNAL_FILE, &json_st);
+     printf("   Kích thước: kho %lld bytes, NDJSON %lld bytes (%.1fx)\n", (long long)store_st.st_size,
+            (long long)json_st.st_size, (double)json_st.st_size / store_st.st_size);
+
+     struct timespec start, mid, end;
+     clock_gettime(CLOCK_MONOTONIC, &start);
+     result_store_t store;
+     result_store_group_t *groups = NULL;
+     int group_count = 0;
+     result_store_filter_t filter = { "PING_042", 0, 0 };
+     long rows = -1;
+     if (result_store_open(&store, TEST_STORE_FILE) == 0) {
+         rows = result_store_query(&store, &filter, &groups, &group_count);
+         free(groups);
+         result_store_close(&store);
+     }
+     clock_gettime(CLOCK_MONOTONIC, &mid);
+
+     result_journal_records_t records;
+     long json_rows = 0;
+     if (result_journal_load(TEST_JOURNAL_FILE, &records) == 0) {
+         for (int i = 0; i < records.count; i++) {
+             json_rows += strcmp(records.results[i].test_id, "PING_042") == 0;
+         }
+         result_journal_records_free(&records);
+     }
+     clock_gettime(CLOCK_MONOTONIC, &end);
+
+     double store_ms = (mid.tv_sec - start.tv_sec) * 1000.0 + (mid.tv_nsec - start.tv_nsec) / 1e6;
+     double json_ms = (end.tv_sec - mid.tv_sec) * 1000.0 + (end.tv_nsec - mid.tv_nsec) / 1e6;
+     printf("   Truy vấn một test ID: kho %.2f ms, parse NDJSON %.2f ms\n", store_ms, json_ms);
+
+     long expected = (long)BENCH_SEGMENTS * BENCH_ROWS_PER_SEGMENT / BENCH_TEST_IDS;
+     if (rows == expected && json_rows == expected && store_st.st_size < json_st.st_size) {
+         printf("   ✓ Kho dạng cột cho cùng kết quả, nhỏ hơn NDJSON\n");
+     } else {
+         printf("   ✗ Kết quả benchmark không khớp (%ld / %ld dòng)\n", rows, json_rows);
+     }
+
+     delete_file(TEST_JOURNAL_FILE);
+ }
+
+ int main() {
+     printf("\n=================================================\n");
+     printf("      KIỂM THỬ MODULE RESULT_STORE.C\n");
+     printf("=================================================\n");
+
+     set_log_file("test_result_store.log");
+     set_log_level(LOG_LVL_WARN);
+     init_logger();
+
+     test_append_and_query();
+     test_timeout_ping();
+     test_truncated_segment();
+     test_benchmark();
+
+     delete_file(TEST_STORE_FILE);
+     delete_file("test_result_store.log");
+
+     printf("\n=================================================\n");
+     printf("      HOÀN TẤT KIỂM THỬ RESULT_STORE.C\n");
+     printf("=================================================\n");
+
+     return 0;
+ }
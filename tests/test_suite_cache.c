@@ -0,0 +1,210 @@
+/**
+ * @file test_suite_cache.c
+ * @brief Kiểm thử cache nhị phân cho test suite
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <utime.h>
+ #include "suite_cache.h"
+ #include "parser_data.h"
+ #include "file_process.h"
+ #include "log.h"
+
+ #define TEST_CONFIG_FILE "test_suite_cache.json"
+ #define TEST_CACHE_FILE TEST_CONFIG_FILE SUITE_CACHE_SUFFIX
+
+ static const char *config_v1 = "{\n"
+                                "  \"test_cases\": [\n"
+                                "    {\"id\": \"C001\", \"name\": \"Ping gateway\", \"type\": \"ping\",\n"
+                                "     \"target\": \"192.168.1.1\", \"timeout\": 2000,\n"
+                                "     \"ping_params\": {\"count\": 3, \"size\": 32, \"interval\": 200}},\n"
+                                "    {\"id\": \"C002\", \"name\": \"Extra\", \"type\": \"other\",\n"
+                                "     \"extra_data\": {\"key\": \"value\", \"n\": 7}}\n"
+                                "  ]\n"
+                                "}\n";
+
+ static const char *config_v2 = "{\n"
+                                "  \"test_cases\": [\n"
+                                "    {\"id\": \"C101\", \"name\": \"Ping WAN\", \"type\": \"ping\",\n"
+                                "     \"target\": \"8.8.4.4\", \"network\": \"WAN\"}\n"
+                                "  ]\n"
+                                "}\n";
+
+ static const char *config_matrix = "{\n"
+                                    "  \"test_cases\": [],\n"
+                                    "  \"matrices\": [\n"
+                                    "    {\"id\": \"M1\", \"name\": \"Sweep\", \"type\": \"ping\",\n"
+                                    "     \"axes\": {\"target\": [\"10.0.0.1\", \"10.0.0.2\"], \"size\": [32, 64, 128]}}\n"
+                                    "  ]\n"
+                                    "}\n";
+
+ /**
+  * @brief Kiểm tra vòng đời cache: lần đầu parse và ghi cache, lần sau nạp từ cache
+  */
+ void test_cache_roundtrip() {
+     printf("\n--- Kiểm tra ghi và nạp cache ---\n");
+
+     suite_cache_invalidate(TEST_CONFIG_FILE);
+     write_file(TEST_CONFIG_FILE, config_v1, strlen(config_v1));
+
+     test_case_t *cases = NULL;
+     int count = 0;
+
+     printf("1. Lần đọc đầu tiên (chưa có cache)...\n");
+     if (!suite_cache_load(TEST_CONFIG_FILE, &cases, &count, NULL)) {
+         printf("   ✓ Chưa có cache, suite_cache_load trả về false\n");
+     } else {
+         printf("   ✗ suite_cache_load không được thành công khi chưa có cache\n");
+         free_test_cases(cases, count);
+     }
+
+     if (read_test_cases_cached(TEST_CONFIG_FILE, &cases, &count, NULL) && file_exists(TEST_CACHE_FILE)) {
+         printf("   ✓ Parse JSON và tạo file cache thành công\n");
+         free_test_cases(cases, count);
+     } else {
+         printf("   ✗ Không tạo được file cache\n");
+     }
+
+     printf("2. Nạp lại từ cache...\n");
+     cases = NULL;
+     count = 0;
+     if (suite_cache_load(TEST_CONFIG_FILE, &cases, &count, NULL) && count == 2) {
+         printf("   ✓ Nạp %d test cases từ cache\n", count);
+
+         if (strcmp(test_case_id(&cases[0]), "C001") == 0 && strcmp(test_case_target(&cases[0]), "192.168.1.1") == 0 &&
+             cases[0].params.ping.count == 3 && cases[0].timeout == 2000) {
+             printf("   ✓ Dữ liệu test case chính xác\n");
+         } else {
+             printf("   ✗ Dữ liệu test case không chính xác\n");
+         }
+
+         if (test_case_extra_data(&cases[1]) && strstr(test_case_extra_data(&cases[1]), "\"key\":\"value\"")) {
+             printf("   ✓ extra_data được khôi phục: %s\n", test_case_extra_data(&cases[1]));
+         } else {
+             printf("   ✗ extra_data không được khôi phục\n");
+         }
+         free_test_cases(cases, count);
+     } else {
+         printf("   ✗ Không nạp được cache\n");
+     }
+ }
+
+ /**
+  * @brief Kiểm tra cache bị vô hiệu khi file config thay đổi
+  */
+ void test_cache_invalidation() {
+     printf("\n--- Kiểm tra vô hiệu hóa cache ---\n");
+
+     test_case_t *cases = NULL;
+     int count = 0;
+
+     printf("1. Touch file config (nội dung không đổi)...\n");
+     struct utimbuf times = { time(NULL) + 10, time(NULL) + 10 };
+     utime(TEST_CONFIG_FILE, &times);
+     if (suite_cache_load(TEST_CONFIG_FILE, &cases, &count, NULL)) {
+         printf("   ✓ Cache vẫn hợp lệ nhờ so khớp hash nội dung\n");
+         free_test_cases(cases, count);
+     } else {
+         printf("   ✗ Cache bị coi là cũ dù nội dung không đổi\n");
+     }
+
+     printf("2. Sửa nội dung file config...\n");
+     write_file(TEST_CONFIG_FILE, config_v2, strlen(config_v2));
+     if (!suite_cache_load(TEST_CONFIG_FILE, &cases, &count, NULL)) {
+         printf("   ✓ Cache cũ bị phát hiện\n");
+     } else {
+         printf("   ✗ Cache cũ vẫn được dùng\n");
+         free_test_cases(cases, count);
+     }
+
+     if (read_test_cases_cached(TEST_CONFIG_FILE, &cases, &count, NULL) && count == 1 &&
+         strcmp(test_case_id(&cases[0]), "C101") == 0 && cases[0].network_type == NETWORK_WAN) {
+         printf("   ✓ Parse lại config mới và cập nhật cache\n");
+         free_test_cases(cases, count);
+     } else {
+         printf("   ✗ Không đọc được config mới\n");
+     }
+
+     printf("3. File cache hỏng...\n");
+     write_file(TEST_CACHE_FILE, "TDSCgarbage", 11);
+     if (!suite_cache_load(TEST_CONFIG_FILE, &cases, &count, NULL)) {
+         printf("   ✓ Cache hỏng bị bỏ qua\n");
+     } else {
+         printf("   ✗ Cache hỏng vẫn được nạp\n");
+         free_test_cases(cases, count);
+     }
+ }
+
+ /**
+  * @brief Kiểm tra cache lưu và khôi phục test matrix
+  */
+ void test_cache_matrices() {
+     printf("\n--- Kiểm tra cache cho test matrix ---\n");
+
+     suite_cache_invalidate(TEST_CONFIG_FILE);
+     write_file(TEST_CONFIG_FILE, config_matrix, strlen(config_matrix));
+
+     test_case_t *cases = NULL;
+     int count = 0;
+     test_matrix_set_t matrices;
+
+     if (read_test_cases_cached(TEST_CONFIG_FILE, &cases, &count, &matrices) && count == 0) {
+         printf("   ✓ Parse suite chỉ có matrix và ghi cache\n");
+         free_test_matrices(&matrices);
+     } else {
+         printf("   ✗ Không đọc được suite chỉ có matrix\n");
+     }
+
+     if (!read_test_cases_cached(TEST_CONFIG_FILE, &cases, &count, NULL)) {
+         printf("   ✓ Người gọi không dùng matrix nhận lỗi khi suite không có test case\n");
+     } else {
+         printf("   ✗ Suite rỗng vẫn được chấp nhận khi bỏ qua matrix\n");
+         free_test_cases(cases, count);
+     }
+
+     if (suite_cache_load(TEST_CONFIG_FILE, &cases, &count, &matrices) && matrices.count == 1 &&
+         test_matrix_set_size(&matrices) == 6) {
+         printf("   ✓ Nạp matrix từ cache (%ld test cases)\n", test_matrix_set_size(&matrices));
+
+         test_matrix_item_t item;
+         test_matrix_item_init(&item);
+         if (test_matrix_expand(&matrices, 0, 5, &item) &&
+             strcmp(test_case_target(&item.test_case), "10.0.0.2") == 0 &&
+             item.test_case.params.ping.size == 128) {
+             printf("   ✓ Test case sinh từ matrix trong cache chính xác\n");
+         } else {
+             printf("   ✗ Test case sinh từ matrix trong cache không chính xác\n");
+         }
+         test_matrix_item_free(&item);
+         free_test_matrices(&matrices);
+     } else {
+         printf("   ✗ Không nạp được matrix từ cache\n");
+     }
+ }
+
+ int main() {
+     printf("\n=================================================\n");
+     printf("      KIỂM THỬ MODULE SUITE_CACHE.C\n");
+     printf("=================================================\n");
+
+     set_log_file("test_suite_cache.log");
+     set_log_level(LOG_LVL_DEBUG);
+     init_logger();
+
+     test_cache_roundtrip();
+     test_cache_invalidation();
+     test_cache_matrices();
+
+     suite_cache_invalidate(TEST_CONFIG_FILE);
+     delete_file(TEST_CONFIG_FILE);
+     delete_file("test_suite_cache.log");
+
+     printf("\n=================================================\n");
+     printf("      HOÀN TẤT KIỂM THỬ SUITE_CACHE.C\n");
+     printf("=================================================\n");
+
+     return 0;
+ }
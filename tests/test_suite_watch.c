@@ -0,0 +1,128 @@
+/**
+ * @file test_suite_watch.c
+ * @brief Kiểm thử theo dõi file config và so sánh hai phiên bản test suite
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include "suite_watch.h"
+ #include "parser_data.h"
+ #include "file_process.h"
+ #include "log.h"
+
+ #define TEST_WATCH_FILE "test_suite_watch.json"
+
+ static const char *suite_v1 = "{\"test_cases\": ["
+                               "{\"id\": \"A\", \"name\": \"Keep\", \"type\": \"ping\", \"target\": \"10.0.0.1\"},"
+                               "{\"id\": \"B\", \"name\": \"Change\", \"type\": \"ping\", \"target\": \"10.0.0.2\"},"
+                               "{\"id\": \"C\", \"name\": \"Remove\", \"type\": \"ping\", \"target\": \"10.0.0.3\"}]}";
+
+ static const char *suite_v2 = "{\"test_cases\": ["
+                               "{\"id\": \"D\", \"name\": \"Add\", \"type\": \"ping\", \"target\": \"10.0.0.4\"},"
+                               "{\"id\": \"B\", \"name\": \"Change\", \"type\": \"ping\", \"target\": \"10.0.0.2\","
+                               " \"ping_params\": {\"count\": 9}},"
+                               "{\"id\": \"A\", \"name\": \"Keep\", \"type\": \"ping\", \"target\": \"10.0.0.1\"}]}";
+
+ /**
+  * @brief Kiểm tra so sánh suite theo ID và hash nội dung
+  */
+ void test_suite_diff() {
+     printf("\n--- Kiểm tra so sánh hai phiên bản suite ---\n");
+
+     test_case_t *old_cases = NULL, *new_cases = NULL;
+     int old_count = 0, new_count = 0;
+     if (!parse_json_content(suite_v1, &old_cases, &old_count) ||
+         !parse_json_content(suite_v2, &new_cases, &new_count)) {
+         printf("   ✗ Không phân tích được suite mẫu\n");
+         return;
+     }
+
+     printf("1. Hash nội dung...\n");
+     if (test_case_hash(&old_cases[0]) == test_case_hash(&new_cases[2]) &&
+         test_case_hash(&old_cases[1]) != test_case_hash(&new_cases[1])) {
+         printf("   ✓ Hash không phụ thuộc vị trí chuỗi, phát hiện được tham số bị sửa\n");
+     } else {
+         printf("   ✗ Hash nội dung không đúng\n");
+     }
+
+     printf("2. So sánh suite...\n");
+     suite_diff_t diff;
+     if (suite_diff_compute(old_cases, old_count, new_cases, new_count, &diff) == 0) {
+         if (diff.added_count == 1 && strcmp(test_case_id(&new_cases[diff.added[0]]), "D") == 0 &&
+             diff.changed_count == 1 && strcmp(test_case_id(&new_cases[diff.changed[0]]), "B") == 0 &&
+             diff.removed_count == 1 && strcmp(test_case_id(&old_cases[diff.removed[0]]), "C") == 0 &&
+             diff.unchanged_count == 1 && diff.old_to_new[0] == 2) {
+             printf("   ✓ 1 thêm (D), 1 sửa (B), 1 xóa (C), 1 giữ nguyên (A)\n");
+         } else {
+             printf("   ✗ Kết quả so sánh không đúng: %d thêm, %d sửa, %d xóa\n",
+                    diff.added_count, diff.changed_count, diff.removed_count);
+         }
+         suite_diff_free(&diff);
+     } else {
+         printf("   ✗ suite_diff_compute thất bại\n");
+     }
+
+     free_test_cases(old_cases, old_count);
+     free_test_cases(new_cases, new_count);
+ }
+
+ /**
+  * @brief Kiểm tra inotify báo khi file config được ghi lại hoặc thay thế bằng rename
+  */
+ void test_watch_events() {
+     printf("\n--- Kiểm tra theo dõi file config ---\n");
+
+     write_file(TEST_WATCH_FILE, suite_v1, strlen(suite_v1));
+
+     suite_watch_t watch;
+     if (suite_watch_init(&watch, TEST_WATCH_FILE) != 0) {
+         printf("   ✗ Không khởi tạo được inotify\n");
+         return;
+     }
+
+     if (suite_watch_wait(&watch, 0) == 0) {
+         printf("   ✓ Không có thay đổi thì không báo\n");
+     } else {
+         printf("   ✗ Báo thay đổi khi file chưa bị sửa\n");
+     }
+
+     write_file(TEST_WATCH_FILE, suite_v2, strlen(suite_v2));
+     if (suite_watch_wait(&watch, 1000) == 1) {
+         printf("   ✓ Phát hiện file bị ghi lại\n");
+     } else {
+         printf("   ✗ Không phát hiện file bị ghi lại\n");
+     }
+
+     write_file(TEST_WATCH_FILE ".tmp", suite_v1, strlen(suite_v1));
+     rename(TEST_WATCH_FILE ".tmp", TEST_WATCH_FILE);
+     if (suite_watch_wait(&watch, 1000) == 1 && suite_watch_wait(&watch, 0) == 0) {
+         printf("   ✓ Phát hiện file bị thay bằng rename, các sự kiện được gộp\n");
+     } else {
+         printf("   ✗ Không phát hiện file bị thay bằng rename\n");
+     }
+
+     suite_watch_close(&watch);
+     delete_file(TEST_WATCH_FILE);
+ }
+
+ int main() {
+     printf("\n=================================================\n");
+     printf("      KIỂM THỬ MODULE SUITE_WATCH.C\n");
+     printf("=================================================\n");
+
+     set_log_file("test_suite_watch.log");
+     set_log_level(LOG_LVL_DEBUG);
+     init_logger();
+
+     test_suite_diff();
+     test_watch_events();
+
+     delete_file("test_suite_watch.log");
+
+     printf("\n=================================================\n");
+     printf("      HOÀN TẤT KIỂM THỬ SUITE_WATCH.C\n");
+     printf("=================================================\n");
+
+     return 0;
+ }
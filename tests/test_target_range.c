@@ -0,0 +1,126 @@
+/**
+ * @file test_target_range.c
+ * @brief Kiểm thử phân tích và duyệt dải địa chỉ đích (CIDR, range)
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include "target_range.h"
+ #include "file_process.h"
+ #include "log.h"
+
+ /**
+  * @brief Kiểm tra phân tích các dạng target
+  */
+ void test_parse() {
+     printf("\n--- Kiểm tra phân tích target ---\n");
+
+     target_range_t range;
+     char first[16], last[16];
+
+     printf("1. CIDR /22...\n");
+     if (target_range_parse("10.0.0.0/22", &range) == 1 && target_range_size(&range) == 1022) {
+         target_range_format(range.first, first, sizeof(first));
+         target_range_format(range.last, last, sizeof(last));
+         if (strcmp(first, "10.0.0.1") == 0 && strcmp(last, "10.0.3.254") == 0) {
+             printf("   ✓ 10.0.0.0/22 -> %s .. %s (1022 host)\n", first, last);
+         } else {
+             printf("   ✗ Biên của dải không đúng: %s .. %s\n", first, last);
+         }
+     } else {
+         printf("   ✗ Không phân tích được 10.0.0.0/22\n");
+     }
+
+     if (target_range_parse("192.168.1.7/32", &range) == 1 && target_range_size(&range) == 1 &&
+         target_range_parse("192.168.1.6/31", &range) == 1 && target_range_size(&range) == 2) {
+         printf("   ✓ /32 và /31 giữ nguyên mọi địa chỉ\n");
+     } else {
+         printf("   ✗ /32 hoặc /31 không đúng\n");
+     }
+
+     printf("2. Dải địa chỉ...\n");
+     if (target_range_parse("10.1.1.250-10.1.2.5", &range) == 1 && target_range_size(&range) == 12) {
+         printf("   ✓ Dải đầy đủ qua biên octet\n");
+     } else {
+         printf("   ✗ Dải đầy đủ không đúng\n");
+     }
+     if (target_range_parse("10.1.1.10-20", &range) == 1 && target_range_size(&range) == 11) {
+         printf("   ✓ Dải rút gọn theo octet cuối\n");
+     } else {
+         printf("   ✗ Dải rút gọn không đúng\n");
+     }
+
+     printf("3. Host đơn và target không hợp lệ...\n");
+     if (target_range_parse("192.168.1.1", &range) == 0 && target_range_parse("my-router.lan", &range) == 0 &&
+         target_range_parse("google.com", &range) == 0) {
+         printf("   ✓ Host đơn và tên miền có dấu '-' không bị coi là dải\n");
+     } else {
+         printf("   ✗ Host đơn bị coi là dải\n");
+     }
+     if (target_range_parse("10.0.0.0/33", &range) == -1 && target_range_parse("10.0.0.9-3", &range) == -1 &&
+         target_range_parse("10.0.0.0/8", &range) == -1 && target_range_parse("10.0.0.1-abc", &range) == -1) {
+         printf("   ✓ Prefix sai, dải ngược, dải quá lớn bị từ chối\n");
+     } else {
+         printf("   ✗ Target không hợp lệ vẫn được chấp nhận\n");
+     }
+ }
+
+ /**
+  * @brief Kiểm tra bộ duyệt sinh đúng thứ tự và số lượng địa chỉ
+  */
+ void test_iterate() {
+     printf("\n--- Kiểm tra bộ duyệt địa chỉ ---\n");
+
+     target_range_t range;
+     target_range_parse("172.16.0.0/24", &range);
+
+     target_range_iter_t iter;
+     target_range_iter_init(&iter, &range);
+
+     uint32_t address = 0, previous = 0;
+     int count = 0;
+     int ordered = 1;
+     while (target_range_iter_next(&iter, &address)) {
+         if (count > 0 && address != previous + 1) {
+             ordered = 0;
+         }
+         previous = address;
+         count++;
+     }
+
+     char last[16];
+     target_range_format(previous, last, sizeof(last));
+     if (count == 254 && ordered && strcmp(last, "172.16.0.254") == 0) {
+         printf("   ✓ Duyệt %d địa chỉ liên tiếp, địa chỉ cuối %s\n", count, last);
+     } else {
+         printf("   ✗ Bộ duyệt trả về %d địa chỉ, địa chỉ cuối %s\n", count, last);
+     }
+
+     if (!target_range_iter_next(&iter, &address)) {
+         printf("   ✓ Bộ duyệt dừng sau địa chỉ cuối\n");
+     } else {
+         printf("   ✗ Bộ duyệt vẫn trả về địa chỉ sau khi kết thúc\n");
+     }
+ }
+
+ int main() {
+     printf("\n=================================================\n");
+     printf("      KIỂM THỬ MODULE TARGET_RANGE.C\n");
+     printf("=================================================\n");
+
+     set_log_file("test_target_range.log");
+     set_log_level(LOG_LVL_DEBUG);
+     init_logger();
+
+     test_parse();
+     test_iterate();
+
+     delete_file("test_target_range.log");
+
+     printf("\n=================================================\n");
+     printf("      HOÀN TẤT KIỂM THỬ TARGET_RANGE.C\n");
+     printf("=================================================\n");
+
+     return 0;
+ }
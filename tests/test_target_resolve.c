@@ -0,0 +1,87 @@
+/**
+ * @file test_target_resolve.c
+ * @brief Kiểm thử phân giải trước và cache địa chỉ target
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include "target_resolve.h"
+ #include "parser_data.h"
+ #include "file_process.h"
+ #include "log.h"
+
+ /**
+  * @brief Kiểm tra phân giải trước cả suite và dùng lại kết quả
+  */
+ void test_prefetch() {
+     printf("\n--- Kiểm tra phân giải trước target ---\n");
+
+     const char *json = "{\"test_cases\": ["
+                        "{\"id\": \"R1\", \"name\": \"A\", \"type\": \"ping\", \"target\": \"localhost\"},"
+                        "{\"id\": \"R2\", \"name\": \"B\", \"type\": \"ping\", \"target\": \"localhost\"},"
+                        "{\"id\": \"R3\", \"name\": \"C\", \"type\": \"ping\", \"target\": \"127.0.0.1\"},"
+                        "{\"id\": \"R4\", \"name\": \"D\", \"type\": \"ping\", \"target\": \"10.0.0.0/30\"}]}";
+     test_case_t *test_cases = NULL;
+     int count = 0;
+     if (!parse_json_content(json, &test_cases, &count)) {
+         printf("   ✗ Không phân tích được suite mẫu\n");
+         return;
+     }
+
+     printf("1. Phân giải trước...\n");
+     int failures = target_resolve_prefetch(test_cases, count);
+     if (failures == 0) {
+         printf("   ✓ Phân giải trước thành công\n");
+     } else {
+         printf("   ✗ Phân giải trước có %d target lỗi\n", failures);
+     }
+
+     printf("2. Lấy địa chỉ từ cache...\n");
+     resolved_target_t resolved;
+     if (target_resolve("localhost", false, &resolved) == 0 && resolved.cached &&
+         strcmp(resolved.address, "127.0.0.1") == 0 && resolved.dns_time == 0.0f) {
+         printf("   ✓ localhost -> %s lấy từ cache, không tính thời gian DNS\n", resolved.address);
+     } else {
+         printf("   ✗ localhost không có trong cache\n");
+     }
+
+     if (target_resolve("127.0.0.1", false, &resolved) == 0 && strcmp(resolved.address, "127.0.0.1") == 0 &&
+         resolved.dns_time == 0.0f) {
+         printf("   ✓ Địa chỉ IP được dùng trực tiếp\n");
+     } else {
+         printf("   ✗ Địa chỉ IP không được xử lý đúng\n");
+     }
+
+     printf("3. TTL hết hạn...\n");
+     target_resolve_set_ttl(0);
+     if (target_resolve("localhost", false, &resolved) == 0 && !resolved.cached) {
+         printf("   ✓ Phân giải lại khi quá TTL\n");
+     } else {
+         printf("   ✗ Vẫn dùng địa chỉ đã quá TTL\n");
+     }
+     target_resolve_set_ttl(RESOLVE_DEFAULT_TTL);
+
+     target_resolve_clear();
+     free_test_cases(test_cases, count);
+ }
+
+ int main() {
+     printf("\n=================================================\n");
+     printf("      KIỂM THỬ MODULE TARGET_RESOLVE.C\n");
+     printf("=================================================\n");
+
+     set_log_file("test_target_resolve.log");
+     set_log_level(LOG_LVL_DEBUG);
+     init_logger();
+
+     test_prefetch();
+
+     delete_file("test_target_resolve.log");
+
+     printf("\n=================================================\n");
+     printf("      HOÀN TẤT KIỂM THỬ TARGET_RESOLVE.C\n");
+     printf("=================================================\n");
+
+     return 0;
+ }
@@ -5,24 +5,36 @@
 
 #include "../include/tc.h"
 #include "../include/log.h"
+#include "cjson/cJSON.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 // Test cases
 test_case_t test_cases[3];
 test_result_info_t results[3];
 
+// Dựng chi tiết dạng text của kết quả (buffer tĩnh, chỉ dùng ngay)
+static const char *details_of(const test_result_info_t *result) {
+    static char details[TEST_RESULT_DETAILS_SIZE];
+    test_result_format_details(result, details, sizeof(details));
+    return details;
+}
+
 // Setup test cases
 void setup_test_cases() {
+    string_pool_t pool;
+    string_pool_init(&pool, 0);
+    
     // Test case 1: Successful ping to localhost
     memset(&test_cases[0], 0, sizeof(test_case_t));
-    strcpy(test_cases[0].id, "PING_01");
-    strcpy(test_cases[0].name, "Ping to localhost");
-    strcpy(test_cases[0].description, "Test ping to localhost");
-    strcpy(test_cases[0].target, "127.0.0.1");
+    test_cases[0].id = string_pool_intern(&pool, "PING_01");
+    test_cases[0].name = string_pool_intern(&pool, "Ping to localhost");
+    test_cases[0].description = string_pool_intern(&pool, "Test ping to localhost");
+    test_cases[0].target = string_pool_intern(&pool, "127.0.0.1");
     test_cases[0].type = TEST_PING;
     test_cases[0].network_type = NETWORK_LAN;
     test_cases[0].timeout = 5000;
@@ -34,10 +46,10 @@ void setup_test_cases() {
     
     // Test case 2: Ping to unreachable host
     memset(&test_cases[1], 0, sizeof(test_case_t));
-    strcpy(test_cases[1].id, "PING_02");
-    strcpy(test_cases[1].name, "Ping to unreachable host");
-    strcpy(test_cases[1].description, "Test ping to unreachable host");
-    strcpy(test_cases[1].target, "8.8.8.8");  // An unlikely local address
+    test_cases[1].id = string_pool_intern(&pool, "PING_02");
+    test_cases[1].name = string_pool_intern(&pool, "Ping to unreachable host");
+    test_cases[1].description = string_pool_intern(&pool, "Test ping to unreachable host");
+    test_cases[1].target = string_pool_intern(&pool, "8.8.8.8");  // An unlikely local address
     test_cases[1].type = TEST_PING;
     test_cases[1].network_type = NETWORK_LAN;
     test_cases[1].timeout = 3000;
@@ -49,14 +61,16 @@ void setup_test_cases() {
     
     // Test case 3: Non-ping test (should be skipped)
     memset(&test_cases[2], 0, sizeof(test_case_t));
-    strcpy(test_cases[2].id, "THROUGHPUT_01");
-    strcpy(test_cases[2].name, "Throughput test");
-    strcpy(test_cases[2].description, "Test throughput to localhost");
-    strcpy(test_cases[2].target, "127.0.0.1");
+    test_cases[2].id = string_pool_intern(&pool, "THROUGHPUT_01");
+    test_cases[2].name = string_pool_intern(&pool, "Throughput test");
+    test_cases[2].description = string_pool_intern(&pool, "Test throughput to localhost");
+    test_cases[2].target = string_pool_intern(&pool, "127.0.0.1");
     test_cases[2].type = TEST_THROUGHPUT;
     test_cases[2].network_type = NETWORK_LAN;
     test_cases[2].timeout = 5000;
     test_cases[2].enabled = true;
+    
+    attach_string_table(test_cases, 3, &pool);
 }
 
 // Test execute_ping_test function
@@ -75,7 +89,7 @@ void test_execute_ping_test() {
     
     printf("Test ping to localhost: %s\n", ret == 0 ? "PASSED" : "FAILED");
     printf("  Status: %s\n", test_result_status_to_string(results[0].status));
-    printf("  Details: %s\n", results[0].result_details);
+    printf("  Details: %s\n", details_of(&results[0]));
     printf("  Execution time: %.2f ms\n", results[0].execution_time);
     
     if (results[0].status == TEST_RESULT_SUCCESS) {
@@ -94,7 +108,7 @@ void test_execute_ping_test() {
     
     printf("\nTest ping to unreachable host: %s\n", ret == 0 ? "PASSED" : "FAILED");
     printf("  Status: %s\n", test_result_status_to_string(results[1].status));
-    printf("  Details: %s\n", results[1].result_details);
+    printf("  Details: %s\n", details_of(&results[1]));
     printf("  Execution time: %.2f ms\n", results[1].execution_time);
 }
 
@@ -108,7 +122,7 @@ void test_execute_test_case() {
     
     printf("Test ping case: %s\n", ret == 0 ? "PASSED" : "FAILED");
     printf("  Status: %s\n", test_result_status_to_string(results[0].status));
-    printf("  Details: %s\n", results[0].result_details);
+    printf("  Details: %s\n", details_of(&results[0]));
     
     // Test non-ping (should be skipped/error)
     memset(&results[2], 0, sizeof(test_result_info_t));
@@ -116,7 +130,7 @@ void test_execute_test_case() {
     
     printf("\nTest non-ping case: %s\n", ret == 0 ? "PASSED" : "FAILED");
     printf("  Status: %s\n", test_result_status_to_string(results[2].status));
-    printf("  Details: %s\n", results[2].result_details);
+    printf("  Details: %s\n", details_of(&results[2]));
 }
 
 // Test execute_test_case_by_network function
@@ -136,7 +150,7 @@ void test_execute_test_case_by_network() {
     
     printf("\nTest ping on WAN (should fail): %s\n", ret == -1 ? "PASSED" : "FAILED");
     printf("  Status: %s\n", test_result_status_to_string(results[0].status));
-    printf("  Details: %s\n", results[0].result_details);
+    printf("  Details: %s\n", details_of(&results[0]));
 }
 
 // Test generate_summary_report function
@@ -173,6 +187,185 @@ void test_generate_summary_report() {
     }
 }
 
+// Test that the summary report carries typed metrics and escaped strings
+void test_structured_report() {
+    printf("\n===== Test structured summary report =====\n");
+    
+    test_result_info_t typed[4];
+    memset(typed, 0, sizeof(typed));
+    strcpy(typed[0].test_id, "P1");
+    typed[0].test_type = TEST_PING;
+    typed[0].status = TEST_RESULT_SUCCESS;
+    typed[0].execution_time = 40.5f;
+    typed[0].started_at = 1700000000000LL;
+    typed[0].finished_at = 1700000000040LL;
+    typed[0].data.ping.packets_sent = 4;
+    typed[0].data.ping.packets_received = 4;
+    typed[0].data.ping.avg_rtt = 0.25f;
+    test_result_set_details(&typed[0], "RTT \"min/avg/max\"\n\\ done");
+    strcpy(typed[1].test_id, "T1");
+    typed[1].test_type = TEST_THROUGHPUT;
+    typed[1].status = TEST_RESULT_FAILED;
+    typed[1].data.throughput.bandwidth = 93.75f;
+    strcpy(typed[2].test_id, "S1");
+    typed[2].test_type = TEST_SECURITY;
+    typed[2].status = TEST_RESULT_TIMEOUT;
+    typed[2].data.security.vulnerabilities = 3;
+    typed[2].data.security.vuln_details = test_result_intern("telnet open on 23");
+    strcpy(typed[3].test_id, "P2");
+    typed[3].test_type = TEST_PING;
+    typed[3].status = TEST_RESULT_TIMEOUT;
+    
+    const char *report_file = "test_structured_report.json";
+    int ret = generate_summary_report(typed, 4, report_file);
+    
+    char content[8192] = {0};
+    FILE *f = fopen(report_file, "r");
+    if (f) {
+        size_t n = fread(content, 1, sizeof(content) - 1, f);
+        content[n] = '\0';
+        fclose(f);
+    }
+    remove(report_file);
+    
+    cJSON *root = cJSON_Parse(content);
+    cJSON *summary = root ? cJSON_GetObjectItem(root, "summary") : NULL;
+    cJSON *list = root ? cJSON_GetObjectItem(root, "test_results") : NULL;
+    bool valid = ret == 0 && root && summary && list && cJSON_GetArraySize(list) == 4;
+    printf("Report is valid JSON: %s\n", valid ? "PASSED" : "FAILED");
+    if (!valid) {
+        cJSON_Delete(root);
+        return;
+    }
+    
+    bool counts = cJSON_GetObjectItem(summary, "total")->valueint == 4 &&
+                  cJSON_GetObjectItem(summary, "success")->valueint == 1 &&
+                  cJSON_GetObjectItem(summary, "failed")->valueint == 1 &&
+                  cJSON_GetObjectItem(summary, "timeout")->valueint == 2;
+    printf("Summary counts: %s\n", counts ? "PASSED" : "FAILED");
+    
+    cJSON *p1 = cJSON_GetArrayItem(list, 0);
+    cJSON *ping = cJSON_GetObjectItem(p1, "ping");
+    bool typed_ping = ping && cJSON_GetObjectItem(ping, "packets_received")->valueint == 4 &&
+                      cJSON_GetObjectItem(ping, "avg_rtt_ms")->valuedouble == 0.25 &&
+                      cJSON_GetObjectItem(p1, "execution_time_ms")->valuedouble == 40.5 &&
+                      cJSON_GetObjectItem(p1, "started_at_ms")->valuedouble == 1700000000000.0;
+    printf("Typed ping metrics and timestamps: %s\n", typed_ping ? "PASSED" : "FAILED");
+    
+    bool escaped = strcmp(cJSON_GetObjectItem(p1, "details")->valuestring, "RTT \"min/avg/max\"\n\\ done") == 0;
+    printf("Details string escaping: %s\n", escaped ? "PASSED" : "FAILED");
+    
+    cJSON *throughput = cJSON_GetObjectItem(cJSON_GetArrayItem(list, 1), "throughput");
+    cJSON *security = cJSON_GetObjectItem(cJSON_GetArrayItem(list, 2), "security");
+    bool other_types = throughput && cJSON_GetObjectItem(throughput, "bandwidth_mbps")->valuedouble == 93.75 &&
+                       security && cJSON_GetObjectItem(security, "vulnerabilities")->valueint == 3 &&
+                       strcmp(cJSON_GetObjectItem(security, "vuln_details")->valuestring, "telnet open on 23") == 0;
+    printf("Typed throughput/security metrics: %s\n", other_types ? "PASSED" : "FAILED");
+    
+    // A ping that timed out before printing statistics has no metrics to report
+    cJSON *timed_out = cJSON_GetArrayItem(list, 3);
+    bool no_ping = timed_out && strcmp(cJSON_GetObjectItem(timed_out, "status")->valuestring, "TIMEOUT") == 0 &&
+                   !cJSON_GetObjectItem(timed_out, "ping");
+    printf("Timed-out ping has no ping block: %s\n", no_ping ? "PASSED" : "FAILED");
+    
+    cJSON_Delete(root);
+}
+
+// Test ping sweep over a CIDR block and an address range
+void test_execute_ping_sweep() {
+    printf("\n===== Test ping sweep =====\n");
+    
+    // Fake ping on PATH: hosts with an odd last octet answer, the others do not
+    const char *fake_dir = "fake_ping_bin";
+    mkdir(fake_dir, 0755);
+    FILE *script = fopen("fake_ping_bin/ping", "w");
+    if (!script) {
+        printf("Create fake ping: FAILED\n");
+        return;
+    }
+    fprintf(script, "#!/bin/sh\nfor last; do :; done\nexit $(( (${last##*.} + 1) %% 2 ))\n");
+    fclose(script);
+    chmod("fake_ping_bin/ping", 0755);
+    
+    char *old_path = getenv("PATH") ? strdup(getenv("PATH")) : NULL;
+    char cwd[1024], new_path[4096];
+    snprintf(new_path, sizeof(new_path), "%s/%s:%s", getcwd(cwd, sizeof(cwd)) ? cwd : ".", fake_dir,
+             old_path ? old_path : "");
+    setenv("PATH", new_path, 1);
+    
+    string_pool_t pool;
+    string_pool_init(&pool, 0);
+    test_case_t sweep[2];
+    memcpy(&sweep[0], &test_cases[0], sizeof(test_case_t));
+    memcpy(&sweep[1], &test_cases[0], sizeof(test_case_t));
+    sweep[0].id = string_pool_intern(&pool, "SWEEP_01");
+    sweep[0].name = string_pool_intern(&pool, "CIDR sweep");
+    sweep[0].target = string_pool_intern(&pool, "10.9.0.0/29");
+    sweep[0].description = sweep[0].extra_data = 0;
+    sweep[1].id = string_pool_intern(&pool, "SWEEP_02");
+    sweep[1].name = string_pool_intern(&pool, "Range sweep");
+    sweep[1].target = string_pool_intern(&pool, "10.9.0.10-12");
+    sweep[1].description = sweep[1].extra_data = 0;
+    attach_string_table(sweep, 2, &pool);
+    
+    test_result_info_t result;
+    int ret = execute_ping_test(&sweep[0], &result);
+    printf("Test CIDR sweep: %s\n",
+           ret == 0 && result.is_sweep && result.data.sweep.hosts_total == 6 &&
+           result.data.sweep.hosts_reachable == 3 ? "PASSED" : "FAILED");
+    printf("  Details: %s\n", details_of(&result));
+    printf("  Unreachable list: %s\n",
+           strstr(details_of(&result), "10.9.0.2, 10.9.0.4, 10.9.0.6") ? "PASSED" : "FAILED");
+    
+    ret = execute_ping_test(&sweep[1], &result);
+    printf("Test range sweep: %s\n",
+           ret == 0 && result.data.sweep.hosts_total == 3 && result.data.sweep.hosts_reachable == 1 &&
+           strstr(details_of(&result), "10.9.0.10, 10.9.0.12") ? "PASSED" : "FAILED");
+    printf("  Details: %s\n", details_of(&result));
+    
+    free((void *)sweep[0].strtab);
+    if (old_path) {
+        setenv("PATH", old_path, 1);
+        free(old_path);
+    }
+    unlink("fake_ping_bin/ping");
+    rmdir(fake_dir);
+}
+
+// Test dựng chi tiết kết quả khi cần
+void test_result_details() {
+    printf("\n===== Test test_result_format_details =====\n");
+    
+    printf("Result struct without details buffer (%zu bytes): %s\n", sizeof(test_result_info_t),
+           sizeof(test_result_info_t) < 512 ? "PASSED" : "FAILED");
+    
+    test_result_info_t result;
+    memset(&result, 0, sizeof(result));
+    result.test_type = TEST_PING;
+    result.reason = RESULT_REASON_PING_DONE;
+    result.target = test_result_intern("192.168.1.1");
+    result.data.ping.packets_sent = 4;
+    result.data.ping.packets_received = 3;
+    result.data.ping.packet_loss = 25.0f;
+    result.data.ping.min_rtt = 0.5f;
+    result.data.ping.avg_rtt = 0.75f;
+    result.data.ping.max_rtt = 1.0f;
+    printf("Ping details rendered from typed fields: %s\n",
+           strcmp(details_of(&result), "Ping to 192.168.1.1 completed. Packets: 3/4, Loss: 25.0%, "
+                  "RTT min/avg/max: 0.500/0.750/1.000 ms") == 0 ? "PASSED" : "FAILED");
+    
+    printf("Target interned once: %s\n",
+           test_result_intern("192.168.1.1") == result.target ? "PASSED" : "FAILED");
+    
+    char small[16];
+    int len = test_result_format_details(&result, small, sizeof(small));
+    printf("Truncated rendering: %s\n",
+           len == (int)strlen(details_of(&result)) && strcmp(small, "Ping to 192.168") == 0 ? "PASSED" : "FAILED");
+    
+    memset(&result, 0, sizeof(result));
+    printf("No details: %s\n", details_of(&result)[0] == '\0' ? "PASSED" : "FAILED");
+}
+
 int main() {
     // Initialize logger
     set_log_level(LOG_LVL_DEBUG);
@@ -185,10 +378,14 @@ int main() {
     
     // Run tests
     test_execute_ping_test();
+    test_execute_ping_sweep();
     test_execute_test_case();
     test_execute_test_case_by_network();
     test_generate_summary_report();
+    test_structured_report();
+    test_result_details();
     
+    test_result_strings_free();
     printf("\nAll tests completed.\n");
     
     return 0;